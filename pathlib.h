@@ -27,6 +27,10 @@
  * operates on "normal" paths, aka not extra long paths that are generated
  * by some sort of dynamic allocation. Since it is a headers only library
  * to get the implementations you must define PATHLIB_IMPLEMENTATION.
+ * Some functions do work in background threads, on posix that means
+ * linking with -pthread, define PATHLIB_NO_THREADS to compile without them.
+ * Hardware accelerated paths (eg the SHA extensions) are picked at runtime,
+ * define PATHLIB_NO_SIMD to always use the portable versions.
  *
  * @copyright MIT license
  */
@@ -34,6 +38,12 @@
 #ifndef _PATHLIB_C_H_
 #define _PATHLIB_C_H_
 
+/* the linux specific fast paths (O_DIRECT, statx, ...) are only visible with _GNU_SOURCE,
+*  this only has an effect when pathlib.h is included before any system header */
+#if defined(PATHLIB_IMPLEMENTATION) && defined(__linux__) && !defined(_GNU_SOURCE)
+    #define _GNU_SOURCE
+#endif
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <assert.h>
@@ -47,6 +57,7 @@
     #include <windows.h>
     #include <shellapi.h>
     #include <shlwapi.h>
+    #include <io.h>
 
     #define PATHLIB_MAX_PATH MAX_PATH
 #else
@@ -57,9 +68,19 @@
     #include <pwd.h>
     #include <dirent.h>
     #include <fnmatch.h>
+    #include <sys/uio.h>
+    #include <sys/statvfs.h>
+    #include <poll.h>
+    
+    #ifndef PATHLIB_NO_THREADS
+        #include <pthread.h>
+    #endif
     
     #ifdef __linux__
         #include <linux/limits.h>
+        #include <sys/sendfile.h>
+        #include <sys/ioctl.h>
+        #include <sys/vfs.h>
     #endif
 
     #define PATHLIB_MAX_PATH PATH_MAX
@@ -80,6 +101,77 @@
 #define PATHLIB_FREE(ptr) free(ptr)
 #endif /* PATHLIB_MALLOC */
 
+#ifndef PATHLIB_ALIGNED_MALLOC
+/**
+ * @brief the function that it will use to allocate the aligned buffers that direct I/O needs
+ * @note if PATHLIB_ALIGNED_MALLOC is defined then #PATHLIB_ALIGNED_FREE(ptr) must be defined too
+ * @note alignment is always a power of two that is at least sizeof(void*)
+ */
+#define PATHLIB_ALIGNED_MALLOC(sz, alignment) pathlib__default_aligned_malloc(sz, alignment)
+/**
+ * @brief the function that it will use to free the pointer that it got from #PATHLIB_ALIGNED_MALLOC(sz, alignment)
+ */
+#define PATHLIB_ALIGNED_FREE(ptr) pathlib__default_aligned_free(ptr)
+#endif /* PATHLIB_ALIGNED_MALLOC */
+
+#ifndef PATHLIB_DIRECT_IO_CHUNK_SIZE
+/**
+ * @brief the size of the bounce buffer that direct I/O uses when the input buffer is not aligned
+ */
+#define PATHLIB_DIRECT_IO_CHUNK_SIZE (8 * 1024 * 1024)
+#endif /* PATHLIB_DIRECT_IO_CHUNK_SIZE */
+
+#ifndef PATHLIB_WRITER_BUFFER_SIZE
+/**
+ * @brief the default size of the buffer of a Pathlib_Writer
+ */
+#define PATHLIB_WRITER_BUFFER_SIZE (1024 * 1024)
+#endif /* PATHLIB_WRITER_BUFFER_SIZE */
+
+#ifndef PATHLIB_SEND_BUFFER_SIZE
+/**
+ * @brief the size of the buffer that pathlib_send_to_fd uses when the kernel cant copy the data by itself
+ */
+#define PATHLIB_SEND_BUFFER_SIZE (128 * 1024)
+#endif /* PATHLIB_SEND_BUFFER_SIZE */
+
+#ifndef PATHLIB_DIGEST_BUFFER_SIZE
+/**
+ * @brief the size of the buffer that pathlib_file_digest reads the file with
+ */
+#define PATHLIB_DIGEST_BUFFER_SIZE (1024 * 1024)
+#endif /* PATHLIB_DIGEST_BUFFER_SIZE */
+
+#ifndef PATHLIB_DIGEST_TREE_CHUNK_SIZE
+/**
+ * @brief the size of the chunks that are hashed independently with PATHLIB_DIGEST_TREE
+ * @warning changing it changes every tree digest
+ */
+#define PATHLIB_DIGEST_TREE_CHUNK_SIZE (4 * 1024 * 1024)
+#endif /* PATHLIB_DIGEST_TREE_CHUNK_SIZE */
+
+/**
+ * @brief the size of the largest digest, enough for any Pathlib_Digest_Algo
+ */
+#define PATHLIB_DIGEST_MAX_SIZE 32
+
+/**
+ * @brief the pathlib_hash64 of a path without parts, the start of every incremental hash
+ */
+#define PATHLIB_HASH64_EMPTY PATHLIB__U64(0x27D4EB2FUL, 0x165667C5UL)
+
+/**
+ * @brief the node of the empty path inside every Pathlib_Path_Tree
+ */
+#define PATHLIB_PATH_TREE_ROOT 0
+
+#ifndef PATHLIB_PATHS_RESTART_INTERVAL
+/**
+ * @brief how many entries pathlib_paths_serialize writes between two full keys, lookups decode at most that many entries
+ */
+#define PATHLIB_PATHS_RESTART_INTERVAL 16
+#endif /* PATHLIB_PATHS_RESTART_INTERVAL */
+
 #ifndef PATHLIB_ASSERT
     #define PATHLIB_ASSERT(statement) assert(statement)
 #endif /* PATHLIB_ASSERT */
@@ -94,6 +186,18 @@
 #define PATHLIB_NULLABLE
 #define PATHLIB_ARRSIZE(arr) (sizeof(arr) / sizeof(*arr))
 
+/* C89 has no 64 bit type so it comes from the compiler, __extension__ keeps -pedantic quiet about long long */
+#if defined(_MSC_VER)
+    typedef unsigned __int64 pathlib_u64;
+#elif defined(__GNUC__)
+    __extension__ typedef unsigned long long pathlib_u64;
+#else
+    typedef unsigned long long pathlib_u64;
+#endif
+/* builds a 64 bit constant from two 32 bit halves because C89 has no long long literals */
+#define PATHLIB__U64(hi, lo) (((pathlib_u64)(hi) << 32) | (pathlib_u64)(lo))
+typedef unsigned int pathlib_u32;
+
 /**
  * @brief a struct that represents a path in segments
  *
@@ -154,2523 +258,12157 @@ typedef enum Pathlib_Error {
 } Pathlib_Error;
 
 /**
- * @brief a variable that represents a possible error after a function call.
+ * @brief flags that change how the *_ex read and write functions talk to the filesystem
  *
- * if a function is supposed to set this variable then it will reset it
- * first with PATHLIB_NONE
- *
- * @see Pathlib_Error
+ * @enum Pathlib_IO_Flags
+ * @see pathlib_read_bytes_ex pathlib_write_bytes_ex
  */
-extern Pathlib_Error pathlib_error;
+typedef enum Pathlib_IO_Flags {
+    /**
+     * @brief behave exactly like the plain read and write functions
+     */
+    PATHLIB_IO_DEFAULT = 0,
+    /**
+     * @brief bypass the page cache (O_DIRECT)
+     *
+     * The bulk of the data is transfered with aligned buffers straight to the
+     * device, the unaligned tail goes through the page cache. If the filesystem
+     * does not support direct I/O it silently falls back to buffered I/O.
+     */
+    PATHLIB_IO_DIRECT = 1 << 0,
+    /**
+     * @brief reserve the final size of the file before writing it (fallocate)
+     *
+     * This avoids fragmentation and fails before anything is written when the
+     * disk does not have enough space left.
+     */
+    PATHLIB_IO_PREALLOCATE = 1 << 1,
+    /**
+     * @brief tell the kernel that the file is read from start to end (fadvise)
+     */
+    PATHLIB_IO_SEQUENTIAL = 1 << 2,
+    /**
+     * @brief append to the end of the file instead of truncating it (O_APPEND)
+     */
+    PATHLIB_IO_APPEND = 1 << 3,
+    /**
+     * @brief write full buffers from a background thread while the next one is filled
+     *
+     * @note it is ignored when PATHLIB_NO_THREADS is defined
+     */
+    PATHLIB_IO_BACKGROUND_FLUSH = 1 << 4
+} Pathlib_IO_Flags;
 
 /**
- * @brief constructs a Path object from a string
+ * @brief the hash functions that the digest functions support
  *
- * @param str the string that it will convert
- * @return a path object that represents the input path
- * @warning str must not be `NULL`
+ * @enum Pathlib_Digest_Algo
+ * @see pathlib_file_digest pathlib_digest_init
  */
-PATHLIB_API Path pathlib_from_str(const char* str);
+typedef enum Pathlib_Digest_Algo {
+    /**
+     * @brief xxHash64, a fast non cryptographic 64 bit hash
+     */
+    PATHLIB_DIGEST_XXH64 = 0,
+    /**
+     * @brief MurmurHash3 x64 128, a fast non cryptographic 128 bit hash
+     */
+    PATHLIB_DIGEST_MURMUR3_128 = 1,
+    /**
+     * @brief SHA-256, uses the x86 SHA extensions when the cpu has them
+     */
+    PATHLIB_DIGEST_SHA256 = 2,
+    /**
+     * @brief a flag for pathlib_file_digest that splits the file in chunks that are hashed in parallel
+     *
+     * The result is the digest of the chunk digests followed by the file size
+     * as a 64 bit little endian integer, so it differs from the plain digest.
+     *
+     * @see PATHLIB_DIGEST_TREE_CHUNK_SIZE
+     */
+    PATHLIB_DIGEST_TREE = 0x100
+} Pathlib_Digest_Algo;
+
 /**
- * @brief adds a new part to the path object
+ * @brief what pathlib_find_duplicates does with the duplicates that it finds
  *
- * @param path the path that it will add the part to
- * @param part the new part that it will append
- * @warning path and part must not be `NULL`
+ * @enum Pathlib_Dedup_Flags
+ * @see pathlib_find_duplicates
  */
-PATHLIB_API void pathlib_add_part(Path* path, const char* part);
+typedef enum Pathlib_Dedup_Flags {
+    /**
+     * @brief only report the duplicates
+     */
+    PATHLIB_DEDUP_REPORT = 0,
+    /**
+     * @brief replace every duplicate with a hardlink to the first file of its group
+     */
+    PATHLIB_DEDUP_HARDLINK = 1 << 0,
+    /**
+     * @brief replace every duplicate with a reflink (a copy on write clone) of the first file of its group
+     *
+     * @note it is only supported on linux filesystems that support FICLONE (btrfs, xfs, ...)
+     */
+    PATHLIB_DEDUP_REFLINK = 1 << 1
+} Pathlib_Dedup_Flags;
+
 /**
- * @brief copies the input path into a new
+ * @brief options for pathlib_disk_usage
  *
- * @param path the path that it will copy
- * @return a copy of the input path
- * @warning path must not be `NULL`
+ * @enum Pathlib_Disk_Usage_Flags
+ * @see pathlib_disk_usage
  */
-PATHLIB_API Path pathlib_copy(const Path* path);
+typedef enum Pathlib_Disk_Usage_Flags {
+    /**
+     * @brief only compute the totals
+     */
+    PATHLIB_DU_DEFAULT = 0,
+    /**
+     * @brief also compute the usage of every direct child of the path
+     */
+    PATHLIB_DU_CHILDREN = 1 << 0,
+    /**
+     * @brief dont descend into directories that are on a different filesystem than the path
+     */
+    PATHLIB_DU_ONE_FILESYSTEM = 1 << 1
+} Pathlib_Disk_Usage_Flags;
+
 /**
- * @brief creates a path that represents the current working directory
+ * @brief the kinds of entries inside a directory
  *
- * @return a path object that represents the current working directory
- * @note sets pathlib_error to PATHLIB_OSERROR in case of error 
- * @see Pathlib_Error
+ * @enum Pathlib_Entry_Type
+ * @see pathlib_query_type
  */
-PATHLIB_API Path pathlib_cwd(void);
+typedef enum Pathlib_Entry_Type {
+    /**
+     * @brief anything that is not one of the others (fifos, sockets, devices, ...)
+     */
+    PATHLIB_ENTRY_OTHER = 0,
+    /**
+     * @brief a regular file
+     */
+    PATHLIB_ENTRY_FILE = 1,
+    /**
+     * @brief a directory
+     */
+    PATHLIB_ENTRY_DIR = 2,
+    /**
+     * @brief a symbolic link, they are never followed
+     */
+    PATHLIB_ENTRY_SYMLINK = 3
+} Pathlib_Entry_Type;
+
 /**
- * @brief creates a path that represents the path to the home folder
+ * @brief what pathlib_aggregate computes besides the count of the matching entries
  *
- * @return a path object that represents the path to the home folder
- * @note sets pathlib_error to PATHLIB_OSERROR in case of error 
- * @see Pathlib_Error
+ * @enum Pathlib_Aggregate_Flags
+ * @see pathlib_aggregate
  */
-PATHLIB_API Path pathlib_home(void);
+typedef enum Pathlib_Aggregate_Flags {
+    /**
+     * @brief only count the entries, nothing is stat'ed for it
+     */
+    PATHLIB_AGGREGATE_COUNT = 0,
+    /**
+     * @brief sum the sizes of the entries
+     */
+    PATHLIB_AGGREGATE_TOTAL_SIZE = 1 << 0,
+    /**
+     * @brief keep the k largest entries
+     */
+    PATHLIB_AGGREGATE_TOP_SIZE = 1 << 1,
+    /**
+     * @brief keep the k most recently modified entries
+     */
+    PATHLIB_AGGREGATE_TOP_MTIME = 1 << 2
+} Pathlib_Aggregate_Flags;
+
 /**
- * @brief creates a path that represents the path to the temp folder
+ * @brief the orders that pathlib_paths_sort supports
  *
- * @return a path object that represents the path to the temp folder
- * @note sets pathlib_error to PATHLIB_OSERROR in case of error 
- * @see Pathlib_Error
- */
-PATHLIB_API Path pathlib_temp(void);
-/**
- * @brief deallocated a Path struct and zero it out
+ * Paths are always compared part by part, so a directory comes right before
+ * its contents. PATHLIB_SORT_IGNORE_CASE and PATHLIB_SORT_NATURAL can be
+ * combined, paths that are equal under the order are ordered by their bytes
+ * so the result is always the same.
  *
- * @param path the path that it will clean up 
- * @warning path must not be `NULL`
+ * @enum Pathlib_Sort_Order
+ * @see pathlib_paths_sort
  */
-PATHLIB_API void pathlib_destroy(Path* path);
+typedef enum Pathlib_Sort_Order {
+    /**
+     * @brief compare the bytes of the parts
+     */
+    PATHLIB_SORT_BYTES = 0,
+    /**
+     * @brief compare the parts with the ascii letters folded to lowercase
+     */
+    PATHLIB_SORT_IGNORE_CASE = 1 << 0,
+    /**
+     * @brief compare runs of digits by their numeric value, so `file2` comes before `file10`
+     */
+    PATHLIB_SORT_NATURAL = 1 << 1,
+    /**
+     * @brief a flag that sorts large lists with a thread per core
+     */
+    PATHLIB_SORT_PARALLEL = 0x100
+} Pathlib_Sort_Order;
+
 /**
- * @brief checks whether a path exists
+ * @brief the operations of pathlib_paths_set_op
  *
- * @param path the path that it will check 
- * @warning path must not be `NULL`
+ * @enum Pathlib_Set_Op
+ * @see pathlib_paths_set_op pathlib_paths_set_op_unsorted
  */
-PATHLIB_API int pathlib_exists(const Path* path);
+typedef enum Pathlib_Set_Op {
+    /**
+     * @brief the paths that are inside a or b
+     */
+    PATHLIB_SET_UNION = 0,
+    /**
+     * @brief the paths that are inside both a and b
+     */
+    PATHLIB_SET_INTERSECTION = 1,
+    /**
+     * @brief the paths of a that are not inside b
+     */
+    PATHLIB_SET_DIFFERENCE = 2,
+    /**
+     * @brief the paths that are inside only one of a and b
+     */
+    PATHLIB_SET_SYMMETRIC_DIFFERENCE = 3
+} Pathlib_Set_Op;
+
 /**
- * @brief checks whether a path is a directory
+ * @brief the state of a streaming digest
  *
- * @param path the path that it will check 
- * @warning path must not be `NULL`
+ * @struct Pathlib_Digest
+ * @see pathlib_digest_init pathlib_digest_update pathlib_digest_final
  */
-PATHLIB_API int pathlib_is_dir(const Path* path);
+typedef struct Pathlib_Digest {
+    int algo;                 /**< the Pathlib_Digest_Algo */
+    pathlib_u64 total_size;   /**< how many bytes have been hashed */
+    union {
+        pathlib_u64 u64[4];
+        pathlib_u32 u32[8];
+    } state;                  /**< the state of the hash function */
+    unsigned char buffer[64]; /**< the partial block */
+    size_t buffer_size;       /**< how many bytes are inside buffer */
+} Pathlib_Digest;
+
 /**
- * @brief checks whether a path is a file
+ * @brief a buffered writer for files that are written incrementally
  *
- * @param path the path that it will check 
- * @note sets pathlib_error to PATHLIB_OSERROR in case of error 
- * @warning path must not be `NULL`
- */
-PATHLIB_API int pathlib_is_file(const Path* path);
-/**
- * @brief checks whether a path is a symlink
+ * Small writes are collected inside a large buffer and the buffer is written
+ * together with the data that didnt fit in a single writev.
  *
- * @param path the path that it will check 
- * @note sets pathlib_error to PATHLIB_OSERROR in case of error 
- * @warning path must not be `NULL`
+ * @struct Pathlib_Writer
+ * @see pathlib_writer_open pathlib_writer_append pathlib_writer_flush pathlib_writer_close
  */
-PATHLIB_API int pathlib_is_symlink(const Path* path);
+typedef struct Pathlib_Writer Pathlib_Writer;
+
 /**
- * @brief checks whether the path points to a mount point
+ * @brief the digests of a directory tree from a previous pathlib_tree_hash
  *
- * @param path the path that it will check 
- * @note sets pathlib_error to PATHLIB_OSERROR in case of error 
- * @warning path must not be `NULL`
+ * For every node it remembers the inode, mtime, size and mode so files that
+ * have not changed since the previous run are not read again.
+ *
+ * @struct Pathlib_Tree_Hash_Cache
+ * @see pathlib_tree_hash pathlib_tree_hash_cache_new pathlib_tree_hash_cache_load
  */
-PATHLIB_API int pathlib_is_mount(const Path* path);
+typedef struct Pathlib_Tree_Hash_Cache Pathlib_Tree_Hash_Cache;
+
 /**
- * @brief checks whether the path points to a block device
+ * @brief a compiled predicate over the entries of a tree
  *
- * @param path the path that it will check 
- * @note sets pathlib_error to PATHLIB_OSERROR in case of error 
- * @warning path must not be `NULL`
+ * Queries are built from the pathlib_query_* functions and combined with
+ * pathlib_query_and, pathlib_query_or and pathlib_query_not, which take the
+ * ownership of their arguments.
+ *
+ * @struct Pathlib_Query
+ * @see pathlib_find pathlib_query_free
  */
-PATHLIB_API int pathlib_is_block_device(const Path* path);
+typedef struct Pathlib_Query Pathlib_Query;
+
 /**
- * @brief checks whether the path points to a character device
+ * @brief an open addressing hash map from paths to a pointer or a 64 bit integer
  *
- * @param path the path that it will check 
- * @note sets pathlib_error to PATHLIB_OSERROR in case of error 
- * @warning path must not be `NULL`
+ * The keys are copied into an arena owned by the map as their parts
+ * separated by 0 bytes, together with their pathlib_hash64, so a lookup
+ * compares the stored hash first and then a single memcmp.
+ *
+ * @struct Pathlib_Path_Map
+ * @see pathlib_path_map_new pathlib_path_map_from_paths
  */
-PATHLIB_API int pathlib_is_char_device(const Path* path);
+typedef struct Pathlib_Path_Map Pathlib_Path_Map;
+
 /**
- * @brief checks whether the path points to a socket
+ * @brief a set of paths, it is a Pathlib_Path_Map whose values are ignored
  *
- * @param path the path that it will check 
- * @warning path must not be `NULL`
- * @note sets pathlib_error to PATHLIB_OSERROR in case of error 
- * @note always returns false on windows
+ * @see pathlib_path_set_new pathlib_path_set_from_paths
  */
-PATHLIB_API int pathlib_is_socket(const Path* path);
+typedef struct Pathlib_Path_Map Pathlib_Path_Set;
+
 /**
- * @brief checks whether a path points to a named pipe (FIFO)
+ * @brief a trie keyed by the parts of paths, for prefix lookups
  *
- * @param path the path that it will check 
- * @note sets pathlib_error to PATHLIB_OSERROR in case of error 
- * @warning path must not be `NULL`
+ * Every node is a part of a path and the edges are kept in one hash table
+ * keyed by the parent and the name, so a lookup costs one probe per part
+ * whatever the width of the directories is. A trie can be frozen into a
+ * single position independent buffer that is queried in place.
+ *
+ * @struct Pathlib_Trie
+ * @see pathlib_trie_new pathlib_trie_from_paths pathlib_trie_freeze
  */
-PATHLIB_API int pathlib_is_fifo(const Path* path);
+typedef struct Pathlib_Trie Pathlib_Trie;
+
 /**
- * @brief checks whether the path is absolute
+ * @brief the function that pathlib_trie_subtree calls for every value
  *
- * @param path the path that it will check 
- * @warning path must not be `NULL`
+ * @param path the path of the value, it is only valid until the callback returns
+ * @param value the value
+ * @param userdata the userdata that was given to pathlib_trie_subtree
+ * @return 0 to stop and anything else to continue
  */
-PATHLIB_API int pathlib_is_absolute(const Path* path);
+typedef int (*Pathlib_Trie_Callback)(const Path* path, pathlib_u64 value, void* userdata);
+
 /**
- * @brief checks whether a path is relative to another
+ * @brief a list of paths that share the storage of their common prefixes
  *
- * @param path the base path
- * @param other the path that will be compared to param
- * @warning path and other must not be `NULL`
+ * Every distinct directory is stored once as a node that knows its parent
+ * and its name, and every entry is only the index of its node. The paths
+ * are rendered when they are needed.
+ *
+ * @struct Pathlib_Path_Tree
+ * @see pathlib_path_tree_new pathlib_rglob_tree
  */
-PATHLIB_API int pathlib_is_relative(const Path* path, const Path* other);
+typedef struct Pathlib_Path_Tree Pathlib_Path_Tree;
+
 /**
- * @brief The last dot-separated portion of the final component, if any
+ * @brief a pool that stores every distinct part once
  *
- * @param path the path that it will try to extract the suffix
- * @return the suffix, if any
- * @warning path must not be `NULL`
+ * The parts of paths that are built through a pool point inside it, so two
+ * parts of the same pool are equal exactly when their pointers are equal.
+ * The strings live until the pool is freed.
+ *
+ * @struct Pathlib_Intern_Pool
+ * @see pathlib_intern_pool_new pathlib_intern pathlib_listdir_interned pathlib_rglob_interned
  */
-PATHLIB_API char* pathlib_suffix(const Path* path);
+typedef struct Pathlib_Intern_Pool Pathlib_Intern_Pool;
+
 /**
- * @brief A list of the path’s suffixes, if any
+ * @brief the directories that previous calls to pathlib_resolve already resolved
  *
- * attempts to extract the suffixes from a given path and return them.
- * the suffix_count parameter is nullable because suffixes[suffix_count] == NULL
+ * For every directory prefix it remembers whether it is a symlink and where
+ * it points to, so paths that share directories only pay for the lstat and
+ * readlink calls of the parts that were not seen before. The entries belong
+ * to a generation and pathlib_resolve_cache_invalidate drops all of them
+ * at once when the tree may have changed.
  *
- * @param path the path that it will try to extract the suffixes
- * @param suffix_count the amount of suffixes it found
- * @return the suffixes, if any
- * @warning path must not be `NULL`
+ * @struct Pathlib_Resolve_Cache
+ * @see pathlib_resolve pathlib_resolve_cache_new
  */
-PATHLIB_API char** pathlib_suffixes(const Path* path, PATHLIB_NULLABLE size_t* suffix_count);
+typedef struct Pathlib_Resolve_Cache Pathlib_Resolve_Cache;
+
 /**
- * @brief it changes the suffix of the path, if there is none then it is added
+ * @brief a cached view of the mount table of the process
  *
- * @param path the path that will modify
- * @param suffix the suffix that it will add
- * @warning path and suffix must not be `NULL`
+ * @struct Pathlib_Mount_Table
+ * @see pathlib_mount_table_new pathlib_mount_of
  */
-PATHLIB_API void pathlib_with_suffix(Path* path, const char* suffix);
+typedef struct Pathlib_Mount_Table Pathlib_Mount_Table;
+
 /**
- * @brief The final path component, without its suffix
+ * @brief a line of `/proc/self/mountinfo`
  *
- * @param path the path that it will try to extract the suffix
- * @return the stem
- * @warning path must not be `NULL`
+ * The strings point inside the table, they are valid until it is refreshed or freed.
+ *
+ * @struct Pathlib_Mount
+ * @see pathlib_mount_of
  */
-PATHLIB_API char* pathlib_stem(const Path* path);
+typedef struct Pathlib_Mount {
+    const char* mount_point; /**< where it is mounted */
+    const char* root;        /**< the directory of the filesystem that is mounted there, it is not `/` for bind mounts */
+    const char* fs_type;     /**< the type of the filesystem, eg `ext4` or `nfs4` */
+    const char* source;      /**< the device or the server, eg `/dev/sda1` */
+    const char* options;     /**< the options of the mount, eg `rw,noatime` */
+    unsigned int id;         /**< the id of the mount */
+    unsigned int parent_id;  /**< the id of the mount that it is mounted on */
+    unsigned int major;      /**< the major number of the device */
+    unsigned int minor;      /**< the minor number of the device */
+} Pathlib_Mount;
+
 /**
- * @brief The logical parent of the path
+ * @brief the mount flags that pathlib_fs_info reports
  *
- * @param path the path
- * @return the logical parent
- * @warning path must not be `NULL`
+ * @enum Pathlib_Fs_Flags
+ * @see Pathlib_Fs_Info
  */
-PATHLIB_API Path pathlib_parent(const Path* path);
+typedef enum Pathlib_Fs_Flags {
+    /**
+     * @brief the filesystem is mounted read only
+     */
+    PATHLIB_FS_READ_ONLY = 1 << 0,
+    /**
+     * @brief the access times are not updated
+     */
+    PATHLIB_FS_NOATIME = 1 << 1,
+    /**
+     * @brief the access times are only updated when they are older than the modification time
+     */
+    PATHLIB_FS_RELATIME = 1 << 2,
+    /**
+     * @brief the set-user-id and set-group-id bits are ignored
+     */
+    PATHLIB_FS_NOSUID = 1 << 3,
+    /**
+     * @brief programs cant be executed
+     */
+    PATHLIB_FS_NOEXEC = 1 << 4,
+    /**
+     * @brief writes are synchronous
+     */
+    PATHLIB_FS_SYNCHRONOUS = 1 << 5
+} Pathlib_Fs_Flags;
+
 /**
- * @brief The logical parents of the path
+ * @brief the capacity and the type of a filesystem
  *
- * @param path the path
- * @return the logicals parent
- * @warning path must not be `NULL`
+ * @struct Pathlib_Fs_Info
+ * @see pathlib_fs_info
  */
-PATHLIB_API Paths pathlib_parents(const Path* path);
+typedef struct Pathlib_Fs_Info {
+    pathlib_u64 total_bytes;      /**< the size of the filesystem */
+    pathlib_u64 free_bytes;       /**< the free bytes, including the ones that are reserved for root */
+    pathlib_u64 available_bytes;  /**< the free bytes that an unprivileged user can use */
+    pathlib_u64 total_inodes;     /**< the count of inodes, 0 when the filesystem doesnt have a limit */
+    pathlib_u64 free_inodes;      /**< the free inodes */
+    pathlib_u64 available_inodes; /**< the free inodes that an unprivileged user can use */
+    pathlib_u64 block_size;       /**< the preferred size of an io, a good buffer size */
+    pathlib_u64 fragment_size;    /**< the unit that the space is allocated in */
+    pathlib_u64 magic;            /**< the type of the filesystem, eg 0xEF53 for ext4, only on linux (see statfs(2)) */
+    pathlib_u64 max_name_size;    /**< the longest name that a file can have */
+    int flags;                    /**< Pathlib_Fs_Flags */
+} Pathlib_Fs_Info;
+
 /**
- * @brief a string representing the final path component
+ * @brief how pathlib_rglob_ex descends into directories
  *
- * @param path the path
- * @return the name
- * @warning path must not be `NULL`
+ * @enum Pathlib_Walk_Flags
+ * @see Pathlib_Walk_Options pathlib_rglob_ex
  */
-PATHLIB_API const char* pathlib_name(const Path* path);
+typedef enum Pathlib_Walk_Flags {
+    /**
+     * @brief dont descend into symlinks to directories
+     */
+    PATHLIB_WALK_DEFAULT = 0,
+    /**
+     * @brief descend into symlinks to directories, a link back to a directory that is being walked is skipped so loops end
+     */
+    PATHLIB_WALK_FOLLOW_SYMLINKS = 1 << 0,
+    /**
+     * @brief dont descend into directories on another filesystem than the root, like `find -xdev`
+     */
+    PATHLIB_WALK_ONE_FILESYSTEM = 1 << 1
+} Pathlib_Walk_Flags;
+
 /**
- * @brief retrieves every file inside the directory 
+ * @brief the options of pathlib_rglob_ex
  *
- * @param path the path
- * @return the files
- * @warning path must not be `NULL`
+ * The children of the root are at depth 1.
+ *
+ * @struct Pathlib_Walk_Options
+ * @see pathlib_rglob_ex
  */
-PATHLIB_API Paths pathlib_listdir(const Path* path);
+typedef struct Pathlib_Walk_Options {
+    int flags;        /**< a combination of Pathlib_Walk_Flags */
+    size_t min_depth; /**< files above this depth are not matched */
+    size_t max_depth; /**< directories at this depth are not entered, 0 for no limit */
+} Pathlib_Walk_Options;
+
 /**
- * @brief joins a and b and creates a new path 
+ * @brief a pool of threads that runs tasks and that the parallel functions share
  *
- * @param pathA the first half of the new path
- * @param pathB the second half of the new path
- * @return the new path
- * @warning pathA and pathB must not be `NULL`
+ * Every worker has a deque per priority, it runs its own newest task first
+ * and steals the oldest task of another worker when its deques are empty.
+ *
+ * @struct Pathlib_Executor
+ * @see pathlib_executor_new pathlib_executor_from_callbacks pathlib_executor_set_default
  */
-PATHLIB_API Path pathlib_joinpath(const Path* pathA, const Path* pathB);
+typedef struct Pathlib_Executor Pathlib_Executor;
+
 /**
- * @brief deletes the file or symlink that the path points to
+ * @brief the function of a task
  *
- * @param path the path that it will delete
- * @return 1 on success and 0 on error
- * @note sets pathlib_error to PATHLIB_OSERROR or PATHLIB_NEXISTS in case of error 
- * @warning path must not be `NULL`
+ * @param arg the arg that was given to pathlib_executor_submit
+ * @param cancelled 1 if pathlib_executor_cancel was called after the task was submitted, then it should only release arg
  */
-PATHLIB_API int pathlib_unlink(const Path* path);
+typedef void (*Pathlib_Task_Func)(void* arg, int cancelled);
+
 /**
- * @brief deletes the directory that path points too
+ * @brief the priority of a task, the queued tasks of a higher priority run first
  *
- * @param path the path that it will delete
- * @param remove_contents whether to delete the contents of the directory
- * @return 1 on success and 0 on error
- * @note sets pathlib_error to PATHLIB_OSERROR or PATHLIB_NEXISTS in case of error 
- * @warning path must not be `NULL`
+ * @enum Pathlib_Task_Priority
+ * @see pathlib_executor_submit
  */
-PATHLIB_API int pathlib_rmdir(const Path* path, int remove_contents);
+typedef enum Pathlib_Task_Priority {
+    /**
+     * @brief background work
+     */
+    PATHLIB_PRIORITY_LOW = 0,
+    /**
+     * @brief the default
+     */
+    PATHLIB_PRIORITY_NORMAL = 1,
+    /**
+     * @brief work that a caller is waiting for, the parallel functions of pathlib use it
+     */
+    PATHLIB_PRIORITY_HIGH = 2
+} Pathlib_Task_Priority;
+
 /**
- * @brief creates the directory that path points too
+ * @brief an existing thread pool that a Pathlib_Executor hands its tasks to
  *
- * @param path the path that it will create
- * @return 1 on success and 0 on error
- * @note sets pathlib_error to PATHLIB_OSERROR or PATHLIB_EXISTS in case of error 
- * @note it creates the parents too if they dont exist
- * @warning path must not be `NULL`
+ * @struct Pathlib_Executor_Callbacks
+ * @see pathlib_executor_from_callbacks
  */
-PATHLIB_API int pathlib_mkdir(const Path* path);
+typedef struct Pathlib_Executor_Callbacks {
+    int (*submit)(void* pool, void (*run)(void* task), void* task, int priority); /**< must call run(task) exactly once on a thread of the pool, returns 0 if it couldnt queue it */
+    void* pool;                                                                   /**< given to submit */
+    size_t workers;                                                               /**< how many threads of the pool the parallel functions may use */
+} Pathlib_Executor_Callbacks;
+
 /**
- * @brief creates the file that the path points too
+ * @brief the groups of identical files that pathlib_find_duplicates found
  *
- * @param path the path that it will create
- * @return 1 on success and 0 on error
- * @note sets pathlib_error to PATHLIB_OSERROR or PATHLIB_EXISTS in case of error 
- * @note it creates the parents too if they dont exist
- * @warning path must not be `NULL`
+ * @struct Pathlib_Duplicates
+ * @see pathlib_find_duplicates pathlib_duplicates_free
  */
-PATHLIB_API int pathlib_touch(const Path* path);
+typedef struct Pathlib_Duplicates {
+    Paths* groups;               /**< every group holds the paths of files with the same contents, in the order of the input */
+    size_t size;                 /**< the count of groups */
+    pathlib_u64 duplicate_bytes; /**< the bytes that the copies after the first of every group take */
+} Pathlib_Duplicates;
+
 /**
- * @brief it opens the file that the path points to
+ * @brief how much space a tree uses
  *
- * @param path the path that it will attempt to open
- * @param mode the mode that it will pass to fopen
- * @return the file handle or NULL on error
- * @note it creates the file if it doesnt exist
- * @warning path must not be `NULL`
+ * @struct Pathlib_Usage
+ * @see pathlib_disk_usage
  */
-PATHLIB_API FILE* pathlib_open(const Path* path, const char* mode);
+typedef struct Pathlib_Usage {
+    pathlib_u64 apparent_size;  /**< the sum of the sizes of the files */
+    pathlib_u64 allocated_size; /**< the bytes of the blocks that are allocated for them (st_blocks * 512) */
+    pathlib_u64 file_count;     /**< everything that is not a directory, hardlinks are counted once */
+    pathlib_u64 dir_count;      /**< the directories, including the root */
+} Pathlib_Usage;
+
 /**
- * @brief it reads the contents of the file that path points to
+ * @brief the result of pathlib_disk_usage
  *
- * @param path the path that it will attempt to open
- * @return the file handle or NULL on error
- * @note it doesnt create the file if it doesnt exist
- * @warning path must not be `NULL`
+ * @struct Pathlib_Disk_Usage
+ * @see pathlib_disk_usage pathlib_disk_usage_free
  */
-PATHLIB_API char* pathlib_read_text(const Path* path);
+typedef struct Pathlib_Disk_Usage {
+    Pathlib_Usage total;        /**< the usage of the whole tree */
+    Paths children;             /**< the direct children of the root with PATHLIB_DU_CHILDREN */
+    Pathlib_Usage* child_usage; /**< the usage of every child, in the same order */
+} Pathlib_Disk_Usage;
+
 /**
- * @brief it reads the contents of the file that path points to
+ * @brief the result of pathlib_aggregate
  *
- * @param path the path that it will attempt to open
- * @param byte_count the amount of bytes it read
- * @return the file handle or NULL on error
- * @note it doesnt create the file if it doesnt exist
- * @warning path must not be `NULL`
+ * @struct Pathlib_Aggregate
+ * @see pathlib_aggregate pathlib_aggregate_free
  */
-PATHLIB_API unsigned char* pathlib_read_bytes(const Path* path, size_t* byte_count);
+typedef struct Pathlib_Aggregate {
+    pathlib_u64 count;      /**< how many entries matched */
+    pathlib_u64 total_size; /**< the sum of their sizes, when it was requested */
+    Paths top;              /**< the top k entries, from the largest key to the smallest */
+    pathlib_u64* top_keys;  /**< the size, or the mtime in nanoseconds since the epoch, of every entry inside top */
+} Pathlib_Aggregate;
+
 /**
- * @brief it writes text into the file that path points to
+ * @brief the function that pathlib_paths_read_bytes calls for every file that it read
  *
- * @param path the path that it will write text into
- * @param text the text that it will write
- * @param text_size how many characters it will write
- * @return 1 on success and 0 on error
- * @note it creates the file if it doesnt exist
- * @warning path must not be `NULL`
+ * @param path the file that it read
+ * @param data the contents of the file, they are only valid until the callback returns
+ * @param size the amount of bytes inside data
+ * @param userdata the userdata that was given to pathlib_paths_read_bytes
+ * @return 0 to stop reading and anything else to continue
  */
-PATHLIB_API int pathlib_write_text(const Path* path, const char* text, size_t text_size);
+typedef int (*Pathlib_Read_Callback)(const Path* path, const unsigned char* data, size_t size, void* userdata);
+
 /**
- * @brief it writes bytes into the file that path points to
+ * @brief a variable that represents a possible error after a function call.
  *
- * @param path the path that it will write bytes into
- * @param buff the buffer that it will write
- * @param buff_size how many bytes it will write
- * @return 1 on success and 0 on error
- * @note it creates the file if it doesnt exist
- * @warning path must not be `NULL`
+ * if a function is supposed to set this variable then it will reset it
+ * first with PATHLIB_NONE
+ *
+ * @see Pathlib_Error
  */
-PATHLIB_API int pathlib_write_bytes(const Path* path, const unsigned char* buff, size_t buff_size);
+extern Pathlib_Error pathlib_error;
+
 /**
- * @brief it creates a string that represents the path
+ * @brief constructs a Path object from a string
  *
- * @param path the path 
- * @return the string representation of the path
+ * @param str the string that it will convert
+ * @return a path object that represents the input path
+ * @warning str must not be `NULL`
+ */
+PATHLIB_API Path pathlib_from_str(const char* str);
+/**
+ * @brief adds a new part to the path object
+ *
+ * @param path the path that it will add the part to
+ * @param part the new part that it will append
+ * @warning path and part must not be `NULL`
+ */
+PATHLIB_API void pathlib_add_part(Path* path, const char* part);
+/**
+ * @brief copies the input path into a new
+ *
+ * @param path the path that it will copy
+ * @return a copy of the input path
  * @warning path must not be `NULL`
  */
-PATHLIB_API char* pathlib_to_str(const Path* path);
+PATHLIB_API Path pathlib_copy(const Path* path);
 /**
- * @brief it creates a string that represents the path and puts it into buffer
+ * @brief creates a path that represents the current working directory
  *
- * @param path the path 
- * @param buffer the buffer that it will write the string into
- * @param buffer_size the capacity of the buffer
- * @return 1 on success and 0 on false
- * @warning path and buffer must not be `NULL`
+ * @return a path object that represents the current working directory
+ * @note sets pathlib_error to PATHLIB_OSERROR in case of error 
+ * @see Pathlib_Error
  */
-PATHLIB_API int pathlib_render_str_to_buffer(const Path* path, char* buffer, size_t buffer_size);
+PATHLIB_API Path pathlib_cwd(void);
 /**
- * @brief it creates a hash for the input path
+ * @brief creates a path that represents the path to the home folder
  *
- * @param path the path 
- * @return the final hash
+ * @return a path object that represents the path to the home folder
+ * @note sets pathlib_error to PATHLIB_OSERROR in case of error 
+ * @see Pathlib_Error
+ */
+PATHLIB_API Path pathlib_home(void);
+/**
+ * @brief creates a path that represents the path to the temp folder
+ *
+ * @return a path object that represents the path to the temp folder
+ * @note sets pathlib_error to PATHLIB_OSERROR in case of error 
+ * @see Pathlib_Error
+ */
+PATHLIB_API Path pathlib_temp(void);
+/**
+ * @brief deallocated a Path struct and zero it out
+ *
+ * @param path the path that it will clean up 
  * @warning path must not be `NULL`
  */
-PATHLIB_API unsigned long pathlib_hashfunc(const Path* path);
+PATHLIB_API void pathlib_destroy(Path* path);
 /**
- * @brief return names of files that match the pattern
+ * @brief checks whether a path exists
  *
- * @param path the path that it will search
- * @param pattern the pattern that will try to match
- * @return the files that match the pattern inside the path directory
- * @note pathlib_glob is not recursive and does not support `**\/`, for recursive globbing check @ref pathlib_rglob
- * @note sets pathlib_error to PATHLIB_NEXISTS or PATHLIB_OSERROR
- * @note they results are not sorted
- * @warning path and pattern must not be `NULL`
+ * @param path the path that it will check 
+ * @warning path must not be `NULL`
  */
-PATHLIB_API Paths pathlib_glob(const Path* path, const char* pattern);
+PATHLIB_API int pathlib_exists(const Path* path);
 /**
- * @brief return names of files that match the pattern recursivly
+ * @brief checks whether a path is a directory
  *
- * @param path the path that it will search
- * @param pattern the pattern that will try to match
- * @return the files that match the pattern inside the path directory
- * @warning path and pattern must not be `NULL`
- * @note sets pathlib_error to PATHLIB_NEXISTS or PATHLIB_OSERROR
- * @note they results are not sorted
+ * @param path the path that it will check 
+ * @warning path must not be `NULL`
  */
-PATHLIB_API Paths pathlib_rglob(const Path* path, const char* pattern);
+PATHLIB_API int pathlib_is_dir(const Path* path);
 /**
- * @brief it adds a new path to a Paths struct
+ * @brief checks whether a path is a file
  *
- * @param paths the struct that it will add the path
- * @param path the path that it will add to paths
+ * @param path the path that it will check 
+ * @note sets pathlib_error to PATHLIB_OSERROR in case of error 
  * @warning path must not be `NULL`
  */
-PATHLIB_API void pathlib_paths_add(Paths* paths, const Path path);
+PATHLIB_API int pathlib_is_file(const Path* path);
 /**
- * @brief it removes the i-th element from paths
+ * @brief checks whether a path is a symlink
  *
- * @param paths the struct that it will remove the element from
- * @param i the index of the element that it will delete
- * @warning paths must not be `NULL` and paths->size > i
+ * @param path the path that it will check 
+ * @note sets pathlib_error to PATHLIB_OSERROR in case of error 
+ * @warning path must not be `NULL`
  */
-PATHLIB_API void pathlib_paths_pop(Paths* paths, size_t i);
+PATHLIB_API int pathlib_is_symlink(const Path* path);
 /**
- * @brief it deallocates the contents of paths->paths and zero it out
+ * @brief checks whether the path points to a mount point
  *
- * @param paths the struct that it will clean up
- * @warning paths must not be `NULL`
+ * @param path the path that it will check 
+ * @note sets pathlib_error to PATHLIB_OSERROR in case of error 
+ * @note bind mounts on the same device are not detected, see pathlib_mount_table_is_mount
+ * @warning path must not be `NULL`
  */
-PATHLIB_API void pathlib_paths_free(Paths* paths);
-
-#endif /* _PATHLIB_C_H_ */
-
-#ifdef PATHLIB_IMPLEMENTATION
-
-Pathlib_Error pathlib_error = PATHLIB_NONE;
-
-void pathlib_print_error(const char *fmt, ...) {
-    va_list args;
-
-    fprintf(stderr, "[ERROR] ");
+PATHLIB_API int pathlib_is_mount(const Path* path);
+/**
+ * @brief checks whether the path points to a block device
+ *
+ * @param path the path that it will check 
+ * @note sets pathlib_error to PATHLIB_OSERROR in case of error 
+ * @warning path must not be `NULL`
+ */
+PATHLIB_API int pathlib_is_block_device(const Path* path);
+/**
+ * @brief checks whether the path points to a character device
+ *
+ * @param path the path that it will check 
+ * @note sets pathlib_error to PATHLIB_OSERROR in case of error 
+ * @warning path must not be `NULL`
+ */
+PATHLIB_API int pathlib_is_char_device(const Path* path);
+/**
+ * @brief checks whether the path points to a socket
+ *
+ * @param path the path that it will check 
+ * @warning path must not be `NULL`
+ * @note sets pathlib_error to PATHLIB_OSERROR in case of error 
+ * @note always returns false on windows
+ */
+PATHLIB_API int pathlib_is_socket(const Path* path);
+/**
+ * @brief checks whether a path points to a named pipe (FIFO)
+ *
+ * @param path the path that it will check 
+ * @note sets pathlib_error to PATHLIB_OSERROR in case of error 
+ * @warning path must not be `NULL`
+ */
+PATHLIB_API int pathlib_is_fifo(const Path* path);
+/**
+ * @brief checks whether the path is absolute
+ *
+ * @param path the path that it will check 
+ * @warning path must not be `NULL`
+ */
+PATHLIB_API int pathlib_is_absolute(const Path* path);
+/**
+ * @brief checks whether a path is relative to another
+ *
+ * @param path the base path
+ * @param other the path that will be compared to param
+ * @warning path and other must not be `NULL`
+ */
+PATHLIB_API int pathlib_is_relative(const Path* path, const Path* other);
+/**
+ * @brief The last dot-separated portion of the final component, if any
+ *
+ * @param path the path that it will try to extract the suffix
+ * @return the suffix, if any
+ * @warning path must not be `NULL`
+ */
+PATHLIB_API char* pathlib_suffix(const Path* path);
+/**
+ * @brief A list of the path’s suffixes, if any
+ *
+ * attempts to extract the suffixes from a given path and return them.
+ * the suffix_count parameter is nullable because suffixes[suffix_count] == NULL
+ *
+ * @param path the path that it will try to extract the suffixes
+ * @param suffix_count the amount of suffixes it found
+ * @return the suffixes, if any
+ * @warning path must not be `NULL`
+ */
+PATHLIB_API char** pathlib_suffixes(const Path* path, PATHLIB_NULLABLE size_t* suffix_count);
+/**
+ * @brief it changes the suffix of the path, if there is none then it is added
+ *
+ * @param path the path that will modify
+ * @param suffix the suffix that it will add
+ * @warning path and suffix must not be `NULL`
+ */
+PATHLIB_API void pathlib_with_suffix(Path* path, const char* suffix);
+/**
+ * @brief The final path component, without its suffix
+ *
+ * @param path the path that it will try to extract the suffix
+ * @return the stem
+ * @warning path must not be `NULL`
+ */
+PATHLIB_API char* pathlib_stem(const Path* path);
+/**
+ * @brief The logical parent of the path
+ *
+ * @param path the path
+ * @return the logical parent
+ * @warning path must not be `NULL`
+ */
+PATHLIB_API Path pathlib_parent(const Path* path);
+/**
+ * @brief The logical parents of the path
+ *
+ * @param path the path
+ * @return the logicals parent
+ * @warning path must not be `NULL`
+ */
+PATHLIB_API Paths pathlib_parents(const Path* path);
+/**
+ * @brief a string representing the final path component
+ *
+ * @param path the path
+ * @return the name
+ * @warning path must not be `NULL`
+ */
+PATHLIB_API const char* pathlib_name(const Path* path);
+/**
+ * @brief retrieves every file inside the directory 
+ *
+ * @param path the path
+ * @return the files
+ * @warning path must not be `NULL`
+ */
+PATHLIB_API Paths pathlib_listdir(const Path* path);
+/**
+ * @brief joins a and b and creates a new path 
+ *
+ * @param pathA the first half of the new path
+ * @param pathB the second half of the new path
+ * @return the new path
+ * @warning pathA and pathB must not be `NULL`
+ */
+PATHLIB_API Path pathlib_joinpath(const Path* pathA, const Path* pathB);
+/**
+ * @brief deletes the file or symlink that the path points to
+ *
+ * @param path the path that it will delete
+ * @return 1 on success and 0 on error
+ * @note sets pathlib_error to PATHLIB_OSERROR or PATHLIB_NEXISTS in case of error 
+ * @warning path must not be `NULL`
+ */
+PATHLIB_API int pathlib_unlink(const Path* path);
+/**
+ * @brief deletes the directory that path points too
+ *
+ * @param path the path that it will delete
+ * @param remove_contents whether to delete the contents of the directory
+ * @return 1 on success and 0 on error
+ * @note sets pathlib_error to PATHLIB_OSERROR or PATHLIB_NEXISTS in case of error 
+ * @warning path must not be `NULL`
+ */
+PATHLIB_API int pathlib_rmdir(const Path* path, int remove_contents);
+/**
+ * @brief creates the directory that path points too
+ *
+ * @param path the path that it will create
+ * @return 1 on success and 0 on error
+ * @note sets pathlib_error to PATHLIB_OSERROR or PATHLIB_EXISTS in case of error 
+ * @note it creates the parents too if they dont exist
+ * @warning path must not be `NULL`
+ */
+PATHLIB_API int pathlib_mkdir(const Path* path);
+/**
+ * @brief creates the file that the path points too
+ *
+ * @param path the path that it will create
+ * @return 1 on success and 0 on error
+ * @note sets pathlib_error to PATHLIB_OSERROR or PATHLIB_EXISTS in case of error 
+ * @note it creates the parents too if they dont exist
+ * @warning path must not be `NULL`
+ */
+PATHLIB_API int pathlib_touch(const Path* path);
+/**
+ * @brief it opens the file that the path points to
+ *
+ * @param path the path that it will attempt to open
+ * @param mode the mode that it will pass to fopen
+ * @return the file handle or NULL on error
+ * @note it creates the file if it doesnt exist
+ * @warning path must not be `NULL`
+ */
+PATHLIB_API FILE* pathlib_open(const Path* path, const char* mode);
+/**
+ * @brief it reads the contents of the file that path points to
+ *
+ * @param path the path that it will attempt to open
+ * @return the file handle or NULL on error
+ * @note it doesnt create the file if it doesnt exist
+ * @warning path must not be `NULL`
+ */
+PATHLIB_API char* pathlib_read_text(const Path* path);
+/**
+ * @brief it reads the contents of the file that path points to
+ *
+ * @param path the path that it will attempt to open
+ * @param byte_count the amount of bytes it read
+ * @return the file handle or NULL on error
+ * @note it doesnt create the file if it doesnt exist
+ * @warning path must not be `NULL`
+ */
+PATHLIB_API unsigned char* pathlib_read_bytes(const Path* path, size_t* byte_count);
+/**
+ * @brief it writes text into the file that path points to
+ *
+ * @param path the path that it will write text into
+ * @param text the text that it will write
+ * @param text_size how many characters it will write
+ * @return 1 on success and 0 on error
+ * @note it creates the file if it doesnt exist
+ * @warning path must not be `NULL`
+ */
+PATHLIB_API int pathlib_write_text(const Path* path, const char* text, size_t text_size);
+/**
+ * @brief it writes bytes into the file that path points to
+ *
+ * @param path the path that it will write bytes into
+ * @param buff the buffer that it will write
+ * @param buff_size how many bytes it will write
+ * @return 1 on success and 0 on error
+ * @note it creates the file if it doesnt exist
+ * @warning path must not be `NULL`
+ */
+PATHLIB_API int pathlib_write_bytes(const Path* path, const unsigned char* buff, size_t buff_size);
+/**
+ * @brief it reads the contents of the file that path points to
+ *
+ * @param path the path that it will attempt to open
+ * @param byte_count the amount of bytes it read
+ * @param flags a combination of Pathlib_IO_Flags
+ * @return the contents of the file or NULL on error
+ * @note with PATHLIB_IO_DIRECT the buffer must be released with pathlib_aligned_free
+ * @note sets pathlib_error to PATHLIB_NEXISTS or PATHLIB_OSERROR in case of error
+ * @warning path and byte_count must not be `NULL`
+ * @see Pathlib_IO_Flags
+ */
+PATHLIB_API unsigned char* pathlib_read_bytes_ex(const Path* path, size_t* byte_count, int flags);
+/**
+ * @brief it writes bytes into the file that path points to
+ *
+ * @param path the path that it will write bytes into
+ * @param buff the buffer that it will write
+ * @param buff_size how many bytes it will write
+ * @param flags a combination of Pathlib_IO_Flags
+ * @return 1 on success and 0 on error
+ * @note it creates the file if it doesnt exist
+ * @note sets pathlib_error to PATHLIB_OSERROR in case of error
+ * @warning path must not be `NULL`
+ * @see Pathlib_IO_Flags
+ */
+PATHLIB_API int pathlib_write_bytes_ex(const Path* path, const unsigned char* buff, size_t buff_size, int flags);
+/**
+ * @brief queries the alignment that direct I/O needs for the file that path points to
+ *
+ * @param path the file that it will query
+ * @param memory_alignment the alignment of the memory buffers
+ * @param offset_alignment the alignment of file offsets and transfer sizes
+ * @return 1 if the file supports direct I/O and 0 otherwise
+ * @note uses statx(STATX_DIOALIGN) when it is available
+ * @note sets pathlib_error to PATHLIB_NEXISTS or PATHLIB_OSERROR in case of error
+ * @warning path, memory_alignment and offset_alignment must not be `NULL`
+ */
+PATHLIB_API int pathlib_direct_io_alignment(const Path* path, size_t* memory_alignment, size_t* offset_alignment);
+/**
+ * @brief frees a buffer that was returned by a direct I/O function
+ *
+ * @param ptr the buffer that it will free
+ */
+PATHLIB_API void pathlib_aligned_free(void* ptr);
+/**
+ * @brief reads every file inside paths and hands the contents to callback
+ *
+ * While a file is processed the next prefetch_window files are already being
+ * read by the kernel in the background (posix_fadvise WILLNEED), and the same
+ * buffer is reused for every file.
+ *
+ * @param paths the files that it will read
+ * @param prefetch_window how many files ahead it will prefetch, 0 disables prefetching
+ * @param flags a combination of Pathlib_IO_Flags, only PATHLIB_IO_SEQUENTIAL is used
+ * @param callback the function that it will call for every file
+ * @param userdata passed as is to callback
+ * @return the amount of files that were handed to callback
+ * @note files that cant be read are skipped and pathlib_error is set to PATHLIB_OSERROR
+ * @warning paths and callback must not be `NULL`
+ */
+PATHLIB_API size_t pathlib_paths_read_bytes(const Paths* paths, size_t prefetch_window, int flags, Pathlib_Read_Callback callback, void* userdata);
+/**
+ * @brief opens a buffered writer for the file that path points to
+ *
+ * @param path the file that it will write into
+ * @param buffer_size the size of the buffer, 0 uses #PATHLIB_WRITER_BUFFER_SIZE
+ * @param flags a combination of Pathlib_IO_Flags, only PATHLIB_IO_APPEND and PATHLIB_IO_BACKGROUND_FLUSH are used
+ * @return the writer or NULL on error
+ * @note it creates the file if it doesnt exist and truncates it unless PATHLIB_IO_APPEND is given
+ * @note sets pathlib_error to PATHLIB_OSERROR in case of error
+ * @warning path must not be `NULL`
+ */
+PATHLIB_API Pathlib_Writer* pathlib_writer_open(const Path* path, size_t buffer_size, int flags);
+/**
+ * @brief appends data to the writer
+ *
+ * @param writer the writer
+ * @param data the data that it will append
+ * @param size the amount of bytes inside data
+ * @return 1 on success and 0 on error
+ * @note errors of a background flush are reported by the next call
+ * @note sets pathlib_error to PATHLIB_OSERROR in case of error
+ * @warning writer must not be `NULL`
+ */
+PATHLIB_API int pathlib_writer_append(Pathlib_Writer* writer, const void* data, size_t size);
+/**
+ * @brief writes everything that is buffered into the file
+ *
+ * @param writer the writer
+ * @return 1 on success and 0 on error
+ * @note sets pathlib_error to PATHLIB_OSERROR in case of error
+ * @warning writer must not be `NULL`
+ */
+PATHLIB_API int pathlib_writer_flush(Pathlib_Writer* writer);
+/**
+ * @brief flushes the writer, closes the file and frees the writer
+ *
+ * @param writer the writer
+ * @return 1 on success and 0 on error
+ * @note the writer is freed even when it returns 0
+ * @note sets pathlib_error to PATHLIB_OSERROR in case of error
+ * @warning writer must not be `NULL`
+ */
+PATHLIB_API int pathlib_writer_close(Pathlib_Writer* writer);
+/**
+ * @brief streams the contents of the file that path points to into another file descriptor
+ *
+ * The data is copied inside the kernel with sendfile or splice when possible,
+ * otherwise it goes through a small buffer. It works with pipes, sockets and
+ * regular files, non blocking descriptors are waited on with poll.
+ *
+ * @param path the file that it will send
+ * @param out_fd the descriptor that it will write into
+ * @param offset the offset inside the file where it will start
+ * @param len how many bytes it will send, 0 sends everything up to the end of the file
+ * @return 1 on success and 0 on error
+ * @note sets pathlib_error to PATHLIB_NEXISTS or PATHLIB_OSERROR in case of error
+ * @warning path must not be `NULL`
+ */
+PATHLIB_API int pathlib_send_to_fd(const Path* path, int out_fd, size_t offset, size_t len);
+/**
+ * @brief the size of the digests that algo produces
+ *
+ * @param algo a Pathlib_Digest_Algo
+ * @return the size in bytes
+ */
+PATHLIB_API size_t pathlib_digest_size(int algo);
+/**
+ * @brief starts a streaming digest
+ *
+ * @param digest the state that it will initialize
+ * @param algo a Pathlib_Digest_Algo without PATHLIB_DIGEST_TREE
+ * @warning digest must not be `NULL`
+ */
+PATHLIB_API void pathlib_digest_init(Pathlib_Digest* digest, int algo);
+/**
+ * @brief hashes more data
+ *
+ * @param digest the state
+ * @param data the data that it will hash
+ * @param size the amount of bytes inside data
+ * @warning digest must not be `NULL`
+ */
+PATHLIB_API void pathlib_digest_update(Pathlib_Digest* digest, const void* data, size_t size);
+/**
+ * @brief finishes a streaming digest
+ *
+ * @param digest the state
+ * @param out where it will write pathlib_digest_size(algo) bytes
+ * @warning digest and out must not be `NULL`
+ */
+PATHLIB_API void pathlib_digest_final(Pathlib_Digest* digest, unsigned char* out);
+/**
+ * @brief hashes a buffer in one go
+ *
+ * @param algo a Pathlib_Digest_Algo without PATHLIB_DIGEST_TREE
+ * @param data the data that it will hash
+ * @param size the amount of bytes inside data
+ * @param out where it will write pathlib_digest_size(algo) bytes
+ * @warning out must not be `NULL`
+ */
+PATHLIB_API void pathlib_digest_buffer(int algo, const void* data, size_t size, unsigned char* out);
+/**
+ * @brief converts a digest into a lowercase hex string
+ *
+ * @param digest the digest
+ * @param digest_size the size of the digest
+ * @param hex where it will write digest_size * 2 + 1 characters
+ * @warning digest and hex must not be `NULL`
+ */
+PATHLIB_API void pathlib_digest_to_hex(const unsigned char* digest, size_t digest_size, char* hex);
+/**
+ * @brief hashes the contents of the file that path points to
+ *
+ * The file is streamed through one reused buffer. With PATHLIB_DIGEST_TREE
+ * the chunks of the file are hashed by multiple threads.
+ *
+ * @param path the file that it will hash
+ * @param algo a Pathlib_Digest_Algo, optionally combined with PATHLIB_DIGEST_TREE
+ * @param out where it will write pathlib_digest_size(algo) bytes
+ * @return 1 on success and 0 on error
+ * @note sets pathlib_error to PATHLIB_NEXISTS or PATHLIB_OSERROR in case of error
+ * @warning path and out must not be `NULL`
+ */
+PATHLIB_API int pathlib_file_digest(const Path* path, int algo, unsigned char* out);
+/**
+ * @brief computes a merkle hash of the directory tree under root
+ *
+ * Every node is hashed together with its type, mode and name, directories
+ * hash the node digests of their children sorted by name and symlinks hash
+ * their target. Equal trees give equal digests wherever they are located.
+ * When a cache is given only the files whose inode, mtime, size or mode
+ * changed since the previous run are read, the rest reuse their digest,
+ * and the cache is updated with the new tree.
+ *
+ * @param root the directory (or file) that it will hash
+ * @param algo a Pathlib_Digest_Algo, with PATHLIB_DIGEST_TREE the file contents are hashed in parallel chunks
+ * @param cache the digests of the previous run or `NULL`
+ * @param out where it will write pathlib_digest_size(algo) bytes
+ * @return 1 on success and 0 on error
+ * @note sets pathlib_error to PATHLIB_NEXISTS or PATHLIB_OSERROR in case of error
+ * @warning root and out must not be `NULL`, the cache must have been created with the same algo
+ */
+PATHLIB_API int pathlib_tree_hash(const Path* root, int algo, PATHLIB_NULLABLE Pathlib_Tree_Hash_Cache* cache, unsigned char* out);
+/**
+ * @brief creates an empty cache for pathlib_tree_hash
+ *
+ * @param algo the algo that it will be used with
+ * @return the cache, free it with pathlib_tree_hash_cache_free
+ */
+PATHLIB_API Pathlib_Tree_Hash_Cache* pathlib_tree_hash_cache_new(int algo);
+/**
+ * @brief loads a cache that was stored with pathlib_tree_hash_cache_save
+ *
+ * @param path the file that it will read
+ * @return the cache or `NULL` on error
+ * @note sets pathlib_error to PATHLIB_NEXISTS or PATHLIB_OSERROR in case of error
+ * @warning path must not be `NULL`
+ */
+PATHLIB_API Pathlib_Tree_Hash_Cache* pathlib_tree_hash_cache_load(const Path* path);
+/**
+ * @brief stores a cache so later processes can reuse it
+ *
+ * @param cache the cache
+ * @param path the file that it will write
+ * @return 1 on success and 0 on error
+ * @note sets pathlib_error to PATHLIB_OSERROR in case of error
+ * @warning cache and path must not be `NULL`
+ */
+PATHLIB_API int pathlib_tree_hash_cache_save(const Pathlib_Tree_Hash_Cache* cache, const Path* path);
+/**
+ * @brief gets the node digest of a path from the last run of pathlib_tree_hash
+ *
+ * @param cache the cache
+ * @param relative the path relative to the root, "." is the root itself
+ * @param out where it will write pathlib_digest_size(algo) bytes
+ * @return 1 if the path was found and 0 otherwise
+ * @warning cache, relative and out must not be `NULL`
+ */
+PATHLIB_API int pathlib_tree_hash_cache_lookup(const Pathlib_Tree_Hash_Cache* cache, const Path* relative, unsigned char* out);
+/**
+ * @brief frees a cache
+ *
+ * @param cache the cache, it may be `NULL`
+ */
+PATHLIB_API void pathlib_tree_hash_cache_free(Pathlib_Tree_Hash_Cache* cache);
+/**
+ * @brief finds the files with identical contents inside paths
+ *
+ * Files are first bucketed by size, then by a hash of their first and last
+ * 4 KB and only the files that are still ambiguous are hashed completely
+ * with SHA-256 by multiple threads. Directories, symlinks and empty files are
+ * ignored and paths that are hardlinks of the same file are only read once.
+ * Duplicates are only replaced when they are on the same device as the first
+ * file of their group and neither file changed since it was hashed.
+ *
+ * @param paths the files, for example the result of pathlib_rglob
+ * @param flags Pathlib_Dedup_Flags
+ * @return the groups, free them with pathlib_duplicates_free
+ * @note sets pathlib_error to PATHLIB_OSERROR when a file couldnt be read or replaced, the rest of the result is still valid
+ * @warning paths must not be `NULL`
+ */
+PATHLIB_API Pathlib_Duplicates pathlib_find_duplicates(const Paths* paths, int flags);
+/**
+ * @brief frees the result of pathlib_find_duplicates
+ *
+ * @param duplicates the result
+ * @warning duplicates must not be `NULL`
+ */
+PATHLIB_API void pathlib_duplicates_free(Pathlib_Duplicates* duplicates);
+/**
+ * @brief computes how much space the tree under path uses, like du
+ *
+ * Every entry is stat'ed exactly once while the directories are listed by
+ * multiple threads, without building a list of all the paths. Symlinks are
+ * not followed and files with more than one link are counted once by their
+ * (dev, ino). When a hardlinked file is inside more than one child it is
+ * added to whichever child reached it first.
+ *
+ * @param path the directory (or file) that it will measure
+ * @param flags Pathlib_Disk_Usage_Flags
+ * @param usage where it will write the result, free it with pathlib_disk_usage_free
+ * @return 1 on success and 0 if the path couldnt be stat'ed
+ * @note sets pathlib_error to PATHLIB_NEXISTS or PATHLIB_OSERROR in case of error, entries that couldnt be read are skipped and set it to PATHLIB_OSERROR
+ * @warning path and usage must not be `NULL`
+ */
+PATHLIB_API int pathlib_disk_usage(const Path* path, int flags, Pathlib_Disk_Usage* usage);
+/**
+ * @brief frees the result of pathlib_disk_usage
+ *
+ * @param usage the result
+ * @warning usage must not be `NULL`
+ */
+PATHLIB_API void pathlib_disk_usage_free(Pathlib_Disk_Usage* usage);
+/**
+ * @brief it creates a string that represents the path
+ *
+ * @param path the path 
+ * @return the string representation of the path
+ * @warning path must not be `NULL`
+ */
+PATHLIB_API char* pathlib_to_str(const Path* path);
+/**
+ * @brief it creates a string that represents the path and puts it into buffer
+ *
+ * @param path the path 
+ * @param buffer the buffer that it will write the string into
+ * @param buffer_size the capacity of the buffer
+ * @return 1 on success and 0 on false
+ * @warning path and buffer must not be `NULL`
+ */
+PATHLIB_API int pathlib_render_str_to_buffer(const Path* path, char* buffer, size_t buffer_size);
+/**
+ * @brief it creates a hash for the input path
+ *
+ * @param path the path 
+ * @return the final hash
+ * @warning path must not be `NULL`
+ */
+PATHLIB_API unsigned long pathlib_hashfunc(const Path* path);
+/**
+ * @brief a 64 bit hash of the path that can be updated one component at a time
+ *
+ * The components are hashed 8 to 32 bytes at a time and folded in order, so
+ * hash(joinpath(a, b)) == pathlib_hash64_join(hash(a), b) and the hashes of
+ * pathlib_add_part and pathlib_parent results follow from the stored hash
+ * without touching the rest of the path.
+ *
+ * @param path the path
+ * @return the hash
+ * @see pathlib_hash64_add_part pathlib_hash64_join pathlib_hash64_parent
+ * @warning path must not be `NULL`
+ */
+PATHLIB_API pathlib_u64 pathlib_hash64(const Path* path);
+/**
+ * @brief the pathlib_hash64 of the path after pathlib_add_part(path, part)
+ *
+ * @param hash the pathlib_hash64 of the path
+ * @param part the part that is added
+ * @return the new hash
+ * @warning part must not be `NULL`
+ */
+PATHLIB_API pathlib_u64 pathlib_hash64_add_part(pathlib_u64 hash, const char* part);
+/**
+ * @brief the pathlib_hash64 of pathlib_joinpath(path, other)
+ *
+ * @param hash the pathlib_hash64 of the path
+ * @param other the path that is joined, only its parts are hashed
+ * @return the new hash
+ * @warning other must not be `NULL`
+ */
+PATHLIB_API pathlib_u64 pathlib_hash64_join(pathlib_u64 hash, const Path* other);
+/**
+ * @brief the pathlib_hash64 of the path without its last part
+ *
+ * @param hash the pathlib_hash64 of the path
+ * @param last_part the last part of the path, eg pathlib_name(path)
+ * @return the hash of the parent
+ * @note for a path with a single part pathlib_parent returns "." but this returns PATHLIB_HASH64_EMPTY
+ * @warning last_part must not be `NULL`
+ */
+PATHLIB_API pathlib_u64 pathlib_hash64_parent(pathlib_u64 hash, const char* last_part);
+/**
+ * @brief creates an empty path map
+ *
+ * @param expected_size how many keys it will hold, it is allocated for them up front
+ * @return the map, free it with pathlib_path_map_free
+ */
+PATHLIB_API Pathlib_Path_Map* pathlib_path_map_new(size_t expected_size);
+/**
+ * @brief creates a map from every path to its index inside paths
+ *
+ * @param paths the keys, when a path appears twice it maps to its last index
+ * @return the map, free it with pathlib_path_map_free
+ * @warning paths must not be `NULL`
+ */
+PATHLIB_API Pathlib_Path_Map* pathlib_path_map_from_paths(const Paths* paths);
+/**
+ * @brief frees a map and every key inside it
+ *
+ * @param map the map, it may be `NULL`
+ */
+PATHLIB_API void pathlib_path_map_free(Pathlib_Path_Map* map);
+/**
+ * @brief how many keys are inside the map
+ *
+ * @param map the map
+ * @return the count of keys
+ * @warning map must not be `NULL`
+ */
+PATHLIB_API size_t pathlib_path_map_size(const Pathlib_Path_Map* map);
+/**
+ * @brief sets the value of key
+ *
+ * @param map the map
+ * @param key the key, it is copied
+ * @param value the value
+ * @return 1 if the key was added and 0 if it was already inside (or too long to be stored)
+ * @warning map and key must not be `NULL`
+ */
+PATHLIB_API int pathlib_path_map_put(Pathlib_Path_Map* map, const Path* key, void* value);
+/**
+ * @brief like pathlib_path_map_put but the value is an integer
+ *
+ * @see pathlib_path_map_put
+ */
+PATHLIB_API int pathlib_path_map_put_u64(Pathlib_Path_Map* map, const Path* key, pathlib_u64 value);
+/**
+ * @brief gets the value of key
+ *
+ * @param map the map
+ * @param key the key
+ * @param value where it will write the value, it may be `NULL`
+ * @return 1 if the key was found and 0 otherwise
+ * @warning map and key must not be `NULL`
+ */
+PATHLIB_API int pathlib_path_map_get(const Pathlib_Path_Map* map, const Path* key, PATHLIB_NULLABLE void** value);
+/**
+ * @brief like pathlib_path_map_get but the value is an integer
+ *
+ * @see pathlib_path_map_get
+ */
+PATHLIB_API int pathlib_path_map_get_u64(const Pathlib_Path_Map* map, const Path* key, PATHLIB_NULLABLE pathlib_u64* value);
+/**
+ * @brief removes key from the map
+ *
+ * @param map the map
+ * @param key the key
+ * @return 1 if the key was removed and 0 if it wasnt inside
+ * @warning map and key must not be `NULL`
+ */
+PATHLIB_API int pathlib_path_map_remove(Pathlib_Path_Map* map, const Path* key);
+/**
+ * @brief iterates over the keys of the map in no particular order
+ *
+ * @param map the map, it must not be modified while it is iterated
+ * @param iterator a cursor that starts at 0
+ * @param key where it will write the key, its parts belong to the map but the path must be freed with pathlib_destroy
+ * @param value where it will write the value as a pointer
+ * @param value_u64 where it will write the value as an integer
+ * @return 1 if there was another key and 0 at the end
+ * @warning map and iterator must not be `NULL`
+ */
+PATHLIB_API int pathlib_path_map_next(const Pathlib_Path_Map* map, size_t* iterator, PATHLIB_NULLABLE Path* key, PATHLIB_NULLABLE void** value, PATHLIB_NULLABLE pathlib_u64* value_u64);
+/**
+ * @brief creates an empty path set
+ *
+ * @param expected_size how many paths it will hold
+ * @return the set, free it with pathlib_path_set_free
+ */
+PATHLIB_API Pathlib_Path_Set* pathlib_path_set_new(size_t expected_size);
+/**
+ * @brief creates a set that holds every path inside paths
+ *
+ * @param paths the paths
+ * @return the set, free it with pathlib_path_set_free
+ * @warning paths must not be `NULL`
+ */
+PATHLIB_API Pathlib_Path_Set* pathlib_path_set_from_paths(const Paths* paths);
+/**
+ * @brief adds a path to the set
+ *
+ * @param set the set
+ * @param path the path, it is copied
+ * @return 1 if it was added and 0 if it was already inside
+ * @warning set and path must not be `NULL`
+ */
+PATHLIB_API int pathlib_path_set_add(Pathlib_Path_Set* set, const Path* path);
+/**
+ * @brief checks if a path is inside the set
+ *
+ * @param set the set
+ * @param path the path
+ * @return 1 if it is inside and 0 otherwise
+ * @warning set and path must not be `NULL`
+ */
+PATHLIB_API int pathlib_path_set_contains(const Pathlib_Path_Set* set, const Path* path);
+/**
+ * @brief removes a path from the set
+ *
+ * @param set the set
+ * @param path the path
+ * @return 1 if it was removed and 0 if it wasnt inside
+ * @warning set and path must not be `NULL`
+ */
+PATHLIB_API int pathlib_path_set_remove(Pathlib_Path_Set* set, const Path* path);
+/**
+ * @brief frees a set
+ *
+ * @param set the set, it may be `NULL`
+ */
+PATHLIB_API void pathlib_path_set_free(Pathlib_Path_Set* set);
+/**
+ * @brief creates an empty trie
+ *
+ * @return the trie, free it with pathlib_trie_free
+ */
+PATHLIB_API Pathlib_Trie* pathlib_trie_new(void);
+/**
+ * @brief creates a trie where every path maps to its index inside paths
+ *
+ * @param paths the paths
+ * @return the trie, free it with pathlib_trie_free
+ * @warning paths must not be `NULL`
+ */
+PATHLIB_API Pathlib_Trie* pathlib_trie_from_paths(const Paths* paths);
+/**
+ * @brief frees a trie
+ *
+ * @param trie the trie, it may be `NULL`
+ */
+PATHLIB_API void pathlib_trie_free(Pathlib_Trie* trie);
+/**
+ * @brief sets the value of a path
+ *
+ * @param trie the trie
+ * @param path the path, its parts are copied
+ * @param value the value
+ * @return 1 if the path didnt have a value before and 0 if it was replaced
+ * @warning trie and path must not be `NULL`
+ */
+PATHLIB_API int pathlib_trie_insert(Pathlib_Trie* trie, const Path* path, pathlib_u64 value);
+/**
+ * @brief gets the value of exactly path
+ *
+ * @param trie the trie
+ * @param path the path
+ * @param value where it will write the value, it may be `NULL`
+ * @return 1 if the path has a value and 0 otherwise
+ * @warning trie and path must not be `NULL`
+ */
+PATHLIB_API int pathlib_trie_get(const Pathlib_Trie* trie, const Path* path, PATHLIB_NULLABLE pathlib_u64* value);
+/**
+ * @brief finds the longest path inside the trie that is a prefix of path (or path itself)
+ *
+ * @param trie the trie
+ * @param path the path
+ * @param value where it will write the value of the prefix, it may be `NULL`
+ * @param prefix_size where it will write how many parts of path the prefix has, it may be `NULL`
+ * @return 1 if a prefix was found and 0 otherwise
+ * @warning trie and path must not be `NULL`
+ */
+PATHLIB_API int pathlib_trie_longest_prefix(const Pathlib_Trie* trie, const Path* path, PATHLIB_NULLABLE pathlib_u64* value, PATHLIB_NULLABLE size_t* prefix_size);
+/**
+ * @brief calls callback for prefix and every path under it that has a value
+ *
+ * @param trie the trie
+ * @param prefix the root of the subtree
+ * @param callback the function that is called for every value
+ * @param userdata passed to callback
+ * @return how many values were visited
+ * @warning trie, prefix and callback must not be `NULL`
+ */
+PATHLIB_API size_t pathlib_trie_subtree(const Pathlib_Trie* trie, const Path* prefix, Pathlib_Trie_Callback callback, void* userdata);
+/**
+ * @brief stores the trie into a single buffer that can be written to a file and mmap'd
+ *
+ * The buffer has no pointers and it is queried in place with the
+ * pathlib_trie_frozen_* functions. It uses the byte order of the machine
+ * that created it.
+ *
+ * @param trie the trie
+ * @param size where it will write the size of the buffer
+ * @return the buffer, free it with PATHLIB_FREE
+ * @warning trie and size must not be `NULL`
+ */
+PATHLIB_API unsigned char* pathlib_trie_freeze(const Pathlib_Trie* trie, size_t* size);
+/**
+ * @brief validates a frozen trie
+ *
+ * The lookups only check the header, data that doesnt come from
+ * pathlib_trie_freeze on the same machine must pass this once before it is used.
+ *
+ * @param data the frozen trie, aligned to 8 bytes
+ * @param size the size of data
+ * @return 1 if it is valid and 0 otherwise
+ * @warning data must not be `NULL`
+ */
+PATHLIB_API int pathlib_trie_frozen_check(const void* data, size_t size);
+/**
+ * @brief like pathlib_trie_get but for a frozen trie
+ *
+ * @see pathlib_trie_get pathlib_trie_freeze
+ */
+PATHLIB_API int pathlib_trie_frozen_get(const void* data, size_t size, const Path* path, PATHLIB_NULLABLE pathlib_u64* value);
+/**
+ * @brief like pathlib_trie_longest_prefix but for a frozen trie
+ *
+ * @see pathlib_trie_longest_prefix pathlib_trie_freeze
+ */
+PATHLIB_API int pathlib_trie_frozen_longest_prefix(const void* data, size_t size, const Path* path, PATHLIB_NULLABLE pathlib_u64* value, PATHLIB_NULLABLE size_t* prefix_size);
+/**
+ * @brief like pathlib_trie_subtree but for a frozen trie
+ *
+ * @see pathlib_trie_subtree pathlib_trie_freeze
+ */
+PATHLIB_API size_t pathlib_trie_frozen_subtree(const void* data, size_t size, const Path* prefix, Pathlib_Trie_Callback callback, void* userdata);
+/**
+ * @brief creates an empty path tree
+ *
+ * @return the tree, free it with pathlib_path_tree_free
+ */
+PATHLIB_API Pathlib_Path_Tree* pathlib_path_tree_new(void);
+/**
+ * @brief frees a path tree
+ *
+ * @param tree the tree, it may be `NULL`
+ */
+PATHLIB_API void pathlib_path_tree_free(Pathlib_Path_Tree* tree);
+/**
+ * @brief how many entries are inside the tree
+ *
+ * @param tree the tree
+ * @return the count of entries
+ * @warning tree must not be `NULL`
+ */
+PATHLIB_API size_t pathlib_path_tree_size(const Pathlib_Path_Tree* tree);
+/**
+ * @brief gets the node of the child name of parent, creating it when it doesnt exist
+ *
+ * @param tree the tree
+ * @param parent a node, PATHLIB_PATH_TREE_ROOT for the empty path
+ * @param name the name of the child, it is copied
+ * @return the node of the child
+ * @warning tree and name must not be `NULL`
+ */
+PATHLIB_API size_t pathlib_path_tree_node(Pathlib_Path_Tree* tree, size_t parent, const char* name);
+/**
+ * @brief gets the node of a path, creating the nodes that dont exist
+ *
+ * @param tree the tree
+ * @param path the path
+ * @return the node of the path
+ * @warning tree and path must not be `NULL`
+ */
+PATHLIB_API size_t pathlib_path_tree_node_of(Pathlib_Path_Tree* tree, const Path* path);
+/**
+ * @brief appends the path of a node to the entries
+ *
+ * @param tree the tree
+ * @param node the node
+ * @return the index of the entry
+ * @warning tree must not be `NULL`
+ */
+PATHLIB_API size_t pathlib_path_tree_push(Pathlib_Path_Tree* tree, size_t node);
+/**
+ * @brief appends a path to the entries
+ *
+ * @param tree the tree
+ * @param path the path, only the parts that are not inside the tree already are copied
+ * @return the index of the entry
+ * @warning tree and path must not be `NULL`
+ */
+PATHLIB_API size_t pathlib_path_tree_add(Pathlib_Path_Tree* tree, const Path* path);
+/**
+ * @brief builds the Path of an entry
+ *
+ * @param tree the tree
+ * @param index the index of the entry
+ * @return the path, its parts point inside the tree so they are only valid until the tree is modified or freed, free it with pathlib_destroy
+ * @warning tree must not be `NULL`
+ */
+PATHLIB_API Path pathlib_path_tree_get(const Pathlib_Path_Tree* tree, size_t index);
+/**
+ * @brief renders the path of an entry into buffer
+ *
+ * @param tree the tree
+ * @param index the index of the entry
+ * @param buffer the buffer
+ * @param buffer_size the capacity of the buffer
+ * @return 1 on success and 0 if it didnt fit
+ * @warning tree and buffer must not be `NULL`
+ */
+PATHLIB_API int pathlib_path_tree_render(const Pathlib_Path_Tree* tree, size_t index, char* buffer, size_t buffer_size);
+/**
+ * @brief like pathlib_rglob but the results are stored inside a Pathlib_Path_Tree
+ *
+ * @param path the directory that it will search
+ * @param pattern the pattern that the names of the files must match
+ * @return the tree, free it with pathlib_path_tree_free
+ * @note symlinks are not followed
+ * @note sets pathlib_error to PATHLIB_NEXISTS or PATHLIB_OSERROR in case of error
+ * @warning path and pattern must not be `NULL`
+ */
+PATHLIB_API Pathlib_Path_Tree* pathlib_rglob_tree(const Path* path, const char* pattern);
+/**
+ * @brief serializes paths into a compact binary buffer
+ *
+ * The paths are sorted part by part and every path only stores what it
+ * doesnt share with the previous one, a full path is stored every
+ * PATHLIB_PATHS_RESTART_INTERVAL entries so the buffer can be searched
+ * without decoding all of it. The format doesnt depend on the machine.
+ *
+ * @param paths the paths, duplicates are kept
+ * @param size where it will write the size of the buffer
+ * @return the buffer, free it with PATHLIB_FREE
+ * @warning paths and size must not be `NULL`
+ */
+PATHLIB_API unsigned char* pathlib_paths_serialize(const Paths* paths, size_t* size);
+/**
+ * @brief decodes a buffer from pathlib_paths_serialize
+ *
+ * @param data the buffer
+ * @param size the size of data
+ * @return the paths in sorted order, the parts of every path are a single allocation that starts at parts[0]
+ * @note sets pathlib_error to PATHLIB_OSERROR if the data is corrupted
+ * @warning data must not be `NULL`
+ */
+PATHLIB_API Paths pathlib_paths_deserialize(const void* data, size_t size);
+/**
+ * @brief validates a buffer from pathlib_paths_serialize
+ *
+ * The lookups never read out of bounds but they only give correct results
+ * for valid data, data that comes from untrusted sources must pass this once.
+ *
+ * @param data the buffer
+ * @param size the size of data
+ * @return 1 if it is valid and 0 otherwise
+ * @warning data must not be `NULL`
+ */
+PATHLIB_API int pathlib_paths_serialized_check(const void* data, size_t size);
+/**
+ * @brief how many paths a buffer from pathlib_paths_serialize holds
+ *
+ * @param data the buffer
+ * @param size the size of data
+ * @return the count of paths, 0 if data is not a serialized Paths
+ * @warning data must not be `NULL`
+ */
+PATHLIB_API size_t pathlib_paths_serialized_count(const void* data, size_t size);
+/**
+ * @brief decodes the index-th path of a buffer from pathlib_paths_serialize
+ *
+ * @param data the buffer
+ * @param size the size of data
+ * @param index the index of the path in sorted order
+ * @param path where it will write the path, its parts are a single allocation that starts at parts[0]
+ * @return 1 on success and 0 if index is out of range or the data is corrupted
+ * @warning data and path must not be `NULL`
+ */
+PATHLIB_API int pathlib_paths_serialized_get(const void* data, size_t size, size_t index, Path* path);
+/**
+ * @brief binary searches a buffer from pathlib_paths_serialize
+ *
+ * @param data the buffer
+ * @param size the size of data
+ * @param path the path that it will search for
+ * @param index where it will write the index of the first path that is not smaller than path
+ * @return 1 if path was found and 0 otherwise
+ * @warning data and path must not be `NULL`
+ */
+PATHLIB_API int pathlib_paths_serialized_find(const void* data, size_t size, const Path* path, PATHLIB_NULLABLE size_t* index);
+/**
+ * @brief creates an empty intern pool
+ *
+ * @return the pool, free it with pathlib_intern_pool_free
+ */
+PATHLIB_API Pathlib_Intern_Pool* pathlib_intern_pool_new(void);
+/**
+ * @brief frees an intern pool and every string inside it
+ *
+ * @param pool the pool, it may be `NULL`
+ * @warning the parts of the paths that were built through the pool become invalid
+ */
+PATHLIB_API void pathlib_intern_pool_free(Pathlib_Intern_Pool* pool);
+/**
+ * @brief how many distinct strings are inside the pool
+ *
+ * @param pool the pool
+ * @return the count of strings
+ * @warning pool must not be `NULL`
+ */
+PATHLIB_API size_t pathlib_intern_pool_size(const Pathlib_Intern_Pool* pool);
+/**
+ * @brief returns the copy of part that lives inside the pool, adding it when it is not there
+ *
+ * @param pool the pool
+ * @param part the string
+ * @return the string inside the pool
+ * @warning pool and part must not be `NULL`
+ */
+PATHLIB_API const char* pathlib_intern(Pathlib_Intern_Pool* pool, const char* part);
+/**
+ * @brief makes every part of path point inside the pool
+ *
+ * @param pool the pool
+ * @param path the path, the strings that its parts pointed to are not freed
+ * @warning pool and path must not be `NULL`
+ */
+PATHLIB_API void pathlib_intern_path(Pathlib_Intern_Pool* pool, Path* path);
+/**
+ * @brief like pathlib_from_str but the parts point inside the pool
+ *
+ * @param pool the pool
+ * @param str the string
+ * @return the path, free it with pathlib_destroy
+ * @warning pool and str must not be `NULL`
+ */
+PATHLIB_API Path pathlib_from_str_interned(Pathlib_Intern_Pool* pool, const char* str);
+/**
+ * @brief compares two paths whose parts come from the same pool
+ *
+ * @param a the first path
+ * @param b the second path
+ * @return 1 if they are equal and 0 otherwise
+ * @note it compares pointers, paths from different pools or from no pool are not equal even with the same parts
+ * @warning a and b must not be `NULL`
+ */
+PATHLIB_API int pathlib_interned_equal(const Path* a, const Path* b);
+/**
+ * @brief like pathlib_listdir but the parts of the results point inside the pool
+ *
+ * @param pool the pool
+ * @param path the directory
+ * @return the files, free every path with pathlib_destroy, the strings belong to the pool
+ * @note sets pathlib_error to PATHLIB_NEXISTS or PATHLIB_OSERROR in case of error
+ * @warning pool and path must not be `NULL`
+ */
+PATHLIB_API Paths pathlib_listdir_interned(Pathlib_Intern_Pool* pool, const Path* path);
+/**
+ * @brief like pathlib_rglob but the parts of the results point inside the pool
+ *
+ * @param pool the pool
+ * @param path the directory that it will search
+ * @param pattern the pattern that the names of the files must match
+ * @return the files, free every path with pathlib_destroy, the strings belong to the pool
+ * @note symlinks are not followed
+ * @note sets pathlib_error to PATHLIB_NEXISTS or PATHLIB_OSERROR in case of error
+ * @note they results are not sorted
+ * @warning pool, path and pattern must not be `NULL`
+ */
+PATHLIB_API Paths pathlib_rglob_interned(Pathlib_Intern_Pool* pool, const Path* path, const char* pattern);
+/**
+ * @brief sorts paths in place
+ *
+ * Every path is turned into a key once and the keys are sorted with an MSD
+ * radix sort, so no path is rendered and nothing is allocated per comparison.
+ *
+ * @param paths the paths
+ * @param order a Pathlib_Sort_Order, optionally combined with PATHLIB_SORT_PARALLEL
+ * @warning paths must not be `NULL`
+ */
+PATHLIB_API void pathlib_paths_sort(Paths* paths, int order);
+/**
+ * @brief computes a set operation over two sorted lists with a single merge
+ *
+ * @param a the first list
+ * @param b the second list
+ * @param op a Pathlib_Set_Op
+ * @param order the Pathlib_Sort_Order that both lists were sorted with by pathlib_paths_sort
+ * @return the paths in the same order, every path appears once, their parts point to the same strings as the parts of a and b, free every path with pathlib_destroy
+ * @warning a and b must not be `NULL`
+ * @warning a and b must be sorted with order, otherwise the result is meaningless
+ */
+PATHLIB_API Paths pathlib_paths_set_op(const Paths* a, const Paths* b, int op, int order);
+/**
+ * @brief like pathlib_paths_set_op but for lists that are not sorted, b is loaded into a Pathlib_Path_Set
+ *
+ * @param a the first list
+ * @param b the second list
+ * @param op a Pathlib_Set_Op
+ * @return the paths of a and then the paths of b in their original order, every path appears once, their parts point to the same strings as the parts of a and b, free every path with pathlib_destroy
+ * @warning a and b must not be `NULL`
+ */
+PATHLIB_API Paths pathlib_paths_set_op_unsorted(const Paths* a, const Paths* b, int op);
+/**
+ * @brief computes the path that leads from base to path
+ *
+ * It only looks at the parts, nothing is rendered and the filesystem is not
+ * touched, so symlinks are not resolved. Empty and `.` parts after the
+ * common prefix are skipped.
+ *
+ * @param path the path
+ * @param base the directory that the result is relative to
+ * @param walk_up when it is not 0 the parts of base that path doesnt share become `..`, otherwise path must be inside base
+ * @param result where it will write the path, `.` when path is base, its parts point to the parts of path or to static strings, free it with pathlib_destroy
+ * @return 1 on success and 0 if path is not inside base (without walk_up), one of them is absolute and the other isnt, they are on different roots or base has a `..` part that would have to be walked up
+ * @warning path, base and result must not be `NULL`
+ */
+PATHLIB_API int pathlib_relative_to(const Path* path, const Path* base, int walk_up, Path* result);
+/**
+ * @brief the longest path that every path inside paths starts with
+ *
+ * The parts are compared in one pass over the list and the pass stops as
+ * soon as nothing is shared anymore.
+ *
+ * @param paths the paths
+ * @return the common path, an empty path when they share nothing or paths is empty, its parts point to the parts of the first path, free it with pathlib_destroy
+ * @warning paths must not be `NULL`
+ */
+PATHLIB_API Path pathlib_common_path(const Paths* paths);
+/**
+ * @brief like pathlib_from_str but the path is normalized while it is split
+ *
+ * @param str the string
+ * @return the normalized path, see pathlib_normalize
+ * @warning str must not be `NULL`
+ */
+PATHLIB_API Path pathlib_from_str_normalized(const char* str);
+/**
+ * @brief removes the redundant parts of a path in place
+ *
+ * Repeated and trailing separators and `.` parts are dropped and `..` removes
+ * the part before it, `..` at the root is dropped and leading `..` of a
+ * relative path are kept. It is purely lexical, `a/link/..` becomes `a` even
+ * if link is a symlink. The parts are moved inside the array so nothing is
+ * allocated, an empty relative path becomes `.`.
+ *
+ * @param path the path
+ * @warning path must not be `NULL`
+ */
+PATHLIB_API void pathlib_normalize(Path* path);
+/**
+ * @brief creates an empty resolve cache
+ *
+ * @return the cache, free it with pathlib_resolve_cache_free
+ */
+PATHLIB_API Pathlib_Resolve_Cache* pathlib_resolve_cache_new(void);
+/**
+ * @brief forgets everything that the cache knows by starting a new generation
+ *
+ * @param cache the cache
+ * @warning cache must not be `NULL`
+ */
+PATHLIB_API void pathlib_resolve_cache_invalidate(Pathlib_Resolve_Cache* cache);
+/**
+ * @brief frees a resolve cache
+ *
+ * @param cache the cache, it may be `NULL`
+ */
+PATHLIB_API void pathlib_resolve_cache_free(Pathlib_Resolve_Cache* cache);
+/**
+ * @brief makes the path absolute and resolves every symlink inside it
+ *
+ * The parts are resolved one at a time like realpath does, `..` is applied
+ * after the symlinks before it were resolved. Parts after the first one
+ * that doesnt exist are appended lexically. A cache lets many calls share
+ * the work for their common directories, it is not thread safe.
+ *
+ * @param path the path, relative paths are relative to the current directory
+ * @param cache the cache, it may be `NULL`
+ * @return the canonical path, an empty path in case of error
+ * @note sets pathlib_error to PATHLIB_OSERROR in case of error, eg a symlink loop
+ * @note on windows the path is only made absolute, symlinks are not resolved
+ * @warning path must not be `NULL`
+ */
+PATHLIB_API Path pathlib_resolve(const Path* path, PATHLIB_NULLABLE Pathlib_Resolve_Cache* cache);
+/**
+ * @brief reads and parses `/proc/self/mountinfo`
+ *
+ * @return the table, free it with pathlib_mount_table_free, `NULL` in case of error
+ * @note sets pathlib_error to PATHLIB_OSERROR in case of error
+ * @note the mount table is only available on linux
+ */
+PATHLIB_API Pathlib_Mount_Table* pathlib_mount_table_new(void);
+/**
+ * @brief reads the mount table again if it changed since the last read
+ *
+ * The kernel reports changes with a poll on the open file, so this is a
+ * single syscall when nothing changed. The mounts that were returned before
+ * are invalidated when it returns 1.
+ *
+ * @param table the table
+ * @return 1 if it was read again and 0 otherwise
+ * @note sets pathlib_error to PATHLIB_OSERROR in case of error, the old contents are kept
+ * @warning table must not be `NULL`
+ */
+PATHLIB_API int pathlib_mount_table_refresh(Pathlib_Mount_Table* table);
+/**
+ * @brief frees a mount table
+ *
+ * @param table the table, it may be `NULL`
+ */
+PATHLIB_API void pathlib_mount_table_free(Pathlib_Mount_Table* table);
+/**
+ * @param table the table
+ * @param size where it will write the count of mounts
+ * @return the mounts, in the order of the kernel
+ * @warning table and size must not be `NULL`
+ */
+PATHLIB_API const Pathlib_Mount* pathlib_mount_table_mounts(const Pathlib_Mount_Table* table, size_t* size);
+/**
+ * @brief finds the mount that contains path
+ *
+ * The lookup is lexical, it takes one step per part of path. A mount point
+ * that was mounted over refers to the mount that is on top.
+ *
+ * @param table the table
+ * @param path an absolute path without symlinks or `..`, eg the result of pathlib_resolve
+ * @return the mount, `NULL` if path is not absolute
+ * @warning table and path must not be `NULL`
+ */
+PATHLIB_API const Pathlib_Mount* pathlib_mount_of(const Pathlib_Mount_Table* table, const Path* path);
+/**
+ * @brief checks whether path is a mount point
+ *
+ * unlike pathlib_is_mount this doesnt touch the filesystem and it finds bind
+ * mounts of a directory on the same device
+ *
+ * @param table the table
+ * @param path an absolute path without symlinks or `..`, eg the result of pathlib_resolve
+ * @warning table and path must not be `NULL`
+ */
+PATHLIB_API int pathlib_mount_table_is_mount(const Pathlib_Mount_Table* table, const Path* path);
+/**
+ * @brief the type of the filesystem that contains path
+ *
+ * @param table the table
+ * @param path an absolute path without symlinks or `..`, eg the result of pathlib_resolve
+ * @return the type, eg `ext4` or `nfs4`, `NULL` if path is not absolute
+ * @warning table and path must not be `NULL`
+ */
+PATHLIB_API const char* pathlib_fs_type(const Pathlib_Mount_Table* table, const Path* path);
+/**
+ * @brief gets the capacity and the flags of the filesystem that contains path
+ *
+ * It is a single statfs call on linux and statvfs on other posix systems.
+ *
+ * @param path a file or directory on the filesystem
+ * @param info where it will write the result
+ * @return 1 on success and 0 otherwise
+ * @note sets pathlib_error to PATHLIB_NEXISTS or PATHLIB_OSERROR in case of error
+ * @note on windows magic is 0 and only PATHLIB_FS_READ_ONLY is reported
+ * @warning path and info must not be `NULL`
+ */
+PATHLIB_API int pathlib_fs_info(const Path* path, Pathlib_Fs_Info* info);
+/**
+ * @brief starts a pool of threads
+ *
+ * @param workers the count of threads, 0 for one per core
+ * @return the executor, free it with pathlib_executor_free, `NULL` if no thread could be started
+ * @note sets pathlib_error to PATHLIB_OSERROR in case of error
+ * @note with PATHLIB_NO_THREADS no thread is started and the tasks run inside pathlib_executor_submit
+ */
+PATHLIB_API Pathlib_Executor* pathlib_executor_new(size_t workers);
+/**
+ * @brief creates an executor that runs its tasks on an existing thread pool
+ *
+ * The priority is handed to the pool, cancellation and pathlib_executor_wait
+ * work like for pathlib_executor_new.
+ *
+ * @param callbacks the pool, it is copied
+ * @return the executor, free it with pathlib_executor_free
+ * @warning callbacks and callbacks->submit must not be `NULL`
+ */
+PATHLIB_API Pathlib_Executor* pathlib_executor_from_callbacks(const Pathlib_Executor_Callbacks* callbacks);
+/**
+ * @brief runs every task that was submitted, stops the threads and frees the executor
+ *
+ * @param executor the executor, it may be `NULL`
+ * @warning it must not be the default executor anymore and it must not be called from a task
+ */
+PATHLIB_API void pathlib_executor_free(Pathlib_Executor* executor);
+/**
+ * @param executor the executor
+ * @return how many threads run its tasks
+ * @warning executor must not be `NULL`
+ */
+PATHLIB_API size_t pathlib_executor_workers(const Pathlib_Executor* executor);
+/**
+ * @brief queues a task
+ *
+ * A task that is submitted from a worker goes to the deque of that worker,
+ * tasks from other threads are spread over the workers.
+ *
+ * @param executor the executor
+ * @param func the function of the task
+ * @param arg given to func
+ * @param priority a Pathlib_Task_Priority
+ * @return 1 if it was queued and 0 if the pool refused it, then func is not called
+ * @warning executor and func must not be `NULL`
+ */
+PATHLIB_API int pathlib_executor_submit(Pathlib_Executor* executor, Pathlib_Task_Func func, void* arg, int priority);
+/**
+ * @brief cancels every task that was submitted and didnt start yet
+ *
+ * The cancelled tasks are still called, with cancelled set to 1, so they can
+ * release their arg. Tasks that already run are not interrupted and the
+ * parallel functions of pathlib just do their remaining work on the calling
+ * thread.
+ *
+ * @param executor the executor
+ * @warning executor must not be `NULL`
+ */
+PATHLIB_API void pathlib_executor_cancel(Pathlib_Executor* executor);
+/**
+ * @brief waits until every task that was submitted returned
+ *
+ * @param executor the executor
+ * @warning executor must not be `NULL` and it must not be called from a task
+ */
+PATHLIB_API void pathlib_executor_wait(Pathlib_Executor* executor);
+/**
+ * @brief sets the executor that the parallel functions use
+ *
+ * The parallel functions are pathlib_file_digest with PATHLIB_DIGEST_TREE,
+ * pathlib_find_duplicates, pathlib_disk_usage and pathlib_paths_sort with
+ * PATHLIB_SORT_PARALLEL. Without an executor every call starts and joins
+ * its own threads. The calling thread always does part of the work, so a
+ * parallel function can be called from a task.
+ *
+ * @param executor the executor, `NULL` to go back to threads per call
+ * @warning it must not be changed while a parallel function runs
+ */
+PATHLIB_API void pathlib_executor_set_default(PATHLIB_NULLABLE Pathlib_Executor* executor);
+/**
+ * @brief return names of files that match the pattern
+ *
+ * @param path the path that it will search
+ * @param pattern the pattern that will try to match
+ * @return the files that match the pattern inside the path directory
+ * @note pathlib_glob is not recursive and does not support `**\/`, for recursive globbing check @ref pathlib_rglob
+ * @note sets pathlib_error to PATHLIB_NEXISTS or PATHLIB_OSERROR
+ * @note they results are not sorted
+ * @warning path and pattern must not be `NULL`
+ */
+PATHLIB_API Paths pathlib_glob(const Path* path, const char* pattern);
+/**
+ * @brief return names of files that match the pattern recursivly
+ *
+ * Symlinks to directories are followed, a link back to one of its own parents is skipped.
+ *
+ * @param path the path that it will search
+ * @param pattern the pattern that will try to match
+ * @return the files that match the pattern inside the path directory
+ * @warning path and pattern must not be `NULL`
+ * @note sets pathlib_error to PATHLIB_NEXISTS or PATHLIB_OSERROR
+ * @note they results are not sorted
+ */
+PATHLIB_API Paths pathlib_rglob(const Path* path, const char* pattern);
+/**
+ * @brief like pathlib_rglob but with options for symlinks, filesystems and the depth
+ *
+ * @param path the path that it will search
+ * @param pattern the pattern that will try to match
+ * @param options how it descends
+ * @return the files that match the pattern inside the path directory
+ * @note sets pathlib_error to PATHLIB_NEXISTS or PATHLIB_OSERROR
+ * @note on windows PATHLIB_WALK_ONE_FILESYSTEM is ignored and linked directories are only entered with PATHLIB_WALK_FOLLOW_SYMLINKS
+ * @warning path, pattern and options must not be `NULL`
+ */
+PATHLIB_API Paths pathlib_rglob_ex(const Path* path, const char* pattern, const Pathlib_Walk_Options* options);
+/**
+ * @brief matches entries whose name matches a glob pattern
+ *
+ * @param pattern the pattern, like in pathlib_glob
+ * @return the query
+ * @warning pattern must not be `NULL`
+ */
+PATHLIB_API Pathlib_Query* pathlib_query_name(const char* pattern);
+/**
+ * @brief matches entries whose depth is inside [min, max], the root is at depth 0
+ *
+ * @param min the minimum depth
+ * @param max the maximum depth, directories deeper than it are not listed at all
+ * @return the query
+ */
+PATHLIB_API Pathlib_Query* pathlib_query_depth(size_t min, size_t max);
+/**
+ * @brief matches entries of one type
+ *
+ * @param type a Pathlib_Entry_Type, symlinks are not followed
+ * @return the query
+ */
+PATHLIB_API Pathlib_Query* pathlib_query_type(int type);
+/**
+ * @brief matches entries whose size in bytes is inside [min, max]
+ *
+ * @param min the minimum size
+ * @param max the maximum size, (pathlib_u64)-1 for no limit
+ * @return the query
+ */
+PATHLIB_API Pathlib_Query* pathlib_query_size(pathlib_u64 min, pathlib_u64 max);
+/**
+ * @brief matches entries whose modification time is inside [min, max]
+ *
+ * @param min the oldest time, in seconds since the epoch
+ * @param max the newest time, in seconds since the epoch
+ * @return the query
+ */
+PATHLIB_API Pathlib_Query* pathlib_query_mtime(pathlib_u64 min, pathlib_u64 max);
+/**
+ * @brief matches entries for which (mode & mask) == bits
+ *
+ * @param mask the permission bits that are checked, eg 0111
+ * @param bits the value that they must have
+ * @return the query
+ */
+PATHLIB_API Pathlib_Query* pathlib_query_perm(unsigned int mask, unsigned int bits);
+/**
+ * @brief matches entries that are owned by a user
+ *
+ * @param uid the user id
+ * @return the query
+ * @note on windows every entry is owned by 0
+ */
+PATHLIB_API Pathlib_Query* pathlib_query_owner(unsigned long uid);
+/**
+ * @brief matches entries that match both queries
+ *
+ * @param left the first query, it is owned by the result
+ * @param right the second query, it is owned by the result
+ * @return the query
+ * @warning left and right must not be `NULL`
+ */
+PATHLIB_API Pathlib_Query* pathlib_query_and(Pathlib_Query* left, Pathlib_Query* right);
+/**
+ * @brief matches entries that match any of the queries
+ *
+ * @param left the first query, it is owned by the result
+ * @param right the second query, it is owned by the result
+ * @return the query
+ * @warning left and right must not be `NULL`
+ */
+PATHLIB_API Pathlib_Query* pathlib_query_or(Pathlib_Query* left, Pathlib_Query* right);
+/**
+ * @brief matches entries that dont match the query
+ *
+ * @param query the query, it is owned by the result
+ * @return the query
+ * @warning query must not be `NULL`
+ */
+PATHLIB_API Pathlib_Query* pathlib_query_not(Pathlib_Query* query);
+/**
+ * @brief frees a query and every query inside it
+ *
+ * @param query the query, it may be `NULL`
+ */
+PATHLIB_API void pathlib_query_free(Pathlib_Query* query);
+/**
+ * @brief finds the entries under root that match query, like find
+ *
+ * The tree is walked once. Name and depth checks are evaluated before the
+ * ones that need the entry to be stat'ed, which only happens when a check
+ * needs a field that readdir didnt return, and directories deeper than the
+ * depth bounds of the query are not listed. The root itself is the entry at
+ * depth 0 and it is the only symlink that is followed.
+ *
+ * @param root the directory that it will search
+ * @param query the query
+ * @return the paths that matched
+ * @note sets pathlib_error to PATHLIB_NEXISTS or PATHLIB_OSERROR in case of error, directories that couldnt be read are skipped
+ * @warning root and query must not be `NULL`
+ */
+PATHLIB_API Paths pathlib_find(const Path* root, const Pathlib_Query* query);
+/**
+ * @brief aggregates the entries under root that match query without keeping them
+ *
+ * It walks the tree like pathlib_find but only keeps a count, a sum and a
+ * heap of at most k entries, so the memory doesnt grow with the tree.
+ *
+ * @param root the directory that it will search
+ * @param query the query or `NULL` to aggregate every entry, including the root
+ * @param flags Pathlib_Aggregate_Flags, PATHLIB_AGGREGATE_TOP_SIZE and PATHLIB_AGGREGATE_TOP_MTIME are exclusive
+ * @param k how many entries the top keeps
+ * @param result where it will write the result, free it with pathlib_aggregate_free
+ * @return 1 on success and 0 if root doesnt exist
+ * @note sets pathlib_error to PATHLIB_NEXISTS or PATHLIB_OSERROR in case of error, directories that couldnt be read are skipped
+ * @warning root and result must not be `NULL`
+ */
+PATHLIB_API int pathlib_aggregate(const Path* root, PATHLIB_NULLABLE const Pathlib_Query* query, int flags, size_t k, Pathlib_Aggregate* result);
+/**
+ * @brief frees the result of pathlib_aggregate
+ *
+ * @param result the result
+ * @warning result must not be `NULL`
+ */
+PATHLIB_API void pathlib_aggregate_free(Pathlib_Aggregate* result);
+/**
+ * @brief it adds a new path to a Paths struct
+ *
+ * @param paths the struct that it will add the path
+ * @param path the path that it will add to paths
+ * @warning path must not be `NULL`
+ */
+PATHLIB_API void pathlib_paths_add(Paths* paths, const Path path);
+/**
+ * @brief it removes the i-th element from paths
+ *
+ * @param paths the struct that it will remove the element from
+ * @param i the index of the element that it will delete
+ * @warning paths must not be `NULL` and paths->size > i
+ */
+PATHLIB_API void pathlib_paths_pop(Paths* paths, size_t i);
+/**
+ * @brief it deallocates the contents of paths->paths and zero it out
+ *
+ * @param paths the struct that it will clean up
+ * @warning paths must not be `NULL`
+ */
+PATHLIB_API void pathlib_paths_free(Paths* paths);
+
+#endif /* _PATHLIB_C_H_ */
+
+#ifdef PATHLIB_IMPLEMENTATION
+
+Pathlib_Error pathlib_error = PATHLIB_NONE;
+
+void pathlib_print_error(const char *fmt, ...) {
+    va_list args;
+
+    fprintf(stderr, "[ERROR] ");
     va_start(args, fmt);
     vfprintf(stderr, fmt, args);
     va_end(args);
     fprintf(stderr, "\n");
 }
 
-#ifdef _WIN32
-    #define pathlib_print_os_error(failed_function_name, pathname) pathlib_print_error(failed_function_name" failed for `%s`: %zu", pathname, GetLastError())
-    #define pathlib_print_func_failed(failed_function_name) pathlib_print_error(failed_function_name" failed: %zu", GetLastError())
-#else /* _WIN32 */
-    #define pathlib_print_os_error(failed_function_name, pathname) pathlib_print_error(failed_function_name" failed for `%s`: %s", pathname, strerror(errno))
-    #define pathlib_print_func_failed(failed_function_name) pathlib_print_error(failed_function_name" failed: %s", strerror(errno))
-#endif /* _WIN32 */
+#ifdef _WIN32
+    #define pathlib_print_os_error(failed_function_name, pathname) pathlib_print_error(failed_function_name" failed for `%s`: %zu", pathname, GetLastError())
+    #define pathlib_print_func_failed(failed_function_name) pathlib_print_error(failed_function_name" failed: %zu", GetLastError())
+#else /* _WIN32 */
+    #define pathlib_print_os_error(failed_function_name, pathname) pathlib_print_error(failed_function_name" failed for `%s`: %s", pathname, strerror(errno))
+    #define pathlib_print_func_failed(failed_function_name) pathlib_print_error(failed_function_name" failed: %s", strerror(errno))
+#endif /* _WIN32 */
+
+void* pathlib___malloc(size_t size, const char* file, size_t line) {
+    void* region = PATHLIB_MALLOC(size);
+    if (region) {
+        return region;
+    }
+    
+    fprintf(stderr, "[FATAL] out of memory at %s:%lu", file, (unsigned long int)line);
+    abort();
+}
+#define pathlib__malloc(size) pathlib___malloc(size, __FILE__, __LINE__)
+
+PATHLIB_API Path pathlib_cwd(void) {
+    char* cwd_buff;
+    size_t size;
+
+    pathlib_error = PATHLIB_NONE;
+    
+    #ifdef _WIN32
+        size = GetCurrentDirectory(0, NULL);
+        if (size == 0) {
+            pathlib_print_func_failed("GetCurrentDirectory");
+            pathlib_error = PATHLIB_OSERROR;
+            return pathlib_from_str(".");
+        }
+
+        cwd_buff = (char*)pathlib__malloc(size * sizeof(char));
+
+        if (GetCurrentDirectory(size, cwd_buff) == 0) {
+            pathlib_print_func_failed("GetCurrentDirectory");
+            pathlib_error = PATHLIB_OSERROR;
+            return pathlib_from_str(".");
+        }
+    #else
+        size = 8;
+        cwd_buff = (char*)pathlib__malloc(size * sizeof(char));
+
+        while (getcwd(cwd_buff, size) == NULL) {
+            if (errno == ERANGE) {
+                size *= 2;
+                PATHLIB_FREE(cwd_buff);
+                cwd_buff = (char*)pathlib__malloc(size * sizeof(char));
+            } else {
+                pathlib_print_func_failed("getcwd");
+                pathlib_error = PATHLIB_OSERROR;
+                return pathlib_from_str(".");
+            }
+        }
+    #endif
+
+    return pathlib_from_str(cwd_buff);
+}
+
+PATHLIB_API Path pathlib_home(void) {
+    char* home_dir = NULL;
+
+    #ifdef _WIN32
+        char* home_drive, *home_path;
+        size_t size;
+        
+        pathlib_error = PATHLIB_NONE;
+        
+        home_dir = getenv("USERPROFILE");
+        if (home_dir && strlen(home_dir) > 0) {
+            return pathlib_from_str(home_dir);
+        }
+
+        home_drive = getenv("HOMEDRIVE");
+        home_path = getenv("HOMEPATH");
+        if (home_drive && home_path) {
+            size = strlen(home_drive) + strlen(home_path) + 1;
+            home_dir = (char*)pathlib__malloc(size * sizeof(char));
+            sprintf(home_dir, "%s%s", home_drive, home_path);
+            return pathlib_from_str(home_dir);
+        }
+
+    #else
+        struct passwd* pw;
+
+        pathlib_error = PATHLIB_NONE;
+        
+        home_dir = getenv("HOME");
+        if (home_dir && strlen(home_dir) > 0) {
+            return pathlib_from_str(home_dir);
+        }
+
+        pw = getpwuid(getuid());
+        if (pw && pw->pw_dir) {
+            return pathlib_from_str(pw->pw_dir);
+        }
+    #endif
+
+    pathlib_print_error("failed to determine the home directory");
+    pathlib_error = PATHLIB_OSERROR;
+    return pathlib_from_str(".");
+}
+
+PATHLIB_API Path pathlib_temp(void) {
+    char* temp_dir = NULL;
+    
+    #ifdef _WIN32
+        DWORD size = GetTempPath(0, NULL);
+        
+        pathlib_error = PATHLIB_NONE;
+        
+        if (size == 0) {
+            pathlib_print_func_failed("GetTempPath");
+            pathlib_error = PATHLIB_OSERROR;
+            return pathlib_from_str("./tmp");
+        }
+
+        temp_dir = (char*)pathlib__malloc(size * sizeof(char));
+
+        if (GetTempPath(size, temp_dir) == 0) {
+            pathlib_print_func_failed("GetTempPath");
+            pathlib_error = PATHLIB_OSERROR;
+            return pathlib_from_str("./tmp");
+        }
+        return pathlib_from_str(temp_dir);
+    #else
+        size_t i;
+        const char* env_vars[] = {"TMPDIR", "TEMP", "TMP"};
+        
+        pathlib_error = PATHLIB_NONE;
+        
+        for (i = 0; i < sizeof(env_vars) / sizeof(env_vars[0]); i++) {
+            temp_dir = getenv(env_vars[i]);
+            if (temp_dir && strlen(temp_dir) > 0) {
+                return pathlib_from_str(temp_dir);
+            }
+        }
+
+        return pathlib_from_str("/tmp");
+    #endif
+}
+
+PATHLIB_API Path pathlib_from_str(const char* instr) {
+    char* start, *temp;
+    size_t instr_len, part_count;
+    char* str;
+    Path path;
+
+    PATHLIB_ASSERT(instr);
+
+    instr_len = strlen(instr);
+    str = memcpy(pathlib__malloc(instr_len + 1), instr, instr_len);
+    str[instr_len] = 0;
+    
+    part_count = 1;
+    for (temp = str; *temp; temp++) {
+        if (*temp == '\\' || *temp == '/') {
+            part_count++;
+        }
+    }
+    
+    path.parts = pathlib__malloc(sizeof(*path.parts) * part_count);
+    path.size = 0;
+    path.capacity = part_count;
+
+    start = str;
+    for (temp = str; ; temp++) {
+        if (*temp == '/' || *temp == '\\') {
+            size_t len = temp - start;
+            start[len] = 0;
+            path.parts[path.size++] = start;
+            start = temp + 1;
+            continue;
+        } else if (*temp == '\0') {
+            size_t len = temp - start;
+            start[len] = 0;
+            path.parts[path.size++] = start;
+            break;
+        }
+    }
+
+    return path;
+}
+
+PATHLIB_API void pathlib_add_part(Path* path, const char* part) {
+    void* temp;
+
+    PATHLIB_ASSERT(path);
+    PATHLIB_ASSERT(part);
+
+    if (path->size >= path->capacity) {
+        path->capacity = path->capacity == 0 ? 4 : (int)(path->capacity*1.5 + 1);
+        temp = pathlib__malloc(path->capacity * sizeof(*path->parts));
+        if (path->size > 0) {
+            memcpy(temp, path->parts, sizeof(*path->parts)*path->size);
+        }
+        PATHLIB_FREE(path->parts);
+        path->parts = temp;
+    }
+
+    path->parts[path->size++] = part;
+}
+
+PATHLIB_API void pathlib_destroy(Path* path) {
+    if (path) {
+        if (path->parts) {
+            PATHLIB_FREE(path->parts);
+            path->parts = 0;
+            path->size = 0;
+            path->capacity = 0;
+        }
+    }
+}
+
+PATHLIB_API Path pathlib_parent(const Path* path) {
+    Path ret;
+
+    PATHLIB_ASSERT(path);
+
+    if (path->size == 1) {
+        ret.parts = pathlib__malloc(sizeof(*path->parts) * 2);
+        ret.capacity = 2;
+        ret.size = 1;
+        ret.parts[0] = ".";
+    } else if (path->size > 0) {
+        ret.parts = pathlib__malloc(path->capacity * sizeof(*path->parts));
+        ret.capacity = path->capacity;
+        ret.size = path->size - 1;
+        memcpy(ret.parts, path->parts, (ret.size) * sizeof(*path->parts));
+    } else {
+        ret.parts = NULL;
+        ret.capacity = 0;
+        ret.size = 0;
+    }
+
+    return ret;
+}
+
+PATHLIB_API Paths pathlib_parents(const Path* path) {
+    Paths paths;
+    const Path* path_ref;
+    
+    size_t i;
+    
+    PATHLIB_ASSERT(path);
+    
+    paths.paths = NULL;
+    paths.size = 0;
+    paths.capacity = 0;
+        
+    if (path->size == 0) {
+        pathlib_paths_add(&paths, pathlib_from_str("."));
+        return paths;
+    }
+    
+    if (path->size == 1) {
+        pathlib_paths_add(&paths, pathlib_from_str("."));
+        return paths;
+    }
+    
+    path_ref = path;
+    for (i = 0; i < path->size; i++) {
+        pathlib_paths_add(&paths, pathlib_parent(path_ref));
+        path_ref = &paths.paths[i];
+    }
+    
+    return paths;
+}
+
+PATHLIB_API char* pathlib_suffix(const Path* path) {
+    size_t last_part_size, suffix_size;
+    const char* last_part;
+    char* suffix;
+
+    PATHLIB_ASSERT(path);
+
+    if (path->size == 0) {
+        return "";
+    }
+    last_part = path->parts[path->size-1];
+    last_part_size = strlen(last_part);
+    suffix_size = 0;
+
+    while (last_part_size > suffix_size) {
+        if (last_part[last_part_size - suffix_size] == '.') break;
+        suffix_size++;
+    }
+
+    if (*(last_part + (last_part_size - suffix_size)) != '.') {
+        return "";
+    }
+    suffix = pathlib__malloc(suffix_size + 1);
+    memcpy(suffix, last_part + (last_part_size - suffix_size), suffix_size);
+    suffix[suffix_size] = 0;
+
+    return suffix;
+}
+
+PATHLIB_API char** pathlib_suffixes(const Path* path, PATHLIB_NULLABLE size_t* suffix_count) {
+    size_t count, i, last_part_size, suffix_size;
+    char** suffixes;
+    char* suffix;
+    const char* last_part;
+    
+    (void) i;
+    (void) last_part_size;
+    
+    PATHLIB_ASSERT(path);
+    
+    if (path->size == 0) {
+        suffixes = pathlib__malloc(sizeof(*suffixes));
+        suffixes[0] = NULL;
+        if (suffix_count != NULL) {
+            suffix_count = 0;
+        }
+        return suffixes;
+    }
+    
+    last_part = path->parts[path->size - 1];
+    last_part_size = 0;
+    count = 0;
+    
+    while (*last_part) {
+        if (*last_part == '.') {
+            count += 1;
+        }
+        
+        last_part_size++;
+        last_part++;
+    }
+    
+    if (count == 0) {
+        suffixes = pathlib__malloc(sizeof(*suffixes));
+        suffixes[0] = NULL;
+        if (suffix_count != NULL) {
+            suffix_count = 0;
+        }
+        return suffixes;
+    }
+    
+    suffixes = pathlib__malloc(sizeof(*suffixes) * (count + 1));
+    suffixes[count] = NULL;
+    if (suffix_count) {
+        *suffix_count = count;
+    }
+    
+    suffix_size = 0;
+    i = 0;
+    while (count) {
+        if (*last_part == '.') {
+            count--;
+            suffix = pathlib__malloc(suffix_size + 1);
+            suffix[suffix_size] = 0;
+            memcpy(suffix, last_part, suffix_size);
+            suffixes[i] = suffix;
+            i++;
+            suffix_size = 1;
+        } else {
+            suffix_size++;
+        }
+        
+        last_part--;
+    }
+    
+    return suffixes;
+}
+
+PATHLIB_API void pathlib_with_suffix(Path* path, const char* new_suffix) {
+    size_t last_part_size, suffix_size;
+    const char* last_part;
+    char* suffix;
+    char* new_last_part;
+
+    PATHLIB_ASSERT(path);
+
+    if (path->size == 0) {
+        pathlib_add_part(path, new_suffix);
+        return;
+    }
+    last_part = path->parts[path->size-1];
+    last_part_size = strlen(last_part);
+    suffix_size = 0;
+
+    while (last_part_size > suffix_size) {
+        if (last_part[last_part_size - suffix_size] == '.') break;
+        suffix_size++;
+    }
+
+    if (*(last_part + (last_part_size - suffix_size)) != '.') {
+        new_last_part = pathlib__malloc(last_part_size + strlen(new_suffix) + 1);
+        memcpy(new_last_part, last_part, last_part_size);
+        memcpy(new_last_part + last_part_size, new_suffix, strlen(new_suffix));
+        
+        new_last_part[last_part_size + strlen(suffix)] = 0;
+        
+        path->parts[path->size-1] = new_last_part;
+        return;
+    }
+    
+    new_last_part = pathlib__malloc(last_part_size - suffix_size + strlen(new_suffix));
+    
+    memcpy(new_last_part, last_part, last_part_size - suffix_size);
+    memcpy(new_last_part + last_part_size - suffix_size, new_suffix, strlen(new_suffix));
+    
+    new_last_part[last_part_size - suffix_size + strlen(new_suffix)] = 0;
+    
+    path->parts[path->size-1] = new_last_part;
+    return;
+}
+
+PATHLIB_API char* pathlib_stem(const Path* path) {
+    size_t last_part_size, suffix_size;
+    const char* last_part;
+    char* region;
+
+    PATHLIB_ASSERT(path);
+
+    if (path->size == 0) {
+        return "";
+    }
+    last_part = path->parts[path->size-1];
+    last_part_size = strlen(last_part);
+    suffix_size = 0;
+
+    while (last_part_size > suffix_size) {
+        if (last_part[last_part_size - suffix_size] == '.') break;
+        suffix_size++;
+    }
+
+    if (*(last_part + (last_part_size - suffix_size)) != '.') {
+        return "";
+    }
+    region = pathlib__malloc(last_part_size - suffix_size + 1);
+    memcpy(region, last_part, last_part_size - suffix_size);
+    region[last_part_size - suffix_size] = 0;
+
+    return region;
+}
+
+PATHLIB_API char* pathlib_to_str(const Path* path) {
+    size_t total_size, i, p;
+    char* region;
+
+    PATHLIB_ASSERT(path);
+
+    total_size = 0;
+    for (i = 0; i < path->size; i++) {
+        total_size += strlen(path->parts[i]);
+    }
+
+    /* add n-1 extra bytes for the seperators */
+    if (path->size > 0) {
+        total_size += path->size - 1;
+    }
+    /* +1 for null terminator */
+    region = pathlib__malloc(total_size + 1);
+
+    if (path->size == 0) {
+        region[0] = 0;
+        return region;
+    }
+
+    p = 0;
+    for (i = 0; i < path->size; i++) {
+        memcpy(region+p, path->parts[i], strlen(path->parts[i]));
+        p += strlen(path->parts[i]);
+        region[p] = '/';
+        p += 1;
+    }
+    region[total_size] = 0;
+
+    return region;
+}
+
+int pathlib_render_str_to_buffer(const Path* path, char* buffer, size_t buffer_size) {
+    size_t i, str_size;
+    
+    PATHLIB_ASSERT(path);
+    PATHLIB_ASSERT(buffer);
+    
+    if (path->size == 0) {
+        if (buffer_size < 1) {
+            return 0;
+        }
+        buffer[0] = 0;
+        return 1;
+    }
+    
+    i = 0;
+    while (buffer_size > 0) {
+        str_size = strlen(path->parts[i]);
+        if (str_size > buffer_size) {
+            return 0;
+        }
+        memcpy(buffer, path->parts[i], str_size);
+        buffer += str_size;
+        buffer_size -= str_size;
+        
+        i++;
+        
+        if (i != path->size) {
+            if (buffer_size < 1) {
+                return 0;
+            }
+            buffer[0] = '/';
+            buffer++;
+            buffer_size--;
+        } else {
+            if (buffer_size < 1) {
+                return 0;
+            }
+            buffer[0] = 0;
+            return 1;
+        }
+    }
+    
+    return 0;
+}
+
+/* internal function so no safety */
+PATHLIB_API int pathlib__render_n_parts_to_buffer(const Path* path, char* buffer, size_t buffer_size, size_t n_parts) {
+    size_t i, str_size;
+        
+    PATHLIB_ASSERT(path);
+    PATHLIB_ASSERT(buffer);
+    
+    if (n_parts) {
+        if (buffer_size < 1) {
+            return 0;
+        }
+        buffer[0] = 0;
+        return 1;
+    }
+    
+    i = 0;
+    while (buffer_size > 0) {
+        str_size = strlen(path->parts[i]);
+        if (str_size > buffer_size) {
+            return 0;
+        }
+        memcpy(buffer, path->parts[i], str_size);
+        buffer += str_size;
+        buffer_size -= str_size;
+        
+        i++;
+        
+        if (i != n_parts) {
+            if (buffer_size < 1) {
+                return 0;
+            }
+            buffer[0] = '/';
+            buffer++;
+            buffer_size--;
+        } else {
+            if (buffer_size < 1) {
+                return 0;
+            }
+            buffer[0] = 0;
+            return 1;
+        }
+    }
+    
+    return 0;
+}
+
+PATHLIB_API int pathlib_exists(const Path* path) {
+    char filename[PATHLIB_MAX_PATH];
+    /* if it cant be rendered in a buffer that holds the system limit for a path then it doesnt exist */
+    if (!pathlib_render_str_to_buffer(path, filename, PATHLIB_ARRSIZE(filename))) {
+        return 0;
+    }
+    #ifdef _WIN32
+        return GetFileAttributesA(filename) != INVALID_FILE_ATTRIBUTES;
+    #else /* _WIN32 */
+        return access(filename, F_OK) == 0;
+    #endif /* _WIN32 */
+}
+
+PATHLIB_API int pathlib_is_file(const Path* path) {
+    char filename[PATHLIB_MAX_PATH];
+    #ifdef _WIN32
+        DWORD attr;
+    #else
+        struct stat statbuf;
+    #endif
+
+    pathlib_error = PATHLIB_NONE;
+
+    if (!pathlib_exists(path)) {
+        return 0;
+    }
+
+    /* if it cant be rendered in a buffer that holds the system limit for a path then it doesnt exist */
+    if (!pathlib_render_str_to_buffer(path, filename, PATHLIB_ARRSIZE(filename))) {
+        return 0;
+    }
+    #ifdef _WIN32
+        attr = GetFileAttributesA(filename);
+        if (attr == INVALID_FILE_ATTRIBUTES) {
+            pathlib_print_os_error("GetFileAttributesA", filename);
+            pathlib_error = PATHLIB_OSERROR;
+            return 0;
+        }
+        return (attr & FILE_ATTRIBUTE_DIRECTORY) == 0;
+    #else /* _WIN32 */
+        if (stat(filename, &statbuf) < 0) {
+            pathlib_print_os_error("stat", filename);
+            pathlib_error = PATHLIB_OSERROR;
+            return 0;
+        }
+
+        return (statbuf.st_mode & S_IFMT) == S_IFREG;
+    #endif /* _WIN32 */
+}
+
+PATHLIB_API int pathlib_is_dir(const Path* path) {
+    char filename[PATH_MAX];
+    #ifdef _WIN32
+        DWORD attr;
+    #else
+        struct stat statbuf;
+    #endif
+
+    pathlib_error = PATHLIB_NONE;
+
+    if (!pathlib_exists(path)) {
+        return 0;
+    }
+
+    /* if it cant be rendered in a buffer that holds the system limit for a path then it doesnt exist */
+    if (!pathlib_render_str_to_buffer(path, filename, PATHLIB_ARRSIZE(filename))) {
+        return 0;
+    }
+    #ifdef _WIN32
+        attr = GetFileAttributesA(filename);
+        if (attr == INVALID_FILE_ATTRIBUTES) {
+            pathlib_print_os_error("GetFileAttributesA", filename);
+            pathlib_error = PATHLIB_OSERROR;
+            return 0;
+        }
+        return (attr & FILE_ATTRIBUTE_DIRECTORY) != 0;
+    #else /* _WIN32 */
+        if (stat(filename, &statbuf) < 0) {
+            pathlib_print_os_error("stat", filename);
+            pathlib_error = PATHLIB_OSERROR;
+            return 0;
+        }
+
+        return (statbuf.st_mode & S_IFMT) == S_IFDIR;
+    #endif /* _WIN32 */
+}
+
+PATHLIB_API int pathlib_is_symlink(const Path* path) {
+    #ifdef _WIN32
+        DWORD attributes;
+    #else
+        struct stat pathStat;
+    #endif
+    char filename[PATHLIB_MAX_PATH];
+
+    PATHLIB_ASSERT(path);
+
+    pathlib_error = PATHLIB_NONE;
+    
+    if (!pathlib_exists(path)) {
+        return 0;
+    }
+
+    if (!pathlib_render_str_to_buffer(path, filename, PATHLIB_ARRSIZE(filename))) {
+        return 0;
+    }
+
+    #ifdef _WIN32
+        attributes = GetFileAttributesA(filename);
+        if (attributes == INVALID_FILE_ATTRIBUTES) {
+            pathlib_print_os_error("GetFileAttributesA", filename);
+            pathlib_error = PATHLIB_OSERROR;
+            return 0;
+        }
+        return (attributes & FILE_ATTRIBUTE_REPARSE_POINT) ? 1 : 0;
+
+    #else
+        if (lstat(filename, &pathStat) != 0) {
+            pathlib_print_os_error("stat", filename);
+            pathlib_error = PATHLIB_OSERROR;
+            return 0;
+        }
+        return S_ISLNK(pathStat.st_mode) ? 1 : 0;
+    #endif
+}
+
+PATHLIB_API int pathlib_is_mount(const Path* path) {
+    char filename[PATHLIB_MAX_PATH];
+    #ifdef _WIN32
+        char volumePath[PATHLIB_MAX_PATH];
+    #else
+        struct stat pathStat, parentStat;
+        char parentPath[PATHLIB_MAX_PATH];
+    #endif
+
+    PATHLIB_ASSERT(path);
+
+    pathlib_error = PATHLIB_NONE;
+
+    if (!pathlib_exists(path)) {
+        return 0;
+    }
+
+    if (!pathlib_render_str_to_buffer(path, filename, PATHLIB_ARRSIZE(filename))) {
+        return 0;
+    }
+
+    #ifdef _WIN32
+        if (!GetVolumePathName(filename, volumePath, PATHLIB_ARRSIZE(volumePath))) {
+            pathlib_print_os_error("GetVolumePathName", filename);
+            pathlib_error = PATHLIB_OSERROR;
+            return 0;
+        }
+        return strcmp(filename, volumePath) == 0 ? 1 : 0;
+
+    #else
+        if (stat(filename, &pathStat) != 0) {
+            pathlib_print_os_error("stat", filename);
+            pathlib_error = PATHLIB_OSERROR;
+            return 0;
+        }
+
+        snprintf(parentPath, sizeof(parentPath), "%s/..", filename);
+
+        if (stat(parentPath, &parentStat) != 0) {
+            pathlib_print_os_error("stat", parentPath);
+            pathlib_error = PATHLIB_OSERROR;
+            return 0;
+        }
+
+        return (pathStat.st_dev != parentStat.st_dev) ? 1 : 0;
+    #endif
+}
+
+PATHLIB_API int pathlib_is_block_device(const Path* path) {
+    char filename[PATHLIB_MAX_PATH];
+    #ifdef _WIN32
+        HANDLE hFile;
+        DWORD bytesReturned;
+        STORAGE_PROPERTY_QUERY query;
+        BYTE buffer[512];
+        BOOL result;
+        STORAGE_DEVICE_DESCRIPTOR* descriptor;
+    #else
+        struct stat pathStat;
+    #endif
+
+    PATHLIB_ASSERT(path);
+
+    pathlib_error = PATHLIB_NONE;
+
+    if (!pathlib_exists(path)) {
+        return 0;
+    }
+
+    if (!pathlib_render_str_to_buffer(path, filename, PATHLIB_ARRSIZE(filename))) {
+        return 0;
+    }
+
+    #ifdef _WIN32
+        hFile = CreateFile(
+            filename,                           /* File path */
+            0,                                  /* No access to the file */
+            FILE_SHARE_READ | FILE_SHARE_WRITE, /* Allow shared access */
+            NULL,                               /* Default security attributes */
+            OPEN_EXISTING,                      /* Open the existing file */
+            FILE_ATTRIBUTE_NORMAL,              /* Normal attributes */
+            NULL                                /* No template file */
+        );
+
+        if (hFile == INVALID_HANDLE_VALUE) {
+            pathlib_print_os_error("CreateFile", filename);
+            pathlib_error = PATHLIB_OSERROR;
+            return 0;
+        }
+
+        query.PropertyId = StorageDeviceProperty;
+        query.QueryType = PropertyStandardQuery;
+
+        result = DeviceIoControl(
+            hFile,
+            IOCTL_STORAGE_QUERY_PROPERTY,
+            &query,
+            sizeof(query),
+            buffer,
+            sizeof(buffer),
+            &bytesReturned,
+            NULL
+        );
+
+        CloseHandle(hFile);
+
+        if (!result) {
+            pathlib_print_os_error("DeviceIoControl", filename);
+            pathlib_error = PATHLIB_OSERROR;
+            return 0;
+        }
+
+        descriptor = (STORAGE_DEVICE_DESCRIPTOR*)buffer;
+        return (descriptor->BusType == BusTypeScsi || descriptor->BusType == BusTypeAta) ? 1 : 0;
+    #else
+        if (stat(filename, &pathStat) != 0) {
+            pathlib_print_os_error("stat", filename);
+            pathlib_error = PATHLIB_OSERROR;
+            return 0;
+        }
+
+        return S_ISBLK(pathStat.st_mode) ? 1 : 0;
+    #endif
+}
+
+PATHLIB_API int pathlib_is_char_device(const Path* path) {
+    char filename[PATHLIB_MAX_PATH];
+    #ifdef _WIN32
+        HANDLE hFile;
+        const char* knownDevices[] = {"CON", "PRN", "AUX", "NUL", "COM1", "COM2", "LPT1", NULL};
+        const char** device;
+    #else
+        struct stat pathStat;
+    #endif
+
+    PATHLIB_ASSERT(path);
+
+    pathlib_error = PATHLIB_NONE;
+    
+    if (!pathlib_exists(path)) {
+        return 0;
+    }
+
+    if (!pathlib_render_str_to_buffer(path, filename, sizeof(filename) / sizeof(*filename))) {
+        return 0;
+    }
+
+    #ifdef _WIN32
+        hFile = CreateFile(
+            filename,
+            0,                                  /* No access to the file */
+            FILE_SHARE_READ | FILE_SHARE_WRITE, /* Allow shared access */
+            NULL,                               /* Default security attributes */
+            OPEN_EXISTING,                      /* Open the existing file */
+            FILE_ATTRIBUTE_NORMAL,              /* Normal attributes */
+            NULL                                /* No template file */
+        );
+
+        if (hFile == INVALID_HANDLE_VALUE) {
+            for (device = knownDevices; *device; ++device) {
+                if (_stricmp(filename, *device) == 0) {
+                    return 1;
+                }
+            }
+
+            pathlib_print_os_error("CreateFile", filename);
+            pathlib_error = PATHLIB_OSERROR;
+            return 0;
+        }
+
+        CloseHandle(hFile);
+        return 1;
+    #else
+        if (stat(filename, &pathStat) != 0) {
+            pathlib_print_os_error("stat", filename);
+            pathlib_error = PATHLIB_OSERROR;
+            return 0;
+        }
+
+        return S_ISCHR(pathStat.st_mode) ? 1 : 0;
+    #endif
+}
+
+PATHLIB_API int pathlib_is_socket(const Path* path) {
+    #ifdef _WIN32
+        (void) path;
+        return 0;
+    #else
+        char filename[PATHLIB_MAX_PATH];
+        struct stat pathStat;
+
+        PATHLIB_ASSERT(path);
+        
+        pathlib_error = PATHLIB_NONE;
+
+        if (!pathlib_exists(path)) {
+            return 0;
+        }
+
+        if (!pathlib_render_str_to_buffer(path, filename, sizeof(filename) / sizeof(*filename))) {
+            return 0;
+        }
+
+        if (stat(filename, &pathStat) != 0) {
+            pathlib_print_os_error("stat", filename);
+            pathlib_error = PATHLIB_OSERROR;
+            return 0;
+        }
+
+        return S_ISSOCK(pathStat.st_mode) ? 1 : 0;
+    #endif
+}
+
+PATHLIB_API int pathlib_is_fifo(const Path* path) {
+    char filename[PATHLIB_MAX_PATH];
+    #ifndef _WIN32
+        struct stat pathStat;
+    #endif
+
+    PATHLIB_ASSERT(path);
+    
+    pathlib_error = PATHLIB_NONE;
+
+    if (!pathlib_exists(path)) {
+        return 0;
+    }
+
+    if (!pathlib_render_str_to_buffer(path, filename, sizeof(filename) / sizeof(*filename))) {
+        return 0;
+    }
+
+    #ifdef _WIN32
+        /* TODO: not certain if this will ever be a string that is possible to be generated */
+        return strncmp(filename, "\\\\.\\pipe\\", 9) == 0;
+    #else
+        if (stat(filename, &pathStat) != 0) {
+            pathlib_print_os_error("stat", filename);
+            pathlib_error = PATHLIB_OSERROR;
+            return 0;
+        }
+
+        return S_ISFIFO(pathStat.st_mode) ? 1 : 0;
+    #endif
+}
+
+PATHLIB_API int pathlib_is_absolute(const Path* path) {
+    #ifdef _WIN32
+        if (path->size == 0) {
+            return 0;
+        }
+        if (strlen(path->parts[0]) != 2) {
+            return 0;
+        }
+        /* Check for drive letter followed by ':' and '\' (implicit), e.g., "C:\" */
+        if (isalpha(path->parts[0][0]) && path->parts[0][1] == ':') {
+            return 1;
+        }
+        /* Check for UNC paths starting with "\\" */
+        if (path->parts[0][0] == '\\' && path->parts[0][1] == '\\') {
+            return 1;
+        }
+    #else
+        size_t i;
+        for (i = 0; i < path->size; i++) {
+            if (path->parts[i][0] == '/') {
+                return 1;
+            }
+        }
+    #endif
+    return 0;
+}
+
+PATHLIB_API int pathlib_is_relative(const Path* path, const Path* other) {
+    size_t i;
+
+    if (path->size > other->size) {
+        return 0;
+    }
+
+    for (i = 0; i < path->size; i++) {
+        if (strcmp(path->parts[i], other->parts[i]) != 0) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+PATHLIB_API int pathlib_mkdir(const Path* path) {
+    char filename[PATHLIB_MAX_PATH];
+    size_t i;
+    
+    pathlib_error = PATHLIB_NONE;
+    
+    if (path->size == 0) return 1;
+    if (pathlib_exists(path) && pathlib_is_dir(path)) return 1;
+
+    for (i = 1; i <= path->size; i++) {
+        if (!pathlib__render_n_parts_to_buffer(path, filename, sizeof(filename) / sizeof(*filename), i)) {
+            return 0;
+        }
+        #ifdef _WIN32
+            if (CreateDirectory(filename, NULL) || GetLastError() == ERROR_ALREADY_EXISTS) {
+                if (i == path->size) {
+                    pathlib_error = PATHLIB_EXISTS;
+                }
+                errno = EEXIST;
+            } else {
+                pathlib_print_os_error("CreateDirectory", filename);
+                pathlib_error = PATHLIB_OSERROR;
+                return 0;
+            }
+        #else /* _WIN32 */
+            if (mkdir(filename, 0755) < 0) {
+                if (errno == EEXIST) {
+                    if (i == path->size) {
+                        pathlib_error = PATHLIB_EXISTS;
+                    }
+                }
+                pathlib_print_os_error("mkdir", filename);
+                pathlib_error = PATHLIB_OSERROR;
+                return 0;
+            }
+        #endif /* _WIN32 */
+    }
+
+    return 1;
+}
+
+PATHLIB_API int pathlib_touch(const Path* path) {
+    #ifdef _WIN32
+        HANDLE hFile;
+    #else
+        int fd;
+    #endif
+    char filename[PATHLIB_MAX_PATH];
+    Path subpath;
+    
+    pathlib_error = PATHLIB_NONE;
+    
+    if (path->size == 0) return 1;
+    if (path->size > 1) {
+        subpath.parts = path->parts;
+        subpath.size = path->size - 1;
+        subpath.capacity = path->capacity;
+        if (!pathlib_mkdir(&subpath)) {
+            return 0;
+        }
+    }
+
+    if (pathlib_exists(path) && pathlib_is_file(path)) {
+        pathlib_error = PATHLIB_EXISTS;
+        return 1;
+    }
+    
+    if (!pathlib_render_str_to_buffer(path, filename, PATHLIB_ARRSIZE(filename))) {
+        return 0;
+    }
+
+    #ifdef _WIN32
+        hFile = CreateFile(
+            filename,              /* File name */
+            GENERIC_WRITE,         /* Desired access */
+            0,                     /* Share mode (no sharing) */
+            NULL,                  /* Security attributes */
+            CREATE_NEW,            /* Creation disposition (create a new file) */
+            FILE_ATTRIBUTE_NORMAL, /* File attributes */
+            NULL                   /* Template file */
+        );
+
+        if (hFile == INVALID_HANDLE_VALUE) {
+            pathlib_print_os_error("CreateFile", filename);
+            pathlib_error = PATHLIB_OSERROR;
+            return 0;
+        }
+        CloseHandle(hFile);
+        return 1;
+    #else
+        fd = open(filename, O_CREAT | O_WRONLY, S_IRUSR | S_IWUSR);
+
+        if (fd == -1) {
+            pathlib_print_os_error("open", filename);
+            pathlib_error = PATHLIB_OSERROR;
+            return 0;
+        }
+
+        close(fd);
+        return 1;
+    #endif
+}
+
+PATHLIB_API Path pathlib_joinpath(const Path* path, const Path* other) {
+    size_t i;
+    Path ret;
+
+    ret.parts = NULL;
+    ret.size = 0;
+    ret.capacity = 0;
+
+    for (i = 0; i < path->size; i++) {
+        pathlib_add_part(&ret, path->parts[i]);
+    }
+
+    for (i = 0; i < other->size; i++) {
+        pathlib_add_part(&ret, other->parts[i]);
+    }
+
+    return ret;
+}
+
+PATHLIB_API const char* pathlib_name(const Path* path) {
+    PATHLIB_ASSERT(path);
+
+    if (path->size == 0) {
+        return "";
+    }
+
+    return path->parts[path->size - 1];
+}
+
+PATHLIB_API Path pathlib_copy(const Path* path) {
+    Path ret;
+
+    ret.parts = pathlib__malloc(path->capacity * sizeof(*path->parts));
+
+    memcpy(ret.parts, path->parts, path->size * sizeof(*path->parts));
+    ret.size = path->size;
+    ret.capacity = path->capacity;
+
+    return ret;
+}
+
+PATHLIB_API FILE* pathlib_open(const Path* path, const char* mode) {
+    char filename[PATHLIB_MAX_PATH];
+
+    PATHLIB_ASSERT(path);
+    PATHLIB_ASSERT(path);
+
+    if (!pathlib_render_str_to_buffer(path, filename, sizeof(filename) / sizeof(*filename))) {
+        return NULL;
+    }
+
+    if (!pathlib_exists(path)) {
+        if (!pathlib_touch(path)) {
+            return NULL;
+        }
+    }
+
+    return fopen(filename, mode);
+}
+
+PATHLIB_API char* pathlib_read_text(const Path* path) {
+    FILE* f;
+    long int file_size;
+    char* buff;
+    
+    if (!pathlib_exists(path)) {
+        return NULL;
+    }
+    
+    f = pathlib_open(path, "r");
+    
+    if (f == NULL) {
+        return NULL;
+    }
+    if (fseek(f, 0, SEEK_END) < 0) {
+        return NULL;
+    }
+    file_size = ftell(f);
+    if (file_size < 0) {
+        return NULL;
+    }
+    if (fseek(f, 0, SEEK_SET) < 0) {
+        return NULL;
+    }
+    
+    buff = pathlib__malloc(file_size + 1);
+    buff[file_size] = 0;
+    fread(buff, file_size, 1, f);
+
+    if (ferror(f)) {
+        fclose(f);
+        PATHLIB_FREE(buff);
+        return NULL;
+    }
+    fclose(f);
+    
+    return buff;
+}
+
+PATHLIB_API unsigned char* pathlib_read_bytes(const Path* path, size_t* byte_count) {
+    FILE* f;
+    long int file_size;
+    unsigned char* buff;
+    
+    if (!pathlib_exists(path)) {
+        return NULL;
+    }
+    
+    f = pathlib_open(path, "rb");
+    
+    if (f == NULL) {
+        return NULL;
+    }
+    if (fseek(f, 0, SEEK_END) < 0) {
+        return NULL;
+    }
+    file_size = ftell(f);
+    if (file_size < 0) {
+        return NULL;
+    }
+    if (fseek(f, 0, SEEK_SET) < 0) {
+        return NULL;
+    }
+    
+    buff = pathlib__malloc(file_size + 1);
+    buff[file_size] = 0;
+    fread(buff, file_size, 1, f);
+
+    if (ferror(f)) {
+        fclose(f);
+        PATHLIB_FREE(buff);
+        return NULL;
+    }
+    fclose(f);
+    
+    *byte_count = file_size;
+    return buff;
+}
+ 
+PATHLIB_API int pathlib_write_text(const Path* path, const char* text, size_t text_size) {
+    FILE* f;
+    size_t n;
+    
+    if (!pathlib_exists(path)) {
+        if (!pathlib_touch(path)) {
+            return 0;
+        }
+    }
+    
+    f = pathlib_open(path, "w");
+    
+    if (f == NULL) {
+        return 0;
+    }
+    
+    while (text_size > 0) {
+        n = fwrite(text, 1, text_size, f);
+        if (ferror(f)) {
+            fclose(f);
+            return 0;
+        }
+        text_size -= n;
+        text  += n;
+    }
+    
+    fclose(f);
+    
+    return 1;
+}
+
+PATHLIB_API int pathlib_write_bytes(const Path* path, const unsigned char* buff, size_t buff_size) {
+    FILE* f;
+    size_t n;
+    
+    if (!pathlib_exists(path)) {
+        if (!pathlib_touch(path)) {
+            return 0;
+        }
+    }
+    
+    f = pathlib_open(path, "wb");
+    
+    if (f == NULL) {
+        return 0;
+    }
+    
+    while (buff_size > 0) {
+        n = fwrite(buff, 1, buff_size, f);
+        if (ferror(f)) {
+            fclose(f);
+            return 0;
+        }
+        buff_size -= n;
+        buff  += n;
+    }
+    
+    fclose(f);
+    
+    return 1;
+}
+
+void* pathlib__default_aligned_malloc(size_t size, size_t alignment) {
+    #ifdef _WIN32
+        return _aligned_malloc(size, alignment);
+    #else
+        void* region;
+        if (posix_memalign(&region, alignment, size) != 0) {
+            return NULL;
+        }
+        return region;
+    #endif
+}
+
+void pathlib__default_aligned_free(void* ptr) {
+    #ifdef _WIN32
+        _aligned_free(ptr);
+    #else
+        free(ptr);
+    #endif
+}
+
+void* pathlib___aligned_malloc(size_t size, size_t alignment, const char* file, size_t line) {
+    void* region = PATHLIB_ALIGNED_MALLOC(size, alignment);
+    if (region) {
+        return region;
+    }
+    
+    fprintf(stderr, "[FATAL] out of memory at %s:%lu", file, (unsigned long int)line);
+    abort();
+}
+#define pathlib__aligned_malloc(size, alignment) pathlib___aligned_malloc(size, alignment, __FILE__, __LINE__)
+
+PATHLIB_API void pathlib_aligned_free(void* ptr) {
+    if (ptr) {
+        PATHLIB_ALIGNED_FREE(ptr);
+    }
+}
+
+#define pathlib__round_up(value, alignment) (((value) + (alignment) - 1) / (alignment) * (alignment))
+
+/* O_DIRECT is only visible with _GNU_SOURCE, without it direct I/O falls back to buffered I/O */
+#if !defined(_WIN32) && defined(O_DIRECT)
+    #define PATHLIB__O_DIRECT O_DIRECT
+#else
+    #define PATHLIB__O_DIRECT 0
+#endif
+
+#ifndef _WIN32
+static int pathlib__write_all(int fd, const unsigned char* buff, size_t size, const char* filename) {
+    ssize_t n;
+    
+    while (size > 0) {
+        n = write(fd, buff, size);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            pathlib_print_os_error("write", filename);
+            pathlib_error = PATHLIB_OSERROR;
+            return 0;
+        }
+        buff += n;
+        size -= n;
+    }
+    
+    return 1;
+}
+
+/* returns 0 when the file behind fd cannot do direct I/O */
+static int pathlib__fd_direct_io_alignment(int fd, size_t* memory_alignment, size_t* offset_alignment) {
+    #if defined(__linux__) && defined(STATX_DIOALIGN)
+        struct statx stx;
+        
+        if (statx(fd, "", AT_EMPTY_PATH, STATX_DIOALIGN, &stx) == 0 && (stx.stx_mask & STATX_DIOALIGN)) {
+            if (stx.stx_dio_offset_align == 0) {
+                return 0;
+            }
+            *memory_alignment = stx.stx_dio_mem_align;
+            *offset_alignment = stx.stx_dio_offset_align;
+            if (*memory_alignment < sizeof(void*)) {
+                *memory_alignment = sizeof(void*);
+            }
+            return 1;
+        }
+    #endif
+    {
+        /* older kernels dont report the alignment, the block size is always a safe choice */
+        struct stat statbuf;
+        
+        if (fstat(fd, &statbuf) != 0) {
+            return 0;
+        }
+        *offset_alignment = statbuf.st_blksize > 512 ? (size_t)statbuf.st_blksize : 512;
+        *memory_alignment = *offset_alignment;
+        return 1;
+    }
+}
+#endif /* _WIN32 */
+
+PATHLIB_API int pathlib_direct_io_alignment(const Path* path, size_t* memory_alignment, size_t* offset_alignment) {
+    char filename[PATHLIB_MAX_PATH];
+    #ifndef _WIN32
+        int fd, ret;
+    #endif
+    
+    PATHLIB_ASSERT(path);
+    PATHLIB_ASSERT(memory_alignment);
+    PATHLIB_ASSERT(offset_alignment);
+    
+    pathlib_error = PATHLIB_NONE;
+    
+    if (!pathlib_exists(path)) {
+        pathlib_error = PATHLIB_NEXISTS;
+        return 0;
+    }
+    
+    if (!pathlib_render_str_to_buffer(path, filename, PATHLIB_ARRSIZE(filename))) {
+        pathlib_error = PATHLIB_NEXISTS;
+        return 0;
+    }
+    
+    #ifdef _WIN32
+        /* direct I/O is not implemented on windows */
+        *memory_alignment = 1;
+        *offset_alignment = 1;
+        return 0;
+    #else
+        fd = open(filename, O_RDONLY);
+        if (fd < 0) {
+            pathlib_print_os_error("open", filename);
+            pathlib_error = PATHLIB_OSERROR;
+            return 0;
+        }
+        ret = pathlib__fd_direct_io_alignment(fd, memory_alignment, offset_alignment);
+        close(fd);
+        return ret;
+    #endif
+}
+
+#ifndef _WIN32
+/* reads the whole file behind fd into *buff, growing it when it is too small */
+static int pathlib__read_fd(int fd, unsigned char** buff, size_t* buff_capacity, size_t* byte_count, const char* filename) {
+    struct stat statbuf;
+    size_t file_size, done;
+    unsigned char* temp;
+    ssize_t n;
+    
+    if (fstat(fd, &statbuf) != 0) {
+        pathlib_print_os_error("fstat", filename);
+        pathlib_error = PATHLIB_OSERROR;
+        return 0;
+    }
+    file_size = statbuf.st_size;
+    
+    if (*buff == NULL || *buff_capacity < file_size + 1) {
+        temp = pathlib__malloc(file_size + 1);
+        PATHLIB_FREE(*buff);
+        *buff = temp;
+        *buff_capacity = file_size + 1;
+    }
+    
+    done = 0;
+    while (done < file_size) {
+        n = read(fd, *buff + done, file_size - done);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            pathlib_print_os_error("read", filename);
+            pathlib_error = PATHLIB_OSERROR;
+            return 0;
+        }
+        if (n == 0) {
+            break;
+        }
+        done += n;
+    }
+    
+    (*buff)[done] = 0;
+    *byte_count = done;
+    return 1;
+}
+
+static int pathlib__preallocate(int fd, size_t size, const char* filename) {
+    int ret;
+    
+    if (size == 0) {
+        return 1;
+    }
+    
+    #if defined(__linux__) && defined(FALLOC_FL_KEEP_SIZE)
+        ret = fallocate(fd, 0, 0, size);
+        if (ret != 0 && (errno == EOPNOTSUPP || errno == ENOSYS)) {
+            /* it is only a hint, the write itself will allocate the space */
+            return 1;
+        }
+    #else
+        /* posix_fallocate can emulate the allocation by writing zeros, that would double the I/O */
+        (void) fd;
+        ret = 0;
+    #endif
+    
+    if (ret != 0) {
+        pathlib_print_os_error("fallocate", filename);
+        pathlib_error = PATHLIB_OSERROR;
+        return 0;
+    }
+    
+    return 1;
+}
+
+static void pathlib__advise(int fd, int flags) {
+    #ifdef POSIX_FADV_SEQUENTIAL
+        if (flags & PATHLIB_IO_SEQUENTIAL) {
+            posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+        }
+    #else
+        (void) fd;
+        (void) flags;
+    #endif
+}
+#endif /* _WIN32 */
+
+/* asks the kernel to start reading the file in the background */
+static void pathlib__prefetch(const Path* path) {
+    #if !defined(_WIN32) && defined(POSIX_FADV_WILLNEED)
+        char filename[PATHLIB_MAX_PATH];
+        int fd;
+        
+        if (!pathlib_render_str_to_buffer(path, filename, PATHLIB_ARRSIZE(filename))) {
+            return;
+        }
+        
+        fd = open(filename, O_RDONLY);
+        if (fd < 0) {
+            return;
+        }
+        /* the readahead keeps going after the descriptor is closed */
+        posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+        close(fd);
+    #else
+        (void) path;
+    #endif
+}
+
+PATHLIB_API unsigned char* pathlib_read_bytes_ex(const Path* path, size_t* byte_count, int flags) {
+    #ifdef _WIN32
+        unsigned char* buff, *aligned;
+        
+        PATHLIB_ASSERT(path);
+        PATHLIB_ASSERT(byte_count);
+        
+        buff = pathlib_read_bytes(path, byte_count);
+        if (buff == NULL || !(flags & PATHLIB_IO_DIRECT)) {
+            return buff;
+        }
+        
+        /* the caller expects a buffer that can be released with pathlib_aligned_free */
+        aligned = pathlib__aligned_malloc(*byte_count + 1, sizeof(void*));
+        memcpy(aligned, buff, *byte_count + 1);
+        PATHLIB_FREE(buff);
+        return aligned;
+    #else
+        char filename[PATHLIB_MAX_PATH];
+        struct stat statbuf;
+        size_t memory_alignment, offset_alignment, file_size, rounded_size, done, request;
+        unsigned char* buff;
+        ssize_t n;
+        int fd, direct;
+        
+        PATHLIB_ASSERT(path);
+        PATHLIB_ASSERT(byte_count);
+        
+        if (flags == PATHLIB_IO_DEFAULT) {
+            return pathlib_read_bytes(path, byte_count);
+        }
+        
+        pathlib_error = PATHLIB_NONE;
+        
+        if (!pathlib_exists(path)) {
+            pathlib_error = PATHLIB_NEXISTS;
+            return NULL;
+        }
+        
+        if (!pathlib_render_str_to_buffer(path, filename, PATHLIB_ARRSIZE(filename))) {
+            pathlib_error = PATHLIB_NEXISTS;
+            return NULL;
+        }
+        
+        direct = (flags & PATHLIB_IO_DIRECT) != 0 && PATHLIB__O_DIRECT != 0;
+        fd = open(filename, O_RDONLY | (direct ? PATHLIB__O_DIRECT : 0));
+        if (fd < 0 && direct && errno == EINVAL) {
+            /* the filesystem doesnt support O_DIRECT (eg tmpfs) */
+            direct = 0;
+            fd = open(filename, O_RDONLY);
+        }
+        if (fd < 0) {
+            pathlib_print_os_error("open", filename);
+            pathlib_error = PATHLIB_OSERROR;
+            return NULL;
+        }
+        
+        pathlib__advise(fd, flags);
+        
+        if (!(flags & PATHLIB_IO_DIRECT)) {
+            buff = NULL;
+            request = 0;
+            if (!pathlib__read_fd(fd, &buff, &request, byte_count, filename)) {
+                PATHLIB_FREE(buff);
+                buff = NULL;
+            }
+            close(fd);
+            return buff;
+        }
+        
+        if (fstat(fd, &statbuf) != 0) {
+            pathlib_print_os_error("fstat", filename);
+            pathlib_error = PATHLIB_OSERROR;
+            close(fd);
+            return NULL;
+        }
+        file_size = statbuf.st_size;
+        
+        if (direct && !pathlib__fd_direct_io_alignment(fd, &memory_alignment, &offset_alignment)) {
+            direct = 0;
+            fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~PATHLIB__O_DIRECT);
+        }
+        if (!direct) {
+            memory_alignment = sizeof(void*);
+            offset_alignment = 1;
+        }
+        
+        /* one extra aligned block so there is always room for the null terminator */
+        rounded_size = pathlib__round_up(file_size, offset_alignment);
+        buff = pathlib__aligned_malloc(rounded_size + offset_alignment, memory_alignment);
+        
+        done = 0;
+        while (done < file_size) {
+            request = rounded_size - done;
+            /* linux never transfers more than this in one call, it is a multiple of every alignment */
+            if (request > 0x40000000) {
+                request = 0x40000000;
+            }
+            n = read(fd, buff + done, request);
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                pathlib_print_os_error("read", filename);
+                pathlib_error = PATHLIB_OSERROR;
+                PATHLIB_ALIGNED_FREE(buff);
+                close(fd);
+                return NULL;
+            }
+            if (n == 0) {
+                break;
+            }
+            done += n;
+        }
+        close(fd);
+        
+        buff[done] = 0;
+        *byte_count = done;
+        return buff;
+    #endif
+}
+
+PATHLIB_API int pathlib_write_bytes_ex(const Path* path, const unsigned char* buff, size_t buff_size, int flags) {
+    #ifdef _WIN32
+        (void) flags;
+        return pathlib_write_bytes(path, buff, buff_size);
+    #else
+        char filename[PATHLIB_MAX_PATH];
+        size_t memory_alignment, offset_alignment, aligned_size, chunk_size, n;
+        unsigned char* bounce;
+        int fd, ok, direct;
+        
+        PATHLIB_ASSERT(path);
+        PATHLIB_ASSERT(buff || buff_size == 0);
+        
+        if (!(flags & (PATHLIB_IO_DIRECT | PATHLIB_IO_PREALLOCATE))) {
+            return pathlib_write_bytes(path, buff, buff_size);
+        }
+        
+        pathlib_error = PATHLIB_NONE;
+        
+        if (!pathlib_exists(path)) {
+            if (!pathlib_touch(path)) {
+                return 0;
+            }
+        }
+        
+        if (!pathlib_render_str_to_buffer(path, filename, PATHLIB_ARRSIZE(filename))) {
+            return 0;
+        }
+        
+        direct = (flags & PATHLIB_IO_DIRECT) != 0 && PATHLIB__O_DIRECT != 0;
+        fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC | (direct ? PATHLIB__O_DIRECT : 0), 0644);
+        if (fd < 0 && direct && errno == EINVAL) {
+            direct = 0;
+            fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        }
+        if (fd < 0) {
+            pathlib_print_os_error("open", filename);
+            pathlib_error = PATHLIB_OSERROR;
+            return 0;
+        }
+        
+        if (direct && !pathlib__fd_direct_io_alignment(fd, &memory_alignment, &offset_alignment)) {
+            direct = 0;
+            fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~PATHLIB__O_DIRECT);
+        }
+        
+        /* reserving the extents up front avoids fragmentation and fails fast on a full disk */
+        if ((flags & PATHLIB_IO_PREALLOCATE) && !pathlib__preallocate(fd, buff_size, filename)) {
+            close(fd);
+            return 0;
+        }
+        
+        ok = 1;
+        aligned_size = direct ? buff_size - buff_size % offset_alignment : 0;
+        
+        if (aligned_size > 0 && (size_t)buff % memory_alignment == 0) {
+            ok = pathlib__write_all(fd, buff, aligned_size, filename);
+        } else if (aligned_size > 0) {
+            /* the input is not aligned so it has to go through an aligned bounce buffer */
+            chunk_size = pathlib__round_up(PATHLIB_DIRECT_IO_CHUNK_SIZE, offset_alignment);
+            if (chunk_size > aligned_size) {
+                chunk_size = aligned_size;
+            }
+            bounce = pathlib__aligned_malloc(chunk_size, memory_alignment);
+            for (n = 0; ok && n < aligned_size; n += chunk_size) {
+                if (chunk_size > aligned_size - n) {
+                    chunk_size = aligned_size - n;
+                }
+                memcpy(bounce, buff + n, chunk_size);
+                ok = pathlib__write_all(fd, bounce, chunk_size, filename);
+            }
+            PATHLIB_ALIGNED_FREE(bounce);
+        }
+        
+        /* the tail is smaller than one block, it goes through the page cache */
+        if (ok && aligned_size < buff_size) {
+            if (direct && fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~PATHLIB__O_DIRECT) != 0) {
+                pathlib_print_os_error("fcntl", filename);
+                pathlib_error = PATHLIB_OSERROR;
+                ok = 0;
+            } else {
+                ok = pathlib__write_all(fd, buff + aligned_size, buff_size - aligned_size, filename);
+            }
+        }
+        
+        if (close(fd) != 0 && ok) {
+            pathlib_print_os_error("close", filename);
+            pathlib_error = PATHLIB_OSERROR;
+            ok = 0;
+        }
+        
+        return ok;
+    #endif
+}
+
+PATHLIB_API size_t pathlib_paths_read_bytes(const Paths* paths, size_t prefetch_window, int flags, Pathlib_Read_Callback callback, void* userdata) {
+    size_t i, prefetched, delivered, byte_count;
+    unsigned char* buff;
+    int failed;
+    #ifndef _WIN32
+        char filename[PATHLIB_MAX_PATH];
+        size_t buff_capacity;
+        int fd, ok;
+    #endif
+    
+    PATHLIB_ASSERT(paths);
+    PATHLIB_ASSERT(callback);
+    
+    pathlib_error = PATHLIB_NONE;
+    
+    buff = NULL;
+    failed = 0;
+    delivered = 0;
+    prefetched = 0;
+    #ifndef _WIN32
+        buff_capacity = 0;
+    #endif
+    
+    for (i = 0; i < paths->size; i++) {
+        /* keep the next prefetch_window files in flight while this one is processed */
+        if (prefetched <= i) {
+            prefetched = i + 1;
+        }
+        while (prefetched < paths->size && prefetched <= i + prefetch_window) {
+            pathlib__prefetch(&paths->paths[prefetched]);
+            prefetched++;
+        }
+        
+        #ifdef _WIN32
+            (void) flags;
+            buff = pathlib_read_bytes(&paths->paths[i], &byte_count);
+            if (buff == NULL) {
+                failed = 1;
+                continue;
+            }
+            delivered++;
+            if (!callback(&paths->paths[i], buff, byte_count, userdata)) {
+                PATHLIB_FREE(buff);
+                buff = NULL;
+                break;
+            }
+            PATHLIB_FREE(buff);
+            buff = NULL;
+        #else
+            if (!pathlib_render_str_to_buffer(&paths->paths[i], filename, PATHLIB_ARRSIZE(filename))) {
+                failed = 1;
+                continue;
+            }
+            fd = open(filename, O_RDONLY);
+            if (fd < 0) {
+                pathlib_print_os_error("open", filename);
+                failed = 1;
+                continue;
+            }
+            pathlib__advise(fd, flags);
+            ok = pathlib__read_fd(fd, &buff, &buff_capacity, &byte_count, filename);
+            close(fd);
+            if (!ok) {
+                failed = 1;
+                continue;
+            }
+            delivered++;
+            if (!callback(&paths->paths[i], buff, byte_count, userdata)) {
+                break;
+            }
+        #endif
+    }
+    
+    PATHLIB_FREE(buff);
+    
+    if (failed) {
+        pathlib_error = PATHLIB_OSERROR;
+    }
+    
+    return delivered;
+}
+
+#ifndef PATHLIB_NO_THREADS
+#ifdef _WIN32
+    typedef HANDLE Pathlib__Thread;
+    typedef DWORD Pathlib__Thread_Id;
+    typedef CRITICAL_SECTION Pathlib__Mutex;
+    typedef CONDITION_VARIABLE Pathlib__Cond;
+    
+    #define pathlib__thread_self() GetCurrentThreadId()
+    #define pathlib__thread_equal(a, b) ((a) == (b))
+    
+    #define pathlib__mutex_init(mutex) InitializeCriticalSection(mutex)
+    #define pathlib__mutex_destroy(mutex) DeleteCriticalSection(mutex)
+    #define pathlib__mutex_lock(mutex) EnterCriticalSection(mutex)
+    #define pathlib__mutex_unlock(mutex) LeaveCriticalSection(mutex)
+    #define pathlib__cond_init(cond) InitializeConditionVariable(cond)
+    #define pathlib__cond_destroy(cond) ((void)(cond))
+    #define pathlib__cond_wait(cond, mutex) SleepConditionVariableCS(cond, mutex, INFINITE)
+    #define pathlib__cond_signal(cond) WakeConditionVariable(cond)
+    #define pathlib__cond_broadcast(cond) WakeAllConditionVariable(cond)
+#else /* _WIN32 */
+    typedef pthread_t Pathlib__Thread;
+    typedef pthread_t Pathlib__Thread_Id;
+    typedef pthread_mutex_t Pathlib__Mutex;
+    typedef pthread_cond_t Pathlib__Cond;
+    
+    #define pathlib__thread_self() pthread_self()
+    #define pathlib__thread_equal(a, b) pthread_equal(a, b)
+    
+    #define pathlib__mutex_init(mutex) pthread_mutex_init(mutex, NULL)
+    #define pathlib__mutex_destroy(mutex) pthread_mutex_destroy(mutex)
+    #define pathlib__mutex_lock(mutex) pthread_mutex_lock(mutex)
+    #define pathlib__mutex_unlock(mutex) pthread_mutex_unlock(mutex)
+    #define pathlib__cond_init(cond) pthread_cond_init(cond, NULL)
+    #define pathlib__cond_destroy(cond) pthread_cond_destroy(cond)
+    #define pathlib__cond_wait(cond, mutex) pthread_cond_wait(cond, mutex)
+    #define pathlib__cond_signal(cond) pthread_cond_signal(cond)
+    #define pathlib__cond_broadcast(cond) pthread_cond_broadcast(cond)
+#endif /* _WIN32 */
+
+typedef struct Pathlib__Thread_Start {
+    void (*func)(void*);
+    void* arg;
+} Pathlib__Thread_Start;
+
+#ifdef _WIN32
+static DWORD WINAPI pathlib__thread_entry(LPVOID param) {
+#else
+static void* pathlib__thread_entry(void* param) {
+#endif
+    Pathlib__Thread_Start start = *(Pathlib__Thread_Start*)param;
+    
+    PATHLIB_FREE(param);
+    start.func(start.arg);
+    
+    return 0;
+}
+
+static int pathlib__thread_create(Pathlib__Thread* thread, void (*func)(void*), void* arg) {
+    Pathlib__Thread_Start* start;
+    
+    start = pathlib__malloc(sizeof(*start));
+    start->func = func;
+    start->arg = arg;
+    
+    #ifdef _WIN32
+        *thread = CreateThread(NULL, 0, pathlib__thread_entry, start, 0, NULL);
+        if (*thread == NULL) {
+            pathlib_print_func_failed("CreateThread");
+            PATHLIB_FREE(start);
+            return 0;
+        }
+    #else
+        errno = pthread_create(thread, NULL, pathlib__thread_entry, start);
+        if (errno != 0) {
+            pathlib_print_func_failed("pthread_create");
+            PATHLIB_FREE(start);
+            return 0;
+        }
+    #endif
+    
+    return 1;
+}
+
+static void pathlib__thread_join(Pathlib__Thread thread) {
+    #ifdef _WIN32
+        WaitForSingleObject(thread, INFINITE);
+        CloseHandle(thread);
+    #else
+        pthread_join(thread, NULL);
+    #endif
+}
+#endif /* PATHLIB_NO_THREADS */
+
+struct Pathlib_Writer {
+    char filename[PATHLIB_MAX_PATH];
+    #ifdef _WIN32
+        HANDLE handle;
+    #else
+        int fd;
+    #endif
+    unsigned char* buffer;
+    size_t size;
+    size_t capacity;
+    int error; /* the errno or GetLastError of the first failed write */
+    #ifndef PATHLIB_NO_THREADS
+        int background;
+        int stop;
+        unsigned char* pending; /* the buffer that the flusher writes, NULL when it is idle */
+        size_t pending_size;
+        unsigned char* spare;
+        Pathlib__Mutex mutex;
+        Pathlib__Cond cond;
+        Pathlib__Thread thread;
+    #endif
+};
+
+/* writes count buffers with as few system calls as possible, returns the error code or 0 */
+static int pathlib__writer_write_raw(Pathlib_Writer* writer, const unsigned char** buffs, const size_t* sizes, int count) {
+    #ifdef _WIN32
+        DWORD written;
+        size_t size;
+        const unsigned char* buff;
+        int i;
+        
+        for (i = 0; i < count; i++) {
+            buff = buffs[i];
+            size = sizes[i];
+            while (size > 0) {
+                if (!WriteFile(writer->handle, buff, size > 0x40000000 ? 0x40000000 : (DWORD)size, &written, NULL)) {
+                    return GetLastError();
+                }
+                buff += written;
+                size -= written;
+            }
+        }
+        
+        return 0;
+    #else
+        struct iovec iov[2];
+        ssize_t n;
+        int i;
+        
+        PATHLIB_ASSERT(count <= (int)PATHLIB_ARRSIZE(iov));
+        
+        for (i = 0; i < count; i++) {
+            iov[i].iov_base = (void*)buffs[i];
+            iov[i].iov_len = sizes[i];
+        }
+        
+        i = 0;
+        while (i < count) {
+            if (iov[i].iov_len == 0) {
+                i++;
+                continue;
+            }
+            n = writev(writer->fd, iov + i, count - i);
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return errno;
+            }
+            /* partial writes leave the iovecs pointing at whatever is left */
+            while (i < count && (size_t)n >= iov[i].iov_len) {
+                n -= iov[i].iov_len;
+                iov[i].iov_len = 0;
+                i++;
+            }
+            if (i < count) {
+                iov[i].iov_base = (unsigned char*)iov[i].iov_base + n;
+                iov[i].iov_len -= n;
+            }
+        }
+        
+        return 0;
+    #endif
+}
+
+static int pathlib__writer_check(Pathlib_Writer* writer) {
+    int error;
+    
+    #ifndef PATHLIB_NO_THREADS
+        if (writer->background) {
+            pathlib__mutex_lock(&writer->mutex);
+            error = writer->error;
+            pathlib__mutex_unlock(&writer->mutex);
+        } else {
+            error = writer->error;
+        }
+    #else
+        error = writer->error;
+    #endif
+    
+    if (error == 0) {
+        return 1;
+    }
+    
+    #ifdef _WIN32
+        pathlib_print_error("WriteFile failed for `%s`: %d", writer->filename, error);
+    #else
+        pathlib_print_error("write failed for `%s`: %s", writer->filename, strerror(error));
+    #endif
+    pathlib_error = PATHLIB_OSERROR;
+    return 0;
+}
+
+#ifndef PATHLIB_NO_THREADS
+static void pathlib__writer_flusher(void* arg) {
+    Pathlib_Writer* writer = arg;
+    const unsigned char* buff;
+    size_t size;
+    int error;
+    
+    pathlib__mutex_lock(&writer->mutex);
+    for (;;) {
+        while (writer->pending == NULL && !writer->stop) {
+            pathlib__cond_wait(&writer->cond, &writer->mutex);
+        }
+        if (writer->pending == NULL) {
+            break;
+        }
+        
+        buff = writer->pending;
+        size = writer->pending_size;
+        error = writer->error;
+        pathlib__mutex_unlock(&writer->mutex);
+        
+        /* after the first error the data is dropped, the error is reported by the next call */
+        if (error == 0) {
+            error = pathlib__writer_write_raw(writer, &buff, &size, 1);
+        } else {
+            error = 0;
+        }
+        
+        pathlib__mutex_lock(&writer->mutex);
+        if (error != 0) {
+            writer->error = error;
+        }
+        writer->spare = writer->pending;
+        writer->pending = NULL;
+        pathlib__cond_broadcast(&writer->cond);
+    }
+    pathlib__mutex_unlock(&writer->mutex);
+}
+
+/* gives the current buffer to the flusher and continues with the spare one */
+static void pathlib__writer_handoff(Pathlib_Writer* writer, int wait_idle) {
+    pathlib__mutex_lock(&writer->mutex);
+    while (writer->pending != NULL) {
+        pathlib__cond_wait(&writer->cond, &writer->mutex);
+    }
+    if (writer->size > 0) {
+        writer->pending = writer->buffer;
+        writer->pending_size = writer->size;
+        writer->buffer = writer->spare;
+        writer->spare = NULL;
+        writer->size = 0;
+        pathlib__cond_broadcast(&writer->cond);
+    }
+    while (wait_idle && writer->pending != NULL) {
+        pathlib__cond_wait(&writer->cond, &writer->mutex);
+    }
+    pathlib__mutex_unlock(&writer->mutex);
+}
+#endif /* PATHLIB_NO_THREADS */
+
+PATHLIB_API Pathlib_Writer* pathlib_writer_open(const Path* path, size_t buffer_size, int flags) {
+    Pathlib_Writer* writer;
+    
+    PATHLIB_ASSERT(path);
+    
+    pathlib_error = PATHLIB_NONE;
+    
+    if (!pathlib_exists(path)) {
+        if (!pathlib_touch(path)) {
+            return NULL;
+        }
+    }
+    
+    writer = pathlib__malloc(sizeof(*writer));
+    memset(writer, 0, sizeof(*writer));
+    
+    if (!pathlib_render_str_to_buffer(path, writer->filename, PATHLIB_ARRSIZE(writer->filename))) {
+        PATHLIB_FREE(writer);
+        return NULL;
+    }
+    
+    #ifdef _WIN32
+        writer->handle = CreateFile(
+            writer->filename,
+            (flags & PATHLIB_IO_APPEND) ? FILE_APPEND_DATA : GENERIC_WRITE,
+            FILE_SHARE_READ,
+            NULL,
+            (flags & PATHLIB_IO_APPEND) ? OPEN_ALWAYS : CREATE_ALWAYS,
+            FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
+            NULL
+        );
+        if (writer->handle == INVALID_HANDLE_VALUE) {
+            pathlib_print_os_error("CreateFile", writer->filename);
+            pathlib_error = PATHLIB_OSERROR;
+            PATHLIB_FREE(writer);
+            return NULL;
+        }
+    #else
+        writer->fd = open(writer->filename, O_WRONLY | O_CREAT | ((flags & PATHLIB_IO_APPEND) ? O_APPEND : O_TRUNC), 0644);
+        if (writer->fd < 0) {
+            pathlib_print_os_error("open", writer->filename);
+            pathlib_error = PATHLIB_OSERROR;
+            PATHLIB_FREE(writer);
+            return NULL;
+        }
+    #endif
+    
+    writer->capacity = buffer_size > 0 ? buffer_size : PATHLIB_WRITER_BUFFER_SIZE;
+    writer->buffer = pathlib__malloc(writer->capacity);
+    
+    #ifndef PATHLIB_NO_THREADS
+        if (flags & PATHLIB_IO_BACKGROUND_FLUSH) {
+            writer->spare = pathlib__malloc(writer->capacity);
+            pathlib__mutex_init(&writer->mutex);
+            pathlib__cond_init(&writer->cond);
+            writer->background = pathlib__thread_create(&writer->thread, pathlib__writer_flusher, writer);
+            if (!writer->background) {
+                /* keep going without the flusher thread */
+                pathlib__mutex_destroy(&writer->mutex);
+                pathlib__cond_destroy(&writer->cond);
+                PATHLIB_FREE(writer->spare);
+                writer->spare = NULL;
+            }
+        }
+    #else
+        (void) flags;
+    #endif
+    
+    return writer;
+}
+
+PATHLIB_API int pathlib_writer_append(Pathlib_Writer* writer, const void* data, size_t size) {
+    const unsigned char* buffs[2];
+    size_t sizes[2], n;
+    
+    PATHLIB_ASSERT(writer);
+    PATHLIB_ASSERT(data || size == 0);
+    
+    pathlib_error = PATHLIB_NONE;
+    
+    if (size <= writer->capacity - writer->size) {
+        memcpy(writer->buffer + writer->size, data, size);
+        writer->size += size;
+        return 1;
+    }
+    
+    #ifndef PATHLIB_NO_THREADS
+        if (writer->background) {
+            while (size > 0) {
+                n = writer->capacity - writer->size;
+                if (n > size) {
+                    n = size;
+                }
+                memcpy(writer->buffer + writer->size, data, n);
+                writer->size += n;
+                data = (const unsigned char*)data + n;
+                size -= n;
+                if (writer->size == writer->capacity) {
+                    pathlib__writer_handoff(writer, 0);
+                }
+            }
+            return pathlib__writer_check(writer);
+        }
+    #else
+        (void) n;
+    #endif
+    
+    /* the buffered data and the new data go out in a single writev */
+    buffs[0] = writer->buffer;
+    sizes[0] = writer->size;
+    buffs[1] = data;
+    sizes[1] = size;
+    writer->size = 0;
+    if (writer->error == 0) {
+        writer->error = pathlib__writer_write_raw(writer, buffs, sizes, 2);
+    }
+    
+    return pathlib__writer_check(writer);
+}
+
+PATHLIB_API int pathlib_writer_flush(Pathlib_Writer* writer) {
+    const unsigned char* buff;
+    size_t size;
+    
+    PATHLIB_ASSERT(writer);
+    
+    pathlib_error = PATHLIB_NONE;
+    
+    #ifndef PATHLIB_NO_THREADS
+        if (writer->background) {
+            pathlib__writer_handoff(writer, 1);
+            return pathlib__writer_check(writer);
+        }
+    #endif
+    
+    buff = writer->buffer;
+    size = writer->size;
+    writer->size = 0;
+    if (size > 0 && writer->error == 0) {
+        writer->error = pathlib__writer_write_raw(writer, &buff, &size, 1);
+    }
+    
+    return pathlib__writer_check(writer);
+}
+
+PATHLIB_API int pathlib_writer_close(Pathlib_Writer* writer) {
+    int ok;
+    
+    PATHLIB_ASSERT(writer);
+    
+    ok = pathlib_writer_flush(writer);
+    
+    #ifndef PATHLIB_NO_THREADS
+        if (writer->background) {
+            pathlib__mutex_lock(&writer->mutex);
+            writer->stop = 1;
+            pathlib__cond_broadcast(&writer->cond);
+            pathlib__mutex_unlock(&writer->mutex);
+            pathlib__thread_join(writer->thread);
+            pathlib__mutex_destroy(&writer->mutex);
+            pathlib__cond_destroy(&writer->cond);
+            PATHLIB_FREE(writer->spare);
+        }
+    #endif
+    
+    #ifdef _WIN32
+        if (!CloseHandle(writer->handle) && ok) {
+            pathlib_print_os_error("CloseHandle", writer->filename);
+            pathlib_error = PATHLIB_OSERROR;
+            ok = 0;
+        }
+    #else
+        if (close(writer->fd) != 0 && ok) {
+            pathlib_print_os_error("close", writer->filename);
+            pathlib_error = PATHLIB_OSERROR;
+            ok = 0;
+        }
+    #endif
+    
+    PATHLIB_FREE(writer->buffer);
+    PATHLIB_FREE(writer);
+    
+    return ok;
+}
+
+#ifndef _WIN32
+/* waits until a non blocking descriptor can take more data */
+static int pathlib__wait_writable(int fd) {
+    struct pollfd pfd;
+    
+    pfd.fd = fd;
+    pfd.events = POLLOUT;
+    pfd.revents = 0;
+    while (poll(&pfd, 1, -1) < 0) {
+        if (errno != EINTR) {
+            return 0;
+        }
+    }
+    
+    return 1;
+}
+#endif /* _WIN32 */
+
+PATHLIB_API int pathlib_send_to_fd(const Path* path, int out_fd, size_t offset, size_t len) {
+    char filename[PATHLIB_MAX_PATH];
+    unsigned char* buff;
+    size_t chunk;
+    #ifdef _WIN32
+        FILE* f;
+        int n;
+    #else
+        struct stat statbuf;
+        off_t pos, end;
+        ssize_t n, written;
+        int fd, mode;
+    #endif
+    
+    PATHLIB_ASSERT(path);
+    
+    pathlib_error = PATHLIB_NONE;
+    
+    if (!pathlib_exists(path)) {
+        pathlib_error = PATHLIB_NEXISTS;
+        return 0;
+    }
+    
+    if (!pathlib_render_str_to_buffer(path, filename, PATHLIB_ARRSIZE(filename))) {
+        pathlib_error = PATHLIB_NEXISTS;
+        return 0;
+    }
+    
+    #ifdef _WIN32
+        f = fopen(filename, "rb");
+        if (f == NULL) {
+            pathlib_print_os_error("fopen", filename);
+            pathlib_error = PATHLIB_OSERROR;
+            return 0;
+        }
+        /* fseek takes a long which is 32 bits on windows */
+        if (_fseeki64(f, (__int64)offset, SEEK_SET) != 0) {
+            pathlib_print_os_error("_fseeki64", filename);
+            pathlib_error = PATHLIB_OSERROR;
+            fclose(f);
+            return 0;
+        }
+        
+        buff = pathlib__malloc(PATHLIB_SEND_BUFFER_SIZE);
+        for (;;) {
+            chunk = PATHLIB_SEND_BUFFER_SIZE;
+            if (len != 0 && chunk > len) {
+                chunk = len;
+            }
+            chunk = fread(buff, 1, chunk, f);
+            if (chunk == 0) {
+                break;
+            }
+            n = _write(out_fd, buff, (unsigned int)chunk);
+            if (n < 0 || (size_t)n != chunk) {
+                pathlib_print_func_failed("_write");
+                pathlib_error = PATHLIB_OSERROR;
+                PATHLIB_FREE(buff);
+                fclose(f);
+                return 0;
+            }
+            if (len != 0) {
+                len -= chunk;
+                if (len == 0) {
+                    break;
+                }
+            }
+        }
+        PATHLIB_FREE(buff);
+        fclose(f);
+        
+        return 1;
+    #else
+        fd = open(filename, O_RDONLY);
+        if (fd < 0) {
+            pathlib_print_os_error("open", filename);
+            pathlib_error = PATHLIB_OSERROR;
+            return 0;
+        }
+        
+        if (fstat(fd, &statbuf) != 0) {
+            pathlib_print_os_error("fstat", filename);
+            pathlib_error = PATHLIB_OSERROR;
+            close(fd);
+            return 0;
+        }
+        
+        /* the range is checked against what is left after offset so offset + len cant wrap */
+        pos = 0;
+        end = 0;
+        if ((pathlib_u64)offset < (pathlib_u64)statbuf.st_size) {
+            pos = (off_t)offset;
+            end = statbuf.st_size;
+            if (len != 0 && (pathlib_u64)len < (pathlib_u64)(end - pos)) {
+                end = pos + (off_t)len;
+            }
+        }
+        
+        #ifdef POSIX_FADV_SEQUENTIAL
+            posix_fadvise(fd, pos, end - pos, POSIX_FADV_SEQUENTIAL);
+        #endif
+        
+        /* 0: sendfile, 1: splice, 2: read and write, each one is tried when the previous isnt supported */
+        mode = 0;
+        #ifndef __linux__
+            (void) mode; /* only linux has sendfile and splice */
+        #endif
+        buff = NULL;
+        while (pos < end) {
+            chunk = end - pos > 0x40000000 ? 0x40000000 : (size_t)(end - pos);
+            
+            #ifdef __linux__
+                if (mode == 0) {
+                    n = sendfile(out_fd, fd, &pos, chunk);
+                    if (n < 0 && (errno == EINVAL || errno == ENOSYS)) {
+                        mode = 1;
+                        continue;
+                    }
+                } else
+            #endif
+            #if defined(__linux__) && defined(SPLICE_F_MOVE)
+                if (mode == 1) {
+                    /* splice needs a pipe on one side, out_fd is the only candidate */
+                    n = splice(fd, &pos, out_fd, NULL, chunk, SPLICE_F_MOVE | SPLICE_F_MORE);
+                    if (n < 0 && (errno == EINVAL || errno == ENOSYS)) {
+                        mode = 2;
+                        continue;
+                    }
+                } else
+            #endif
+            {
+                if (buff == NULL) {
+                    buff = pathlib__malloc(PATHLIB_SEND_BUFFER_SIZE);
+                }
+                if (chunk > PATHLIB_SEND_BUFFER_SIZE) {
+                    chunk = PATHLIB_SEND_BUFFER_SIZE;
+                }
+                n = pread(fd, buff, chunk, pos);
+                if (n > 0) {
+                    chunk = n;
+                    written = 0;
+                    while ((size_t)written < chunk) {
+                        n = write(out_fd, buff + written, chunk - written);
+                        if (n < 0) {
+                            if (errno == EINTR || ((errno == EAGAIN || errno == EWOULDBLOCK) && pathlib__wait_writable(out_fd))) {
+                                continue;
+                            }
+                            break;
+                        }
+                        written += n;
+                    }
+                    if (n >= 0) {
+                        n = written;
+                        pos += written;
+                    }
+                }
+            }
+            
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                if ((errno == EAGAIN || errno == EWOULDBLOCK) && pathlib__wait_writable(out_fd)) {
+                    continue;
+                }
+                pathlib_print_os_error("send", filename);
+                pathlib_error = PATHLIB_OSERROR;
+                PATHLIB_FREE(buff);
+                close(fd);
+                return 0;
+            }
+            if (n == 0) {
+                /* the file got shorter while it was sent */
+                break;
+            }
+        }
+        
+        PATHLIB_FREE(buff);
+        close(fd);
+        
+        return 1;
+    #endif
+}
+
+#define pathlib__rotl64(x, r) (((x) << (r)) | ((x) >> (64 - (r))))
+#define pathlib__rotr32(x, r) ((((x) >> (r)) | ((x) << (32 - (r)))) & 0xFFFFFFFFu)
+
+static pathlib_u64 pathlib__read64le(const unsigned char* p) {
+    return (pathlib_u64)p[0] | ((pathlib_u64)p[1] << 8) | ((pathlib_u64)p[2] << 16) | ((pathlib_u64)p[3] << 24) |
+           ((pathlib_u64)p[4] << 32) | ((pathlib_u64)p[5] << 40) | ((pathlib_u64)p[6] << 48) | ((pathlib_u64)p[7] << 56);
+}
+
+static pathlib_u32 pathlib__read32le(const unsigned char* p) {
+    return (pathlib_u32)p[0] | ((pathlib_u32)p[1] << 8) | ((pathlib_u32)p[2] << 16) | ((pathlib_u32)p[3] << 24);
+}
+
+static void pathlib__write64be(unsigned char* p, pathlib_u64 value) {
+    int i;
+    for (i = 7; i >= 0; i--) {
+        p[i] = (unsigned char)value;
+        value >>= 8;
+    }
+}
+
+static void pathlib__write64le(unsigned char* p, pathlib_u64 value) {
+    int i;
+    for (i = 0; i < 8; i++) {
+        p[i] = (unsigned char)value;
+        value >>= 8;
+    }
+}
+
+/* xxHash64 by Yann Collet, four independent lanes of 8 bytes */
+#define PATHLIB__XXH_P1 PATHLIB__U64(0x9E3779B1UL, 0x85EBCA87UL)
+#define PATHLIB__XXH_P2 PATHLIB__U64(0xC2B2AE3DUL, 0x27D4EB4FUL)
+#define PATHLIB__XXH_P3 PATHLIB__U64(0x165667B1UL, 0x9E3779F9UL)
+#define PATHLIB__XXH_P4 PATHLIB__U64(0x85EBCA77UL, 0xC2B2AE63UL)
+#define PATHLIB__XXH_P5 PATHLIB__U64(0x27D4EB2FUL, 0x165667C5UL)
+
+static pathlib_u64 pathlib__xxh64_round(pathlib_u64 acc, pathlib_u64 input) {
+    acc += input * PATHLIB__XXH_P2;
+    acc = pathlib__rotl64(acc, 31);
+    return acc * PATHLIB__XXH_P1;
+}
+
+static pathlib_u64 pathlib__xxh64_merge(pathlib_u64 acc, pathlib_u64 value) {
+    acc ^= pathlib__xxh64_round(0, value);
+    return acc * PATHLIB__XXH_P1 + PATHLIB__XXH_P4;
+}
+
+static const unsigned char* pathlib__xxh64_stripes(pathlib_u64* v, const unsigned char* p, const unsigned char* end) {
+    pathlib_u64 v1 = v[0], v2 = v[1], v3 = v[2], v4 = v[3];
+    
+    while (p + 32 <= end) {
+        v1 = pathlib__xxh64_round(v1, pathlib__read64le(p));
+        v2 = pathlib__xxh64_round(v2, pathlib__read64le(p + 8));
+        v3 = pathlib__xxh64_round(v3, pathlib__read64le(p + 16));
+        v4 = pathlib__xxh64_round(v4, pathlib__read64le(p + 24));
+        p += 32;
+    }
+    
+    v[0] = v1;
+    v[1] = v2;
+    v[2] = v3;
+    v[3] = v4;
+    return p;
+}
+
+static pathlib_u64 pathlib__xxh64_final(const pathlib_u64* v, pathlib_u64 total_size, const unsigned char* p, size_t size) {
+    pathlib_u64 h;
+    
+    if (total_size >= 32) {
+        h = pathlib__rotl64(v[0], 1) + pathlib__rotl64(v[1], 7) + pathlib__rotl64(v[2], 12) + pathlib__rotl64(v[3], 18);
+        h = pathlib__xxh64_merge(h, v[0]);
+        h = pathlib__xxh64_merge(h, v[1]);
+        h = pathlib__xxh64_merge(h, v[2]);
+        h = pathlib__xxh64_merge(h, v[3]);
+    } else {
+        h = v[2] + PATHLIB__XXH_P5;
+    }
+    h += total_size;
+    
+    while (size >= 8) {
+        h ^= pathlib__xxh64_round(0, pathlib__read64le(p));
+        h = pathlib__rotl64(h, 27) * PATHLIB__XXH_P1 + PATHLIB__XXH_P4;
+        p += 8;
+        size -= 8;
+    }
+    if (size >= 4) {
+        h ^= (pathlib_u64)pathlib__read32le(p) * PATHLIB__XXH_P1;
+        h = pathlib__rotl64(h, 23) * PATHLIB__XXH_P2 + PATHLIB__XXH_P3;
+        p += 4;
+        size -= 4;
+    }
+    while (size > 0) {
+        h ^= (*p) * PATHLIB__XXH_P5;
+        h = pathlib__rotl64(h, 11) * PATHLIB__XXH_P1;
+        p++;
+        size--;
+    }
+    
+    h ^= h >> 33;
+    h *= PATHLIB__XXH_P2;
+    h ^= h >> 29;
+    h *= PATHLIB__XXH_P3;
+    h ^= h >> 32;
+    return h;
+}
+
+/* MurmurHash3 x64 128 by Austin Appleby, two lanes of 8 bytes */
+#define PATHLIB__MURMUR_C1 PATHLIB__U64(0x87C37B91UL, 0x114253D5UL)
+#define PATHLIB__MURMUR_C2 PATHLIB__U64(0x4CF5AD43UL, 0x2745937FUL)
+
+static pathlib_u64 pathlib__murmur_fmix(pathlib_u64 k) {
+    k ^= k >> 33;
+    k *= PATHLIB__U64(0xFF51AFD7UL, 0xED558CCDUL);
+    k ^= k >> 33;
+    k *= PATHLIB__U64(0xC4CEB9FEUL, 0x1A85EC53UL);
+    k ^= k >> 33;
+    return k;
+}
+
+static const unsigned char* pathlib__murmur_blocks(pathlib_u64* state, const unsigned char* p, const unsigned char* end) {
+    pathlib_u64 h1 = state[0], h2 = state[1], k1, k2;
+    
+    while (p + 16 <= end) {
+        k1 = pathlib__read64le(p);
+        k2 = pathlib__read64le(p + 8);
+        
+        k1 *= PATHLIB__MURMUR_C1;
+        k1 = pathlib__rotl64(k1, 31);
+        k1 *= PATHLIB__MURMUR_C2;
+        h1 ^= k1;
+        h1 = pathlib__rotl64(h1, 27);
+        h1 += h2;
+        h1 = h1 * 5 + 0x52DCE729;
+        
+        k2 *= PATHLIB__MURMUR_C2;
+        k2 = pathlib__rotl64(k2, 33);
+        k2 *= PATHLIB__MURMUR_C1;
+        h2 ^= k2;
+        h2 = pathlib__rotl64(h2, 31);
+        h2 += h1;
+        h2 = h2 * 5 + 0x38495AB5;
+        
+        p += 16;
+    }
+    
+    state[0] = h1;
+    state[1] = h2;
+    return p;
+}
+
+static void pathlib__murmur_final(const pathlib_u64* state, pathlib_u64 total_size, const unsigned char* tail, size_t size, unsigned char* out) {
+    pathlib_u64 h1 = state[0], h2 = state[1], k1 = 0, k2 = 0;
+    size_t i;
+    
+    for (i = size; i > 8; i--) {
+        k2 ^= (pathlib_u64)tail[i - 1] << ((i - 9) * 8);
+    }
+    if (size > 8) {
+        k2 *= PATHLIB__MURMUR_C2;
+        k2 = pathlib__rotl64(k2, 33);
+        k2 *= PATHLIB__MURMUR_C1;
+        h2 ^= k2;
+    }
+    for (i = size > 8 ? 8 : size; i > 0; i--) {
+        k1 ^= (pathlib_u64)tail[i - 1] << ((i - 1) * 8);
+    }
+    if (size > 0) {
+        k1 *= PATHLIB__MURMUR_C1;
+        k1 = pathlib__rotl64(k1, 31);
+        k1 *= PATHLIB__MURMUR_C2;
+        h1 ^= k1;
+    }
+    
+    h1 ^= total_size;
+    h2 ^= total_size;
+    h1 += h2;
+    h2 += h1;
+    h1 = pathlib__murmur_fmix(h1);
+    h2 = pathlib__murmur_fmix(h2);
+    h1 += h2;
+    h2 += h1;
+    
+    pathlib__write64le(out, h1);
+    pathlib__write64le(out + 8, h2);
+}
+
+/* SHA-256 as specified in FIPS 180-4 */
+static const pathlib_u32 pathlib__sha256_k[64] = {
+    0x428A2F98, 0x71374491, 0xB5C0FBCF, 0xE9B5DBA5, 0x3956C25B, 0x59F111F1, 0x923F82A4, 0xAB1C5ED5,
+    0xD807AA98, 0x12835B01, 0x243185BE, 0x550C7DC3, 0x72BE5D74, 0x80DEB1FE, 0x9BDC06A7, 0xC19BF174,
+    0xE49B69C1, 0xEFBE4786, 0x0FC19DC6, 0x240CA1CC, 0x2DE92C6F, 0x4A7484AA, 0x5CB0A9DC, 0x76F988DA,
+    0x983E5152, 0xA831C66D, 0xB00327C8, 0xBF597FC7, 0xC6E00BF3, 0xD5A79147, 0x06CA6351, 0x14292967,
+    0x27B70A85, 0x2E1B2138, 0x4D2C6DFC, 0x53380D13, 0x650A7354, 0x766A0ABB, 0x81C2C92E, 0x92722C85,
+    0xA2BFE8A1, 0xA81A664B, 0xC24B8B70, 0xC76C51A3, 0xD192E819, 0xD6990624, 0xF40E3585, 0x106AA070,
+    0x19A4C116, 0x1E376C08, 0x2748774C, 0x34B0BCB5, 0x391C0CB3, 0x4ED8AA4A, 0x5B9CCA4F, 0x682E6FF3,
+    0x748F82EE, 0x78A5636F, 0x84C87814, 0x8CC70208, 0x90BEFFFA, 0xA4506CEB, 0xBEF9A3F7, 0xC67178F2
+};
+
+static void pathlib__sha256_blocks_generic(pathlib_u32* state, const unsigned char* p, size_t blocks) {
+    pathlib_u32 w[64], a, b, c, d, e, f, g, h, t1, t2, s0, s1;
+    size_t i;
+    
+    while (blocks--) {
+        for (i = 0; i < 16; i++) {
+            w[i] = ((pathlib_u32)p[i * 4] << 24) | ((pathlib_u32)p[i * 4 + 1] << 16) | ((pathlib_u32)p[i * 4 + 2] << 8) | (pathlib_u32)p[i * 4 + 3];
+        }
+        for (i = 16; i < 64; i++) {
+            s0 = pathlib__rotr32(w[i - 15], 7) ^ pathlib__rotr32(w[i - 15], 18) ^ (w[i - 15] >> 3);
+            s1 = pathlib__rotr32(w[i - 2], 17) ^ pathlib__rotr32(w[i - 2], 19) ^ (w[i - 2] >> 10);
+            w[i] = (w[i - 16] + s0 + w[i - 7] + s1) & 0xFFFFFFFFu;
+        }
+        
+        a = state[0]; b = state[1]; c = state[2]; d = state[3];
+        e = state[4]; f = state[5]; g = state[6]; h = state[7];
+        
+        for (i = 0; i < 64; i++) {
+            s1 = pathlib__rotr32(e, 6) ^ pathlib__rotr32(e, 11) ^ pathlib__rotr32(e, 25);
+            t1 = (h + s1 + ((e & f) ^ (~e & g)) + pathlib__sha256_k[i] + w[i]) & 0xFFFFFFFFu;
+            s0 = pathlib__rotr32(a, 2) ^ pathlib__rotr32(a, 13) ^ pathlib__rotr32(a, 22);
+            t2 = (s0 + ((a & b) ^ (a & c) ^ (b & c))) & 0xFFFFFFFFu;
+            h = g;
+            g = f;
+            f = e;
+            e = (d + t1) & 0xFFFFFFFFu;
+            d = c;
+            c = b;
+            b = a;
+            a = (t1 + t2) & 0xFFFFFFFFu;
+        }
+        
+        state[0] = (state[0] + a) & 0xFFFFFFFFu;
+        state[1] = (state[1] + b) & 0xFFFFFFFFu;
+        state[2] = (state[2] + c) & 0xFFFFFFFFu;
+        state[3] = (state[3] + d) & 0xFFFFFFFFu;
+        state[4] = (state[4] + e) & 0xFFFFFFFFu;
+        state[5] = (state[5] + f) & 0xFFFFFFFFu;
+        state[6] = (state[6] + g) & 0xFFFFFFFFu;
+        state[7] = (state[7] + h) & 0xFFFFFFFFu;
+        
+        p += 64;
+    }
+}
+
+#if !defined(PATHLIB_NO_SIMD) && (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define PATHLIB__SHA_NI
+#include <immintrin.h>
+#include <cpuid.h>
+
+/* the x86 SHA extensions do two rounds per instruction */
+__attribute__((target("sha,sse4.1,ssse3")))
+static void pathlib__sha256_blocks_sha_ni(pathlib_u32* state, const unsigned char* p, size_t blocks) {
+    __m128i state0, state1, msg, tmp, abef, cdgh;
+    __m128i w[4];
+    const __m128i mask = _mm_set_epi32(0x0C0D0E0F, 0x08090A0B, 0x04050607, 0x00010203);
+    int i;
+    
+    tmp = _mm_loadu_si128((const __m128i*)&state[0]);
+    state1 = _mm_loadu_si128((const __m128i*)&state[4]);
+    tmp = _mm_shuffle_epi32(tmp, 0xB1);
+    state1 = _mm_shuffle_epi32(state1, 0x1B);
+    state0 = _mm_alignr_epi8(tmp, state1, 8);
+    state1 = _mm_blend_epi16(state1, tmp, 0xF0);
+    
+    while (blocks--) {
+        abef = state0;
+        cdgh = state1;
+        
+        for (i = 0; i < 16; i++) {
+            if (i < 4) {
+                w[i] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(p + i * 16)), mask);
+            }
+            msg = _mm_add_epi32(w[i & 3], _mm_loadu_si128((const __m128i*)&pathlib__sha256_k[i * 4]));
+            state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+            if (i >= 3 && i <= 14) {
+                tmp = _mm_alignr_epi8(w[i & 3], w[(i - 1) & 3], 4);
+                w[(i + 1) & 3] = _mm_add_epi32(w[(i + 1) & 3], tmp);
+                w[(i + 1) & 3] = _mm_sha256msg2_epu32(w[(i + 1) & 3], w[i & 3]);
+            }
+            msg = _mm_shuffle_epi32(msg, 0x0E);
+            state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+            if (i >= 1 && i <= 12) {
+                w[(i - 1) & 3] = _mm_sha256msg1_epu32(w[(i - 1) & 3], w[i & 3]);
+            }
+        }
+        
+        state0 = _mm_add_epi32(state0, abef);
+        state1 = _mm_add_epi32(state1, cdgh);
+        p += 64;
+    }
+    
+    tmp = _mm_shuffle_epi32(state0, 0x1B);
+    state1 = _mm_shuffle_epi32(state1, 0xB1);
+    state0 = _mm_blend_epi16(tmp, state1, 0xF0);
+    state1 = _mm_alignr_epi8(state1, tmp, 8);
+    _mm_storeu_si128((__m128i*)&state[0], state0);
+    _mm_storeu_si128((__m128i*)&state[4], state1);
+}
+
+static int pathlib__has_sha_ni(void) {
+    static int cached = -1;
+    unsigned int eax, ebx, ecx, edx;
+    int supported = 0;
+    
+    if (cached >= 0) {
+        return cached;
+    }
+    
+    if (__get_cpuid(1, &eax, &ebx, &ecx, &edx) && (ecx & (1u << 19)) && (ecx & (1u << 9))) {
+        if (__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx) && (ebx & (1u << 29))) {
+            supported = 1;
+        }
+    }
+    
+    cached = supported;
+    return supported;
+}
+#endif
+
+static void pathlib__sha256_blocks(pathlib_u32* state, const unsigned char* p, size_t blocks) {
+    #ifdef PATHLIB__SHA_NI
+        if (pathlib__has_sha_ni()) {
+            pathlib__sha256_blocks_sha_ni(state, p, blocks);
+            return;
+        }
+    #endif
+    pathlib__sha256_blocks_generic(state, p, blocks);
+}
+
+PATHLIB_API size_t pathlib_digest_size(int algo) {
+    switch (algo & ~PATHLIB_DIGEST_TREE) {
+        case PATHLIB_DIGEST_XXH64: return 8;
+        case PATHLIB_DIGEST_MURMUR3_128: return 16;
+        case PATHLIB_DIGEST_SHA256: return 32;
+    }
+    
+    PATHLIB_ASSERT(0 && "unknown digest algorithm");
+    return 0;
+}
+
+PATHLIB_API void pathlib_digest_init(Pathlib_Digest* digest, int algo) {
+    static const pathlib_u32 sha256_init[8] = {
+        0x6A09E667, 0xBB67AE85, 0x3C6EF372, 0xA54FF53A, 0x510E527F, 0x9B05688C, 0x1F83D9AB, 0x5BE0CD19
+    };
+    
+    PATHLIB_ASSERT(digest);
+    PATHLIB_ASSERT((algo & PATHLIB_DIGEST_TREE) == 0);
+    
+    digest->algo = algo;
+    digest->total_size = 0;
+    digest->buffer_size = 0;
+    
+    switch (algo) {
+        case PATHLIB_DIGEST_XXH64:
+            digest->state.u64[0] = PATHLIB__XXH_P1 + PATHLIB__XXH_P2;
+            digest->state.u64[1] = PATHLIB__XXH_P2;
+            digest->state.u64[2] = 0;
+            digest->state.u64[3] = 0 - PATHLIB__XXH_P1;
+            break;
+        case PATHLIB_DIGEST_MURMUR3_128:
+            digest->state.u64[0] = 0;
+            digest->state.u64[1] = 0;
+            break;
+        case PATHLIB_DIGEST_SHA256:
+            memcpy(digest->state.u32, sha256_init, sizeof(sha256_init));
+            break;
+        default:
+            PATHLIB_ASSERT(0 && "unknown digest algorithm");
+    }
+}
+
+PATHLIB_API void pathlib_digest_update(Pathlib_Digest* digest, const void* data, size_t size) {
+    const unsigned char* p = data;
+    const unsigned char* end = p + size;
+    size_t block_size, n;
+    
+    PATHLIB_ASSERT(digest);
+    PATHLIB_ASSERT(data || size == 0);
+    
+    digest->total_size += size;
+    block_size = digest->algo == PATHLIB_DIGEST_XXH64 ? 32 : digest->algo == PATHLIB_DIGEST_MURMUR3_128 ? 16 : 64;
+    
+    /* finish the partial block from the previous update first */
+    if (digest->buffer_size > 0) {
+        n = block_size - digest->buffer_size;
+        if (n > size) {
+            n = size;
+        }
+        memcpy(digest->buffer + digest->buffer_size, p, n);
+        digest->buffer_size += n;
+        p += n;
+        if (digest->buffer_size < block_size) {
+            return;
+        }
+        switch (digest->algo) {
+            case PATHLIB_DIGEST_XXH64: pathlib__xxh64_stripes(digest->state.u64, digest->buffer, digest->buffer + 32); break;
+            case PATHLIB_DIGEST_MURMUR3_128: pathlib__murmur_blocks(digest->state.u64, digest->buffer, digest->buffer + 16); break;
+            case PATHLIB_DIGEST_SHA256: pathlib__sha256_blocks(digest->state.u32, digest->buffer, 1); break;
+        }
+        digest->buffer_size = 0;
+    }
+    
+    switch (digest->algo) {
+        case PATHLIB_DIGEST_XXH64: p = pathlib__xxh64_stripes(digest->state.u64, p, end); break;
+        case PATHLIB_DIGEST_MURMUR3_128: p = pathlib__murmur_blocks(digest->state.u64, p, end); break;
+        case PATHLIB_DIGEST_SHA256:
+            n = (end - p) / 64;
+            pathlib__sha256_blocks(digest->state.u32, p, n);
+            p += n * 64;
+            break;
+    }
+    
+    memcpy(digest->buffer, p, end - p);
+    digest->buffer_size = end - p;
+}
+
+PATHLIB_API void pathlib_digest_final(Pathlib_Digest* digest, unsigned char* out) {
+    unsigned char padding[128];
+    pathlib_u64 bits;
+    size_t padding_size, i;
+    
+    PATHLIB_ASSERT(digest);
+    PATHLIB_ASSERT(out);
+    
+    switch (digest->algo) {
+        case PATHLIB_DIGEST_XXH64:
+            pathlib__write64be(out, pathlib__xxh64_final(digest->state.u64, digest->total_size, digest->buffer, digest->buffer_size));
+            break;
+        case PATHLIB_DIGEST_MURMUR3_128:
+            pathlib__murmur_final(digest->state.u64, digest->total_size, digest->buffer, digest->buffer_size, out);
+            break;
+        case PATHLIB_DIGEST_SHA256:
+            bits = digest->total_size * 8;
+            padding_size = digest->buffer_size < 56 ? 64 : 128;
+            memset(padding, 0, sizeof(padding));
+            memcpy(padding, digest->buffer, digest->buffer_size);
+            padding[digest->buffer_size] = 0x80;
+            pathlib__write64be(padding + padding_size - 8, bits);
+            pathlib__sha256_blocks(digest->state.u32, padding, padding_size / 64);
+            for (i = 0; i < 8; i++) {
+                out[i * 4] = (unsigned char)(digest->state.u32[i] >> 24);
+                out[i * 4 + 1] = (unsigned char)(digest->state.u32[i] >> 16);
+                out[i * 4 + 2] = (unsigned char)(digest->state.u32[i] >> 8);
+                out[i * 4 + 3] = (unsigned char)digest->state.u32[i];
+            }
+            break;
+    }
+}
+
+PATHLIB_API void pathlib_digest_buffer(int algo, const void* data, size_t size, unsigned char* out) {
+    Pathlib_Digest digest;
+    
+    pathlib_digest_init(&digest, algo);
+    pathlib_digest_update(&digest, data, size);
+    pathlib_digest_final(&digest, out);
+}
+
+PATHLIB_API void pathlib_digest_to_hex(const unsigned char* digest, size_t digest_size, char* hex) {
+    static const char digits[] = "0123456789abcdef";
+    size_t i;
+    
+    PATHLIB_ASSERT(digest);
+    PATHLIB_ASSERT(hex);
+    
+    for (i = 0; i < digest_size; i++) {
+        hex[i * 2] = digits[digest[i] >> 4];
+        hex[i * 2 + 1] = digits[digest[i] & 15];
+    }
+    hex[digest_size * 2] = 0;
+}
+
+#ifndef PATHLIB_NO_THREADS
+static size_t pathlib__cpu_count(void) {
+    #ifdef _WIN32
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        return info.dwNumberOfProcessors > 0 ? info.dwNumberOfProcessors : 1;
+    #else
+        long count = sysconf(_SC_NPROCESSORS_ONLN);
+        return count > 0 ? (size_t)count : 1;
+    #endif
+}
+#endif /* PATHLIB_NO_THREADS */
+
+#define PATHLIB__PRIORITY_COUNT 3
+
+typedef struct Pathlib__Task {
+    Pathlib_Task_Func func;
+    void* arg;
+    pathlib_u64 generation; /* the cancel generation of the executor when it was submitted */
+} Pathlib__Task;
+
+#ifndef PATHLIB_NO_THREADS
+/* a ring buffer, the owner takes the newest task and thieves take the oldest */
+typedef struct Pathlib__Deque {
+    Pathlib__Mutex mutex;
+    Pathlib__Task* tasks;
+    size_t head;     /* the oldest task */
+    size_t size;
+    size_t capacity; /* always 0 or a power of two */
+} Pathlib__Deque;
+
+typedef struct Pathlib__Executor_Worker {
+    Pathlib_Executor* executor;
+    size_t index;
+    Pathlib__Thread thread;
+    Pathlib__Thread_Id id;
+    Pathlib__Deque deques[PATHLIB__PRIORITY_COUNT];
+} Pathlib__Executor_Worker;
+
+/* what an external pool runs for every task */
+typedef struct Pathlib__Executor_Job {
+    Pathlib_Executor* executor;
+    Pathlib__Task task;
+} Pathlib__Executor_Job;
+#endif /* PATHLIB_NO_THREADS */
+
+struct Pathlib_Executor {
+    Pathlib_Executor_Callbacks callbacks; /* submit is NULL for the own threads */
+    size_t worker_count;
+    #ifndef PATHLIB_NO_THREADS
+        Pathlib__Executor_Worker* workers;
+        size_t allocated;    /* the workers whose deques were initialized, some threads may have failed to start */
+        Pathlib__Mutex mutex;
+        Pathlib__Cond wake;  /* the workers sleep on it while nothing is queued */
+        Pathlib__Cond idle;  /* signals outstanding reaching 0 and the workers starting */
+        size_t queued;       /* the tasks inside the deques */
+        size_t outstanding;  /* the tasks that were submitted and didnt return yet */
+        size_t started;
+        size_t next;         /* the worker that gets the next task from a thread outside the pool */
+        int ready;
+        int stop;
+    #endif
+    pathlib_u64 generation;  /* incremented by pathlib_executor_cancel */
+};
+
+/* the executor of the parallel functions */
+static Pathlib_Executor* pathlib__default_executor = NULL;
+
+#ifndef PATHLIB_NO_THREADS
+/* the caller must hold the mutex of the deque */
+static void pathlib__deque_push(Pathlib__Deque* deque, const Pathlib__Task* task) {
+    Pathlib__Task* tasks;
+    size_t i;
+    
+    if (deque->size == deque->capacity) {
+        tasks = pathlib__malloc(sizeof(*tasks) * (deque->capacity == 0 ? 16 : deque->capacity * 2));
+        for (i = 0; i < deque->size; i++) {
+            tasks[i] = deque->tasks[(deque->head + i) & (deque->capacity - 1)];
+        }
+        PATHLIB_FREE(deque->tasks);
+        deque->tasks = tasks;
+        deque->head = 0;
+        deque->capacity = deque->capacity == 0 ? 16 : deque->capacity * 2;
+    }
+    
+    deque->tasks[(deque->head + deque->size) & (deque->capacity - 1)] = *task;
+    deque->size++;
+}
+
+static int pathlib__deque_pop(Pathlib__Deque* deque, int steal, Pathlib__Task* task) {
+    int found;
+    
+    pathlib__mutex_lock(&deque->mutex);
+    found = deque->size > 0;
+    if (found && steal) {
+        *task = deque->tasks[deque->head];
+        deque->head = (deque->head + 1) & (deque->capacity - 1);
+        deque->size--;
+    } else if (found) {
+        *task = deque->tasks[(deque->head + deque->size - 1) & (deque->capacity - 1)];
+        deque->size--;
+    }
+    pathlib__mutex_unlock(&deque->mutex);
+    
+    return found;
+}
+
+/* the index of the worker that runs on the calling thread, or worker_count if it is not a worker */
+static size_t pathlib__executor_self(const Pathlib_Executor* executor) {
+    Pathlib__Thread_Id self;
+    size_t i;
+    
+    self = pathlib__thread_self();
+    for (i = 0; i < executor->worker_count; i++) {
+        if (pathlib__thread_equal(executor->workers[i].id, self)) {
+            break;
+        }
+    }
+    
+    return i;
+}
+
+/* the highest priority goes first, the own deque before the deques of the others */
+static int pathlib__executor_take(Pathlib_Executor* executor, size_t self, Pathlib__Task* task, int* cancelled) {
+    size_t i, victim;
+    int priority;
+    
+    for (priority = PATHLIB__PRIORITY_COUNT - 1; priority >= 0; priority--) {
+        for (i = 0; i < executor->worker_count; i++) {
+            victim = (self + i) % executor->worker_count;
+            if (pathlib__deque_pop(&executor->workers[victim].deques[priority], victim != self, task)) {
+                pathlib__mutex_lock(&executor->mutex);
+                executor->queued--;
+                *cancelled = task->generation != executor->generation;
+                pathlib__mutex_unlock(&executor->mutex);
+                return 1;
+            }
+        }
+    }
+    
+    return 0;
+}
+
+static void pathlib__executor_finish(Pathlib_Executor* executor) {
+    pathlib__mutex_lock(&executor->mutex);
+    if (--executor->outstanding == 0) {
+        pathlib__cond_broadcast(&executor->idle);
+    }
+    pathlib__mutex_unlock(&executor->mutex);
+}
+
+static void pathlib__executor_worker(void* arg) {
+    Pathlib__Executor_Worker* self = arg;
+    Pathlib_Executor* executor = self->executor;
+    Pathlib__Task task;
+    int cancelled;
+    
+    /* the workers only look at each other once all of them started */
+    pathlib__mutex_lock(&executor->mutex);
+    self->id = pathlib__thread_self();
+    executor->started++;
+    pathlib__cond_broadcast(&executor->idle);
+    while (!executor->ready) {
+        pathlib__cond_wait(&executor->wake, &executor->mutex);
+    }
+    pathlib__mutex_unlock(&executor->mutex);
+    
+    for (;;) {
+        if (pathlib__executor_take(executor, self->index, &task, &cancelled)) {
+            task.func(task.arg, cancelled);
+            pathlib__executor_finish(executor);
+            continue;
+        }
+        
+        pathlib__mutex_lock(&executor->mutex);
+        while (!executor->stop && executor->queued == 0) {
+            pathlib__cond_wait(&executor->wake, &executor->mutex);
+        }
+        if (executor->stop && executor->queued == 0) {
+            pathlib__mutex_unlock(&executor->mutex);
+            break;
+        }
+        pathlib__mutex_unlock(&executor->mutex);
+    }
+}
+
+static void pathlib__executor_run_job(void* arg) {
+    Pathlib__Executor_Job* job = arg;
+    Pathlib_Executor* executor = job->executor;
+    int cancelled;
+    
+    pathlib__mutex_lock(&executor->mutex);
+    cancelled = job->task.generation != executor->generation;
+    pathlib__mutex_unlock(&executor->mutex);
+    
+    job->task.func(job->task.arg, cancelled);
+    PATHLIB_FREE(job);
+    pathlib__executor_finish(executor);
+}
+#endif /* PATHLIB_NO_THREADS */
+
+PATHLIB_API Pathlib_Executor* pathlib_executor_new(size_t workers) {
+    Pathlib_Executor* executor;
+    #ifndef PATHLIB_NO_THREADS
+        size_t i;
+        int priority;
+    #endif
+    
+    pathlib_error = PATHLIB_NONE;
+    
+    executor = pathlib__malloc(sizeof(*executor));
+    memset(executor, 0, sizeof(*executor));
+    
+    #ifdef PATHLIB_NO_THREADS
+        (void) workers;
+        executor->worker_count = 1;
+    #else
+        if (workers == 0) {
+            workers = pathlib__cpu_count();
+        }
+        
+        pathlib__mutex_init(&executor->mutex);
+        pathlib__cond_init(&executor->wake);
+        pathlib__cond_init(&executor->idle);
+        executor->workers = pathlib__malloc(sizeof(*executor->workers) * workers);
+        executor->allocated = workers;
+        for (i = 0; i < workers; i++) {
+            executor->workers[i].executor = executor;
+            executor->workers[i].index = i;
+            for (priority = 0; priority < PATHLIB__PRIORITY_COUNT; priority++) {
+                memset(&executor->workers[i].deques[priority], 0, sizeof(executor->workers[i].deques[priority]));
+                pathlib__mutex_init(&executor->workers[i].deques[priority].mutex);
+            }
+        }
+        
+        /* if a thread cant be created the pool just has less of them */
+        for (i = 0; i < workers; i++) {
+            if (!pathlib__thread_create(&executor->workers[i].thread, pathlib__executor_worker, &executor->workers[i])) {
+                break;
+            }
+        }
+        
+        pathlib__mutex_lock(&executor->mutex);
+        while (executor->started < i) {
+            pathlib__cond_wait(&executor->idle, &executor->mutex);
+        }
+        executor->worker_count = i;
+        executor->ready = 1;
+        pathlib__cond_broadcast(&executor->wake);
+        pathlib__mutex_unlock(&executor->mutex);
+        
+        if (i == 0) {
+            pathlib_executor_free(executor);
+            pathlib_error = PATHLIB_OSERROR;
+            return NULL;
+        }
+    #endif
+    
+    return executor;
+}
+
+PATHLIB_API Pathlib_Executor* pathlib_executor_from_callbacks(const Pathlib_Executor_Callbacks* callbacks) {
+    Pathlib_Executor* executor;
+    
+    PATHLIB_ASSERT(callbacks);
+    PATHLIB_ASSERT(callbacks->submit);
+    
+    executor = pathlib__malloc(sizeof(*executor));
+    memset(executor, 0, sizeof(*executor));
+    executor->callbacks = *callbacks;
+    executor->worker_count = callbacks->workers > 0 ? callbacks->workers : 1;
+    #ifndef PATHLIB_NO_THREADS
+        pathlib__mutex_init(&executor->mutex);
+        pathlib__cond_init(&executor->wake);
+        pathlib__cond_init(&executor->idle);
+        executor->ready = 1;
+    #endif
+    
+    return executor;
+}
+
+PATHLIB_API void pathlib_executor_free(Pathlib_Executor* executor) {
+    #ifndef PATHLIB_NO_THREADS
+        size_t i;
+        int priority;
+    #endif
+    
+    if (executor == NULL) {
+        return;
+    }
+    
+    #ifndef PATHLIB_NO_THREADS
+        pathlib_executor_wait(executor);
+        
+        pathlib__mutex_lock(&executor->mutex);
+        executor->stop = 1;
+        pathlib__cond_broadcast(&executor->wake);
+        pathlib__mutex_unlock(&executor->mutex);
+        
+        if (executor->callbacks.submit == NULL) {
+            for (i = 0; i < executor->worker_count; i++) {
+                pathlib__thread_join(executor->workers[i].thread);
+            }
+            for (i = 0; i < executor->allocated; i++) {
+                for (priority = 0; priority < PATHLIB__PRIORITY_COUNT; priority++) {
+                    pathlib__mutex_destroy(&executor->workers[i].deques[priority].mutex);
+                    PATHLIB_FREE(executor->workers[i].deques[priority].tasks);
+                }
+            }
+            PATHLIB_FREE(executor->workers);
+        }
+        
+        pathlib__mutex_destroy(&executor->mutex);
+        pathlib__cond_destroy(&executor->wake);
+        pathlib__cond_destroy(&executor->idle);
+    #endif
+    PATHLIB_FREE(executor);
+}
+
+PATHLIB_API size_t pathlib_executor_workers(const Pathlib_Executor* executor) {
+    PATHLIB_ASSERT(executor);
+    
+    return executor->worker_count;
+}
+
+PATHLIB_API int pathlib_executor_submit(Pathlib_Executor* executor, Pathlib_Task_Func func, void* arg, int priority) {
+    #ifndef PATHLIB_NO_THREADS
+        Pathlib__Executor_Job* job;
+        Pathlib__Task task;
+        size_t target;
+    #endif
+    
+    PATHLIB_ASSERT(executor);
+    PATHLIB_ASSERT(func);
+    
+    if (priority < PATHLIB_PRIORITY_LOW) {
+        priority = PATHLIB_PRIORITY_LOW;
+    } else if (priority > PATHLIB_PRIORITY_HIGH) {
+        priority = PATHLIB_PRIORITY_HIGH;
+    }
+    
+    #ifdef PATHLIB_NO_THREADS
+        func(arg, 0);
+    #else
+        task.func = func;
+        task.arg = arg;
+        
+        if (executor->callbacks.submit != NULL) {
+            job = pathlib__malloc(sizeof(*job));
+            job->executor = executor;
+            job->task = task;
+            pathlib__mutex_lock(&executor->mutex);
+            job->task.generation = executor->generation;
+            executor->outstanding++;
+            pathlib__mutex_unlock(&executor->mutex);
+            
+            if (!executor->callbacks.submit(executor->callbacks.pool, pathlib__executor_run_job, job, priority)) {
+                PATHLIB_FREE(job);
+                pathlib__executor_finish(executor);
+                return 0;
+            }
+            return 1;
+        }
+        
+        target = pathlib__executor_self(executor);
+        
+        pathlib__mutex_lock(&executor->mutex);
+        if (target == executor->worker_count) {
+            target = executor->next++ % executor->worker_count;
+        }
+        task.generation = executor->generation;
+        pathlib__mutex_lock(&executor->workers[target].deques[priority].mutex);
+        pathlib__deque_push(&executor->workers[target].deques[priority], &task);
+        pathlib__mutex_unlock(&executor->workers[target].deques[priority].mutex);
+        executor->queued++;
+        executor->outstanding++;
+        pathlib__cond_signal(&executor->wake);
+        pathlib__mutex_unlock(&executor->mutex);
+    #endif
+    
+    return 1;
+}
+
+PATHLIB_API void pathlib_executor_cancel(Pathlib_Executor* executor) {
+    PATHLIB_ASSERT(executor);
+    
+    #ifndef PATHLIB_NO_THREADS
+        pathlib__mutex_lock(&executor->mutex);
+    #endif
+    executor->generation++;
+    #ifndef PATHLIB_NO_THREADS
+        pathlib__mutex_unlock(&executor->mutex);
+    #endif
+}
+
+PATHLIB_API void pathlib_executor_wait(Pathlib_Executor* executor) {
+    PATHLIB_ASSERT(executor);
+    
+    #ifndef PATHLIB_NO_THREADS
+        pathlib__mutex_lock(&executor->mutex);
+        while (executor->outstanding > 0) {
+            pathlib__cond_wait(&executor->idle, &executor->mutex);
+        }
+        pathlib__mutex_unlock(&executor->mutex);
+    #endif
+}
+
+PATHLIB_API void pathlib_executor_set_default(PATHLIB_NULLABLE Pathlib_Executor* executor) {
+    pathlib__default_executor = executor;
+}
+
+typedef void (*Pathlib__Parallel_Func)(void* ctx, size_t index, size_t worker);
+
+/* how many workers pathlib__parallel_for will use for count items */
+static size_t pathlib__parallel_workers(size_t count) {
+    #ifdef PATHLIB_NO_THREADS
+        (void) count;
+        return 1;
+    #else
+        size_t workers;
+        
+        workers = pathlib__default_executor != NULL ? pathlib__default_executor->worker_count : pathlib__cpu_count();
+        if (workers > count) {
+            workers = count;
+        }
+        return workers > 0 ? workers : 1;
+    #endif
+}
+
+#ifndef PATHLIB_NO_THREADS
+typedef struct Pathlib__Parallel_Worker {
+    struct Pathlib__Parallel* parallel;
+    size_t worker;
+} Pathlib__Parallel_Worker;
+
+typedef struct Pathlib__Parallel {
+    Pathlib__Parallel_Func func;
+    void* ctx;
+    size_t count;
+    size_t next;
+    size_t running; /* the calls of func that didnt return yet */
+    size_t refs;    /* the caller and the tasks that didnt run yet, the last one frees it */
+    Pathlib__Mutex mutex;
+    Pathlib__Cond done;
+    Pathlib__Parallel_Worker* selves;
+} Pathlib__Parallel;
+
+static void pathlib__parallel_run(Pathlib__Parallel* parallel, size_t worker) {
+    size_t index;
+    
+    pathlib__mutex_lock(&parallel->mutex);
+    while (parallel->next < parallel->count) {
+        index = parallel->next++;
+        parallel->running++;
+        pathlib__mutex_unlock(&parallel->mutex);
+        
+        parallel->func(parallel->ctx, index, worker);
+        
+        pathlib__mutex_lock(&parallel->mutex);
+        parallel->running--;
+    }
+    if (parallel->running == 0) {
+        pathlib__cond_broadcast(&parallel->done);
+    }
+    pathlib__mutex_unlock(&parallel->mutex);
+}
+
+static void pathlib__parallel_worker(void* arg) {
+    Pathlib__Parallel_Worker* self = arg;
+    
+    pathlib__parallel_run(self->parallel, self->worker);
+}
+
+static void pathlib__parallel_release(Pathlib__Parallel* parallel) {
+    size_t refs;
+    
+    pathlib__mutex_lock(&parallel->mutex);
+    refs = --parallel->refs;
+    pathlib__mutex_unlock(&parallel->mutex);
+    
+    if (refs == 0) {
+        pathlib__mutex_destroy(&parallel->mutex);
+        pathlib__cond_destroy(&parallel->done);
+        PATHLIB_FREE(parallel->selves);
+        PATHLIB_FREE(parallel);
+    }
+}
+
+/* a task of the executor that helps the caller, it may start after all the items are done */
+static void pathlib__parallel_task(void* arg, int cancelled) {
+    Pathlib__Parallel_Worker* self = arg;
+    Pathlib__Parallel* parallel = self->parallel;
+    
+    if (!cancelled) {
+        pathlib__parallel_run(parallel, self->worker);
+    }
+    pathlib__parallel_release(parallel);
+}
+#endif /* PATHLIB_NO_THREADS */
+
+/* calls func for every index in [0, count) with at most workers threads, the calling thread is worker 0 */
+static void pathlib__parallel_for(size_t count, size_t workers, Pathlib__Parallel_Func func, void* ctx) {
+    size_t i;
+    #ifndef PATHLIB_NO_THREADS
+        Pathlib_Executor* executor = pathlib__default_executor;
+        Pathlib__Parallel* parallel;
+        Pathlib__Thread* threads;
+        int* started;
+    #endif
+    
+    if (workers <= 1 || count <= 1) {
+        for (i = 0; i < count; i++) {
+            func(ctx, i, 0);
+        }
+        return;
+    }
+    
+    #ifndef PATHLIB_NO_THREADS
+        parallel = pathlib__malloc(sizeof(*parallel));
+        parallel->func = func;
+        parallel->ctx = ctx;
+        parallel->count = count;
+        parallel->next = 0;
+        parallel->running = 0;
+        parallel->refs = workers;
+        pathlib__mutex_init(&parallel->mutex);
+        pathlib__cond_init(&parallel->done);
+        parallel->selves = pathlib__malloc(sizeof(*parallel->selves) * workers);
+        for (i = 0; i < workers; i++) {
+            parallel->selves[i].parallel = parallel;
+            parallel->selves[i].worker = i;
+        }
+        
+        if (executor != NULL) {
+            /* the tasks only help, the caller never waits for a task that didnt start so a full pool cant deadlock it */
+            for (i = 1; i < workers; i++) {
+                if (!pathlib_executor_submit(executor, pathlib__parallel_task, &parallel->selves[i], PATHLIB_PRIORITY_HIGH)) {
+                    pathlib__parallel_release(parallel);
+                }
+            }
+            pathlib__parallel_run(parallel, 0);
+            
+            pathlib__mutex_lock(&parallel->mutex);
+            while (parallel->running > 0) {
+                pathlib__cond_wait(&parallel->done, &parallel->mutex);
+            }
+            pathlib__mutex_unlock(&parallel->mutex);
+            pathlib__parallel_release(parallel);
+            return;
+        }
+        
+        threads = pathlib__malloc(sizeof(*threads) * workers);
+        started = pathlib__malloc(sizeof(*started) * workers);
+        
+        for (i = 0; i < workers; i++) {
+            /* if a thread cant be created the remaining workers just do more of the work */
+            started[i] = i > 0 && pathlib__thread_create(&threads[i], pathlib__parallel_worker, &parallel->selves[i]);
+        }
+        pathlib__parallel_worker(&parallel->selves[0]);
+        for (i = 1; i < workers; i++) {
+            if (started[i]) {
+                pathlib__thread_join(threads[i]);
+            }
+        }
+        
+        parallel->refs = 1;
+        pathlib__parallel_release(parallel);
+        PATHLIB_FREE(threads);
+        PATHLIB_FREE(started);
+    #endif
+}
+
+#ifdef _WIN32
+    typedef FILE* Pathlib__File;
+#else
+    typedef int Pathlib__File;
+#endif
+
+/* reads up to size bytes at offset, returns the amount of bytes read or -1 on error */
+static long pathlib__pread(Pathlib__File file, unsigned char* buff, size_t size, pathlib_u64 offset) {
+    #ifdef _WIN32
+        /* windows only reaches here from a single thread so the shared file position is fine */
+        if (_fseeki64(file, (__int64)offset, SEEK_SET) != 0) {
+            return -1;
+        }
+        size = fread(buff, 1, size, file);
+        return ferror(file) ? -1 : (long)size;
+    #else
+        size_t done = 0;
+        ssize_t n;
+        
+        while (done < size) {
+            n = pread(file, buff + done, size - done, offset + done);
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return -1;
+            }
+            if (n == 0) {
+                break;
+            }
+            done += n;
+        }
+        return (long)done;
+    #endif
+}
+
+typedef struct Pathlib__Tree_Digest {
+    Pathlib__File file;
+    const char* filename;
+    int algo;
+    pathlib_u64 file_size;
+    unsigned char* digests;  /* one digest per chunk */
+    unsigned char** buffers; /* one chunk buffer per worker */
+    #ifndef PATHLIB_NO_THREADS
+        Pathlib__Mutex mutex; /* guards failed */
+    #endif
+    int failed;
+} Pathlib__Tree_Digest;
+
+static void pathlib__tree_digest_chunk(void* arg, size_t index, size_t worker) {
+    Pathlib__Tree_Digest* tree = arg;
+    pathlib_u64 offset = (pathlib_u64)index * PATHLIB_DIGEST_TREE_CHUNK_SIZE;
+    size_t size = PATHLIB_DIGEST_TREE_CHUNK_SIZE;
+    long n;
+    
+    if (offset + size > tree->file_size) {
+        size = (size_t)(tree->file_size - offset);
+    }
+    if (tree->buffers[worker] == NULL) {
+        tree->buffers[worker] = pathlib__malloc(PATHLIB_DIGEST_TREE_CHUNK_SIZE);
+    }
+    
+    n = pathlib__pread(tree->file, tree->buffers[worker], size, offset);
+    if (n < 0) {
+        pathlib_print_os_error("pread", tree->filename);
+        #ifndef PATHLIB_NO_THREADS
+            pathlib__mutex_lock(&tree->mutex);
+        #endif
+        tree->failed = 1;
+        #ifndef PATHLIB_NO_THREADS
+            pathlib__mutex_unlock(&tree->mutex);
+        #endif
+        return;
+    }
+    pathlib_digest_buffer(tree->algo, tree->buffers[worker], n, tree->digests + index * pathlib_digest_size(tree->algo));
+}
+
+/* hashes the file with the given name, sets pathlib_error in case of error */
+static int pathlib__file_digest(const char* filename, int algo, unsigned char* out) {
+    Pathlib__Tree_Digest tree;
+    Pathlib_Digest digest;
+    unsigned char* buff;
+    unsigned char size_bytes[8];
+    size_t chunks, workers, i;
+    pathlib_u64 offset;
+    long n;
+    #ifndef _WIN32
+        struct stat statbuf;
+    #endif
+    
+    #ifdef _WIN32
+        tree.file = fopen(filename, "rb");
+        if (tree.file == NULL) {
+            pathlib_print_os_error("fopen", filename);
+            pathlib_error = PATHLIB_OSERROR;
+            return 0;
+        }
+        _fseeki64(tree.file, 0, SEEK_END);
+        tree.file_size = _ftelli64(tree.file);
+        _fseeki64(tree.file, 0, SEEK_SET);
+    #else
+        tree.file = open(filename, O_RDONLY);
+        if (tree.file < 0) {
+            pathlib_print_os_error("open", filename);
+            pathlib_error = PATHLIB_OSERROR;
+            return 0;
+        }
+        if (fstat(tree.file, &statbuf) != 0) {
+            pathlib_print_os_error("fstat", filename);
+            pathlib_error = PATHLIB_OSERROR;
+            close(tree.file);
+            return 0;
+        }
+        tree.file_size = statbuf.st_size;
+        #ifdef POSIX_FADV_SEQUENTIAL
+            posix_fadvise(tree.file, 0, 0, POSIX_FADV_SEQUENTIAL);
+        #endif
+    #endif
+    
+    tree.filename = filename;
+    tree.algo = algo & ~PATHLIB_DIGEST_TREE;
+    tree.failed = 0;
+    
+    if (algo & PATHLIB_DIGEST_TREE) {
+        /* every chunk is hashed on its own and the root hashes the chunk digests and the file size */
+        chunks = (size_t)((tree.file_size + PATHLIB_DIGEST_TREE_CHUNK_SIZE - 1) / PATHLIB_DIGEST_TREE_CHUNK_SIZE);
+        workers = pathlib__parallel_workers(chunks);
+        #ifdef _WIN32
+            workers = 1;
+        #endif
+        tree.digests = pathlib__malloc(chunks * pathlib_digest_size(tree.algo) + 1);
+        tree.buffers = pathlib__malloc(sizeof(*tree.buffers) * workers);
+        memset(tree.buffers, 0, sizeof(*tree.buffers) * workers);
+        
+        #ifndef PATHLIB_NO_THREADS
+            pathlib__mutex_init(&tree.mutex);
+        #endif
+        pathlib__parallel_for(chunks, workers, pathlib__tree_digest_chunk, &tree);
+        #ifndef PATHLIB_NO_THREADS
+            pathlib__mutex_destroy(&tree.mutex);
+        #endif
+        
+        if (!tree.failed) {
+            pathlib__write64le(size_bytes, tree.file_size);
+            pathlib_digest_init(&digest, tree.algo);
+            pathlib_digest_update(&digest, tree.digests, chunks * pathlib_digest_size(tree.algo));
+            pathlib_digest_update(&digest, size_bytes, sizeof(size_bytes));
+            pathlib_digest_final(&digest, out);
+        }
+        
+        for (i = 0; i < workers; i++) {
+            PATHLIB_FREE(tree.buffers[i]);
+        }
+        PATHLIB_FREE(tree.buffers);
+        PATHLIB_FREE(tree.digests);
+    } else {
+        buff = pathlib__malloc(PATHLIB_DIGEST_BUFFER_SIZE);
+        pathlib_digest_init(&digest, tree.algo);
+        offset = 0;
+        for (;;) {
+            n = pathlib__pread(tree.file, buff, PATHLIB_DIGEST_BUFFER_SIZE, offset);
+            if (n < 0) {
+                pathlib_print_os_error("read", filename);
+                tree.failed = 1;
+                break;
+            }
+            if (n == 0) {
+                break;
+            }
+            pathlib_digest_update(&digest, buff, n);
+            offset += n;
+        }
+        if (!tree.failed) {
+            pathlib_digest_final(&digest, out);
+        }
+        PATHLIB_FREE(buff);
+    }
+    
+    #ifdef _WIN32
+        fclose(tree.file);
+    #else
+        close(tree.file);
+    #endif
+    
+    if (tree.failed) {
+        pathlib_error = PATHLIB_OSERROR;
+        return 0;
+    }
+    
+    return 1;
+}
+
+PATHLIB_API int pathlib_file_digest(const Path* path, int algo, unsigned char* out) {
+    char filename[PATHLIB_MAX_PATH];
+    
+    PATHLIB_ASSERT(path);
+    PATHLIB_ASSERT(out);
+    
+    pathlib_error = PATHLIB_NONE;
+    
+    if (!pathlib_exists(path)) {
+        pathlib_error = PATHLIB_NEXISTS;
+        return 0;
+    }
+    
+    if (!pathlib_render_str_to_buffer(path, filename, PATHLIB_ARRSIZE(filename))) {
+        pathlib_error = PATHLIB_NEXISTS;
+        return 0;
+    }
+    
+    return pathlib__file_digest(filename, algo, out);
+}
+
+/* the subset of stat that pathlib uses, filled the same way on every platform */
+typedef struct Pathlib__Stat {
+    int type; /* Pathlib_Entry_Type */
+    unsigned int mode;
+    unsigned long uid;
+    pathlib_u64 size;
+    pathlib_u64 allocated; /* the bytes of the blocks that the file uses */
+    pathlib_u64 nlink;
+    pathlib_u64 dev;
+    pathlib_u64 ino;
+    pathlib_u64 mtime_sec;
+    pathlib_u64 mtime_nsec;
+} Pathlib__Stat;
+
+#ifndef _WIN32
+static void pathlib__stat_from_native(const struct stat* statbuf, Pathlib__Stat* st) {
+    st->mode = statbuf->st_mode;
+    st->uid = statbuf->st_uid;
+    st->size = statbuf->st_size;
+    /* st_blocks is always in 512 byte units */
+    st->allocated = (pathlib_u64)statbuf->st_blocks * 512;
+    st->nlink = statbuf->st_nlink;
+    st->dev = statbuf->st_dev;
+    st->ino = statbuf->st_ino;
+    st->mtime_sec = statbuf->st_mtime;
+    #if defined(__APPLE__)
+        st->mtime_nsec = statbuf->st_mtimespec.tv_nsec;
+    #else
+        st->mtime_nsec = statbuf->st_mtim.tv_nsec;
+    #endif
+    
+    if (S_ISREG(statbuf->st_mode)) {
+        st->type = PATHLIB_ENTRY_FILE;
+    } else if (S_ISDIR(statbuf->st_mode)) {
+        st->type = PATHLIB_ENTRY_DIR;
+    } else if (S_ISLNK(statbuf->st_mode)) {
+        st->type = PATHLIB_ENTRY_SYMLINK;
+    } else {
+        st->type = PATHLIB_ENTRY_OTHER;
+    }
+}
+#endif /* _WIN32 */
+
+/* returns 0 and leaves errno set when the file cant be stat'ed */
+static int pathlib__stat_str(const char* filename, int follow_symlinks, Pathlib__Stat* st) {
+    #ifdef _WIN32
+        WIN32_FILE_ATTRIBUTE_DATA data;
+        pathlib_u64 ticks;
+        
+        (void) follow_symlinks;
+        
+        if (!GetFileAttributesExA(filename, GetFileExInfoStandard, &data)) {
+            errno = ENOENT;
+            return 0;
+        }
+        
+        ticks = ((pathlib_u64)data.ftLastWriteTime.dwHighDateTime << 32) | data.ftLastWriteTime.dwLowDateTime;
+        /* FILETIME counts 100ns intervals since 1601 */
+        ticks -= PATHLIB__U64(0x019DB1DEUL, 0xD53E8000UL);
+        st->mtime_sec = ticks / 10000000;
+        st->mtime_nsec = (ticks % 10000000) * 100;
+        st->size = ((pathlib_u64)data.nFileSizeHigh << 32) | data.nFileSizeLow;
+        st->allocated = st->size;
+        st->nlink = 1;
+        st->uid = 0;
+        st->dev = 0;
+        st->ino = 0;
+        if (data.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) {
+            st->type = PATHLIB_ENTRY_SYMLINK;
+            st->mode = 0120777;
+        } else if (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+            st->type = PATHLIB_ENTRY_DIR;
+            st->mode = 0040755;
+        } else {
+            st->type = PATHLIB_ENTRY_FILE;
+            st->mode = (data.dwFileAttributes & FILE_ATTRIBUTE_READONLY) ? 0100444 : 0100644;
+        }
+        return 1;
+    #else
+        struct stat statbuf;
+        
+        if ((follow_symlinks ? stat(filename, &statbuf) : lstat(filename, &statbuf)) != 0) {
+            return 0;
+        }
+        pathlib__stat_from_native(&statbuf, st);
+        return 1;
+    #endif
+}
+
+/* the names inside a directory, all of them live inside one buffer */
+typedef struct Pathlib__Names {
+    char* data;
+    size_t data_size;
+    size_t data_capacity;
+    char** names;
+    size_t count;
+} Pathlib__Names;
+
+static void pathlib__names_push(Pathlib__Names* names, const char* name) {
+    size_t size = strlen(name) + 1;
+    char* temp;
+    
+    if (names->data_size + size > names->data_capacity) {
+        names->data_capacity = names->data_capacity == 0 ? 1024 : names->data_capacity * 2;
+        while (names->data_size + size > names->data_capacity) {
+            names->data_capacity *= 2;
+        }
+        temp = pathlib__malloc(names->data_capacity);
+        if (names->data_size > 0) {
+            memcpy(temp, names->data, names->data_size);
+        }
+        PATHLIB_FREE(names->data);
+        names->data = temp;
+    }
+    
+    memcpy(names->data + names->data_size, name, size);
+    names->data_size += size;
+    names->count++;
+}
+
+static int pathlib__names_cmp(const void* a, const void* b) {
+    return strcmp(*(char* const*)a, *(char* const*)b);
+}
+
+/* lists the directory without "." and "..", sorted by name when sorted is set */
+static int pathlib__names_read(Pathlib__Names* names, const char* dirname, int sorted) {
+    size_t i;
+    char* p;
+    #ifdef _WIN32
+        char search_path[PATHLIB_MAX_PATH + 3];
+        WIN32_FIND_DATA find_data;
+        HANDLE hFind;
+    #else
+        DIR* dir;
+        struct dirent* entry;
+    #endif
+    
+    names->data = NULL;
+    names->data_size = 0;
+    names->data_capacity = 0;
+    names->names = NULL;
+    names->count = 0;
+    
+    #ifdef _WIN32
+        if (snprintf(search_path, sizeof(search_path), "%s\\*", dirname) < 0) {
+            return 0;
+        }
+        hFind = FindFirstFile(search_path, &find_data);
+        if (hFind == INVALID_HANDLE_VALUE) {
+            pathlib_print_os_error("FindFirstFile", search_path);
+            return 0;
+        }
+        do {
+            if (strcmp(find_data.cFileName, ".") != 0 && strcmp(find_data.cFileName, "..") != 0) {
+                pathlib__names_push(names, find_data.cFileName);
+            }
+        } while (FindNextFile(hFind, &find_data) != 0);
+        FindClose(hFind);
+    #else
+        dir = opendir(dirname);
+        if (dir == NULL) {
+            pathlib_print_os_error("opendir", dirname);
+            return 0;
+        }
+        while ((entry = readdir(dir)) != NULL) {
+            if (strcmp(entry->d_name, ".") != 0 && strcmp(entry->d_name, "..") != 0) {
+                pathlib__names_push(names, entry->d_name);
+            }
+        }
+        closedir(dir);
+    #endif
+    
+    names->names = pathlib__malloc(sizeof(*names->names) * (names->count + 1));
+    p = names->data;
+    for (i = 0; i < names->count; i++) {
+        names->names[i] = p;
+        p += strlen(p) + 1;
+    }
+    
+    if (sorted && names->count > 1) {
+        qsort(names->names, names->count, sizeof(*names->names), pathlib__names_cmp);
+    }
+    
+    return 1;
+}
+
+static void pathlib__names_free(Pathlib__Names* names) {
+    PATHLIB_FREE(names->data);
+    PATHLIB_FREE(names->names);
+    names->data = NULL;
+    names->names = NULL;
+    names->count = 0;
+}
+
+/* a one shot hash for the internal hash tables */
+static pathlib_u64 pathlib__hash_bytes(const void* data, size_t size) {
+    pathlib_u64 v[4];
+    const unsigned char* p = data;
+    const unsigned char* end = p + size;
+    
+    v[0] = PATHLIB__XXH_P1 + PATHLIB__XXH_P2;
+    v[1] = PATHLIB__XXH_P2;
+    v[2] = 0;
+    v[3] = 0 - PATHLIB__XXH_P1;
+    p = pathlib__xxh64_stripes(v, p, end);
+    
+    return pathlib__xxh64_final(v, size, p, end - p);
+}
+
+/* an open addressing hash table from strings to pointers */
+typedef struct Pathlib__Str_Map_Slot {
+    pathlib_u64 hash;
+    char* key; /* NULL for empty slots */
+    size_t key_size;
+    void* value;
+} Pathlib__Str_Map_Slot;
+
+typedef struct Pathlib__Str_Map {
+    Pathlib__Str_Map_Slot* slots;
+    size_t size;
+    size_t capacity; /* always 0 or a power of two */
+} Pathlib__Str_Map;
+
+static Pathlib__Str_Map_Slot* pathlib__str_map_find(const Pathlib__Str_Map* map, const char* key, size_t key_size, pathlib_u64 hash) {
+    Pathlib__Str_Map_Slot* slot;
+    size_t i;
+    
+    for (i = (size_t)hash & (map->capacity - 1); ; i = (i + 1) & (map->capacity - 1)) {
+        slot = &map->slots[i];
+        if (slot->key == NULL) {
+            return slot;
+        }
+        if (slot->hash == hash && slot->key_size == key_size && memcmp(slot->key, key, key_size) == 0) {
+            return slot;
+        }
+    }
+}
+
+static void* pathlib__str_map_get(const Pathlib__Str_Map* map, const char* key, size_t key_size) {
+    if (map->size == 0) {
+        return NULL;
+    }
+    return pathlib__str_map_find(map, key, key_size, pathlib__hash_bytes(key, key_size))->value;
+}
+
+static void pathlib__str_map_grow(Pathlib__Str_Map* map) {
+    Pathlib__Str_Map_Slot* old_slots = map->slots;
+    size_t old_capacity = map->capacity, i;
+    
+    map->capacity = map->capacity == 0 ? 16 : map->capacity * 2;
+    map->slots = pathlib__malloc(sizeof(*map->slots) * map->capacity);
+    memset(map->slots, 0, sizeof(*map->slots) * map->capacity);
+    
+    for (i = 0; i < old_capacity; i++) {
+        if (old_slots[i].key != NULL) {
+            *pathlib__str_map_find(map, old_slots[i].key, old_slots[i].key_size, old_slots[i].hash) = old_slots[i];
+        }
+    }
+    
+    PATHLIB_FREE(old_slots);
+}
+
+/* returns the slot of key, new slots have a copy of the key and a NULL value */
+static Pathlib__Str_Map_Slot* pathlib__str_map_insert(Pathlib__Str_Map* map, const char* key, size_t key_size) {
+    Pathlib__Str_Map_Slot* slot;
+    pathlib_u64 hash;
+    
+    /* keep the load factor under 0.7 */
+    if ((map->size + 1) * 10 > map->capacity * 7) {
+        pathlib__str_map_grow(map);
+    }
+    
+    hash = pathlib__hash_bytes(key, key_size);
+    slot = pathlib__str_map_find(map, key, key_size, hash);
+    if (slot->key == NULL) {
+        slot->hash = hash;
+        slot->key = memcpy(pathlib__malloc(key_size + 1), key, key_size);
+        slot->key[key_size] = 0;
+        slot->key_size = key_size;
+        slot->value = NULL;
+        map->size++;
+    }
+    
+    return slot;
+}
+
+static void pathlib__str_map_free(Pathlib__Str_Map* map, int free_values) {
+    size_t i;
+    
+    for (i = 0; i < map->capacity; i++) {
+        if (map->slots[i].key != NULL) {
+            PATHLIB_FREE(map->slots[i].key);
+            if (free_values) {
+                PATHLIB_FREE(map->slots[i].value);
+            }
+        }
+    }
+    
+    PATHLIB_FREE(map->slots);
+    map->slots = NULL;
+    map->size = 0;
+    map->capacity = 0;
+}
+
+typedef struct Pathlib__Tree_Hash_Entry {
+    pathlib_u64 ino;
+    pathlib_u64 mtime_sec;
+    pathlib_u64 mtime_nsec;
+    pathlib_u64 size;
+    unsigned int mode;
+    unsigned long generation;
+    unsigned char content[PATHLIB_DIGEST_MAX_SIZE]; /* the digest of the contents of a file */
+    unsigned char node[PATHLIB_DIGEST_MAX_SIZE];    /* the merkle hash of the node */
+} Pathlib__Tree_Hash_Entry;
+
+struct Pathlib_Tree_Hash_Cache {
+    int algo;
+    unsigned long generation;
+    Pathlib__Str_Map entries; /* relative path -> Pathlib__Tree_Hash_Entry */
+};
+
+typedef struct Pathlib__Tree_Hash {
+    Pathlib_Tree_Hash_Cache* cache;
+    int algo;      /* the algorithm of the nodes */
+    int file_algo; /* the algorithm of the file contents, it may have PATHLIB_DIGEST_TREE */
+    size_t digest_size;
+    size_t root_size;
+    char path[PATHLIB_MAX_PATH];
+} Pathlib__Tree_Hash;
+
+/* hashes the node at th->path whose rendered length is path_size */
+static int pathlib__tree_hash_node(Pathlib__Tree_Hash* th, size_t path_size, const char* name, unsigned char* out) {
+    Pathlib__Tree_Hash_Entry* entry;
+    Pathlib__Str_Map_Slot* slot;
+    Pathlib__Names names;
+    Pathlib__Stat st;
+    Pathlib_Digest digest;
+    unsigned char content[PATHLIB_DIGEST_MAX_SIZE];
+    unsigned char header[5];
+    unsigned char* children;
+    const char* relative;
+    size_t relative_size, name_size, i, count;
+    #ifndef _WIN32
+        char target[PATHLIB_MAX_PATH];
+        ssize_t target_size;
+    #endif
+    
+    if (!pathlib__stat_str(th->path, 0, &st)) {
+        if (errno == ENOENT) {
+            /* it was deleted while the tree was hashed */
+            return -1;
+        }
+        pathlib_print_os_error("lstat", th->path);
+        return 0;
+    }
+    
+    relative = path_size > th->root_size ? th->path + th->root_size + 1 : "";
+    relative_size = path_size > th->root_size ? path_size - th->root_size - 1 : 0;
+    
+    entry = NULL;
+    if (th->cache) {
+        slot = pathlib__str_map_insert(&th->cache->entries, relative, relative_size);
+        if (slot->value == NULL) {
+            slot->value = pathlib__malloc(sizeof(*entry));
+            memset(slot->value, 0, sizeof(*entry));
+        }
+        entry = slot->value;
+    }
+    
+    if (st.type == PATHLIB_ENTRY_DIR) {
+        if (!pathlib__names_read(&names, th->path, 1)) {
+            return 0;
+        }
+        
+        children = pathlib__malloc(names.count * th->digest_size + 1);
+        count = 0;
+        for (i = 0; i < names.count; i++) {
+            name_size = strlen(names.names[i]);
+            if (path_size + 1 + name_size + 1 > sizeof(th->path)) {
+                pathlib_print_error("path too long inside `%s`", th->path);
+                PATHLIB_FREE(children);
+                pathlib__names_free(&names);
+                return 0;
+            }
+            th->path[path_size] = '/';
+            memcpy(th->path + path_size + 1, names.names[i], name_size + 1);
+            
+            switch (pathlib__tree_hash_node(th, path_size + 1 + name_size, names.names[i], children + count * th->digest_size)) {
+                case 0:
+                    PATHLIB_FREE(children);
+                    pathlib__names_free(&names);
+                    return 0;
+                case 1:
+                    count++;
+                    break;
+            }
+        }
+        th->path[path_size] = 0;
+        
+        /* the children of a directory are hashed in name order so the result doesnt depend on readdir */
+        pathlib_digest_init(&digest, th->algo);
+        pathlib_digest_update(&digest, children, count * th->digest_size);
+        pathlib_digest_final(&digest, content);
+        
+        PATHLIB_FREE(children);
+        pathlib__names_free(&names);
+    } else if (entry && entry->generation != 0 && entry->ino == st.ino && entry->mtime_sec == st.mtime_sec &&
+               entry->mtime_nsec == st.mtime_nsec && entry->size == st.size && entry->mode == st.mode) {
+        /* unchanged since the last run, reuse the stored digest */
+        memcpy(content, entry->content, th->digest_size);
+    } else if (st.type == PATHLIB_ENTRY_FILE) {
+        if (!pathlib__file_digest(th->path, th->file_algo, content)) {
+            return 0;
+        }
+    } else if (st.type == PATHLIB_ENTRY_SYMLINK) {
+        #ifdef _WIN32
+            pathlib_digest_buffer(th->algo, "", 0, content);
+        #else
+            target_size = readlink(th->path, target, sizeof(target));
+            if (target_size < 0) {
+                pathlib_print_os_error("readlink", th->path);
+                return 0;
+            }
+            pathlib_digest_buffer(th->algo, target, target_size, content);
+        #endif
+    } else {
+        pathlib_digest_buffer(th->algo, "", 0, content);
+    }
+    
+    /* node = H(type, mode, name, 0, contents) */
+    header[0] = st.type == PATHLIB_ENTRY_DIR ? 'd' : st.type == PATHLIB_ENTRY_FILE ? 'f' : st.type == PATHLIB_ENTRY_SYMLINK ? 'l' : 'o';
+    header[1] = (unsigned char)st.mode;
+    header[2] = (unsigned char)(st.mode >> 8);
+    header[3] = (unsigned char)(st.mode >> 16);
+    header[4] = (unsigned char)(st.mode >> 24);
+    pathlib_digest_init(&digest, th->algo);
+    pathlib_digest_update(&digest, header, sizeof(header));
+    pathlib_digest_update(&digest, name, strlen(name) + 1);
+    pathlib_digest_update(&digest, content, th->digest_size);
+    pathlib_digest_final(&digest, out);
+    
+    if (entry) {
+        entry->ino = st.ino;
+        entry->mtime_sec = st.mtime_sec;
+        entry->mtime_nsec = st.mtime_nsec;
+        entry->size = st.size;
+        entry->mode = st.mode;
+        entry->generation = th->cache->generation;
+        memcpy(entry->content, content, th->digest_size);
+        memcpy(entry->node, out, th->digest_size);
+    }
+    
+    return 1;
+}
+
+/* drops the entries of files that were not seen by the last run */
+static void pathlib__tree_hash_cache_prune(Pathlib_Tree_Hash_Cache* cache) {
+    Pathlib__Str_Map entries;
+    Pathlib__Str_Map_Slot* old;
+    size_t i;
+    
+    entries = cache->entries;
+    cache->entries.slots = NULL;
+    cache->entries.size = 0;
+    cache->entries.capacity = 0;
+    
+    for (i = 0; i < entries.capacity; i++) {
+        old = &entries.slots[i];
+        if (old->key == NULL) {
+            continue;
+        }
+        if (((Pathlib__Tree_Hash_Entry*)old->value)->generation == cache->generation) {
+            pathlib__str_map_insert(&cache->entries, old->key, old->key_size)->value = old->value;
+        } else {
+            PATHLIB_FREE(old->value);
+        }
+    }
+    
+    pathlib__str_map_free(&entries, 0);
+}
+
+PATHLIB_API Pathlib_Tree_Hash_Cache* pathlib_tree_hash_cache_new(int algo) {
+    Pathlib_Tree_Hash_Cache* cache;
+    
+    cache = pathlib__malloc(sizeof(*cache));
+    cache->algo = algo;
+    cache->generation = 0;
+    cache->entries.slots = NULL;
+    cache->entries.size = 0;
+    cache->entries.capacity = 0;
+    
+    return cache;
+}
+
+PATHLIB_API void pathlib_tree_hash_cache_free(Pathlib_Tree_Hash_Cache* cache) {
+    if (cache) {
+        pathlib__str_map_free(&cache->entries, 1);
+        PATHLIB_FREE(cache);
+    }
+}
+
+PATHLIB_API int pathlib_tree_hash(const Path* root, int algo, PATHLIB_NULLABLE Pathlib_Tree_Hash_Cache* cache, unsigned char* out) {
+    Pathlib__Tree_Hash* th;
+    int ret;
+    
+    PATHLIB_ASSERT(root);
+    PATHLIB_ASSERT(out);
+    PATHLIB_ASSERT(cache == NULL || cache->algo == algo);
+    
+    pathlib_error = PATHLIB_NONE;
+    
+    if (!pathlib_exists(root)) {
+        pathlib_error = PATHLIB_NEXISTS;
+        return 0;
+    }
+    
+    th = pathlib__malloc(sizeof(*th));
+    th->cache = cache;
+    th->algo = algo & ~PATHLIB_DIGEST_TREE;
+    th->file_algo = algo;
+    th->digest_size = pathlib_digest_size(th->algo);
+    
+    if (!pathlib_render_str_to_buffer(root, th->path, PATHLIB_ARRSIZE(th->path))) {
+        PATHLIB_FREE(th);
+        pathlib_error = PATHLIB_NEXISTS;
+        return 0;
+    }
+    th->root_size = strlen(th->path);
+    
+    if (cache) {
+        cache->generation++;
+    }
+    
+    /* the root has no name so equal trees hash the same wherever they are */
+    ret = pathlib__tree_hash_node(th, th->root_size, "", out);
+    PATHLIB_FREE(th);
+    
+    if (ret != 1) {
+        pathlib_error = ret == 0 ? PATHLIB_OSERROR : PATHLIB_NEXISTS;
+        return 0;
+    }
+    
+    if (cache) {
+        pathlib__tree_hash_cache_prune(cache);
+    }
+    
+    return 1;
+}
+
+PATHLIB_API int pathlib_tree_hash_cache_lookup(const Pathlib_Tree_Hash_Cache* cache, const Path* relative, unsigned char* out) {
+    char key[PATHLIB_MAX_PATH];
+    Pathlib__Tree_Hash_Entry* entry;
+    
+    PATHLIB_ASSERT(cache);
+    PATHLIB_ASSERT(relative);
+    PATHLIB_ASSERT(out);
+    
+    if (!pathlib_render_str_to_buffer(relative, key, PATHLIB_ARRSIZE(key))) {
+        return 0;
+    }
+    if (strcmp(key, ".") == 0) {
+        key[0] = 0;
+    }
+    
+    entry = pathlib__str_map_get(&cache->entries, key, strlen(key));
+    if (entry == NULL) {
+        return 0;
+    }
+    
+    memcpy(out, entry->node, pathlib_digest_size(cache->algo & ~PATHLIB_DIGEST_TREE));
+    return 1;
+}
+
+static char* pathlib__u64_to_str(pathlib_u64 value, char* end) {
+    *--end = 0;
+    do {
+        *--end = (char)('0' + value % 10);
+        value /= 10;
+    } while (value);
+    return end;
+}
+
+/* parses the digits at str, it stops at end */
+static pathlib_u64 pathlib__str_to_u64(const char** str, const char* end) {
+    pathlib_u64 value = 0;
+    
+    while (*str < end && **str >= '0' && **str <= '9') {
+        value = value * 10 + (**str - '0');
+        (*str)++;
+    }
+    
+    return value;
+}
+
+static int pathlib__hex_to_bytes(const char** str, unsigned char* out, size_t size) {
+    size_t i;
+    int j, c, nibble;
+    
+    for (i = 0; i < size; i++) {
+        out[i] = 0;
+        for (j = 0; j < 2; j++) {
+            c = *(*str)++;
+            if (c >= '0' && c <= '9') {
+                nibble = c - '0';
+            } else if (c >= 'a' && c <= 'f') {
+                nibble = c - 'a' + 10;
+            } else {
+                return 0;
+            }
+            out[i] = (unsigned char)(out[i] << 4 | nibble);
+        }
+    }
+    
+    return 1;
+}
+
+PATHLIB_API int pathlib_tree_hash_cache_save(const Pathlib_Tree_Hash_Cache* cache, const Path* path) {
+    Pathlib__Tree_Hash_Entry* entry;
+    Pathlib_Writer* writer;
+    char number[32], hex[PATHLIB_DIGEST_MAX_SIZE * 2 + 1];
+    pathlib_u64 fields[5];
+    size_t i, j, digest_size;
+    const char* key;
+    int ok;
+    
+    PATHLIB_ASSERT(cache);
+    PATHLIB_ASSERT(path);
+    
+    writer = pathlib_writer_open(path, 0, 0);
+    if (writer == NULL) {
+        return 0;
+    }
+    
+    digest_size = pathlib_digest_size(cache->algo & ~PATHLIB_DIGEST_TREE);
+    
+    /* one line per node: ino mtime_sec mtime_nsec size mode content node relative_path */
+    ok = pathlib_writer_append(writer, "pathlib-tree-hash 1 ", 20);
+    key = pathlib__u64_to_str(cache->algo, number + sizeof(number));
+    ok = ok && pathlib_writer_append(writer, key, strlen(key));
+    ok = ok && pathlib_writer_append(writer, "\n", 1);
+    
+    for (i = 0; ok && i < cache->entries.capacity; i++) {
+        if (cache->entries.slots[i].key == NULL) {
+            continue;
+        }
+        entry = cache->entries.slots[i].value;
+        fields[0] = entry->ino;
+        fields[1] = entry->mtime_sec;
+        fields[2] = entry->mtime_nsec;
+        fields[3] = entry->size;
+        fields[4] = entry->mode;
+        for (j = 0; ok && j < PATHLIB_ARRSIZE(fields); j++) {
+            key = pathlib__u64_to_str(fields[j], number + sizeof(number));
+            ok = pathlib_writer_append(writer, key, strlen(key)) && pathlib_writer_append(writer, " ", 1);
+        }
+        pathlib_digest_to_hex(entry->content, digest_size, hex);
+        ok = ok && pathlib_writer_append(writer, hex, digest_size * 2) && pathlib_writer_append(writer, " ", 1);
+        pathlib_digest_to_hex(entry->node, digest_size, hex);
+        ok = ok && pathlib_writer_append(writer, hex, digest_size * 2) && pathlib_writer_append(writer, " ", 1);
+        
+        /* newlines and backslashes inside names are escaped */
+        for (key = cache->entries.slots[i].key; ok && *key; key++) {
+            if (*key == '\n') {
+                ok = pathlib_writer_append(writer, "\\n", 2);
+            } else if (*key == '\\') {
+                ok = pathlib_writer_append(writer, "\\\\", 2);
+            } else {
+                ok = pathlib_writer_append(writer, key, 1);
+            }
+        }
+        ok = ok && pathlib_writer_append(writer, "\n", 1);
+    }
+    
+    return pathlib_writer_close(writer) && ok;
+}
+
+PATHLIB_API Pathlib_Tree_Hash_Cache* pathlib_tree_hash_cache_load(const Path* path) {
+    Pathlib_Tree_Hash_Cache* cache;
+    Pathlib__Tree_Hash_Entry* entry;
+    Pathlib__Str_Map_Slot* slot;
+    unsigned char* data;
+    char* key;
+    const char* p, *end;
+    pathlib_u64 fields[5];
+    size_t size, key_size, digest_size, i;
+    int algo, corrupted;
+    
+    PATHLIB_ASSERT(path);
+    
+    data = pathlib_read_bytes(path, &size);
+    if (data == NULL) {
+        pathlib_error = PATHLIB_NEXISTS;
+        return NULL;
+    }
+    
+    p = (const char*)data;
+    end = p + size;
+    if (size < 20 || memcmp(p, "pathlib-tree-hash 1 ", 20) != 0) {
+        pathlib_print_error("`%s` is not a tree hash cache", pathlib_name(path));
+        pathlib_error = PATHLIB_OSERROR;
+        PATHLIB_FREE(data);
+        return NULL;
+    }
+    p += 20;
+    algo = (int)pathlib__str_to_u64(&p, end);
+    if (p >= end || *p++ != '\n' || ((algo & ~PATHLIB_DIGEST_TREE) != PATHLIB_DIGEST_XXH64 && (algo & ~PATHLIB_DIGEST_TREE) != PATHLIB_DIGEST_MURMUR3_128 && (algo & ~PATHLIB_DIGEST_TREE) != PATHLIB_DIGEST_SHA256)) {
+        pathlib_print_error("`%s` is not a tree hash cache", pathlib_name(path));
+        pathlib_error = PATHLIB_OSERROR;
+        PATHLIB_FREE(data);
+        return NULL;
+    }
+    
+    cache = pathlib_tree_hash_cache_new(algo);
+    digest_size = pathlib_digest_size(algo & ~PATHLIB_DIGEST_TREE);
+    key = pathlib__malloc(size + 1);
+    
+    while (p < end) {
+        entry = pathlib__malloc(sizeof(*entry));
+        memset(entry, 0, sizeof(*entry));
+        /* ino, mtime seconds, mtime nanoseconds, size and mode, every one followed by a space */
+        corrupted = 0;
+        for (i = 0; i < PATHLIB_ARRSIZE(fields) && !corrupted; i++) {
+            fields[i] = pathlib__str_to_u64(&p, end);
+            corrupted = p >= end || *p++ != ' ';
+        }
+        entry->ino = fields[0];
+        entry->mtime_sec = fields[1];
+        entry->mtime_nsec = fields[2];
+        entry->size = fields[3];
+        entry->mode = (unsigned int)fields[4];
+        /* the digests are followed by a space so they cant run past the end of the buffer */
+        if (corrupted || end - p < (long)(digest_size * 4 + 2) || !pathlib__hex_to_bytes(&p, entry->content, digest_size) || *p++ != ' ' ||
+            !pathlib__hex_to_bytes(&p, entry->node, digest_size) || *p++ != ' ') {
+            pathlib_print_error("`%s` is corrupted", pathlib_name(path));
+            pathlib_error = PATHLIB_OSERROR;
+            PATHLIB_FREE(entry);
+            PATHLIB_FREE(key);
+            PATHLIB_FREE(data);
+            pathlib_tree_hash_cache_free(cache);
+            return NULL;
+        }
+        
+        key_size = 0;
+        while (p < end && *p != '\n') {
+            if (*p == '\\' && p + 1 < end) {
+                p++;
+                key[key_size++] = *p == 'n' ? '\n' : *p;
+            } else {
+                key[key_size++] = *p;
+            }
+            p++;
+        }
+        if (p < end) {
+            p++;
+        }
+        
+        /* a non zero generation marks the entry as valid for the next run */
+        entry->generation = 1;
+        slot = pathlib__str_map_insert(&cache->entries, key, key_size);
+        PATHLIB_FREE(slot->value);
+        slot->value = entry;
+    }
+    
+    cache->generation = 1;
+    PATHLIB_FREE(key);
+    PATHLIB_FREE(data);
+    
+    return cache;
+}
+
+/* how much of the start and the end of a file the first pass of pathlib_find_duplicates hashes */
+#define PATHLIB__DUP_EDGE_SIZE 4096
+
+#if defined(__linux__) && defined(_IOW)
+    /* FICLONE from linux/fs.h, that header clashes with sys/mount.h on older libcs */
+    #define PATHLIB__FICLONE _IOW(0x94, 9, int)
+#endif
+
+typedef struct Pathlib__Dup_File {
+    char* filename;
+    size_t index; /* inside the input paths */
+    pathlib_u64 size;
+    pathlib_u64 dev;
+    pathlib_u64 ino;
+    pathlib_u64 mtime_sec;
+    pathlib_u64 mtime_nsec;
+    unsigned char edges[16]; /* murmur3 of the first and last PATHLIB__DUP_EDGE_SIZE bytes */
+    unsigned char full[32];  /* sha256 of the contents */
+    int failed;
+} Pathlib__Dup_File;
+
+typedef struct Pathlib__Dup_Hash {
+    Pathlib__Dup_File** files;
+    unsigned char** buffers; /* one per worker */
+    int full;
+} Pathlib__Dup_Hash;
+
+/* on windows there are no inode numbers so every file is its own inode */
+static int pathlib__dup_same_inode(const Pathlib__Dup_File* a, const Pathlib__Dup_File* b) {
+    return a->ino != 0 && a->dev == b->dev && a->ino == b->ino;
+}
+
+static int pathlib__dup_cmp_inode(const void* a_, const void* b_) {
+    const Pathlib__Dup_File* a = *(Pathlib__Dup_File* const*)a_;
+    const Pathlib__Dup_File* b = *(Pathlib__Dup_File* const*)b_;
+    
+    if (a->size != b->size) return a->size < b->size ? -1 : 1;
+    if (a->dev != b->dev) return a->dev < b->dev ? -1 : 1;
+    if (a->ino != b->ino) return a->ino < b->ino ? -1 : 1;
+    return a->index < b->index ? -1 : a->index > b->index;
+}
+
+static int pathlib__dup_cmp_edges(const void* a_, const void* b_) {
+    const Pathlib__Dup_File* a = *(Pathlib__Dup_File* const*)a_;
+    const Pathlib__Dup_File* b = *(Pathlib__Dup_File* const*)b_;
+    int cmp;
+    
+    if (a->size != b->size) return a->size < b->size ? -1 : 1;
+    cmp = memcmp(a->edges, b->edges, sizeof(a->edges));
+    if (cmp != 0) return cmp;
+    return a->index < b->index ? -1 : a->index > b->index;
+}
+
+/* the biggest groups come first */
+static int pathlib__dup_cmp_full(const void* a_, const void* b_) {
+    const Pathlib__Dup_File* a = *(Pathlib__Dup_File* const*)a_;
+    const Pathlib__Dup_File* b = *(Pathlib__Dup_File* const*)b_;
+    int cmp;
+    
+    if (a->size != b->size) return a->size > b->size ? -1 : 1;
+    cmp = memcmp(a->full, b->full, sizeof(a->full));
+    if (cmp != 0) return cmp;
+    return a->index < b->index ? -1 : a->index > b->index;
+}
+
+/* reads exactly size bytes, files that shrank while they were read count as errors */
+static int pathlib__dup_read(Pathlib__File file, unsigned char* buff, size_t size, pathlib_u64 offset) {
+    long n;
+    
+    while (size > 0) {
+        n = pathlib__pread(file, buff, size, offset);
+        if (n <= 0) {
+            return 0;
+        }
+        buff += n;
+        size -= n;
+        offset += n;
+    }
+    
+    return 1;
+}
+
+/* runs inside the workers so it only reports errors through the file */
+static void pathlib__dup_hash(void* ctx, size_t index, size_t worker) {
+    Pathlib__Dup_Hash* hash = ctx;
+    Pathlib__Dup_File* file = hash->files[index];
+    Pathlib_Digest digest;
+    Pathlib__File handle;
+    unsigned char* buff;
+    size_t head, tail, n;
+    pathlib_u64 offset;
+    
+    if (hash->buffers[worker] == NULL) {
+        hash->buffers[worker] = pathlib__malloc(PATHLIB_DIGEST_BUFFER_SIZE);
+    }
+    buff = hash->buffers[worker];
+    
+    #ifdef _WIN32
+        handle = fopen(file->filename, "rb");
+        if (handle == NULL) {
+            pathlib_print_os_error("fopen", file->filename);
+            file->failed = 1;
+            return;
+        }
+    #else
+        handle = open(file->filename, O_RDONLY);
+        if (handle < 0) {
+            pathlib_print_os_error("open", file->filename);
+            file->failed = 1;
+            return;
+        }
+    #endif
+    
+    if (!hash->full) {
+        head = file->size < PATHLIB__DUP_EDGE_SIZE ? (size_t)file->size : PATHLIB__DUP_EDGE_SIZE;
+        tail = 0;
+        if (file->size > PATHLIB__DUP_EDGE_SIZE) {
+            tail = file->size < 2 * PATHLIB__DUP_EDGE_SIZE ? (size_t)file->size - PATHLIB__DUP_EDGE_SIZE : PATHLIB__DUP_EDGE_SIZE;
+        }
+        if (!pathlib__dup_read(handle, buff, head, 0) || !pathlib__dup_read(handle, buff + head, tail, file->size - tail)) {
+            pathlib_print_error("failed to read `%s`", file->filename);
+            file->failed = 1;
+        } else {
+            pathlib_digest_buffer(PATHLIB_DIGEST_MURMUR3_128, buff, head + tail, file->edges);
+        }
+    } else {
+        pathlib_digest_init(&digest, PATHLIB_DIGEST_SHA256);
+        for (offset = 0; offset < file->size; offset += n) {
+            n = file->size - offset < PATHLIB_DIGEST_BUFFER_SIZE ? (size_t)(file->size - offset) : PATHLIB_DIGEST_BUFFER_SIZE;
+            if (!pathlib__dup_read(handle, buff, n, offset)) {
+                pathlib_print_error("failed to read `%s`", file->filename);
+                file->failed = 1;
+                break;
+            }
+            pathlib_digest_update(&digest, buff, n);
+        }
+        if (!file->failed) {
+            pathlib_digest_final(&digest, file->full);
+        }
+    }
+    
+    #ifdef _WIN32
+        fclose(handle);
+    #else
+        close(handle);
+    #endif
+}
+
+/* hashes every file in files that doesnt share its inode with the previous one and drops the ones that failed */
+static size_t pathlib__dup_hash_all(Pathlib__Dup_File** files, size_t count, int full) {
+    Pathlib__Dup_Hash hash;
+    Pathlib__Dup_File** unique;
+    size_t unique_count, workers, i, j;
+    
+    unique = pathlib__malloc(sizeof(*unique) * count + 1);
+    unique_count = 0;
+    for (i = 0; i < count; i++) {
+        if (i == 0 || !pathlib__dup_same_inode(files[i - 1], files[i])) {
+            unique[unique_count++] = files[i];
+        }
+    }
+    
+    workers = pathlib__parallel_workers(unique_count);
+    hash.files = unique;
+    hash.full = full;
+    hash.buffers = pathlib__malloc(sizeof(*hash.buffers) * workers);
+    memset(hash.buffers, 0, sizeof(*hash.buffers) * workers);
+    
+    pathlib__parallel_for(unique_count, workers, pathlib__dup_hash, &hash);
+    
+    for (i = 0; i < workers; i++) {
+        PATHLIB_FREE(hash.buffers[i]);
+    }
+    PATHLIB_FREE(hash.buffers);
+    PATHLIB_FREE(unique);
+    
+    /* hardlinks of the same file share the result of the first one */
+    for (i = 1; i < count; i++) {
+        if (pathlib__dup_same_inode(files[i - 1], files[i])) {
+            files[i]->failed = files[i - 1]->failed;
+            memcpy(files[i]->edges, files[i - 1]->edges, sizeof(files[i]->edges));
+            memcpy(files[i]->full, files[i - 1]->full, sizeof(files[i]->full));
+        }
+    }
+    
+    for (i = 0, j = 0; i < count; i++) {
+        if (!files[i]->failed) {
+            files[j++] = files[i];
+        }
+    }
+    
+    return j;
+}
+
+/* keeps the runs of files for which same is true with at least two different inodes */
+static size_t pathlib__dup_keep_runs(Pathlib__Dup_File** files, size_t count, int full) {
+    size_t i, j, end, k;
+    int distinct;
+    
+    for (i = 0, j = 0; i < count; i = end) {
+        distinct = 0;
+        for (end = i + 1; end < count && files[end]->size == files[i]->size; end++) {
+            if (full ? memcmp(files[end]->full, files[i]->full, sizeof(files[i]->full)) != 0
+                     : memcmp(files[end]->edges, files[i]->edges, sizeof(files[i]->edges)) != 0) {
+                break;
+            }
+        }
+        for (k = i + 1; k < end; k++) {
+            if (!pathlib__dup_same_inode(files[i], files[k])) {
+                distinct = 1;
+            }
+        }
+        if (distinct) {
+            for (k = i; k < end; k++) {
+                files[j++] = files[k];
+            }
+        }
+    }
+    
+    return j;
+}
+
+/* atomically replaces target with a hardlink or a reflink of source */
+static int pathlib__dup_replace(const Pathlib__Dup_File* source, const Pathlib__Dup_File* target, int flags) {
+    char temp[PATHLIB_MAX_PATH];
+    Pathlib__Stat target_st, source_st;
+    #if !defined(_WIN32) && defined(PATHLIB__FICLONE)
+        int source_fd, temp_fd, ok;
+    #endif
+    
+    /* dont touch files that were modified after they were hashed */
+    if (!pathlib__stat_str(target->filename, 0, &target_st) || target_st.size != target->size ||
+        target_st.mtime_sec != target->mtime_sec || target_st.mtime_nsec != target->mtime_nsec) {
+        return 1;
+    }
+    if (!pathlib__stat_str(source->filename, 0, &source_st) || source_st.size != source->size ||
+        source_st.mtime_sec != source->mtime_sec || source_st.mtime_nsec != source->mtime_nsec) {
+        return 1;
+    }
+    
+    if (snprintf(temp, sizeof(temp), "%s.pathlib-dedup", target->filename) >= (int)sizeof(temp)) {
+        pathlib_print_error("path too long `%s`", target->filename);
+        return 0;
+    }
+    
+    #ifdef _WIN32
+        if (flags & PATHLIB_DEDUP_REFLINK) {
+            pathlib_print_error("reflinks are not supported for `%s`", target->filename);
+            return 0;
+        }
+        if (!CreateHardLinkA(temp, source->filename, NULL)) {
+            pathlib_print_os_error("CreateHardLink", temp);
+            return 0;
+        }
+        if (!MoveFileExA(temp, target->filename, MOVEFILE_REPLACE_EXISTING)) {
+            pathlib_print_os_error("MoveFileEx", target->filename);
+            DeleteFileA(temp);
+            return 0;
+        }
+    #else
+        if (flags & PATHLIB_DEDUP_REFLINK) {
+            #ifdef PATHLIB__FICLONE
+                source_fd = open(source->filename, O_RDONLY);
+                if (source_fd < 0) {
+                    pathlib_print_os_error("open", source->filename);
+                    return 0;
+                }
+                temp_fd = open(temp, O_WRONLY | O_CREAT | O_EXCL, 0600);
+                if (temp_fd < 0) {
+                    pathlib_print_os_error("open", temp);
+                    close(source_fd);
+                    return 0;
+                }
+                ok = ioctl(temp_fd, PATHLIB__FICLONE, source_fd) == 0;
+                if (!ok) {
+                    pathlib_print_os_error("ioctl(FICLONE)", target->filename);
+                }
+                /* the clone is a new file so it gets the permissions of the file it replaces */
+                ok = ok && fchmod(temp_fd, target_st.mode & 07777) == 0;
+                close(temp_fd);
+                close(source_fd);
+                if (!ok) {
+                    unlink(temp);
+                    return 0;
+                }
+            #else
+                pathlib_print_error("reflinks are not supported for `%s`", target->filename);
+                return 0;
+            #endif
+        } else if (link(source->filename, temp) != 0) {
+            pathlib_print_os_error("link", temp);
+            return 0;
+        }
+        if (rename(temp, target->filename) != 0) {
+            pathlib_print_os_error("rename", target->filename);
+            unlink(temp);
+            return 0;
+        }
+    #endif
+    
+    return 1;
+}
+
+PATHLIB_API Pathlib_Duplicates pathlib_find_duplicates(const Paths* paths, int flags) {
+    Pathlib_Duplicates duplicates;
+    Pathlib__Dup_File* files;
+    Pathlib__Dup_File** candidates;
+    Pathlib__Stat st;
+    char filename[PATHLIB_MAX_PATH];
+    size_t total, count, hashed, i, j, end, k;
+    
+    PATHLIB_ASSERT(paths);
+    PATHLIB_ASSERT((flags & PATHLIB_DEDUP_HARDLINK) == 0 || (flags & PATHLIB_DEDUP_REFLINK) == 0);
+    
+    pathlib_error = PATHLIB_NONE;
+    
+    duplicates.groups = NULL;
+    duplicates.size = 0;
+    duplicates.duplicate_bytes = 0;
+    
+    files = pathlib__malloc(sizeof(*files) * paths->size + 1);
+    candidates = pathlib__malloc(sizeof(*candidates) * paths->size + 1);
+    count = 0;
+    
+    /* only non empty regular files, symlinks are never followed */
+    for (i = 0; i < paths->size; i++) {
+        if (!pathlib_render_str_to_buffer(&paths->paths[i], filename, PATHLIB_ARRSIZE(filename))) {
+            continue;
+        }
+        if (!pathlib__stat_str(filename, 0, &st) || st.type != PATHLIB_ENTRY_FILE || st.size == 0) {
+            continue;
+        }
+        files[count].filename = memcpy(pathlib__malloc(strlen(filename) + 1), filename, strlen(filename) + 1);
+        files[count].index = i;
+        files[count].size = st.size;
+        files[count].dev = st.dev;
+        files[count].ino = st.ino;
+        files[count].mtime_sec = st.mtime_sec;
+        files[count].mtime_nsec = st.mtime_nsec;
+        files[count].failed = 0;
+        memset(files[count].edges, 0, sizeof(files[count].edges));
+        memset(files[count].full, 0, sizeof(files[count].full));
+        candidates[count] = &files[count];
+        count++;
+    }
+    
+    total = count;
+    
+    /* 1. files with a unique size cant have duplicates */
+    qsort(candidates, count, sizeof(*candidates), pathlib__dup_cmp_inode);
+    for (i = 0, j = 0; i < count; i = end) {
+        for (end = i + 1; end < count && candidates[end]->size == candidates[i]->size; end++);
+        for (k = i + 1; k < end; k++) {
+            if (!pathlib__dup_same_inode(candidates[i], candidates[k])) {
+                break;
+            }
+        }
+        if (k < end) {
+            for (k = i; k < end; k++) {
+                candidates[j++] = candidates[k];
+            }
+        }
+    }
+    count = j;
+    
+    /* 2. the start and the end of the file are enough to tell most files apart */
+    hashed = pathlib__dup_hash_all(candidates, count, 0);
+    if (hashed != count) {
+        pathlib_error = PATHLIB_OSERROR;
+    }
+    count = hashed;
+    qsort(candidates, count, sizeof(*candidates), pathlib__dup_cmp_edges);
+    count = pathlib__dup_keep_runs(candidates, count, 0);
+    
+    /* 3. the full contents, inode order again so hardlinks are next to each other */
+    qsort(candidates, count, sizeof(*candidates), pathlib__dup_cmp_inode);
+    hashed = pathlib__dup_hash_all(candidates, count, 1);
+    if (hashed != count) {
+        pathlib_error = PATHLIB_OSERROR;
+    }
+    count = hashed;
+    qsort(candidates, count, sizeof(*candidates), pathlib__dup_cmp_full);
+    count = pathlib__dup_keep_runs(candidates, count, 1);
+    
+    for (i = 0; i < count; i = end) {
+        for (end = i + 1; end < count && candidates[end]->size == candidates[i]->size &&
+             memcmp(candidates[end]->full, candidates[i]->full, sizeof(candidates[i]->full)) == 0; end++);
+        duplicates.size++;
+    }
+    
+    duplicates.groups = pathlib__malloc(sizeof(*duplicates.groups) * duplicates.size + 1);
+    duplicates.size = 0;
+    for (i = 0; i < count; i = end) {
+        Paths* group = &duplicates.groups[duplicates.size++];
+        
+        group->paths = NULL;
+        group->size = 0;
+        group->capacity = 0;
+        for (end = i; end < count && candidates[end]->size == candidates[i]->size &&
+             memcmp(candidates[end]->full, candidates[i]->full, sizeof(candidates[i]->full)) == 0; end++) {
+            pathlib_paths_add(group, pathlib_copy(&paths->paths[candidates[end]->index]));
+            
+            /* the first file of every group is kept, the others are extra copies unless they are hardlinks of one seen before */
+            for (k = i; k < end; k++) {
+                if (pathlib__dup_same_inode(candidates[k], candidates[end])) {
+                    break;
+                }
+            }
+            if (k == end && end != i) {
+                duplicates.duplicate_bytes += candidates[end]->size;
+            }
+            
+            /* every other link of a replaced file is replaced too so its blocks are released */
+            if ((flags & (PATHLIB_DEDUP_HARDLINK | PATHLIB_DEDUP_REFLINK)) && end != i &&
+                !pathlib__dup_same_inode(candidates[i], candidates[end]) && candidates[end]->dev == candidates[i]->dev) {
+                if (!pathlib__dup_replace(candidates[i], candidates[end], flags)) {
+                    pathlib_error = PATHLIB_OSERROR;
+                }
+            }
+        }
+    }
+    
+    for (i = 0; i < total; i++) {
+        PATHLIB_FREE(files[i].filename);
+    }
+    PATHLIB_FREE(candidates);
+    PATHLIB_FREE(files);
+    
+    return duplicates;
+}
+
+PATHLIB_API void pathlib_duplicates_free(Pathlib_Duplicates* duplicates) {
+    size_t i, j;
+    
+    PATHLIB_ASSERT(duplicates);
+    
+    for (i = 0; i < duplicates->size; i++) {
+        for (j = 0; j < duplicates->groups[i].size; j++) {
+            pathlib_destroy(&duplicates->groups[i].paths[j]);
+        }
+        pathlib_paths_free(&duplicates->groups[i]);
+    }
+    PATHLIB_FREE(duplicates->groups);
+    duplicates->groups = NULL;
+    duplicates->size = 0;
+    duplicates->duplicate_bytes = 0;
+}
+
+/* a set of (dev, ino) pairs, open addressing with the inode 0 marking empty slots */
+typedef struct Pathlib__Inode_Set {
+    pathlib_u64* slots; /* dev, ino pairs */
+    size_t size;
+    size_t capacity;    /* always 0 or a power of two */
+} Pathlib__Inode_Set;
+
+/* the slot where the probing for a pair starts */
+static size_t pathlib__inode_set_home(const Pathlib__Inode_Set* set, pathlib_u64 dev, pathlib_u64 ino) {
+    return (size_t)((ino * PATHLIB__XXH_P1) ^ (dev * PATHLIB__XXH_P2) ^ ((ino * PATHLIB__XXH_P1) >> 29)) & (set->capacity - 1);
+}
+
+static size_t pathlib__inode_set_slot(const Pathlib__Inode_Set* set, pathlib_u64 dev, pathlib_u64 ino) {
+    size_t i;
+    
+    for (i = pathlib__inode_set_home(set, dev, ino); ; i = (i + 1) & (set->capacity - 1)) {
+        if (set->slots[i * 2 + 1] == 0 || (set->slots[i * 2] == dev && set->slots[i * 2 + 1] == ino)) {
+            return i;
+        }
+    }
+}
+
+/* returns 1 if the pair was added and 0 if it was already inside, inode 0 is never stored */
+static int pathlib__inode_set_add(Pathlib__Inode_Set* set, pathlib_u64 dev, pathlib_u64 ino) {
+    pathlib_u64* old_slots;
+    size_t old_capacity, i, slot;
+    
+    if (ino == 0) {
+        return 1;
+    }
+    
+    if ((set->size + 1) * 10 > set->capacity * 7) {
+        old_slots = set->slots;
+        old_capacity = set->capacity;
+        set->capacity = set->capacity == 0 ? 64 : set->capacity * 2;
+        set->slots = pathlib__malloc(sizeof(*set->slots) * 2 * set->capacity);
+        memset(set->slots, 0, sizeof(*set->slots) * 2 * set->capacity);
+        for (i = 0; i < old_capacity; i++) {
+            if (old_slots[i * 2 + 1] != 0) {
+                slot = pathlib__inode_set_slot(set, old_slots[i * 2], old_slots[i * 2 + 1]);
+                set->slots[slot * 2] = old_slots[i * 2];
+                set->slots[slot * 2 + 1] = old_slots[i * 2 + 1];
+            }
+        }
+        PATHLIB_FREE(old_slots);
+    }
+    
+    slot = pathlib__inode_set_slot(set, dev, ino);
+    if (set->slots[slot * 2 + 1] != 0) {
+        return 0;
+    }
+    set->slots[slot * 2] = dev;
+    set->slots[slot * 2 + 1] = ino;
+    set->size++;
+    
+    return 1;
+}
+
+/* removes the pair if it is inside, the pairs after it are shifted back so no probe chain is broken */
+static void pathlib__inode_set_remove(Pathlib__Inode_Set* set, pathlib_u64 dev, pathlib_u64 ino) {
+    size_t hole, i, home;
+    
+    if (ino == 0 || set->capacity == 0) {
+        return;
+    }
+    hole = pathlib__inode_set_slot(set, dev, ino);
+    if (set->slots[hole * 2 + 1] == 0) {
+        return;
+    }
+    for (i = (hole + 1) & (set->capacity - 1); set->slots[i * 2 + 1] != 0; i = (i + 1) & (set->capacity - 1)) {
+        home = pathlib__inode_set_home(set, set->slots[i * 2], set->slots[i * 2 + 1]);
+        /* the pair stays when its probe starts after the hole and not after i */
+        if (hole <= i ? (hole < home && home <= i) : (hole < home || home <= i)) {
+            continue;
+        }
+        set->slots[hole * 2] = set->slots[i * 2];
+        set->slots[hole * 2 + 1] = set->slots[i * 2 + 1];
+        hole = i;
+    }
+    set->slots[hole * 2] = 0;
+    set->slots[hole * 2 + 1] = 0;
+    set->size--;
+}
+
+static void pathlib__inode_set_free(Pathlib__Inode_Set* set) {
+    PATHLIB_FREE(set->slots);
+    set->slots = NULL;
+    set->size = 0;
+    set->capacity = 0;
+}
+
+typedef struct Pathlib__Du_Job {
+    char* dirname;
+    size_t child; /* the slot of the child of the root that it is inside */
+} Pathlib__Du_Job;
+
+typedef struct Pathlib__Du {
+    int flags;
+    pathlib_u64 root_dev;
+    #ifndef PATHLIB_NO_THREADS
+        Pathlib__Mutex mutex;
+        Pathlib__Cond cond;
+    #endif
+    Pathlib__Du_Job* jobs;
+    size_t job_count;
+    size_t job_capacity;
+    size_t pending; /* the jobs that are queued or running */
+    Pathlib__Inode_Set inodes;
+    Pathlib_Usage** usage; /* slot_count usages for every worker */
+    size_t slot_count;
+    int failed;
+} Pathlib__Du;
+
+static void pathlib__du_lock(Pathlib__Du* du) {
+    #ifndef PATHLIB_NO_THREADS
+        pathlib__mutex_lock(&du->mutex);
+    #else
+        (void) du;
+    #endif
+}
+
+static void pathlib__du_unlock(Pathlib__Du* du) {
+    #ifndef PATHLIB_NO_THREADS
+        pathlib__mutex_unlock(&du->mutex);
+    #else
+        (void) du;
+    #endif
+}
+
+/* marks the walk as failed, the workers call it while other workers may read or write failed */
+static void pathlib__du_fail(Pathlib__Du* du) {
+    pathlib__du_lock(du);
+    du->failed = 1;
+    pathlib__du_unlock(du);
+}
+
+/* must be called with the lock held */
+static void pathlib__du_push(Pathlib__Du* du, char* dirname, size_t child) {
+    Pathlib__Du_Job* temp;
+    
+    if (du->job_count >= du->job_capacity) {
+        du->job_capacity = du->job_capacity == 0 ? 64 : du->job_capacity * 2;
+        temp = pathlib__malloc(sizeof(*temp) * du->job_capacity);
+        if (du->job_count > 0) {
+            memcpy(temp, du->jobs, sizeof(*temp) * du->job_count);
+        }
+        PATHLIB_FREE(du->jobs);
+        du->jobs = temp;
+    }
+    
+    du->jobs[du->job_count].dirname = dirname;
+    du->jobs[du->job_count].child = child;
+    du->job_count++;
+    du->pending++;
+    #ifndef PATHLIB_NO_THREADS
+        pathlib__cond_signal(&du->cond);
+    #endif
+}
+
+/* queues the directory name inside the directory whose rendered form with a trailing separator is inside path */
+static void pathlib__du_queue(Pathlib__Du* du, char* path, size_t dirname_size, const char* name, size_t child) {
+    size_t name_size = strlen(name);
+    
+    if (dirname_size + name_size + 1 > PATHLIB_MAX_PATH) {
+        pathlib_print_error("path too long inside `%.*s`", (int)dirname_size, path);
+        pathlib__du_fail(du);
+        return;
+    }
+    memcpy(path + dirname_size, name, name_size + 1);
+    
+    pathlib__du_lock(du);
+    pathlib__du_push(du, memcpy(pathlib__malloc(dirname_size + name_size + 1), path, dirname_size + name_size + 1), child);
+    pathlib__du_unlock(du);
+}
+
+/* adds an entry to the usage of its slot and returns 1 if it is a directory that must be walked */
+static int pathlib__du_add(Pathlib__Du* du, Pathlib_Usage* usage, const Pathlib__Stat* st) {
+    int first = 1;
+    
+    if (st->type == PATHLIB_ENTRY_DIR) {
+        if ((du->flags & PATHLIB_DU_ONE_FILESYSTEM) && st->dev != du->root_dev) {
+            return 0;
+        }
+        usage->dir_count++;
+    } else {
+        /* a file with more than one link is only counted the first time that it is seen */
+        if (st->nlink > 1) {
+            pathlib__du_lock(du);
+            first = pathlib__inode_set_add(&du->inodes, st->dev, st->ino);
+            pathlib__du_unlock(du);
+        }
+        if (!first) {
+            return 0;
+        }
+        usage->file_count++;
+    }
+    
+    usage->apparent_size += st->size;
+    usage->allocated_size += st->allocated;
+    
+    return st->type == PATHLIB_ENTRY_DIR;
+}
+
+/* lists dirname and queues its subdirectories, everything inside it is added to usage[child] */
+static void pathlib__du_walk(Pathlib__Du* du, const char* dirname, size_t child, Pathlib_Usage* usage) {
+    char path[PATHLIB_MAX_PATH];
+    size_t dirname_size;
+    Pathlib__Stat st;
+    const char* name;
+    #ifdef _WIN32
+        char search_path[PATHLIB_MAX_PATH + 3];
+        WIN32_FIND_DATA find_data;
+        HANDLE hFind;
+    #else
+        DIR* dir;
+        struct dirent* entry;
+        struct stat statbuf;
+    #endif
+    
+    dirname_size = strlen(dirname);
+    memcpy(path, dirname, dirname_size);
+    path[dirname_size++] = '/';
+    
+    #ifdef _WIN32
+        if (snprintf(search_path, sizeof(search_path), "%s\\*", dirname) < 0) {
+            return;
+        }
+        hFind = FindFirstFile(search_path, &find_data);
+        if (hFind == INVALID_HANDLE_VALUE) {
+            pathlib_print_os_error("FindFirstFile", search_path);
+            pathlib__du_fail(du);
+            return;
+        }
+        do {
+            name = find_data.cFileName;
+            if (strcmp(name, ".") == 0 || strcmp(name, "..") == 0) {
+                continue;
+            }
+            memset(&st, 0, sizeof(st));
+            st.size = ((pathlib_u64)find_data.nFileSizeHigh << 32) | find_data.nFileSizeLow;
+            st.allocated = st.size;
+            st.nlink = 1;
+            if (find_data.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) {
+                st.type = PATHLIB_ENTRY_SYMLINK;
+            } else if (find_data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+                st.type = PATHLIB_ENTRY_DIR;
+            } else {
+                st.type = PATHLIB_ENTRY_FILE;
+            }
+    #else
+        dir = opendir(dirname);
+        if (dir == NULL) {
+            pathlib_print_os_error("opendir", dirname);
+            pathlib__du_fail(du);
+            return;
+        }
+        while ((entry = readdir(dir)) != NULL) {
+            name = entry->d_name;
+            if (strcmp(name, ".") == 0 || strcmp(name, "..") == 0) {
+                continue;
+            }
+            /* stat relative to the open directory so the kernel doesnt resolve the whole path again */
+            #ifdef AT_SYMLINK_NOFOLLOW
+                if (fstatat(dirfd(dir), name, &statbuf, AT_SYMLINK_NOFOLLOW) != 0) {
+            #else
+                if (snprintf(path + dirname_size, sizeof(path) - dirname_size, "%s", name) < 0 || lstat(path, &statbuf) != 0) {
+            #endif
+                if (errno != ENOENT) {
+                    pathlib_print_os_error("lstat", name);
+                    pathlib__du_fail(du);
+                }
+                continue;
+            }
+            pathlib__stat_from_native(&statbuf, &st);
+    #endif
+            
+            if (pathlib__du_add(du, &usage[child], &st)) {
+                pathlib__du_queue(du, path, dirname_size, name, child);
+            }
+    #ifdef _WIN32
+        } while (FindNextFile(hFind, &find_data) != 0);
+        FindClose(hFind);
+    #else
+        }
+        closedir(dir);
+    #endif
+}
+
+static void pathlib__du_worker(void* ctx, size_t index, size_t worker) {
+    Pathlib__Du* du = ctx;
+    Pathlib__Du_Job job;
+    
+    (void) index;
+    
+    pathlib__du_lock(du);
+    for (;;) {
+        if (du->job_count == 0) {
+            if (du->pending == 0) {
+                break;
+            }
+            #ifndef PATHLIB_NO_THREADS
+                pathlib__cond_wait(&du->cond, &du->mutex);
+            #endif
+            continue;
+        }
+        job = du->jobs[--du->job_count];
+        pathlib__du_unlock(du);
+        
+        pathlib__du_walk(du, job.dirname, job.child, du->usage[worker]);
+        PATHLIB_FREE(job.dirname);
+        
+        pathlib__du_lock(du);
+        if (--du->pending == 0) {
+            #ifndef PATHLIB_NO_THREADS
+                pathlib__cond_broadcast(&du->cond);
+            #endif
+        }
+    }
+    pathlib__du_unlock(du);
+}
+
+PATHLIB_API int pathlib_disk_usage(const Path* path, int flags, Pathlib_Disk_Usage* usage) {
+    char filename[PATHLIB_MAX_PATH];
+    Pathlib_Usage* sum;
+    Pathlib__Names names;
+    Pathlib__Stat st;
+    Pathlib__Du du;
+    Path child;
+    size_t filename_size, workers, slot, i, j;
+    
+    PATHLIB_ASSERT(path);
+    PATHLIB_ASSERT(usage);
+    
+    pathlib_error = PATHLIB_NONE;
+    
+    memset(usage, 0, sizeof(*usage));
+    
+    if (!pathlib_render_str_to_buffer(path, filename, PATHLIB_ARRSIZE(filename))) {
+        pathlib_error = PATHLIB_NEXISTS;
+        return 0;
+    }
+    if (!pathlib__stat_str(filename, 0, &st)) {
+        pathlib_error = errno == ENOENT ? PATHLIB_NEXISTS : PATHLIB_OSERROR;
+        return 0;
+    }
+    
+    names.count = 0;
+    if (st.type == PATHLIB_ENTRY_DIR && !pathlib__names_read(&names, filename, 0)) {
+        pathlib_error = PATHLIB_OSERROR;
+        return 0;
+    }
+    
+    memset(&du, 0, sizeof(du));
+    du.flags = flags;
+    du.root_dev = st.dev;
+    /* slot i is the i-th child of the root and the last one is the root itself */
+    du.slot_count = (flags & PATHLIB_DU_CHILDREN) ? names.count + 1 : 1;
+    
+    workers = pathlib__parallel_workers((size_t)-1);
+    du.usage = pathlib__malloc(sizeof(*du.usage) * workers);
+    for (i = 0; i < workers; i++) {
+        du.usage[i] = pathlib__malloc(sizeof(**du.usage) * du.slot_count);
+        memset(du.usage[i], 0, sizeof(**du.usage) * du.slot_count);
+    }
+    #ifndef PATHLIB_NO_THREADS
+        pathlib__mutex_init(&du.mutex);
+        pathlib__cond_init(&du.cond);
+    #endif
+    
+    pathlib__du_add(&du, &du.usage[0][du.slot_count - 1], &st);
+    
+    if (st.type == PATHLIB_ENTRY_DIR) {
+        filename_size = strlen(filename);
+        if (filename_size + 1 < sizeof(filename) && filename[filename_size - 1] != '/') {
+            filename[filename_size++] = '/';
+        }
+        
+        /* the children of the root are listed here so each one gets its own slot */
+        for (i = 0; i < names.count; i++) {
+            slot = (flags & PATHLIB_DU_CHILDREN) ? i : 0;
+            if (flags & PATHLIB_DU_CHILDREN) {
+                /* the parts of a path are not owned by it, like in pathlib_listdir the name is copied */
+                child = pathlib_copy(path);
+                pathlib_add_part(&child, memcpy(pathlib__malloc(strlen(names.names[i]) + 1), names.names[i], strlen(names.names[i]) + 1));
+                pathlib_paths_add(&usage->children, child);
+            }
+            
+            if (snprintf(filename + filename_size, sizeof(filename) - filename_size, "%s", names.names[i]) >= (int)(sizeof(filename) - filename_size) ||
+                !pathlib__stat_str(filename, 0, &st)) {
+                if (errno != ENOENT) {
+                    pathlib_print_os_error("lstat", filename);
+                    du.failed = 1;
+                }
+                continue;
+            }
+            if (pathlib__du_add(&du, &du.usage[0][slot], &st)) {
+                pathlib__du_queue(&du, filename, filename_size, names.names[i], slot);
+            }
+        }
+        pathlib__names_free(&names);
+        
+        /* every worker keeps taking directories from the shared stack until all of them are done */
+        pathlib__parallel_for(workers, workers, pathlib__du_worker, &du);
+    }
+    
+    #ifndef PATHLIB_NO_THREADS
+        pathlib__mutex_destroy(&du.mutex);
+        pathlib__cond_destroy(&du.cond);
+    #endif
+    
+    if (flags & PATHLIB_DU_CHILDREN) {
+        usage->child_usage = pathlib__malloc(sizeof(*usage->child_usage) * du.slot_count);
+        memset(usage->child_usage, 0, sizeof(*usage->child_usage) * du.slot_count);
+    }
+    for (i = 0; i < workers; i++) {
+        for (j = 0; j < du.slot_count; j++) {
+            sum = usage->child_usage && j < du.slot_count - 1 ? &usage->child_usage[j] : NULL;
+            if (sum) {
+                sum->apparent_size += du.usage[i][j].apparent_size;
+                sum->allocated_size += du.usage[i][j].allocated_size;
+                sum->file_count += du.usage[i][j].file_count;
+                sum->dir_count += du.usage[i][j].dir_count;
+            }
+            usage->total.apparent_size += du.usage[i][j].apparent_size;
+            usage->total.allocated_size += du.usage[i][j].allocated_size;
+            usage->total.file_count += du.usage[i][j].file_count;
+            usage->total.dir_count += du.usage[i][j].dir_count;
+        }
+        PATHLIB_FREE(du.usage[i]);
+    }
+    PATHLIB_FREE(du.usage);
+    PATHLIB_FREE(du.jobs);
+    pathlib__inode_set_free(&du.inodes);
+    
+    if (du.failed) {
+        pathlib_error = PATHLIB_OSERROR;
+    }
+    
+    return 1;
+}
+
+PATHLIB_API void pathlib_disk_usage_free(Pathlib_Disk_Usage* usage) {
+    size_t i;
+    
+    PATHLIB_ASSERT(usage);
+    
+    for (i = 0; i < usage->children.size; i++) {
+        pathlib_destroy(&usage->children.paths[i]);
+    }
+    pathlib_paths_free(&usage->children);
+    PATHLIB_FREE(usage->child_usage);
+    usage->child_usage = NULL;
+}
+
+PATHLIB_API int pathlib_unlink(const Path* path) {
+    char filename[PATHLIB_MAX_PATH];
+   
+    PATHLIB_ASSERT(path);
+    
+    pathlib_error = PATHLIB_NONE;
+    
+    if (!pathlib_exists(path)) {
+        pathlib_error = PATHLIB_NEXISTS;
+        return 0;
+    }
 
-void* pathlib___malloc(size_t size, const char* file, size_t line) {
-    void* region = PATHLIB_MALLOC(size);
-    if (region) {
-        return region;
+    if (!pathlib_render_str_to_buffer(path, filename, sizeof(filename) / sizeof(*filename))) {
+        /* this part should be unreachable */
+        pathlib_error = PATHLIB_NEXISTS;
+        return 0;
     }
     
-    fprintf(stderr, "[FATAL] out of memory at %s:%lu", file, (unsigned long int)line);
-    abort();
-}
-#define pathlib__malloc(size) pathlib___malloc(size, __FILE__, __LINE__)
+    if (remove(filename) != 0) {
+        pathlib_error = PATHLIB_OSERROR;
+        return 0;
+    }
 
-PATHLIB_API Path pathlib_cwd(void) {
-    char* cwd_buff;
-    size_t size;
+    return 1;
+}
 
+#ifdef _WIN32
+int pathlib__remove_directory_contents(const Path* path) {
+    WIN32_FIND_DATA findFileData;
+    HANDLE hFind;
+    char fullPath[MAX_PATH];
+    char searchPath[MAX_PATH+3];
+    size_t searchPathSize;
+    Path subpath;
+    
     pathlib_error = PATHLIB_NONE;
     
-    #ifdef _WIN32
-        size = GetCurrentDirectory(0, NULL);
-        if (size == 0) {
-            pathlib_print_func_failed("GetCurrentDirectory");
-            pathlib_error = PATHLIB_OSERROR;
-            return pathlib_from_str(".");
-        }
+    if (!pathlib_render_str_to_buffer(path, searchPath, sizeof(fullPath) / sizeof(*fullPath))) {
+        return 0;
+    }
+    searchPathSize = strlen(searchPath);
+    searchPath[searchPathSize] = '\\';
+    searchPath[searchPathSize+1] = '*';
+    searchPath[searchPathSize+2] = '\0';
 
-        cwd_buff = (char*)pathlib__malloc(size * sizeof(char));
+    hFind = FindFirstFile(searchPath, &findFileData);
+    if (hFind == INVALID_HANDLE_VALUE) {
+        pathlib_print_os_error("FindFirstFile", searchPath);
+        pathlib_error = PATHLIB_OSERROR;
+        return 0;
+    }
 
-        if (GetCurrentDirectory(size, cwd_buff) == 0) {
-            pathlib_print_func_failed("GetCurrentDirectory");
-            pathlib_error = PATHLIB_OSERROR;
-            return pathlib_from_str(".");
+    do {
+        const char* name = findFileData.cFileName;
+
+        /* Skip "." and ".." entries */
+        if (strcmp(name, ".") == 0 || strcmp(name, "..") == 0) {
+            continue;
         }
-    #else
-        size = 8;
-        cwd_buff = (char*)pathlib__malloc(size * sizeof(char));
+        
+        subpath = pathlib_copy(path);
+        pathlib_add_part(&subpath, name);
 
-        while (getcwd(cwd_buff, size) == NULL) {
-            if (errno == ERANGE) {
-                size *= 2;
-                PATHLIB_FREE(cwd_buff);
-                cwd_buff = (char*)pathlib__malloc(size * sizeof(char));
-            } else {
-                pathlib_print_func_failed("getcwd");
+        /* Recursive removal for directories, or delete files */
+        if (findFileData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+            if (!pathlib_rmdir(&subpath, 1)) {
+                FindClose(hFind);
+                return 0;
+            }
+        } else {
+            if (!pathlib_render_str_to_buffer(&subpath, fullPath, sizeof(fullPath) / sizeof(*fullPath))) {
+                return 0;
+            }
+            if (!DeleteFile(fullPath)) {
+                FindClose(hFind);
+                pathlib_print_os_error("DeleteFile", fullPath);
                 pathlib_error = PATHLIB_OSERROR;
-                return pathlib_from_str(".");
+                return 0;
             }
         }
-    #endif
 
-    return pathlib_from_str(cwd_buff);
+        pathlib_destroy(&subpath);
+
+    } while (FindNextFile(hFind, &findFileData) != 0);
+
+    FindClose(hFind);
+    return 1;
 }
+#else /* _WIN32 */
+int pathlib__remove_directory_contents(const Path* path) {
+    DIR* dir;
+    struct dirent* entry;
+    struct stat pathStat;
+    char fullPath[PATHLIB_MAX_PATH];
+    Path subpath;
+    
+    pathlib_error = PATHLIB_NONE;
+    
+    if (!pathlib_render_str_to_buffer(path, fullPath, sizeof(fullPath) / sizeof(*fullPath))) {
+        return 0;
+    }
 
-PATHLIB_API Path pathlib_home(void) {
-    char* home_dir = NULL;
+    dir = opendir(fullPath);
+    if (dir == NULL) {
+        pathlib_print_os_error("opendir", fullPath);
+        pathlib_error = PATHLIB_OSERROR;
+        return 0;
+    }
 
-    #ifdef _WIN32
-        char* home_drive, *home_path;
-        size_t size;
-        
-        pathlib_error = PATHLIB_NONE;
-        
-        home_dir = getenv("USERPROFILE");
-        if (home_dir && strlen(home_dir) > 0) {
-            return pathlib_from_str(home_dir);
-        }
+    while ((entry = readdir(dir)) != NULL) {
+        const char* name = entry->d_name;
 
-        home_drive = getenv("HOMEDRIVE");
-        home_path = getenv("HOMEPATH");
-        if (home_drive && home_path) {
-            size = strlen(home_drive) + strlen(home_path) + 1;
-            home_dir = (char*)pathlib__malloc(size * sizeof(char));
-            sprintf(home_dir, "%s%s", home_drive, home_path);
-            return pathlib_from_str(home_dir);
+        if (strcmp(name, ".") == 0 || strcmp(name, "..") == 0) {
+            continue;
         }
 
-    #else
-        struct passwd* pw;
+        subpath = pathlib_copy(path);
+        pathlib_add_part(&subpath, name);
 
-        pathlib_error = PATHLIB_NONE;
+        if (!pathlib_render_str_to_buffer(&subpath, fullPath, sizeof(fullPath) / sizeof(*fullPath))) {
+            pathlib_destroy(&subpath);
+            return 0;
+        }
         
-        home_dir = getenv("HOME");
-        if (home_dir && strlen(home_dir) > 0) {
-            return pathlib_from_str(home_dir);
+        if (stat(fullPath, &pathStat) != 0) {
+            pathlib_print_os_error("stat", fullPath);
+            pathlib_error = PATHLIB_OSERROR;
+            closedir(dir);
+            pathlib_destroy(&subpath);
+            return 0;
         }
 
-        pw = getpwuid(getuid());
-        if (pw && pw->pw_dir) {
-            return pathlib_from_str(pw->pw_dir);
+        if (S_ISDIR(pathStat.st_mode)) {
+            if (!pathlib_rmdir(&subpath, 1)) {
+                closedir(dir);
+                pathlib_destroy(&subpath);
+                return 0;
+            }
+        } else {
+            if (unlink(fullPath) != 0) {
+                closedir(dir);
+                pathlib_destroy(&subpath);
+                return 0;
+            }
         }
-    #endif
 
-    pathlib_print_error("failed to determine the home directory");
-    pathlib_error = PATHLIB_OSERROR;
-    return pathlib_from_str(".");
+        pathlib_destroy(&subpath);
+    }
+
+    closedir(dir);
+    return 1;
 }
+#endif /* _WIN32 */
 
-PATHLIB_API Path pathlib_temp(void) {
-    char* temp_dir = NULL;
+PATHLIB_API int pathlib_rmdir(const Path* path, int remove_contents) {
+    char filename[PATHLIB_MAX_PATH];
     
-    #ifdef _WIN32
-        DWORD size = GetTempPath(0, NULL);
-        
-        pathlib_error = PATHLIB_NONE;
-        
-        if (size == 0) {
-            pathlib_print_func_failed("GetTempPath");
+    PATHLIB_ASSERT(path);
+    
+    pathlib_error = PATHLIB_NONE;
+    
+    if (!pathlib_exists(path)) {
+        pathlib_error = PATHLIB_NEXISTS;
+        return 0;
+    }
+    
+    if (!pathlib_render_str_to_buffer(path, filename, sizeof(filename) / sizeof(*filename))) {
+        pathlib_error = PATHLIB_NEXISTS;
+        return 0;
+    }
+    
+    
+    if (remove_contents) {
+        if (!pathlib__remove_directory_contents(path)) {
             pathlib_error = PATHLIB_OSERROR;
-            return pathlib_from_str("./tmp");
+            return 0;
         }
-
-        temp_dir = (char*)pathlib__malloc(size * sizeof(char));
-
-        if (GetTempPath(size, temp_dir) == 0) {
-            pathlib_print_func_failed("GetTempPath");
+    }
+    
+    #ifdef _WIN32
+        if (!RemoveDirectory(filename)) {
+            pathlib_print_os_error("RemoveDirectory", filename);
             pathlib_error = PATHLIB_OSERROR;
-            return pathlib_from_str("./tmp");
+            return 0;
         }
-        return pathlib_from_str(temp_dir);
     #else
-        size_t i;
-        const char* env_vars[] = {"TMPDIR", "TEMP", "TMP"};
-        
-        pathlib_error = PATHLIB_NONE;
-        
-        for (i = 0; i < sizeof(env_vars) / sizeof(env_vars[0]); i++) {
-            temp_dir = getenv(env_vars[i]);
-            if (temp_dir && strlen(temp_dir) > 0) {
-                return pathlib_from_str(temp_dir);
-            }
+        if (rmdir(filename) != 0) {
+            pathlib_print_os_error("rmdir", filename);
+            pathlib_error = PATHLIB_OSERROR;
+            return 0;
         }
+    #endif
+    
+    return 1;
+}
+
+/* the multiplier of a component step and its inverse mod 2^64, so a step can be undone */
+#define PATHLIB__PATH_HASH_MUL PATHLIB__XXH_P1
+#define PATHLIB__PATH_HASH_MUL_INV PATHLIB__U64(0x08874934UL, 0x32BADB37UL)
+
+/*
+*  every component is hashed on its own and then folded into the hash of the path with
+*  h' = (rotl(h, 23) ^ hash(component)) * MUL, both operations are invertible so the hash of
+*  a parent is derived from the hash of its child and the name that was removed
+*/
+PATHLIB_API pathlib_u64 pathlib_hash64_add_part(pathlib_u64 hash, const char* part) {
+    PATHLIB_ASSERT(part);
+    
+    return (pathlib__rotl64(hash, 23) ^ pathlib__hash_bytes(part, strlen(part))) * PATHLIB__PATH_HASH_MUL;
+}
+
+PATHLIB_API pathlib_u64 pathlib_hash64_parent(pathlib_u64 hash, const char* last_part) {
+    PATHLIB_ASSERT(last_part);
+    
+    hash = (hash * PATHLIB__PATH_HASH_MUL_INV) ^ pathlib__hash_bytes(last_part, strlen(last_part));
+    return (hash >> 23) | (hash << 41);
+}
+
+PATHLIB_API pathlib_u64 pathlib_hash64_join(pathlib_u64 hash, const Path* other) {
+    size_t i;
+    
+    PATHLIB_ASSERT(other);
+    
+    for (i = 0; i < other->size; i++) {
+        hash = pathlib_hash64_add_part(hash, other->parts[i]);
+    }
+    
+    return hash;
+}
 
-        return pathlib_from_str("/tmp");
-    #endif
+PATHLIB_API pathlib_u64 pathlib_hash64(const Path* path) {
+    PATHLIB_ASSERT(path);
+    
+    return pathlib_hash64_join(PATHLIB_HASH64_EMPTY, path);
 }
 
-PATHLIB_API Path pathlib_from_str(const char* instr) {
-    char* start, *temp;
-    size_t instr_len, part_count;
-    char* str;
-    Path path;
+PATHLIB_API unsigned long pathlib_hashfunc(const Path* path) {
+    pathlib_u64 hash;
+    
+    PATHLIB_ASSERT(path);
+    
+    hash = pathlib_hash64(path);
+    if (sizeof(unsigned long) < sizeof(pathlib_u64)) {
+        /* keep the high half when unsigned long is 32 bits */
+        hash ^= hash >> 32;
+    }
+    
+    return (unsigned long)hash;
+}
 
-    PATHLIB_ASSERT(instr);
+#define PATHLIB__ARENA_BLOCK_SIZE (64 * 1024)
 
-    instr_len = strlen(instr);
-    str = memcpy(pathlib__malloc(instr_len + 1), instr, instr_len);
-    str[instr_len] = 0;
+/* bump allocated blocks that are freed together, every block starts with a pointer to the previous one */
+typedef struct Pathlib__Arena {
+    char* block;
+    size_t used;
+    size_t size;
+} Pathlib__Arena;
+
+static void* pathlib__arena_alloc(Pathlib__Arena* arena, size_t size) {
+    char* block;
+    size_t block_size;
     
-    part_count = 1;
-    for (temp = str; *temp; temp++) {
-        if (*temp == '\\' || *temp == '/') {
-            part_count++;
-        }
+    /* keep every allocation aligned for the largest scalar */
+    size = pathlib__round_up(size, sizeof(pathlib_u64));
+    
+    if (arena->block == NULL || arena->used + size > arena->size) {
+        block_size = sizeof(pathlib_u64) + size > PATHLIB__ARENA_BLOCK_SIZE ? sizeof(pathlib_u64) + size : PATHLIB__ARENA_BLOCK_SIZE;
+        block = pathlib__malloc(block_size);
+        *(char**)block = arena->block;
+        arena->block = block;
+        arena->used = sizeof(pathlib_u64);
+        arena->size = block_size;
     }
     
-    path.parts = pathlib__malloc(sizeof(*path.parts) * part_count);
-    path.size = 0;
-    path.capacity = part_count;
+    arena->used += size;
+    return arena->block + arena->used - size;
+}
 
-    start = str;
-    for (temp = str; ; temp++) {
-        if (*temp == '/' || *temp == '\\') {
-            size_t len = temp - start;
-            start[len] = 0;
-            path.parts[path.size++] = start;
-            start = temp + 1;
-            continue;
-        } else if (*temp == '\0') {
-            size_t len = temp - start;
-            start[len] = 0;
-            path.parts[path.size++] = start;
-            break;
-        }
+static void pathlib__arena_free(Pathlib__Arena* arena) {
+    char* previous;
+    
+    while (arena->block) {
+        previous = *(char**)arena->block;
+        PATHLIB_FREE(arena->block);
+        arena->block = previous;
     }
-
-    return path;
+    arena->used = 0;
+    arena->size = 0;
 }
 
-PATHLIB_API void pathlib_add_part(Path* path, const char* part) {
-    void* temp;
+/* the parts of the path one after the other with a 0 after each one, returns 0 if it doesnt fit */
+static size_t pathlib__path_key(const Path* path, char* buffer, size_t buffer_size) {
+    size_t i, size, part_size;
+    
+    size = 0;
+    for (i = 0; i < path->size; i++) {
+        part_size = strlen(path->parts[i]) + 1;
+        if (size + part_size > buffer_size) {
+            return 0;
+        }
+        memcpy(buffer + size, path->parts[i], part_size);
+        size += part_size;
+    }
+    
+    return size;
+}
 
-    PATHLIB_ASSERT(path);
-    PATHLIB_ASSERT(part);
+typedef struct Pathlib__Path_Map_Slot {
+    pathlib_u64 hash;
+    const char* key; /* NULL for empty slots */
+    size_t key_size;
+    union {
+        void* ptr;
+        pathlib_u64 u64;
+    } value;
+} Pathlib__Path_Map_Slot;
+
+struct Pathlib_Path_Map {
+    Pathlib__Path_Map_Slot* slots;
+    size_t size;
+    size_t capacity; /* always a power of two */
+    Pathlib__Arena arena;
+};
 
-    if (path->size >= path->capacity) {
-        path->capacity = path->capacity == 0 ? 4 : (int)(path->capacity*1.5 + 1);
-        temp = pathlib__malloc(path->capacity * sizeof(*path->parts));
-        if (path->size > 0) {
-            memcpy(temp, path->parts, sizeof(*path->parts)*path->size);
+/* the slot of the key or the empty slot where it would go */
+static Pathlib__Path_Map_Slot* pathlib__path_map_find(const Pathlib_Path_Map* map, const char* key, size_t key_size, pathlib_u64 hash) {
+    Pathlib__Path_Map_Slot* slot;
+    size_t i;
+    
+    for (i = (size_t)hash & (map->capacity - 1); ; i = (i + 1) & (map->capacity - 1)) {
+        slot = &map->slots[i];
+        /* the stored hash rejects almost every other key before their bytes are compared */
+        if (slot->key == NULL || (slot->hash == hash && slot->key_size == key_size && memcmp(slot->key, key, key_size) == 0)) {
+            return slot;
         }
-        PATHLIB_FREE(path->parts);
-        path->parts = temp;
     }
-
-    path->parts[path->size++] = part;
 }
 
-PATHLIB_API void pathlib_destroy(Path* path) {
-    if (path) {
-        if (path->parts) {
-            PATHLIB_FREE(path->parts);
-            path->parts = 0;
-            path->size = 0;
-            path->capacity = 0;
+static void pathlib__path_map_resize(Pathlib_Path_Map* map, size_t capacity) {
+    Pathlib__Path_Map_Slot* old_slots = map->slots;
+    size_t old_capacity = map->capacity, i;
+    
+    map->capacity = capacity;
+    map->slots = pathlib__malloc(sizeof(*map->slots) * capacity);
+    memset(map->slots, 0, sizeof(*map->slots) * capacity);
+    
+    for (i = 0; i < old_capacity; i++) {
+        if (old_slots[i].key != NULL) {
+            *pathlib__path_map_find(map, old_slots[i].key, old_slots[i].key_size, old_slots[i].hash) = old_slots[i];
         }
     }
+    
+    PATHLIB_FREE(old_slots);
 }
 
-PATHLIB_API Path pathlib_parent(const Path* path) {
-    Path ret;
-
-    PATHLIB_ASSERT(path);
+PATHLIB_API Pathlib_Path_Map* pathlib_path_map_new(size_t expected_size) {
+    Pathlib_Path_Map* map;
+    size_t capacity = 16;
+    
+    /* big enough that expected_size keys stay under the 0.7 load factor */
+    while (capacity * 7 < expected_size * 10) {
+        capacity *= 2;
+    }
+    
+    map = pathlib__malloc(sizeof(*map));
+    map->slots = NULL;
+    map->size = 0;
+    map->capacity = 0;
+    map->arena.block = NULL;
+    map->arena.used = 0;
+    map->arena.size = 0;
+    pathlib__path_map_resize(map, capacity);
+    
+    return map;
+}
 
-    if (path->size == 1) {
-        ret.parts = pathlib__malloc(sizeof(*path->parts) * 2);
-        ret.capacity = 2;
-        ret.size = 1;
-        ret.parts[0] = ".";
-    } else if (path->size > 0) {
-        ret.parts = pathlib__malloc(path->capacity * sizeof(*path->parts));
-        ret.capacity = path->capacity;
-        ret.size = path->size - 1;
-        memcpy(ret.parts, path->parts, (ret.size) * sizeof(*path->parts));
-    } else {
-        ret.parts = NULL;
-        ret.capacity = 0;
-        ret.size = 0;
+PATHLIB_API void pathlib_path_map_free(Pathlib_Path_Map* map) {
+    if (map) {
+        pathlib__arena_free(&map->arena);
+        PATHLIB_FREE(map->slots);
+        PATHLIB_FREE(map);
     }
+}
 
-    return ret;
+PATHLIB_API size_t pathlib_path_map_size(const Pathlib_Path_Map* map) {
+    PATHLIB_ASSERT(map);
+    
+    return map->size;
 }
 
-PATHLIB_API Paths pathlib_parents(const Path* path) {
-    Paths paths;
-    const Path* path_ref;
+/* returns the slot of path, inserting it when create is set, or NULL */
+static Pathlib__Path_Map_Slot* pathlib__path_map_slot(Pathlib_Path_Map* map, const Path* path, int create, int* created) {
+    char key[PATHLIB_MAX_PATH];
+    Pathlib__Path_Map_Slot* slot;
+    size_t key_size;
+    pathlib_u64 hash;
     
-    size_t i;
+    key_size = pathlib__path_key(path, key, sizeof(key));
+    if (key_size == 0 && path->size > 0) {
+        pathlib_print_error("path too long for a path map");
+        return NULL;
+    }
     
-    PATHLIB_ASSERT(path);
+    if (create && (map->size + 1) * 10 > map->capacity * 7) {
+        pathlib__path_map_resize(map, map->capacity * 2);
+    }
     
-    paths.paths = NULL;
-    paths.size = 0;
-    paths.capacity = 0;
-        
-    if (path->size == 0) {
-        pathlib_paths_add(&paths, pathlib_from_str("."));
-        return paths;
+    hash = pathlib_hash64(path);
+    slot = pathlib__path_map_find(map, key, key_size, hash);
+    if (created) {
+        *created = 0;
+    }
+    if (slot->key == NULL) {
+        if (!create) {
+            return NULL;
+        }
+        slot->hash = hash;
+        /* an empty path still needs a key that is not NULL */
+        slot->key = memcpy(pathlib__arena_alloc(&map->arena, key_size + 1), key, key_size);
+        slot->key_size = key_size;
+        slot->value.u64 = 0;
+        map->size++;
+        if (created) {
+            *created = 1;
+        }
     }
     
-    if (path->size == 1) {
-        pathlib_paths_add(&paths, pathlib_from_str("."));
-        return paths;
+    return slot;
+}
+
+PATHLIB_API int pathlib_path_map_put(Pathlib_Path_Map* map, const Path* key, void* value) {
+    Pathlib__Path_Map_Slot* slot;
+    int created;
+    
+    PATHLIB_ASSERT(map);
+    PATHLIB_ASSERT(key);
+    
+    slot = pathlib__path_map_slot(map, key, 1, &created);
+    if (slot == NULL) {
+        return 0;
     }
+    slot->value.ptr = value;
     
-    path_ref = path;
-    for (i = 0; i < path->size; i++) {
-        pathlib_paths_add(&paths, pathlib_parent(path_ref));
-        path_ref = &paths.paths[i];
+    return created;
+}
+
+PATHLIB_API int pathlib_path_map_put_u64(Pathlib_Path_Map* map, const Path* key, pathlib_u64 value) {
+    Pathlib__Path_Map_Slot* slot;
+    int created;
+    
+    PATHLIB_ASSERT(map);
+    PATHLIB_ASSERT(key);
+    
+    slot = pathlib__path_map_slot(map, key, 1, &created);
+    if (slot == NULL) {
+        return 0;
     }
+    slot->value.u64 = value;
     
-    return paths;
+    return created;
 }
 
-PATHLIB_API char* pathlib_suffix(const Path* path) {
-    size_t last_part_size, suffix_size;
-    const char* last_part;
-    char* suffix;
+PATHLIB_API int pathlib_path_map_get(const Pathlib_Path_Map* map, const Path* key, PATHLIB_NULLABLE void** value) {
+    Pathlib__Path_Map_Slot* slot;
+    
+    PATHLIB_ASSERT(map);
+    PATHLIB_ASSERT(key);
+    
+    slot = pathlib__path_map_slot((Pathlib_Path_Map*)map, key, 0, NULL);
+    if (slot == NULL) {
+        return 0;
+    }
+    if (value) {
+        *value = slot->value.ptr;
+    }
+    
+    return 1;
+}
 
-    PATHLIB_ASSERT(path);
+PATHLIB_API int pathlib_path_map_get_u64(const Pathlib_Path_Map* map, const Path* key, PATHLIB_NULLABLE pathlib_u64* value) {
+    Pathlib__Path_Map_Slot* slot;
+    
+    PATHLIB_ASSERT(map);
+    PATHLIB_ASSERT(key);
+    
+    slot = pathlib__path_map_slot((Pathlib_Path_Map*)map, key, 0, NULL);
+    if (slot == NULL) {
+        return 0;
+    }
+    if (value) {
+        *value = slot->value.u64;
+    }
+    
+    return 1;
+}
 
-    if (path->size == 0) {
-        return "";
+PATHLIB_API int pathlib_path_map_remove(Pathlib_Path_Map* map, const Path* key) {
+    Pathlib__Path_Map_Slot* slot;
+    size_t hole, i, home;
+    
+    PATHLIB_ASSERT(map);
+    PATHLIB_ASSERT(key);
+    
+    slot = pathlib__path_map_slot(map, key, 0, NULL);
+    if (slot == NULL) {
+        return 0;
     }
-    last_part = path->parts[path->size-1];
-    last_part_size = strlen(last_part);
-    suffix_size = 0;
+    
+    /* backward shift deletion, the entries after the hole that may move into it are moved so no tombstones are needed */
+    hole = slot - map->slots;
+    for (i = (hole + 1) & (map->capacity - 1); map->slots[i].key != NULL; i = (i + 1) & (map->capacity - 1)) {
+        home = (size_t)map->slots[i].hash & (map->capacity - 1);
+        if (((i - home) & (map->capacity - 1)) >= ((i - hole) & (map->capacity - 1))) {
+            map->slots[hole] = map->slots[i];
+            hole = i;
+        }
+    }
+    map->slots[hole].key = NULL;
+    map->size--;
+    
+    /* the key stays inside the arena until the map is freed */
+    return 1;
+}
 
-    while (last_part_size > suffix_size) {
-        if (last_part[last_part_size - suffix_size] == '.') break;
-        suffix_size++;
+PATHLIB_API int pathlib_path_map_next(const Pathlib_Path_Map* map, size_t* iterator, PATHLIB_NULLABLE Path* key, PATHLIB_NULLABLE void** value, PATHLIB_NULLABLE pathlib_u64* value_u64) {
+    const Pathlib__Path_Map_Slot* slot;
+    const char* p;
+    
+    PATHLIB_ASSERT(map);
+    PATHLIB_ASSERT(iterator);
+    
+    while (*iterator < map->capacity) {
+        slot = &map->slots[(*iterator)++];
+        if (slot->key == NULL) {
+            continue;
+        }
+        if (key) {
+            /* the parts point inside the map so they live as long as it */
+            key->parts = NULL;
+            key->size = 0;
+            key->capacity = 0;
+            for (p = slot->key; p < slot->key + slot->key_size; p += strlen(p) + 1) {
+                pathlib_add_part(key, p);
+            }
+        }
+        if (value) {
+            *value = slot->value.ptr;
+        }
+        if (value_u64) {
+            *value_u64 = slot->value.u64;
+        }
+        return 1;
     }
+    
+    return 0;
+}
 
-    if (*(last_part + (last_part_size - suffix_size)) != '.') {
-        return "";
+PATHLIB_API Pathlib_Path_Map* pathlib_path_map_from_paths(const Paths* paths) {
+    Pathlib_Path_Map* map;
+    size_t i;
+    
+    PATHLIB_ASSERT(paths);
+    
+    /* sized once for every path so the table never grows while it is built */
+    map = pathlib_path_map_new(paths->size);
+    for (i = 0; i < paths->size; i++) {
+        pathlib_path_map_put_u64(map, &paths->paths[i], i);
     }
-    suffix = pathlib__malloc(suffix_size + 1);
-    memcpy(suffix, last_part + (last_part_size - suffix_size), suffix_size);
-    suffix[suffix_size] = 0;
+    
+    return map;
+}
 
-    return suffix;
+PATHLIB_API Pathlib_Path_Set* pathlib_path_set_new(size_t expected_size) {
+    return pathlib_path_map_new(expected_size);
 }
 
-PATHLIB_API char** pathlib_suffixes(const Path* path, PATHLIB_NULLABLE size_t* suffix_count) {
-    size_t count, i, last_part_size, suffix_size;
-    char** suffixes;
-    char* suffix;
-    const char* last_part;
+PATHLIB_API Pathlib_Path_Set* pathlib_path_set_from_paths(const Paths* paths) {
+    return pathlib_path_map_from_paths(paths);
+}
+
+PATHLIB_API int pathlib_path_set_add(Pathlib_Path_Set* set, const Path* path) {
+    return pathlib_path_map_put(set, path, NULL);
+}
+
+PATHLIB_API int pathlib_path_set_contains(const Pathlib_Path_Set* set, const Path* path) {
+    return pathlib_path_map_get(set, path, NULL);
+}
+
+PATHLIB_API int pathlib_path_set_remove(Pathlib_Path_Set* set, const Path* path) {
+    return pathlib_path_map_remove(set, path);
+}
+
+PATHLIB_API void pathlib_path_set_free(Pathlib_Path_Set* set) {
+    pathlib_path_map_free(set);
+}
+
+/* the layout of a node is the same in a trie and in its frozen form */
+typedef struct Pathlib__Trie_Node {
+    pathlib_u64 value;
+    pathlib_u32 parent;
+    pathlib_u32 name_offset; /* inside the strings, the name is followed by a 0 */
+    pathlib_u32 name_size;
+    pathlib_u32 has_value;
+    pathlib_u32 first_child; /* 0 when there are none, the root is never a child */
+    pathlib_u32 next_sibling;
+} Pathlib__Trie_Node;
+
+/* the frozen form is this header followed by the nodes, the table and the strings */
+typedef struct Pathlib__Trie_Header {
+    char magic[8];
+    pathlib_u64 node_count;
+    pathlib_u64 table_capacity;
+    pathlib_u64 strings_size;
+} Pathlib__Trie_Header;
+
+#define PATHLIB__TRIE_MAGIC "PLTRIE01"
+
+/* the arrays that the lookups need, a trie and a frozen trie are both read through it */
+typedef struct Pathlib__Trie_View {
+    const Pathlib__Trie_Node* nodes;
+    const pathlib_u32* table; /* node index + 1, 0 for empty slots */
+    size_t table_capacity;    /* always a power of two */
+    const char* strings;
+} Pathlib__Trie_View;
+
+struct Pathlib_Trie {
+    Pathlib__Trie_Node* nodes;
+    size_t node_count;
+    size_t node_capacity;
+    pathlib_u32* table;
+    size_t table_capacity;
+    char* strings;
+    size_t strings_size;
+    size_t strings_capacity;
+};
+
+/* every edge is keyed by its parent and the hash of its name */
+static size_t pathlib__trie_slot_hash(pathlib_u32 parent, pathlib_u64 name_hash) {
+    pathlib_u64 hash = (name_hash ^ ((pathlib_u64)parent * PATHLIB__XXH_P2)) * PATHLIB__XXH_P1;
+    return (size_t)(hash ^ (hash >> 32));
+}
+
+/* returns the index of the child or 0 if there is no such child */
+static pathlib_u32 pathlib__trie_view_child(const Pathlib__Trie_View* view, pathlib_u32 parent, const char* name, size_t name_size) {
+    const Pathlib__Trie_Node* node;
+    size_t i;
     
-    (void) i;
-    (void) last_part_size;
+    for (i = pathlib__trie_slot_hash(parent, pathlib__hash_bytes(name, name_size)) & (view->table_capacity - 1); ;
+         i = (i + 1) & (view->table_capacity - 1)) {
+        if (view->table[i] == 0) {
+            return 0;
+        }
+        node = &view->nodes[view->table[i] - 1];
+        if (node->parent == parent && node->name_size == name_size && memcmp(view->strings + node->name_offset, name, name_size) == 0) {
+            return view->table[i] - 1;
+        }
+    }
+}
+
+/* walks the parts of path, returns the last node that was reached and how many parts it matched */
+static pathlib_u32 pathlib__trie_view_walk(const Pathlib__Trie_View* view, const Path* path, size_t* matched, pathlib_u32* best, size_t* best_matched) {
+    pathlib_u32 node = 0, child;
+    size_t i;
     
-    PATHLIB_ASSERT(path);
+    *best = view->nodes[0].has_value ? 0 : (pathlib_u32)-1;
+    *best_matched = 0;
     
-    if (path->size == 0) {
-        suffixes = pathlib__malloc(sizeof(*suffixes));
-        suffixes[0] = NULL;
-        if (suffix_count != NULL) {
-            suffix_count = 0;
+    for (i = 0; i < path->size; i++) {
+        child = pathlib__trie_view_child(view, node, path->parts[i], strlen(path->parts[i]));
+        if (child == 0) {
+            break;
         }
-        return suffixes;
+        node = child;
+        if (view->nodes[node].has_value) {
+            *best = node;
+            *best_matched = i + 1;
+        }
+    }
+    
+    *matched = i;
+    return node;
+}
+
+static int pathlib__trie_view_get(const Pathlib__Trie_View* view, const Path* path, pathlib_u64* value) {
+    pathlib_u32 node, best;
+    size_t matched, best_matched;
+    
+    node = pathlib__trie_view_walk(view, path, &matched, &best, &best_matched);
+    if (matched != path->size || !view->nodes[node].has_value) {
+        return 0;
+    }
+    if (value) {
+        *value = view->nodes[node].value;
     }
     
-    last_part = path->parts[path->size - 1];
-    last_part_size = 0;
-    count = 0;
+    return 1;
+}
+
+static int pathlib__trie_view_longest_prefix(const Pathlib__Trie_View* view, const Path* path, pathlib_u64* value, size_t* prefix_size) {
+    pathlib_u32 best;
+    size_t matched, best_matched;
     
-    while (*last_part) {
-        if (*last_part == '.') {
-            count += 1;
-        }
-        
-        last_part_size++;
-        last_part++;
+    pathlib__trie_view_walk(view, path, &matched, &best, &best_matched);
+    if (best == (pathlib_u32)-1) {
+        return 0;
     }
-    
-    if (count == 0) {
-        suffixes = pathlib__malloc(sizeof(*suffixes));
-        suffixes[0] = NULL;
-        if (suffix_count != NULL) {
-            suffix_count = 0;
-        }
-        return suffixes;
+    if (value) {
+        *value = view->nodes[best].value;
+    }
+    if (prefix_size) {
+        *prefix_size = best_matched;
     }
     
-    suffixes = pathlib__malloc(sizeof(*suffixes) * (count + 1));
-    suffixes[count] = NULL;
-    if (suffix_count) {
-        *suffix_count = count;
+    return 1;
+}
+
+/* visits every value under prefix in depth first order, returns how many were visited */
+static size_t pathlib__trie_view_subtree(const Pathlib__Trie_View* view, const Path* prefix, Pathlib_Trie_Callback callback, void* userdata) {
+    const Pathlib__Trie_Node* nodes = view->nodes;
+    pathlib_u32 root, node, best;
+    size_t matched, best_matched, visited, depth;
+    Path path;
+    
+    root = pathlib__trie_view_walk(view, prefix, &matched, &best, &best_matched);
+    if (matched != prefix->size) {
+        return 0;
     }
     
-    suffix_size = 0;
-    i = 0;
-    while (count) {
-        if (*last_part == '.') {
-            count--;
-            suffix = pathlib__malloc(suffix_size + 1);
-            suffix[suffix_size] = 0;
-            memcpy(suffix, last_part, suffix_size);
-            suffixes[i] = suffix;
-            i++;
-            suffix_size = 1;
-        } else {
-            suffix_size++;
+    /* the parts of the prefix are borrowed and the rest point inside the strings of the trie */
+    path = pathlib_copy(prefix);
+    visited = 0;
+    depth = 0;
+    node = root;
+    for (;;) {
+        if (nodes[node].has_value) {
+            visited++;
+            if (!callback(&path, nodes[node].value, userdata)) {
+                break;
+            }
         }
         
-        last_part--;
+        if (nodes[node].first_child != 0) {
+            node = nodes[node].first_child;
+            pathlib_add_part(&path, view->strings + nodes[node].name_offset);
+            depth++;
+            continue;
+        }
+        
+        /* go up until a node has a next sibling */
+        while (depth > 0 && nodes[node].next_sibling == 0) {
+            node = nodes[node].parent;
+            path.size--;
+            depth--;
+        }
+        if (depth == 0) {
+            break;
+        }
+        node = nodes[node].next_sibling;
+        path.parts[path.size - 1] = view->strings + nodes[node].name_offset;
     }
     
-    return suffixes;
+    pathlib_destroy(&path);
+    return visited;
 }
 
-PATHLIB_API void pathlib_with_suffix(Path* path, const char* new_suffix) {
-    size_t last_part_size, suffix_size;
-    const char* last_part;
-    char* suffix;
-    char* new_last_part;
+static void pathlib__trie_view(const Pathlib_Trie* trie, Pathlib__Trie_View* view) {
+    view->nodes = trie->nodes;
+    view->table = trie->table;
+    view->table_capacity = trie->table_capacity;
+    view->strings = trie->strings;
+}
 
-    PATHLIB_ASSERT(path);
+static void pathlib__trie_table_add(pathlib_u32* table, size_t capacity, const Pathlib__Trie_Node* nodes, const char* strings, pathlib_u32 node) {
+    size_t i;
+    
+    i = pathlib__trie_slot_hash(nodes[node].parent, pathlib__hash_bytes(strings + nodes[node].name_offset, nodes[node].name_size));
+    for (i &= capacity - 1; table[i] != 0; i = (i + 1) & (capacity - 1));
+    table[i] = node + 1;
+}
 
-    if (path->size == 0) {
-        pathlib_add_part(path, new_suffix);
-        return;
-    }
-    last_part = path->parts[path->size-1];
-    last_part_size = strlen(last_part);
-    suffix_size = 0;
+PATHLIB_API Pathlib_Trie* pathlib_trie_new(void) {
+    Pathlib_Trie* trie;
+    
+    trie = pathlib__malloc(sizeof(*trie));
+    trie->node_capacity = 64;
+    trie->nodes = pathlib__malloc(sizeof(*trie->nodes) * trie->node_capacity);
+    trie->table_capacity = 128;
+    trie->table = pathlib__malloc(sizeof(*trie->table) * trie->table_capacity);
+    memset(trie->table, 0, sizeof(*trie->table) * trie->table_capacity);
+    trie->strings_capacity = 1024;
+    trie->strings = pathlib__malloc(trie->strings_capacity);
+    
+    /* the root is the empty path, its name is the 0 at the start of the strings */
+    memset(&trie->nodes[0], 0, sizeof(trie->nodes[0]));
+    trie->node_count = 1;
+    trie->strings[0] = 0;
+    trie->strings_size = 1;
+    
+    return trie;
+}
 
-    while (last_part_size > suffix_size) {
-        if (last_part[last_part_size - suffix_size] == '.') break;
-        suffix_size++;
+PATHLIB_API void pathlib_trie_free(Pathlib_Trie* trie) {
+    if (trie) {
+        PATHLIB_FREE(trie->nodes);
+        PATHLIB_FREE(trie->table);
+        PATHLIB_FREE(trie->strings);
+        PATHLIB_FREE(trie);
     }
+}
 
-    if (*(last_part + (last_part_size - suffix_size)) != '.') {
-        new_last_part = pathlib__malloc(last_part_size + strlen(new_suffix) + 1);
-        memcpy(new_last_part, last_part, last_part_size);
-        memcpy(new_last_part + last_part_size, new_suffix, strlen(new_suffix));
-        
-        new_last_part[last_part_size + strlen(suffix)] = 0;
-        
-        path->parts[path->size-1] = new_last_part;
-        return;
+static pathlib_u32 pathlib__trie_add_child(Pathlib_Trie* trie, pathlib_u32 parent, const char* name, size_t name_size) {
+    Pathlib__Trie_Node* node;
+    void* temp;
+    size_t i;
+    
+    if (trie->node_count >= trie->node_capacity) {
+        trie->node_capacity *= 2;
+        temp = pathlib__malloc(sizeof(*trie->nodes) * trie->node_capacity);
+        memcpy(temp, trie->nodes, sizeof(*trie->nodes) * trie->node_count);
+        PATHLIB_FREE(trie->nodes);
+        trie->nodes = temp;
+    }
+    if (trie->strings_size + name_size + 1 > trie->strings_capacity) {
+        while (trie->strings_size + name_size + 1 > trie->strings_capacity) {
+            trie->strings_capacity *= 2;
+        }
+        temp = pathlib__malloc(trie->strings_capacity);
+        memcpy(temp, trie->strings, trie->strings_size);
+        PATHLIB_FREE(trie->strings);
+        trie->strings = temp;
+    }
+    /* keep the load factor of the edges under 0.5 */
+    if ((trie->node_count + 1) * 2 > trie->table_capacity) {
+        PATHLIB_FREE(trie->table);
+        trie->table_capacity *= 2;
+        trie->table = pathlib__malloc(sizeof(*trie->table) * trie->table_capacity);
+        memset(trie->table, 0, sizeof(*trie->table) * trie->table_capacity);
+        for (i = 1; i < trie->node_count; i++) {
+            pathlib__trie_table_add(trie->table, trie->table_capacity, trie->nodes, trie->strings, (pathlib_u32)i);
+        }
     }
     
-    new_last_part = pathlib__malloc(last_part_size - suffix_size + strlen(new_suffix));
+    node = &trie->nodes[trie->node_count];
+    node->value = 0;
+    node->parent = parent;
+    node->name_offset = (pathlib_u32)trie->strings_size;
+    node->name_size = (pathlib_u32)name_size;
+    node->has_value = 0;
+    node->first_child = 0;
+    node->next_sibling = trie->nodes[parent].first_child;
+    trie->nodes[parent].first_child = (pathlib_u32)trie->node_count;
     
-    memcpy(new_last_part, last_part, last_part_size - suffix_size);
-    memcpy(new_last_part + last_part_size - suffix_size, new_suffix, strlen(new_suffix));
+    memcpy(trie->strings + trie->strings_size, name, name_size);
+    trie->strings[trie->strings_size + name_size] = 0;
+    trie->strings_size += name_size + 1;
     
-    new_last_part[last_part_size - suffix_size + strlen(new_suffix)] = 0;
+    pathlib__trie_table_add(trie->table, trie->table_capacity, trie->nodes, trie->strings, (pathlib_u32)trie->node_count);
     
-    path->parts[path->size-1] = new_last_part;
-    return;
+    return (pathlib_u32)trie->node_count++;
 }
 
-PATHLIB_API char* pathlib_stem(const Path* path) {
-    size_t last_part_size, suffix_size;
-    const char* last_part;
-    char* region;
-
+PATHLIB_API int pathlib_trie_insert(Pathlib_Trie* trie, const Path* path, pathlib_u64 value) {
+    Pathlib__Trie_View view;
+    pathlib_u32 node, child;
+    size_t i, name_size;
+    int created;
+    
+    PATHLIB_ASSERT(trie);
     PATHLIB_ASSERT(path);
-
-    if (path->size == 0) {
-        return "";
-    }
-    last_part = path->parts[path->size-1];
-    last_part_size = strlen(last_part);
-    suffix_size = 0;
-
-    while (last_part_size > suffix_size) {
-        if (last_part[last_part_size - suffix_size] == '.') break;
-        suffix_size++;
+    
+    node = 0;
+    for (i = 0; i < path->size; i++) {
+        name_size = strlen(path->parts[i]);
+        pathlib__trie_view(trie, &view);
+        child = pathlib__trie_view_child(&view, node, path->parts[i], name_size);
+        if (child == 0) {
+            child = pathlib__trie_add_child(trie, node, path->parts[i], name_size);
+        }
+        node = child;
     }
+    
+    created = !trie->nodes[node].has_value;
+    trie->nodes[node].has_value = 1;
+    trie->nodes[node].value = value;
+    
+    return created;
+}
 
-    if (*(last_part + (last_part_size - suffix_size)) != '.') {
-        return "";
+PATHLIB_API Pathlib_Trie* pathlib_trie_from_paths(const Paths* paths) {
+    Pathlib_Trie* trie;
+    size_t i;
+    
+    PATHLIB_ASSERT(paths);
+    
+    trie = pathlib_trie_new();
+    for (i = 0; i < paths->size; i++) {
+        pathlib_trie_insert(trie, &paths->paths[i], i);
     }
-    region = pathlib__malloc(last_part_size - suffix_size + 1);
-    memcpy(region, last_part, last_part_size - suffix_size);
-    region[last_part_size - suffix_size] = 0;
-
-    return region;
+    
+    return trie;
 }
 
-PATHLIB_API char* pathlib_to_str(const Path* path) {
-    size_t total_size, i, p;
-    char* region;
+PATHLIB_API int pathlib_trie_get(const Pathlib_Trie* trie, const Path* path, PATHLIB_NULLABLE pathlib_u64* value) {
+    Pathlib__Trie_View view;
+    
+    PATHLIB_ASSERT(trie);
+    PATHLIB_ASSERT(path);
+    
+    pathlib__trie_view(trie, &view);
+    return pathlib__trie_view_get(&view, path, value);
+}
 
+PATHLIB_API int pathlib_trie_longest_prefix(const Pathlib_Trie* trie, const Path* path, PATHLIB_NULLABLE pathlib_u64* value, PATHLIB_NULLABLE size_t* prefix_size) {
+    Pathlib__Trie_View view;
+    
+    PATHLIB_ASSERT(trie);
     PATHLIB_ASSERT(path);
+    
+    pathlib__trie_view(trie, &view);
+    return pathlib__trie_view_longest_prefix(&view, path, value, prefix_size);
+}
 
-    total_size = 0;
-    for (i = 0; i < path->size; i++) {
-        total_size += strlen(path->parts[i]);
-    }
+PATHLIB_API size_t pathlib_trie_subtree(const Pathlib_Trie* trie, const Path* prefix, Pathlib_Trie_Callback callback, void* userdata) {
+    Pathlib__Trie_View view;
+    
+    PATHLIB_ASSERT(trie);
+    PATHLIB_ASSERT(prefix);
+    PATHLIB_ASSERT(callback);
+    
+    pathlib__trie_view(trie, &view);
+    return pathlib__trie_view_subtree(&view, prefix, callback, userdata);
+}
 
-    /* add n-1 extra bytes for the seperators */
-    if (path->size > 0) {
-        total_size += path->size - 1;
-    }
-    /* +1 for null terminator */
-    region = pathlib__malloc(total_size + 1);
+PATHLIB_API unsigned char* pathlib_trie_freeze(const Pathlib_Trie* trie, size_t* size) {
+    Pathlib__Trie_Header header;
+    unsigned char* data;
+    size_t nodes_size, table_size;
+    
+    PATHLIB_ASSERT(trie);
+    PATHLIB_ASSERT(size);
+    
+    nodes_size = sizeof(*trie->nodes) * trie->node_count;
+    table_size = sizeof(*trie->table) * trie->table_capacity;
+    
+    memcpy(header.magic, PATHLIB__TRIE_MAGIC, sizeof(header.magic));
+    header.node_count = trie->node_count;
+    header.table_capacity = trie->table_capacity;
+    header.strings_size = trie->strings_size;
+    
+    *size = sizeof(header) + nodes_size + table_size + trie->strings_size;
+    data = pathlib__malloc(*size);
+    memcpy(data, &header, sizeof(header));
+    memcpy(data + sizeof(header), trie->nodes, nodes_size);
+    memcpy(data + sizeof(header) + nodes_size, trie->table, table_size);
+    memcpy(data + sizeof(header) + nodes_size + table_size, trie->strings, trie->strings_size);
+    
+    return data;
+}
 
-    if (path->size == 0) {
-        region[0] = 0;
-        return region;
+/* checks the header of a frozen trie and points view inside it */
+static int pathlib__trie_frozen_view(const void* data, size_t size, Pathlib__Trie_View* view) {
+    const Pathlib__Trie_Header* header = data;
+    const unsigned char* p = data;
+    pathlib_u64 rest;
+    
+    if (size < sizeof(*header) || memcmp(header->magic, PATHLIB__TRIE_MAGIC, sizeof(header->magic)) != 0) {
+        pathlib_print_error("not a frozen trie");
+        return 0;
     }
-
-    p = 0;
-    for (i = 0; i < path->size; i++) {
-        memcpy(region+p, path->parts[i], strlen(path->parts[i]));
-        p += strlen(path->parts[i]);
-        region[p] = '/';
-        p += 1;
+    
+    /* every count is bounded by the data first so the sizes below cant wrap */
+    rest = size - sizeof(*header);
+    if (header->node_count == 0 || header->node_count > rest / sizeof(Pathlib__Trie_Node) ||
+        header->table_capacity == 0 || header->table_capacity > rest / sizeof(pathlib_u32) || (header->table_capacity & (header->table_capacity - 1)) != 0 ||
+        header->strings_size > rest ||
+        rest != header->node_count * sizeof(Pathlib__Trie_Node) + header->table_capacity * sizeof(pathlib_u32) + header->strings_size) {
+        pathlib_print_error("not a frozen trie");
+        return 0;
     }
-    region[total_size] = 0;
-
-    return region;
+    
+    view->nodes = (const Pathlib__Trie_Node*)(p + sizeof(*header));
+    view->table = (const pathlib_u32*)(p + sizeof(*header) + header->node_count * sizeof(Pathlib__Trie_Node));
+    view->table_capacity = (size_t)header->table_capacity;
+    view->strings = (const char*)(view->table + header->table_capacity);
+    
+    return 1;
 }
 
-int pathlib_render_str_to_buffer(const Path* path, char* buffer, size_t buffer_size) {
-    size_t i, str_size;
+PATHLIB_API int pathlib_trie_frozen_check(const void* data, size_t size) {
+    const Pathlib__Trie_Header* header = data;
+    const Pathlib__Trie_Node* node;
+    Pathlib__Trie_View view;
+    unsigned char* reached;
+    size_t i, j, mask, empty, run, home;
+    pathlib_u32 child;
+    int valid;
     
-    PATHLIB_ASSERT(path);
-    PATHLIB_ASSERT(buffer);
+    PATHLIB_ASSERT(data);
     
-    if (path->size == 0) {
-        if (buffer_size < 1) {
+    if (!pathlib__trie_frozen_view(data, size, &view)) {
+        return 0;
+    }
+    
+    for (i = 0; i < header->node_count; i++) {
+        node = &view.nodes[i];
+        if ((i > 0 && node->parent >= i) || (node->first_child != 0 && (node->first_child <= i || node->first_child >= header->node_count)) ||
+            (node->next_sibling != 0 && node->next_sibling >= i) || node->has_value > 1 ||
+            (pathlib_u64)node->name_offset + node->name_size >= header->strings_size || view.strings[node->name_offset + node->name_size] != 0) {
+            pathlib_print_error("corrupted frozen trie");
             return 0;
         }
-        buffer[0] = 0;
-        return 1;
     }
     
-    i = 0;
-    while (buffer_size > 0) {
-        str_size = strlen(path->parts[i]);
-        if (str_size > buffer_size) {
+    /* the siblings get smaller so every list of children ends, every child has to point back to the
+    *  node whose list it is in and every node except the root has to be inside exactly one list,
+    *  then the nodes form a tree and every walk ends */
+    reached = pathlib__malloc(header->node_count);
+    memset(reached, 0, header->node_count);
+    valid = view.nodes[0].next_sibling == 0;
+    for (i = 0; valid && i < header->node_count; i++) {
+        for (child = view.nodes[i].first_child; child != 0; child = view.nodes[child].next_sibling) {
+            if (view.nodes[child].parent != i || reached[child]) {
+                valid = 0;
+                break;
+            }
+            reached[child] = 1;
+        }
+    }
+    for (i = 1; valid && i < header->node_count; i++) {
+        valid = reached[i];
+    }
+    PATHLIB_FREE(reached);
+    if (!valid) {
+        pathlib_print_error("corrupted frozen trie");
+        return 0;
+    }
+    
+    /* a lookup stops at an empty slot so there has to be one, and every node has to be reachable
+    *  from the slot that its hash starts at without crossing an empty slot */
+    mask = view.table_capacity - 1;
+    for (empty = 0; empty < view.table_capacity && view.table[empty] != 0; empty++);
+    if (empty == view.table_capacity) {
+        pathlib_print_error("corrupted frozen trie");
+        return 0;
+    }
+    run = 0;
+    for (i = 1; i < view.table_capacity; i++) {
+        j = (empty + i) & mask;
+        if (view.table[j] == 0) {
+            run = 0;
+            continue;
+        }
+        run++;
+        if (view.table[j] < 2 || view.table[j] > header->node_count) {
+            pathlib_print_error("corrupted frozen trie");
             return 0;
         }
-        memcpy(buffer, path->parts[i], str_size);
-        buffer += str_size;
-        buffer_size -= str_size;
-        
-        i++;
-        
-        if (i != path->size) {
-            if (buffer_size < 1) {
-                return 0;
-            }
-            buffer[0] = '/';
-            buffer++;
-            buffer_size--;
-        } else {
-            if (buffer_size < 1) {
-                return 0;
-            }
-            buffer[0] = 0;
-            return 1;
+        node = &view.nodes[view.table[j] - 1];
+        home = pathlib__trie_slot_hash(node->parent, pathlib__hash_bytes(view.strings + node->name_offset, node->name_size)) & mask;
+        if (((j - home) & mask) >= run) {
+            pathlib_print_error("corrupted frozen trie");
+            return 0;
         }
     }
     
-    return 0;
+    return 1;
+}
+
+PATHLIB_API int pathlib_trie_frozen_get(const void* data, size_t size, const Path* path, PATHLIB_NULLABLE pathlib_u64* value) {
+    Pathlib__Trie_View view;
+    
+    PATHLIB_ASSERT(data);
+    PATHLIB_ASSERT(path);
+    
+    return pathlib__trie_frozen_view(data, size, &view) && pathlib__trie_view_get(&view, path, value);
+}
+
+PATHLIB_API int pathlib_trie_frozen_longest_prefix(const void* data, size_t size, const Path* path, PATHLIB_NULLABLE pathlib_u64* value, PATHLIB_NULLABLE size_t* prefix_size) {
+    Pathlib__Trie_View view;
+    
+    PATHLIB_ASSERT(data);
+    PATHLIB_ASSERT(path);
+    
+    return pathlib__trie_frozen_view(data, size, &view) && pathlib__trie_view_longest_prefix(&view, path, value, prefix_size);
+}
+
+PATHLIB_API size_t pathlib_trie_frozen_subtree(const void* data, size_t size, const Path* prefix, Pathlib_Trie_Callback callback, void* userdata) {
+    Pathlib__Trie_View view;
+    
+    PATHLIB_ASSERT(data);
+    PATHLIB_ASSERT(prefix);
+    PATHLIB_ASSERT(callback);
+    
+    if (!pathlib__trie_frozen_view(data, size, &view)) {
+        return 0;
+    }
+    return pathlib__trie_view_subtree(&view, prefix, callback, userdata);
+}
+
+/* a serialized Paths is a header followed by the restart offsets and the entries, every integer is
+*  little endian so the data can move between machines. An entry is the size of the prefix that it
+*  shares with the previous key, the size of the rest and the rest, the entries at a restart point
+*  share nothing so a lookup can start decoding from them. The key of a path is every part followed by a 0,
+*  sorting the keys bytewise sorts the paths part by part */
+#define PATHLIB__PATHS_MAGIC "PLPATHS1"
+#define PATHLIB__PATHS_HEADER_SIZE 48
+
+typedef struct Pathlib__Paths_Key {
+    const unsigned char* key;
+    size_t size;
+} Pathlib__Paths_Key;
+
+typedef struct Pathlib__Paths_Reader {
+    pathlib_u64 count;
+    pathlib_u64 restart_count;
+    pathlib_u64 restart_interval;
+    pathlib_u64 max_key_size;
+    const unsigned char* restarts;
+    const unsigned char* entries;
+    const unsigned char* end;
+} Pathlib__Paths_Reader;
+
+static void pathlib__store_u64le(unsigned char* p, pathlib_u64 value) {
+    size_t i;
+    
+    for (i = 0; i < 8; i++) {
+        p[i] = (unsigned char)(value >> (i * 8));
+    }
+}
+
+static pathlib_u64 pathlib__load_u64le(const unsigned char* p) {
+    pathlib_u64 value = 0;
+    size_t i;
+    
+    for (i = 0; i < 8; i++) {
+        value |= (pathlib_u64)p[i] << (i * 8);
+    }
+    return value;
 }
 
-/* internal function so no safety */
-PATHLIB_API int pathlib__render_n_parts_to_buffer(const Path* path, char* buffer, size_t buffer_size, size_t n_parts) {
-    size_t i, str_size;
-        
-    PATHLIB_ASSERT(path);
-    PATHLIB_ASSERT(buffer);
+/* writes value 7 bits at a time and returns how many bytes it took, p may be NULL to only measure it */
+static size_t pathlib__put_varint(unsigned char* p, pathlib_u64 value) {
+    size_t size = 1;
     
-    if (n_parts) {
-        if (buffer_size < 1) {
-            return 0;
+    while (value >= 0x80) {
+        if (p) {
+            *p++ = (unsigned char)(value | 0x80);
         }
-        buffer[0] = 0;
-        return 1;
+        value >>= 7;
+        size++;
+    }
+    if (p) {
+        *p = (unsigned char)value;
     }
+    return size;
+}
+
+static int pathlib__get_varint(const unsigned char** p, const unsigned char* end, pathlib_u64* value) {
+    unsigned int shift;
     
-    i = 0;
-    while (buffer_size > 0) {
-        str_size = strlen(path->parts[i]);
-        if (str_size > buffer_size) {
-            return 0;
-        }
-        memcpy(buffer, path->parts[i], str_size);
-        buffer += str_size;
-        buffer_size -= str_size;
-        
-        i++;
-        
-        if (i != n_parts) {
-            if (buffer_size < 1) {
-                return 0;
-            }
-            buffer[0] = '/';
-            buffer++;
-            buffer_size--;
-        } else {
-            if (buffer_size < 1) {
-                return 0;
-            }
-            buffer[0] = 0;
+    *value = 0;
+    for (shift = 0; shift < 64 && *p < end; shift += 7) {
+        *value |= (pathlib_u64)(**p & 0x7F) << shift;
+        if ((*(*p)++ & 0x80) == 0) {
             return 1;
         }
     }
-    
     return 0;
 }
 
-PATHLIB_API int pathlib_exists(const Path* path) {
-    char filename[PATHLIB_MAX_PATH];
-    /* if it cant be rendered in a buffer that holds the system limit for a path then it doesnt exist */
-    if (!pathlib_render_str_to_buffer(path, filename, PATHLIB_ARRSIZE(filename))) {
-        return 0;
+static size_t pathlib__paths_key_size(const Path* path) {
+    size_t i, size = 0;
+    
+    for (i = 0; i < path->size; i++) {
+        size += strlen(path->parts[i]) + 1;
     }
-    #ifdef _WIN32
-        return GetFileAttributesA(filename) != INVALID_FILE_ATTRIBUTES;
-    #else /* _WIN32 */
-        return access(filename, F_OK) == 0;
-    #endif /* _WIN32 */
+    return size;
 }
 
-PATHLIB_API int pathlib_is_file(const Path* path) {
-    char filename[PATHLIB_MAX_PATH];
-    #ifdef _WIN32
-        DWORD attr;
-    #else
-        struct stat statbuf;
-    #endif
-
-    pathlib_error = PATHLIB_NONE;
+static unsigned char* pathlib__paths_write_key(const Path* path, unsigned char* key) {
+    size_t i, part_size;
+    
+    for (i = 0; i < path->size; i++) {
+        part_size = strlen(path->parts[i]) + 1;
+        memcpy(key, path->parts[i], part_size);
+        key += part_size;
+    }
+    return key;
+}
 
-    if (!pathlib_exists(path)) {
-        return 0;
+static int pathlib__paths_key_cmp(const unsigned char* a, size_t a_size, const unsigned char* b, size_t b_size) {
+    int cmp = memcmp(a, b, a_size < b_size ? a_size : b_size);
+    
+    if (cmp != 0) {
+        return cmp;
     }
+    return a_size < b_size ? -1 : a_size > b_size;
+}
 
-    /* if it cant be rendered in a buffer that holds the system limit for a path then it doesnt exist */
-    if (!pathlib_render_str_to_buffer(path, filename, PATHLIB_ARRSIZE(filename))) {
+static int pathlib__paths_key_qsort_cmp(const void* a, const void* b) {
+    const Pathlib__Paths_Key* x = a;
+    const Pathlib__Paths_Key* y = b;
+    
+    return pathlib__paths_key_cmp(x->key, x->size, y->key, y->size);
+}
+
+static size_t pathlib__paths_shared_size(const Pathlib__Paths_Key* a, const Pathlib__Paths_Key* b) {
+    size_t i, size = a->size < b->size ? a->size : b->size;
+    
+    for (i = 0; i < size && a->key[i] == b->key[i]; i++);
+    return i;
+}
+
+/* the parts point inside a single allocation that starts at parts[0] */
+static int pathlib__paths_key_to_path(const unsigned char* key, size_t key_size, Path* path) {
+    char* str;
+    size_t i, part_count;
+    
+    memset(path, 0, sizeof(*path));
+    if (key_size == 0) {
+        return 1;
+    }
+    
+    part_count = 0;
+    for (i = 0; i < key_size; i++) {
+        part_count += key[i] == 0;
+    }
+    if (key[key_size - 1] != 0 || part_count > (unsigned short)-1) {
         return 0;
     }
-    #ifdef _WIN32
-        attr = GetFileAttributesA(filename);
-        if (attr == INVALID_FILE_ATTRIBUTES) {
-            pathlib_print_os_error("GetFileAttributesA", filename);
-            pathlib_error = PATHLIB_OSERROR;
-            return 0;
-        }
-        return (attr & FILE_ATTRIBUTE_DIRECTORY) == 0;
-    #else /* _WIN32 */
-        if (stat(filename, &statbuf) < 0) {
-            pathlib_print_os_error("stat", filename);
-            pathlib_error = PATHLIB_OSERROR;
-            return 0;
+    
+    str = memcpy(pathlib__malloc(key_size), key, key_size);
+    path->parts = pathlib__malloc(sizeof(*path->parts) * part_count);
+    path->capacity = (unsigned short)part_count;
+    path->parts[path->size++] = str;
+    for (i = 0; i < key_size - 1; i++) {
+        if (str[i] == 0) {
+            path->parts[path->size++] = str + i + 1;
         }
-
-        return (statbuf.st_mode & S_IFMT) == S_IFREG;
-    #endif /* _WIN32 */
+    }
+    
+    return 1;
 }
 
-PATHLIB_API int pathlib_is_dir(const Path* path) {
-    char filename[PATH_MAX];
-    #ifdef _WIN32
-        DWORD attr;
-    #else
-        struct stat statbuf;
-    #endif
-
-    pathlib_error = PATHLIB_NONE;
+static int pathlib__paths_reader_open(Pathlib__Paths_Reader* reader, const void* data, size_t size) {
+    const unsigned char* p = data;
+    pathlib_u64 restarts_size;
+    
+    if (size < PATHLIB__PATHS_HEADER_SIZE || memcmp(p, PATHLIB__PATHS_MAGIC, 8) != 0) {
+        pathlib_print_error("not a serialized Paths");
+        return 0;
+    }
+    
+    reader->count = pathlib__load_u64le(p + 8);
+    reader->restart_count = pathlib__load_u64le(p + 16);
+    reader->restart_interval = pathlib__load_u64le(p + 24);
+    reader->max_key_size = pathlib__load_u64le(p + 32);
+    restarts_size = reader->restart_count * 8;
+    /* every entry takes at least 2 bytes and no key is longer than all of the entries together,
+    *  the count of restarts is rounded up without an addition that a huge interval would wrap */
+    if (reader->restart_interval == 0 || reader->restart_count > (size - PATHLIB__PATHS_HEADER_SIZE) / 8 ||
+        reader->count > (size - PATHLIB__PATHS_HEADER_SIZE - restarts_size) / 2 || reader->max_key_size > size ||
+        reader->restart_count != reader->count / reader->restart_interval + (reader->count % reader->restart_interval != 0) ||
+        pathlib__load_u64le(p + 40) != size - PATHLIB__PATHS_HEADER_SIZE - restarts_size) {
+        pathlib_print_error("not a serialized Paths");
+        return 0;
+    }
+    
+    reader->restarts = p + PATHLIB__PATHS_HEADER_SIZE;
+    reader->entries = reader->restarts + restarts_size;
+    reader->end = p + size;
+    
+    return 1;
+}
 
-    if (!pathlib_exists(path)) {
+/* decodes the entry at p into key which holds the previous key, every size is checked so corrupted data cant
+*  make it read or write out of bounds. It and the functions below dont print anything, their callers report the corruption once */
+static int pathlib__paths_reader_next(const Pathlib__Paths_Reader* reader, const unsigned char** p, unsigned char* key, size_t* key_size) {
+    pathlib_u64 shared, suffix_size;
+    
+    if (!pathlib__get_varint(p, reader->end, &shared) || !pathlib__get_varint(p, reader->end, &suffix_size) ||
+        shared > *key_size || suffix_size > reader->max_key_size - shared || suffix_size > (pathlib_u64)(reader->end - *p)) {
         return 0;
     }
+    
+    memcpy(key + shared, *p, (size_t)suffix_size);
+    *p += suffix_size;
+    *key_size = (size_t)(shared + suffix_size);
+    
+    return 1;
+}
 
-    /* if it cant be rendered in a buffer that holds the system limit for a path then it doesnt exist */
-    if (!pathlib_render_str_to_buffer(path, filename, PATHLIB_ARRSIZE(filename))) {
+/* points p at the start of a restart block */
+static int pathlib__paths_reader_seek(const Pathlib__Paths_Reader* reader, pathlib_u64 restart, const unsigned char** p) {
+    pathlib_u64 offset = pathlib__load_u64le(reader->restarts + restart * 8);
+    
+    if (offset >= (pathlib_u64)(reader->end - reader->entries)) {
         return 0;
     }
-    #ifdef _WIN32
-        attr = GetFileAttributesA(filename);
-        if (attr == INVALID_FILE_ATTRIBUTES) {
-            pathlib_print_os_error("GetFileAttributesA", filename);
-            pathlib_error = PATHLIB_OSERROR;
-            return 0;
+    *p = reader->entries + offset;
+    return 1;
+}
+
+PATHLIB_API unsigned char* pathlib_paths_serialize(const Paths* paths, size_t* size) {
+    Pathlib__Paths_Key* keys;
+    unsigned char* key_data, *data, *p;
+    size_t i, shared, keys_size, data_size, max_key_size, restart_count;
+    
+    PATHLIB_ASSERT(paths);
+    PATHLIB_ASSERT(size);
+    
+    keys_size = 0;
+    for (i = 0; i < paths->size; i++) {
+        keys_size += pathlib__paths_key_size(&paths->paths[i]);
+    }
+    key_data = pathlib__malloc(keys_size + 1);
+    keys = pathlib__malloc(sizeof(*keys) * (paths->size + 1));
+    
+    p = key_data;
+    max_key_size = 0;
+    for (i = 0; i < paths->size; i++) {
+        keys[i].key = p;
+        p = pathlib__paths_write_key(&paths->paths[i], p);
+        keys[i].size = p - keys[i].key;
+        if (keys[i].size > max_key_size) {
+            max_key_size = keys[i].size;
         }
-        return (attr & FILE_ATTRIBUTE_DIRECTORY) != 0;
-    #else /* _WIN32 */
-        if (stat(filename, &statbuf) < 0) {
-            pathlib_print_os_error("stat", filename);
-            pathlib_error = PATHLIB_OSERROR;
-            return 0;
+    }
+    qsort(keys, paths->size, sizeof(*keys), pathlib__paths_key_qsort_cmp);
+    
+    /* the first pass measures the entries so the buffer is allocated once */
+    data_size = 0;
+    for (i = 0; i < paths->size; i++) {
+        shared = i % PATHLIB_PATHS_RESTART_INTERVAL == 0 ? 0 : pathlib__paths_shared_size(&keys[i - 1], &keys[i]);
+        data_size += pathlib__put_varint(NULL, shared) + pathlib__put_varint(NULL, keys[i].size - shared) + keys[i].size - shared;
+    }
+    restart_count = (paths->size + PATHLIB_PATHS_RESTART_INTERVAL - 1) / PATHLIB_PATHS_RESTART_INTERVAL;
+    
+    *size = PATHLIB__PATHS_HEADER_SIZE + restart_count * 8 + data_size;
+    data = pathlib__malloc(*size);
+    memcpy(data, PATHLIB__PATHS_MAGIC, 8);
+    pathlib__store_u64le(data + 8, paths->size);
+    pathlib__store_u64le(data + 16, restart_count);
+    pathlib__store_u64le(data + 24, PATHLIB_PATHS_RESTART_INTERVAL);
+    pathlib__store_u64le(data + 32, max_key_size);
+    pathlib__store_u64le(data + 40, data_size);
+    
+    p = data + PATHLIB__PATHS_HEADER_SIZE + restart_count * 8;
+    for (i = 0; i < paths->size; i++) {
+        if (i % PATHLIB_PATHS_RESTART_INTERVAL == 0) {
+            pathlib__store_u64le(data + PATHLIB__PATHS_HEADER_SIZE + i / PATHLIB_PATHS_RESTART_INTERVAL * 8,
+                                 p - (data + PATHLIB__PATHS_HEADER_SIZE + restart_count * 8));
+            shared = 0;
+        } else {
+            shared = pathlib__paths_shared_size(&keys[i - 1], &keys[i]);
         }
-
-        return (statbuf.st_mode & S_IFMT) == S_IFDIR;
-    #endif /* _WIN32 */
+        p += pathlib__put_varint(p, shared);
+        p += pathlib__put_varint(p, keys[i].size - shared);
+        memcpy(p, keys[i].key + shared, keys[i].size - shared);
+        p += keys[i].size - shared;
+    }
+    
+    PATHLIB_FREE(keys);
+    PATHLIB_FREE(key_data);
+    
+    return data;
 }
 
-PATHLIB_API int pathlib_is_symlink(const Path* path) {
-    #ifdef _WIN32
-        DWORD attributes;
-    #else
-        struct stat pathStat;
-    #endif
-    char filename[PATHLIB_MAX_PATH];
-
-    PATHLIB_ASSERT(path);
-
-    pathlib_error = PATHLIB_NONE;
+/* decodes every entry and checks everything that the lookups rely on, the paths are added to paths when it is not NULL */
+static int pathlib__paths_decode(const void* data, size_t size, Paths* paths) {
+    Pathlib__Paths_Reader reader;
+    const unsigned char* p, *restart;
+    unsigned char* key, *previous;
+    size_t key_size, previous_size;
+    pathlib_u64 i;
+    Path path;
+    int ok;
     
-    if (!pathlib_exists(path)) {
+    if (!pathlib__paths_reader_open(&reader, data, size)) {
         return 0;
     }
-
-    if (!pathlib_render_str_to_buffer(path, filename, PATHLIB_ARRSIZE(filename))) {
-        return 0;
+    
+    key = pathlib__malloc((size_t)reader.max_key_size + 1);
+    previous = pathlib__malloc((size_t)reader.max_key_size + 1);
+    key_size = 0;
+    previous_size = 0;
+    p = reader.entries;
+    ok = 1;
+    for (i = 0; i < reader.count && ok; i++) {
+        if (i % reader.restart_interval == 0) {
+            /* the entries at a restart point must share nothing */
+            ok = pathlib__paths_reader_seek(&reader, i / reader.restart_interval, &restart) && restart == p;
+            key_size = 0;
+        }
+        ok = ok && pathlib__paths_reader_next(&reader, &p, key, &key_size) &&
+             (i == 0 || pathlib__paths_key_cmp(previous, previous_size, key, key_size) <= 0);
+        if (ok && paths) {
+            ok = pathlib__paths_key_to_path(key, key_size, &path);
+            if (ok) {
+                pathlib_paths_add(paths, path);
+            }
+        }
+        memcpy(previous, key, key_size);
+        previous_size = key_size;
+    }
+    if (ok && p != reader.end) {
+        ok = 0;
+    }
+    if (!ok) {
+        pathlib_print_error("corrupted serialized Paths");
     }
+    
+    PATHLIB_FREE(previous);
+    PATHLIB_FREE(key);
+    
+    return ok;
+}
 
-    #ifdef _WIN32
-        attributes = GetFileAttributesA(filename);
-        if (attributes == INVALID_FILE_ATTRIBUTES) {
-            pathlib_print_os_error("GetFileAttributesA", filename);
-            pathlib_error = PATHLIB_OSERROR;
-            return 0;
+PATHLIB_API Paths pathlib_paths_deserialize(const void* data, size_t size) {
+    Paths paths;
+    size_t i;
+    
+    PATHLIB_ASSERT(data);
+    
+    pathlib_error = PATHLIB_NONE;
+    memset(&paths, 0, sizeof(paths));
+    
+    if (!pathlib__paths_decode(data, size, &paths)) {
+        for (i = 0; i < paths.size; i++) {
+            if (paths.paths[i].size > 0) {
+                PATHLIB_FREE((void*)paths.paths[i].parts[0]);
+            }
+            pathlib_destroy(&paths.paths[i]);
         }
-        return (attributes & FILE_ATTRIBUTE_REPARSE_POINT) ? 1 : 0;
+        pathlib_paths_free(&paths);
+        pathlib_error = PATHLIB_OSERROR;
+    }
+    
+    return paths;
+}
 
-    #else
-        if (lstat(filename, &pathStat) != 0) {
-            pathlib_print_os_error("stat", filename);
-            pathlib_error = PATHLIB_OSERROR;
-            return 0;
-        }
-        return S_ISLNK(pathStat.st_mode) ? 1 : 0;
-    #endif
+PATHLIB_API int pathlib_paths_serialized_check(const void* data, size_t size) {
+    PATHLIB_ASSERT(data);
+    
+    return pathlib__paths_decode(data, size, NULL);
 }
 
-PATHLIB_API int pathlib_is_mount(const Path* path) {
-    char filename[PATHLIB_MAX_PATH];
-    #ifdef _WIN32
-        char volumePath[PATHLIB_MAX_PATH];
-    #else
-        struct stat pathStat, parentStat;
-        char parentPath[PATHLIB_MAX_PATH];
-    #endif
+PATHLIB_API size_t pathlib_paths_serialized_count(const void* data, size_t size) {
+    Pathlib__Paths_Reader reader;
+    
+    PATHLIB_ASSERT(data);
+    
+    if (!pathlib__paths_reader_open(&reader, data, size)) {
+        return 0;
+    }
+    return (size_t)reader.count;
+}
 
+PATHLIB_API int pathlib_paths_serialized_get(const void* data, size_t size, size_t index, Path* path) {
+    Pathlib__Paths_Reader reader;
+    const unsigned char* p;
+    unsigned char* key;
+    size_t i, key_size;
+    int ok;
+    
+    PATHLIB_ASSERT(data);
     PATHLIB_ASSERT(path);
+    
+    if (!pathlib__paths_reader_open(&reader, data, size) || index >= reader.count ||
+        !pathlib__paths_reader_seek(&reader, index / reader.restart_interval, &p)) {
+        return 0;
+    }
+    
+    key = pathlib__malloc((size_t)reader.max_key_size + 1);
+    key_size = 0;
+    ok = 1;
+    for (i = 0; i <= index % reader.restart_interval && ok; i++) {
+        ok = pathlib__paths_reader_next(&reader, &p, key, &key_size);
+    }
+    ok = ok && pathlib__paths_key_to_path(key, key_size, path);
+    if (!ok) {
+        pathlib_print_error("corrupted serialized Paths");
+    }
+    PATHLIB_FREE(key);
+    
+    return ok;
+}
 
-    pathlib_error = PATHLIB_NONE;
-
-    if (!pathlib_exists(path)) {
+PATHLIB_API int pathlib_paths_serialized_find(const void* data, size_t size, const Path* path, PATHLIB_NULLABLE size_t* index) {
+    Pathlib__Paths_Reader reader;
+    const unsigned char* p;
+    unsigned char* target, *key;
+    size_t target_size, key_size;
+    pathlib_u64 low, high, middle, i;
+    int cmp, found;
+    
+    PATHLIB_ASSERT(data);
+    PATHLIB_ASSERT(path);
+    
+    if (!pathlib__paths_reader_open(&reader, data, size)) {
         return 0;
     }
-
-    if (!pathlib_render_str_to_buffer(path, filename, PATHLIB_ARRSIZE(filename))) {
+    
+    target_size = pathlib__paths_key_size(path);
+    target = pathlib__malloc(target_size + 1);
+    pathlib__paths_write_key(path, target);
+    key = pathlib__malloc((size_t)reader.max_key_size + 1);
+    
+    /* the key at a restart point is stored whole, find the first one that is not smaller than the target */
+    low = 0;
+    high = reader.restart_count;
+    while (low < high) {
+        middle = low + (high - low) / 2;
+        key_size = 0;
+        if (!pathlib__paths_reader_seek(&reader, middle, &p) || !pathlib__paths_reader_next(&reader, &p, key, &key_size)) {
+            pathlib_print_error("corrupted serialized Paths");
+            PATHLIB_FREE(key);
+            PATHLIB_FREE(target);
+            return 0;
+        }
+        if (pathlib__paths_key_cmp(key, key_size, target, target_size) < 0) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    
+    /* the first key that is not smaller is inside the block before it */
+    found = 0;
+    i = low == 0 ? 0 : (low - 1) * reader.restart_interval;
+    p = reader.entries;
+    if (i < reader.count && !pathlib__paths_reader_seek(&reader, i / reader.restart_interval, &p)) {
+        pathlib_print_error("corrupted serialized Paths");
+        PATHLIB_FREE(key);
+        PATHLIB_FREE(target);
         return 0;
     }
-
-    #ifdef _WIN32
-        if (!GetVolumePathName(filename, volumePath, PATHLIB_ARRSIZE(volumePath))) {
-            pathlib_print_os_error("GetVolumePathName", filename);
-            pathlib_error = PATHLIB_OSERROR;
+    key_size = 0;
+    for (; i < reader.count; i++) {
+        if (!pathlib__paths_reader_next(&reader, &p, key, &key_size)) {
+            pathlib_print_error("corrupted serialized Paths");
+            PATHLIB_FREE(key);
+            PATHLIB_FREE(target);
             return 0;
         }
-        return strcmp(filename, volumePath) == 0 ? 1 : 0;
-
-    #else
-        if (stat(filename, &pathStat) != 0) {
-            pathlib_print_os_error("stat", filename);
-            pathlib_error = PATHLIB_OSERROR;
-            return 0;
+        cmp = pathlib__paths_key_cmp(key, key_size, target, target_size);
+        if (cmp >= 0) {
+            found = cmp == 0;
+            break;
         }
+    }
+    if (index) {
+        *index = (size_t)i;
+    }
+    
+    PATHLIB_FREE(key);
+    PATHLIB_FREE(target);
+    
+    return found;
+}
 
-        snprintf(parentPath, sizeof(parentPath), "%s/..", filename);
+PATHLIB_API void pathlib_paths_add(Paths* paths, const Path path) {
+    void* temp;
+    
+    PATHLIB_ASSERT(paths);
 
-        if (stat(parentPath, &parentStat) != 0) {
-            pathlib_print_os_error("stat", parentPath);
-            pathlib_error = PATHLIB_OSERROR;
-            return 0;
+    if (paths->size >= paths->capacity) {
+        paths->capacity = paths->capacity == 0 ? 4 : paths->capacity*2;
+        temp = pathlib__malloc(paths->capacity * sizeof(*paths->paths));
+        if (paths->size > 0) {
+            memcpy(temp, paths->paths, sizeof(*paths->paths)*paths->size);
         }
+        PATHLIB_FREE(paths->paths);
+        paths->paths = temp;
+    }
 
-        return (pathStat.st_dev != parentStat.st_dev) ? 1 : 0;
-    #endif
+    paths->paths[paths->size++] = path;
 }
 
-PATHLIB_API int pathlib_is_block_device(const Path* path) {
-    char filename[PATHLIB_MAX_PATH];
-    #ifdef _WIN32
-        HANDLE hFile;
-        DWORD bytesReturned;
-        STORAGE_PROPERTY_QUERY query;
-        BYTE buffer[512];
-        BOOL result;
-        STORAGE_DEVICE_DESCRIPTOR* descriptor;
-    #else
-        struct stat pathStat;
-    #endif
-
-    PATHLIB_ASSERT(path);
+PATHLIB_API void pathlib_paths_pop(Paths* paths, size_t i) {
+    PATHLIB_ASSERT(paths->size > i);
+    
+    if (paths->size == 0) {
+        return;
+    }
+    if (paths->size - 1 == i) {
+        paths->size--;
+        return;
+    }
 
-    pathlib_error = PATHLIB_NONE;
+    memmove(paths->paths + i, paths->paths + i + 1, sizeof(*paths->paths) * (paths->size - i));
+    paths->size--;
+}
 
-    if (!pathlib_exists(path)) {
-        return 0;
+PATHLIB_API void pathlib_paths_free(Paths* paths) {
+    if (paths->paths) {
+        PATHLIB_FREE(paths->paths);
+        paths->capacity = 0;
+        paths->size = 0;
+        paths->paths = NULL;
     }
+}
 
-    if (!pathlib_render_str_to_buffer(path, filename, PATHLIB_ARRSIZE(filename))) {
-        return 0;
+PATHLIB_API Paths pathlib_listdir(const Path* inpath) {
+    Paths paths;
+    char fullPath[PATHLIB_MAX_PATH];
+    Path path;
+    Path subpath;
+    size_t name_len, count;
+    const char* name;
+    #ifdef _WIN32
+        char searchPath[PATHLIB_MAX_PATH+3];
+        WIN32_FIND_DATA findFileData;
+        HANDLE hFind;
+        size_t searchPathSize;
+    #else /* _WIN32 */
+        DIR* dir;
+        struct dirent* entry;
+    #endif /* _WIN32 */
+        
+    paths.paths = NULL;
+    paths.size = 0;
+    paths.capacity = 0;
+    subpath.parts = NULL;
+    subpath.size = 0;
+    subpath.capacity = 0;
+    
+    pathlib_error = PATHLIB_NONE;
+    
+    if (!pathlib_exists(inpath)) {
+        return paths;
     }
-
+    
+    if (!pathlib_render_str_to_buffer(inpath, fullPath, sizeof(fullPath) / sizeof(*fullPath))) {
+        return paths;
+    }
+    
+    /* doing this because this function appends one extra item to the end of the input path
+    *  and this way it doesnt need to waste memory by doubling the capacity of the path */
+    path.parts = memcpy(pathlib__malloc(sizeof(*path.parts) * (inpath->capacity + 1)), inpath->parts, sizeof(*path.parts) * (inpath->capacity + 1));
+    path.size = inpath->size;
+    path.capacity = inpath->capacity + 1;
+    
+    /* TODO */
     #ifdef _WIN32
-        hFile = CreateFile(
-            filename,                           /* File path */
-            0,                                  /* No access to the file */
-            FILE_SHARE_READ | FILE_SHARE_WRITE, /* Allow shared access */
-            NULL,                               /* Default security attributes */
-            OPEN_EXISTING,                      /* Open the existing file */
-            FILE_ATTRIBUTE_NORMAL,              /* Normal attributes */
-            NULL                                /* No template file */
-        );
+        memcpy(searchPath, fullPath, PATHLIB_MAX_PATH);
 
-        if (hFile == INVALID_HANDLE_VALUE) {
-            pathlib_print_os_error("CreateFile", filename);
+        searchPathSize = strlen(searchPath);
+        searchPath[searchPathSize] = '\\';
+        searchPath[searchPathSize+1] = '*';
+        searchPath[searchPathSize+2] = '\0';
+
+        count = 0;
+        hFind = FindFirstFile(searchPath, &findFileData);
+        if (hFind == INVALID_HANDLE_VALUE) {
+            pathlib_print_os_error("FindFirstFile", searchPath);
             pathlib_error = PATHLIB_OSERROR;
-            return 0;
+            return paths;
         }
+        
+        do {
+            name = findFileData.cFileName;
+    
+            /* Skip "." and ".." entries */
+            if (strcmp(name, ".") == 0 || strcmp(name, "..") == 0) {
+                continue;
+            }
+            
+            count++;
+    
+        } while (FindNextFile(hFind, &findFileData) != 0);
+    
+        FindClose(hFind);
+        
+        paths.paths = pathlib__malloc(sizeof(*paths.paths)*count);
+        paths.capacity = count;
+        
+        hFind = FindFirstFile(searchPath, &findFileData);
+        if (hFind == INVALID_HANDLE_VALUE) {
+            pathlib_print_os_error("FindFirstFile", searchPath);
+            pathlib_error = PATHLIB_OSERROR;
+            return paths;
+        }
+    
+        do {
+            name = findFileData.cFileName;
+    
+            /* Skip "." and ".." entries */
+            if (strcmp(name, ".") == 0 || strcmp(name, "..") == 0) {
+                continue;
+            }
+            
+            name_len = strlen(name);
+            name = memcpy(pathlib__malloc(name_len + 1), name, name_len);
+            
+            subpath = pathlib_copy(&path);
+            pathlib_add_part(&subpath, name);
+            pathlib_paths_add(&paths, subpath);
+    
+        } while (FindNextFile(hFind, &findFileData) != 0);
+    
+        FindClose(hFind);
+        
+    #else /* _WIN32 */
+        count = 0;
+        dir = opendir(fullPath);
+        if (dir == NULL) {
+            pathlib_print_os_error("opendir", fullPath);
+            pathlib_error = PATHLIB_OSERROR;
+            return paths;
+        }
+    
+        while ((entry = readdir(dir)) != NULL) {
+            name = entry->d_name;
+    
+            if (strcmp(name, ".") == 0 || strcmp(name, "..") == 0) {
+                continue;
+            }
+            count++;
+        }
+    
+        closedir(dir);
+        
+        paths.paths = pathlib__malloc(sizeof(*paths.paths)*count);
+        paths.capacity = count;
+        
+        dir = opendir(fullPath);
+        if (dir == NULL) {
+            pathlib_print_os_error("opendir", fullPath);
+            pathlib_error = PATHLIB_OSERROR;
+            return paths;
+        }
+    
+        while ((entry = readdir(dir)) != NULL) {
+            name = entry->d_name;
+    
+            if (strcmp(name, ".") == 0 || strcmp(name, "..") == 0) {
+                continue;
+            }
+            
+            name_len = strlen(name);
+            name = memcpy(pathlib__malloc(name_len + 1), name, name_len);
+            
+            subpath = pathlib_copy(&path);
+            pathlib_add_part(&subpath, name);
+            pathlib_paths_add(&paths, subpath);
+        }
+    
+        closedir(dir);
+    #endif /* _WIN32 */
+    
+    pathlib_destroy(&path);
+        
+    return paths;
+}
 
-        query.PropertyId = StorageDeviceProperty;
-        query.QueryType = PropertyStandardQuery;
-
-        result = DeviceIoControl(
-            hFile,
-            IOCTL_STORAGE_QUERY_PROPERTY,
-            &query,
-            sizeof(query),
-            buffer,
-            sizeof(buffer),
-            &bytesReturned,
-            NULL
-        );
-
-        CloseHandle(hFile);
+/* a slightly stripped down version of fnmatch from musl C stdlib */
+/* BEGIN OF https://github.com/kraj/musl/blob/eb4309b142bb7a8bdc839ef1faf18811b9ff31c8/src/regex/fnmatch.c */
+#define END 0
+#define UNMATCHABLE -2
+#define BRACKET -3
+#define QUESTION -4
+#define STAR -5
+#define	FNM_NOMATCH 1
+#define FNM_NOSYS   (-1)
 
-        if (!result) {
-            pathlib_print_os_error("DeviceIoControl", filename);
-            pathlib_error = PATHLIB_OSERROR;
-            return 0;
-        }
+static wctype_t pathlib__wctype(const char *s) {
+   	int i;
+   	const char *p;
+   	/* order must match! */
+   	static const char names[] =
+  		"alnum\0" "alpha\0" "blank\0"
+  		"cntrl\0" "digit\0" "graph\0"
+  		"lower\0" "print\0" "punct\0"
+  		"space\0" "upper\0" "xdigit";
+   	for (i=1, p=names; *p; i++, p+=6)
+  		if (*s == *p && !strcmp(s, p))
+ 			return i;
+   	return 0;
+}
 
-        descriptor = (STORAGE_DEVICE_DESCRIPTOR*)buffer;
-        return (descriptor->BusType == BusTypeScsi || descriptor->BusType == BusTypeAta) ? 1 : 0;
-    #else
-        if (stat(filename, &pathStat) != 0) {
-            pathlib_print_os_error("stat", filename);
-            pathlib_error = PATHLIB_OSERROR;
-            return 0;
-        }
+static int pathlib__str_next(const char *str, size_t n, size_t *step) {
+   	if (!n) {
+  		*step = 0;
+  		return 0;
+   	}
+   	*step = 1;
+   	return str[0];
+}
 
-        return S_ISBLK(pathStat.st_mode) ? 1 : 0;
-    #endif
+static int pathlib__pat_next(const char *pat, size_t m, size_t *step) {
+   	if (!m || !*pat) {
+  		*step = 0;
+  		return END;
+   	}
+   	*step = 1;
+   	if (pat[0]=='\\' && pat[1]) {
+  		*step = 2;
+  		pat++;
+  		goto escaped;
+   	}
+   	if (pat[0]=='[') {
+  		size_t k = 1;
+  		if (k<m) if (pat[k] == '^' || pat[k] == '!') k++;
+  		if (k<m) if (pat[k] == ']') k++;
+  		for (; k<m && pat[k] && pat[k]!=']'; k++) {
+ 			if (k+1<m && pat[k+1] && pat[k]=='[' && (pat[k+1]==':' || pat[k+1]=='.' || pat[k+1]=='=')) {
+				int z = pat[k+1];
+				k+=2;
+				if (k<m && pat[k]) k++;
+				while (k<m && pat[k] && (pat[k-1]!=z || pat[k]!=']')) k++;
+				if (k==m || !pat[k]) break;
+ 			}
+  		}
+  		if (k==m || !pat[k]) {
+ 			*step = 1;
+ 			return '[';
+  		}
+  		*step = k+1;
+  		return BRACKET;
+   	}
+   	if (pat[0] == '*')
+  		return STAR;
+   	if (pat[0] == '?')
+  		return QUESTION;
+escaped:
+   	return pat[0];
 }
 
-PATHLIB_API int pathlib_is_char_device(const Path* path) {
-    char filename[PATHLIB_MAX_PATH];
-    #ifdef _WIN32
-        HANDLE hFile;
-        const char* knownDevices[] = {"CON", "PRN", "AUX", "NUL", "COM1", "COM2", "LPT1", NULL};
-        const char** device;
-    #else
-        struct stat pathStat;
-    #endif
+static int pathlib__match_bracket(const char *p, int k, int kfold) {
+   	wchar_t wc;
+   	int inv = 0;
+   	p++;
+   	if (*p=='^' || *p=='!') {
+  		inv = 1;
+  		p++;
+   	}
+   	if (*p==']') {
+  		if (k==']') return !inv;
+  		p++;
+   	} else if (*p=='-') {
+  		if (k=='-') return !inv;
+  		p++;
+   	}
+   	wc = p[-1];
+   	for (; *p != ']'; p++) {
+  		if (p[0]=='-' && p[1]!=']') {
+ 			wchar_t wc2;
+ 			int l = mbtowc(&wc2, p+1, 4);
+ 			if (l < 0) return 0;
+ 			if (wc <= wc2)
+				if ((unsigned)k-wc <= (unsigned)wc2-wc ||
+				(unsigned)kfold-wc <= (unsigned)wc2-wc)
+   					return !inv;
+ 			p += l-1;
+ 			continue;
+  		}
+  		if (p[0]=='[' && (p[1]==':' || p[1]=='.' || p[1]=='=')) {
+ 			const char *p0 = p+2;
+ 			int z = p[1];
+ 			p+=3;
+ 			while (p[-1]!=z || p[0]!=']') p++;
+ 			if (z == ':' && p-1-p0 < 16) {
+				char buf[16];
+				memcpy(buf, p0, p-1-p0);
+				buf[p-1-p0] = 0;
+				if (iswctype(k, pathlib__wctype(buf)) ||
+				    iswctype(kfold, pathlib__wctype(buf)))
+   					return !inv;
+ 			}
+ 			continue;
+  		}
+  		if ((unsigned char)*p < 128U) {
+ 			wc = (unsigned char)*p;
+  		} else {
+ 			int l = mbtowc(&wc, p, 4);
+ 			if (l < 0) return 0;
+ 			p += l-1;
+  		}
+  		if (wc==k || wc==kfold) return !inv;
+   	}
+   	return inv;
+}
 
-    PATHLIB_ASSERT(path);
+static int pathlib__fnmatch_internal(const char *pat, size_t m, const char *str, size_t n) {
+   	const char *p, *ptail, *endpat;
+   	const char *s, *stail, *endstr;
+   	size_t pinc, sinc, tailcnt=0;
+   	int c, k;
 
-    pathlib_error = PATHLIB_NONE;
-    
-    if (!pathlib_exists(path)) {
-        return 0;
-    }
+   	for (;;) {
+  		switch ((c = pathlib__pat_next(pat, m, &pinc))) {
+  		case UNMATCHABLE:
+ 			return FNM_NOMATCH;
+  		case STAR:
+ 			pat++;
+ 			m--;
+ 			break;
+  		default:
+ 			k = pathlib__str_next(str, n, &sinc);
+ 			if (k <= 0)
+				return (c==END) ? 0 : FNM_NOMATCH;
+ 			str += sinc;
+ 			n -= sinc;
+ 			if (c == BRACKET) {
+				if (!pathlib__match_bracket(pat, k, k))
+   					return FNM_NOMATCH;
+ 			} else if (c != QUESTION && k != c && k != c) {
+				return FNM_NOMATCH;
+ 			}
+ 			pat+=pinc;
+ 			m-=pinc;
+ 			continue;
+  		}
+  		break;
+   	}
 
-    if (!pathlib_render_str_to_buffer(path, filename, sizeof(filename) / sizeof(*filename))) {
-        return 0;
-    }
+   	/* Compute real pat length if it was initially unknown/-1 */
+   	m = strlen(pat);
+   	endpat = pat + m;
 
-    #ifdef _WIN32
-        hFile = CreateFile(
-            filename,
-            0,                                  /* No access to the file */
-            FILE_SHARE_READ | FILE_SHARE_WRITE, /* Allow shared access */
-            NULL,                               /* Default security attributes */
-            OPEN_EXISTING,                      /* Open the existing file */
-            FILE_ATTRIBUTE_NORMAL,              /* Normal attributes */
-            NULL                                /* No template file */
-        );
+   	/* Find the last * in pat and count chars needed after it */
+   	for (p=ptail=pat; p<endpat; p+=pinc) {
+  		switch (pathlib__pat_next(p, endpat-p, &pinc)) {
+  		case UNMATCHABLE:
+ 			return FNM_NOMATCH;
+  		case STAR:
+ 			tailcnt=0;
+ 			ptail = p+1;
+ 			break;
+  		default:
+ 			tailcnt++;
+ 			break;
+  		}
+   	}
 
-        if (hFile == INVALID_HANDLE_VALUE) {
-            for (device = knownDevices; *device; ++device) {
-                if (_stricmp(filename, *device) == 0) {
-                    return 1;
-                }
-            }
+   	/* Past this point we need not check for UNMATCHABLE in pat,
+  	 * because all of pat has already been parsed once. */
 
-            pathlib_print_os_error("CreateFile", filename);
-            pathlib_error = PATHLIB_OSERROR;
-            return 0;
-        }
+   	/* Compute real str length if it was initially unknown/-1 */
+   	n = strlen(str);
+   	endstr = str + n;
+   	if (n < tailcnt) return FNM_NOMATCH;
+
+   	/* Find the final tailcnt chars of str, accounting for UTF-8.
+  	 * On illegal sequences we may get it wrong, but in that case
+  	 * we necessarily have a matching failure anyway. */
+   	for (s=endstr; s>str && tailcnt; tailcnt--) {
+  		if ((unsigned char)s[-1] < 128U || MB_CUR_MAX==1) s--;
+  		else while ((unsigned char)*--s-0x80U<0x40 && s>str);
+   	}
+   	if (tailcnt) return FNM_NOMATCH;
+   	stail = s;
+
+   	/* Check that the pat and str tails match */
+   	p = ptail;
+   	for (;;) {
+  		c = pathlib__pat_next(p, endpat-p, &pinc);
+  		p += pinc;
+  		if ((k = pathlib__str_next(s, endstr-s, &sinc)) <= 0) {
+ 			if (c != END) return FNM_NOMATCH;
+ 			break;
+  		}
+  		s += sinc;
+  		if (c == BRACKET) {
+ 			if (!pathlib__match_bracket(p-pinc, k, k))
+				return FNM_NOMATCH;
+  		} else if (c != QUESTION && k != c && k != c) {
+ 			return FNM_NOMATCH;
+  		}
+   	}
 
-        CloseHandle(hFile);
-        return 1;
-    #else
-        if (stat(filename, &pathStat) != 0) {
-            pathlib_print_os_error("stat", filename);
-            pathlib_error = PATHLIB_OSERROR;
-            return 0;
-        }
+   	/* We're all done with the tails now, so throw them out */
+   	endstr = stail;
+   	endpat = ptail;
 
-        return S_ISCHR(pathStat.st_mode) ? 1 : 0;
-    #endif
+   	/* Match pattern components until there are none left */
+   	while (pat<endpat) {
+  		p = pat;
+  		s = str;
+  		for (;;) {
+ 			c = pathlib__pat_next(p, endpat-p, &pinc);
+ 			p += pinc;
+ 			/* Encountering * completes/commits a component */
+ 			if (c == STAR) {
+				pat = p;
+				str = s;
+				break;
+ 			}
+ 			k = pathlib__str_next(s, endstr-s, &sinc);
+ 			if (!k)
+				return FNM_NOMATCH;
+ 			if (c == BRACKET) {
+				if (!pathlib__match_bracket(p-pinc, k, k))
+   					break;
+ 			} else if (c != QUESTION && k != c && k != c) {
+				break;
+ 			}
+ 			s += sinc;
+  		}
+  		if (c == STAR) continue;
+  		/* If we failed, advance str, by 1 char if it's a valid
+ 		 * char, or past all invalid bytes otherwise. */
+  		k = pathlib__str_next(str, endstr-str, &sinc);
+  		if (k > 0) str += sinc;
+  		else for (str++; pathlib__str_next(str, endstr-str, &sinc)<0; str++);
+   	}
+
+   	return 0;
 }
 
-PATHLIB_API int pathlib_is_socket(const Path* path) {
-    #ifdef _WIN32
-        (void) path;
-        return 0;
-    #else
-        char filename[PATHLIB_MAX_PATH];
-        struct stat pathStat;
+int pathlib__fnmatch(const char *pat, const char *str) {
+   	return pathlib__fnmatch_internal(pat, -1, str, -1);
+}
 
-        PATHLIB_ASSERT(path);
-        
-        pathlib_error = PATHLIB_NONE;
+#undef END
+#undef UNMATCHABLE
+#undef BRACKET
+#undef QUESTION
+#undef STAR
+#undef FNM_NOMATCH
+#undef FNM_NOSYS
 
-        if (!pathlib_exists(path)) {
-            return 0;
-        }
+/* END OF https://github.com/kraj/musl/blob/eb4309b142bb7a8bdc839ef1faf18811b9ff31c8/src/regex/fnmatch.c */
 
-        if (!pathlib_render_str_to_buffer(path, filename, sizeof(filename) / sizeof(*filename))) {
+/* the options of a glob and what it remembers while it descends */
+typedef struct Pathlib__Glob {
+    const char* pattern;
+    int recursive;
+    int flags;                  /* Pathlib_Walk_Flags */
+    size_t min_depth;
+    size_t max_depth;           /* 0 for no limit */
+    pathlib_u64 root_dev;
+    Pathlib__Inode_Set visited; /* the directories from the root down to the current one when symlinks are followed */
+} Pathlib__Glob;
+
+/* matches the entries inside base_path which are at depth, the children of the root are at depth 1 */
+static int pathlib__recursive_glob(char* base_path, size_t depth, Pathlib__Glob* glob, Paths* results) {
+    char fullpath[PATHLIB_MAX_PATH];
+    int descend = glob->recursive && (glob->max_depth == 0 || depth < glob->max_depth);
+    
+    #if defined(_WIN32)
+        WIN32_FIND_DATA find_data;
+        HANDLE hFind;
+        char search_path[PATHLIB_MAX_PATH];
+    
+        if (snprintf(search_path, sizeof(search_path), "%s\\*", base_path) < 0) {
             return 0;
         }
-
-        if (stat(filename, &pathStat) != 0) {
-            pathlib_print_os_error("stat", filename);
+    
+        hFind = FindFirstFile(search_path, &find_data);
+        if (hFind == INVALID_HANDLE_VALUE) {
+            pathlib_print_os_error("FindFirstFile", search_path);
             pathlib_error = PATHLIB_OSERROR;
             return 0;
         }
-
-        return S_ISSOCK(pathStat.st_mode) ? 1 : 0;
-    #endif
-}
-
-PATHLIB_API int pathlib_is_fifo(const Path* path) {
-    char filename[PATHLIB_MAX_PATH];
-    #ifndef _WIN32
-        struct stat pathStat;
-    #endif
-
-    PATHLIB_ASSERT(path);
     
-    pathlib_error = PATHLIB_NONE;
-
-    if (!pathlib_exists(path)) {
-        return 0;
-    }
-
-    if (!pathlib_render_str_to_buffer(path, filename, sizeof(filename) / sizeof(*filename))) {
-        return 0;
-    }
+        do {
+            const char* name = find_data.cFileName;
+            
+            if (strcmp(name, ".") == 0 || strcmp(name, "..") == 0) {
+                continue;
+            }
+    
+            if (snprintf(fullpath, sizeof(fullpath), "%s\\%s", base_path, name) < 0) {
+                continue;
+            }
 
-    #ifdef _WIN32
-        /* TODO: not certain if this will ever be a string that is possible to be generated */
-        return strncmp(filename, "\\\\.\\pipe\\", 9) == 0;
-    #else
-        if (stat(filename, &pathStat) != 0) {
-            pathlib_print_os_error("stat", filename);
+            if (find_data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+                /* there are no inode numbers to detect loops so junctions and directory symlinks are only entered when they are followed */
+                if (descend && ((glob->flags & PATHLIB_WALK_FOLLOW_SYMLINKS) || !(find_data.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT))) {
+                    if (!pathlib__recursive_glob(fullpath, depth + 1, glob, results)) {
+                        FindClose(hFind);
+                        return 0;
+                    }
+                }
+                continue;
+            }
+    
+            if (depth >= glob->min_depth && pathlib__fnmatch(glob->pattern, name) == 0) {
+                pathlib_paths_add(results, pathlib_from_str(fullpath));
+            }
+    
+        } while (FindNextFile(hFind, &find_data) != 0);
+    
+        FindClose(hFind);
+    #else /* _WIN32 */
+        DIR* dir;
+        struct dirent* entry;
+        struct stat path_stat;
+        int status;
+    
+        dir = opendir(base_path);
+        if (dir == NULL) {
+            pathlib_print_os_error("opendir", base_path);
             pathlib_error = PATHLIB_OSERROR;
             return 0;
         }
-
-        return S_ISFIFO(pathStat.st_mode) ? 1 : 0;
-    #endif
-}
-
-PATHLIB_API int pathlib_is_absolute(const Path* path) {
-    #ifdef _WIN32
-        if (path->size == 0) {
-            return 0;
-        }
-        if (strlen(path->parts[0]) != 2) {
-            return 0;
-        }
-        /* Check for drive letter followed by ':' and '\' (implicit), e.g., "C:\" */
-        if (isalpha(path->parts[0][0]) && path->parts[0][1] == ':') {
-            return 1;
-        }
-        /* Check for UNC paths starting with "\\" */
-        if (path->parts[0][0] == '\\' && path->parts[0][1] == '\\') {
-            return 1;
-        }
-    #else
-        size_t i;
-        for (i = 0; i < path->size; i++) {
-            if (path->parts[i][0] == '/') {
-                return 1;
+    
+        while ((entry = readdir(dir)) != NULL) {
+            if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
+                continue;
+            }
+    
+            if (snprintf(fullpath, sizeof(fullpath), "%s/%s", base_path, entry->d_name) < 0) {
+                continue;
+            }
+    
+            status = glob->flags & PATHLIB_WALK_FOLLOW_SYMLINKS ? stat(fullpath, &path_stat) : lstat(fullpath, &path_stat);
+            if (status != 0) {
+                continue;
+            }
+    
+            if (S_ISDIR(path_stat.st_mode)) {
+                if (!descend) {
+                    continue;
+                }
+                if ((glob->flags & PATHLIB_WALK_ONE_FILESYSTEM) && (pathlib_u64)path_stat.st_dev != glob->root_dev) {
+                    continue;
+                }
+                /* a directory that is one of its own ancestors is a symlink loop, like `find -L` a second link elsewhere is still walked */
+                if ((glob->flags & PATHLIB_WALK_FOLLOW_SYMLINKS) && !pathlib__inode_set_add(&glob->visited, path_stat.st_dev, path_stat.st_ino)) {
+                    continue;
+                }
+                if (!pathlib__recursive_glob(fullpath, depth + 1, glob, results)) {
+                    closedir(dir);
+                    return 0;
+                }
+                if (glob->flags & PATHLIB_WALK_FOLLOW_SYMLINKS) {
+                    pathlib__inode_set_remove(&glob->visited, path_stat.st_dev, path_stat.st_ino);
+                }
+                continue;
+            }
+    
+            if (depth >= glob->min_depth && pathlib__fnmatch(glob->pattern, entry->d_name) == 0) {
+                pathlib_paths_add(results, pathlib_from_str(fullpath));
             }
         }
-    #endif
-    return 0;
-}
-
-PATHLIB_API int pathlib_is_relative(const Path* path, const Path* other) {
-    size_t i;
-
-    if (path->size > other->size) {
-        return 0;
-    }
-
-    for (i = 0; i < path->size; i++) {
-        if (strcmp(path->parts[i], other->parts[i]) != 0) {
-            return 0;
-        }
-    }
+    
+        closedir(dir);
+    #endif /*_WIN32 */
 
     return 1;
 }
 
-PATHLIB_API int pathlib_mkdir(const Path* path) {
-    char filename[PATHLIB_MAX_PATH];
-    size_t i;
+/* globs inside path, flags and the depths are the Pathlib_Walk_Options */
+static Paths pathlib__glob(const Path* path, const char* pattern, int recursive, int flags, size_t min_depth, size_t max_depth) {
+    char fullpath[PATHLIB_MAX_PATH];
+    Pathlib__Glob glob;
+    Paths results;
+    #ifndef _WIN32
+        struct stat root_stat;
+    #endif
+    results.paths = NULL;
+    results.size = 0;
+    results.capacity = 0;
     
     pathlib_error = PATHLIB_NONE;
     
-    if (path->size == 0) return 1;
-    if (pathlib_exists(path) && pathlib_is_dir(path)) return 1;
-
-    for (i = 1; i <= path->size; i++) {
-        if (!pathlib__render_n_parts_to_buffer(path, filename, sizeof(filename) / sizeof(*filename), i)) {
-            return 0;
-        }
-        #ifdef _WIN32
-            if (CreateDirectory(filename, NULL) || GetLastError() == ERROR_ALREADY_EXISTS) {
-                if (i == path->size) {
-                    pathlib_error = PATHLIB_EXISTS;
-                }
-                errno = EEXIST;
-            } else {
-                pathlib_print_os_error("CreateDirectory", filename);
-                pathlib_error = PATHLIB_OSERROR;
-                return 0;
-            }
-        #else /* _WIN32 */
-            if (mkdir(filename, 0755) < 0) {
-                if (errno == EEXIST) {
-                    if (i == path->size) {
-                        pathlib_error = PATHLIB_EXISTS;
-                    }
-                }
-                pathlib_print_os_error("mkdir", filename);
-                pathlib_error = PATHLIB_OSERROR;
-                return 0;
-            }
-        #endif /* _WIN32 */
+    if (!pathlib_is_dir(path)) {
+        pathlib_error = PATHLIB_NEXISTS;
+        return results;
+    }
+    
+    if (!pathlib_render_str_to_buffer(path, fullpath, PATHLIB_ARRSIZE(fullpath))) {
+        pathlib_error = PATHLIB_NEXISTS;
+        return results;
+    }
+    
+    glob.pattern = pattern;
+    glob.recursive = recursive;
+    glob.flags = flags;
+    glob.min_depth = min_depth;
+    glob.max_depth = max_depth;
+    glob.root_dev = 0;
+    memset(&glob.visited, 0, sizeof(glob.visited));
+    #ifndef _WIN32
+        /* the root is followed like pathlib_is_dir did */
+        if (stat(fullpath, &root_stat) == 0) {
+            glob.root_dev = root_stat.st_dev;
+            pathlib__inode_set_add(&glob.visited, root_stat.st_dev, root_stat.st_ino);
+        }
+    #endif
+    
+    if (!pathlib__recursive_glob(fullpath, 1, &glob, &results)) {
+        pathlib_paths_free(&results);
     }
+    pathlib__inode_set_free(&glob.visited);
 
-    return 1;
+    return results;
 }
 
-PATHLIB_API int pathlib_touch(const Path* path) {
-    #ifdef _WIN32
-        HANDLE hFile;
-    #else
-        int fd;
-    #endif
-    char filename[PATHLIB_MAX_PATH];
-    Path subpath;
+PATHLIB_API Paths pathlib_glob(const Path* path, const char* pattern) {
+    PATHLIB_ASSERT(path);
+    PATHLIB_ASSERT(pattern);
     
-    pathlib_error = PATHLIB_NONE;
+    return pathlib__glob(path, pattern, 0, PATHLIB_WALK_FOLLOW_SYMLINKS, 0, 0);
+}
+
+PATHLIB_API Paths pathlib_rglob(const Path* path, const char* pattern) {
+    PATHLIB_ASSERT(path);
+    PATHLIB_ASSERT(pattern);
     
-    if (path->size == 0) return 1;
-    if (path->size > 1) {
-        subpath.parts = path->parts;
-        subpath.size = path->size - 1;
-        subpath.capacity = path->capacity;
-        if (!pathlib_mkdir(&subpath)) {
-            return 0;
+    return pathlib__glob(path, pattern, 1, PATHLIB_WALK_FOLLOW_SYMLINKS, 0, 0);
+}
+
+PATHLIB_API Paths pathlib_rglob_ex(const Path* path, const char* pattern, const Pathlib_Walk_Options* options) {
+    PATHLIB_ASSERT(path);
+    PATHLIB_ASSERT(pattern);
+    PATHLIB_ASSERT(options);
+    
+    return pathlib__glob(path, pattern, 1, options->flags, options->min_depth, options->max_depth);
+}
+
+/* the state of a walk, the fields describe the entry that the callback is called for */
+typedef struct Pathlib__Walk {
+    char path[PATHLIB_MAX_PATH];
+    size_t path_size;
+    size_t name_offset; /* where the name of the entry starts inside path */
+    size_t depth;       /* the root is at depth 0 */
+    int type;           /* a Pathlib_Entry_Type or -1 when it is not known without a stat */
+    int has_stat;       /* 1 when st is valid and -1 when the stat failed */
+    Pathlib__Stat st;
+    int failed;
+} Pathlib__Walk;
+
+/* returns 1 to descend into the entry when it is a directory */
+typedef int (*Pathlib__Walk_Func)(Pathlib__Walk* walk, void* ctx);
+
+/* stats the current entry the first time that a field of it is needed */
+static int pathlib__walk_stat(Pathlib__Walk* walk) {
+    if (walk->has_stat == 0) {
+        if (pathlib__stat_str(walk->path, 0, &walk->st)) {
+            walk->has_stat = 1;
+            walk->type = walk->st.type;
+        } else {
+            walk->has_stat = -1;
         }
     }
+    
+    return walk->has_stat == 1;
+}
 
-    if (pathlib_exists(path) && pathlib_is_file(path)) {
-        pathlib_error = PATHLIB_EXISTS;
-        return 1;
+static int pathlib__walk_type(Pathlib__Walk* walk) {
+    if (walk->type < 0 && !pathlib__walk_stat(walk)) {
+        return -1;
     }
     
-    if (!pathlib_render_str_to_buffer(path, filename, PATHLIB_ARRSIZE(filename))) {
-        return 0;
-    }
+    return walk->type;
+}
 
+/* calls func for every entry inside the directory walk->path and descends where func wants to */
+static void pathlib__walk_dir(Pathlib__Walk* walk, Pathlib__Walk_Func func, void* ctx) {
+    size_t dirname_size, name_size, name_offset, separator;
+    const char* name;
     #ifdef _WIN32
-        hFile = CreateFile(
-            filename,              /* File name */
-            GENERIC_WRITE,         /* Desired access */
-            0,                     /* Share mode (no sharing) */
-            NULL,                  /* Security attributes */
-            CREATE_NEW,            /* Creation disposition (create a new file) */
-            FILE_ATTRIBUTE_NORMAL, /* File attributes */
-            NULL                   /* Template file */
-        );
-
-        if (hFile == INVALID_HANDLE_VALUE) {
-            pathlib_print_os_error("CreateFile", filename);
-            pathlib_error = PATHLIB_OSERROR;
-            return 0;
+        char search_path[PATHLIB_MAX_PATH + 3];
+        WIN32_FIND_DATA find_data;
+        HANDLE hFind;
+        pathlib_u64 ticks;
+    #else
+        DIR* dir;
+        struct dirent* entry;
+    #endif
+    
+    dirname_size = walk->path_size;
+    name_offset = walk->name_offset;
+    /* a root like "/" or "C:\" already ends with a separator */
+    separator = dirname_size > 0 && (walk->path[dirname_size - 1] == '/' || walk->path[dirname_size - 1] == '\\') ? 0 : 1;
+    
+    #ifdef _WIN32
+        if (snprintf(search_path, sizeof(search_path), "%s%s*", walk->path, separator ? "\\" : "") < 0) {
+            return;
         }
-        CloseHandle(hFile);
-        return 1;
+        hFind = FindFirstFile(search_path, &find_data);
+        if (hFind == INVALID_HANDLE_VALUE) {
+            pathlib_print_os_error("FindFirstFile", search_path);
+            walk->failed = 1;
+            return;
+        }
+        do {
+            name = find_data.cFileName;
     #else
-        fd = open(filename, O_CREAT | O_WRONLY, S_IRUSR | S_IWUSR);
-
-        if (fd == -1) {
-            pathlib_print_os_error("open", filename);
-            pathlib_error = PATHLIB_OSERROR;
-            return 0;
+        dir = opendir(walk->path);
+        if (dir == NULL) {
+            pathlib_print_os_error("opendir", walk->path);
+            walk->failed = 1;
+            return;
         }
-
-        close(fd);
-        return 1;
+        while ((entry = readdir(dir)) != NULL) {
+            name = entry->d_name;
+    #endif
+            if (strcmp(name, ".") == 0 || strcmp(name, "..") == 0) {
+                continue;
+            }
+            
+            name_size = strlen(name);
+            if (dirname_size + separator + name_size + 1 > sizeof(walk->path)) {
+                pathlib_print_error("path too long inside `%s`", walk->path);
+                walk->failed = 1;
+                continue;
+            }
+            if (separator) {
+                walk->path[dirname_size] = '/';
+            }
+            memcpy(walk->path + dirname_size + separator, name, name_size + 1);
+            walk->path_size = dirname_size + separator + name_size;
+            walk->name_offset = dirname_size + separator;
+            walk->depth++;
+            walk->type = -1;
+            walk->has_stat = 0;
+            
+            #ifdef _WIN32
+                /* FindNextFile already returns everything that a stat would */
+                memset(&walk->st, 0, sizeof(walk->st));
+                ticks = ((pathlib_u64)find_data.ftLastWriteTime.dwHighDateTime << 32) | find_data.ftLastWriteTime.dwLowDateTime;
+                ticks -= PATHLIB__U64(0x019DB1DEUL, 0xD53E8000UL);
+                walk->st.mtime_sec = ticks / 10000000;
+                walk->st.mtime_nsec = (ticks % 10000000) * 100;
+                walk->st.size = ((pathlib_u64)find_data.nFileSizeHigh << 32) | find_data.nFileSizeLow;
+                walk->st.allocated = walk->st.size;
+                walk->st.nlink = 1;
+                if (find_data.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) {
+                    walk->st.type = PATHLIB_ENTRY_SYMLINK;
+                    walk->st.mode = 0120777;
+                } else if (find_data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+                    walk->st.type = PATHLIB_ENTRY_DIR;
+                    walk->st.mode = 0040755;
+                } else {
+                    walk->st.type = PATHLIB_ENTRY_FILE;
+                    walk->st.mode = (find_data.dwFileAttributes & FILE_ATTRIBUTE_READONLY) ? 0100444 : 0100644;
+                }
+                walk->type = walk->st.type;
+                walk->has_stat = 1;
+            #elif defined(DT_UNKNOWN)
+                /* most filesystems give the type for free so only the entries that need more are stat'ed */
+                switch (entry->d_type) {
+                    case DT_REG: walk->type = PATHLIB_ENTRY_FILE; break;
+                    case DT_DIR: walk->type = PATHLIB_ENTRY_DIR; break;
+                    case DT_LNK: walk->type = PATHLIB_ENTRY_SYMLINK; break;
+                    case DT_UNKNOWN: walk->type = -1; break;
+                    default: walk->type = PATHLIB_ENTRY_OTHER; break;
+                }
+            #endif
+            
+            if (func(walk, ctx) && pathlib__walk_type(walk) == PATHLIB_ENTRY_DIR) {
+                pathlib__walk_dir(walk, func, ctx);
+            }
+            
+            walk->depth--;
+    #ifdef _WIN32
+        } while (FindNextFile(hFind, &find_data) != 0);
+        FindClose(hFind);
+    #else
+        }
+        closedir(dir);
     #endif
+    
+    walk->path[dirname_size] = 0;
+    walk->path_size = dirname_size;
+    walk->name_offset = name_offset;
 }
 
-PATHLIB_API Path pathlib_joinpath(const Path* path, const Path* other) {
-    size_t i;
-    Path ret;
-
-    ret.parts = NULL;
-    ret.size = 0;
-    ret.capacity = 0;
-
-    for (i = 0; i < path->size; i++) {
-        pathlib_add_part(&ret, path->parts[i]);
+/* walks the tree under root, the root itself is the first entry, returns 0 if the root doesnt exist */
+static int pathlib__walk(Pathlib__Walk* walk, const Path* root, Pathlib__Walk_Func func, void* ctx) {
+    char* slash;
+    
+    walk->failed = 0;
+    walk->depth = 0;
+    
+    if (!pathlib_render_str_to_buffer(root, walk->path, PATHLIB_ARRSIZE(walk->path))) {
+        return 0;
     }
-
-    for (i = 0; i < other->size; i++) {
-        pathlib_add_part(&ret, other->parts[i]);
+    walk->path_size = strlen(walk->path);
+    /* a trailing separator is dropped except for a root like "/" or "C:\", pathlib__walk_dir doesnt add another one to those */
+    if (walk->path_size > 1 && (walk->path[walk->path_size - 1] == '/' || walk->path[walk->path_size - 1] == '\\') &&
+        walk->path[walk->path_size - 2] != ':') {
+        walk->path[--walk->path_size] = 0;
     }
-
-    return ret;
+    slash = strrchr(walk->path, '/');
+    walk->name_offset = slash ? (size_t)(slash - walk->path) + 1 : 0;
+    
+    /* the root is followed when it is a symlink */
+    if (!pathlib__stat_str(walk->path, 1, &walk->st)) {
+        return 0;
+    }
+    walk->has_stat = 1;
+    walk->type = walk->st.type;
+    
+    if (func(walk, ctx) && walk->type == PATHLIB_ENTRY_DIR) {
+        pathlib__walk_dir(walk, func, ctx);
+    }
+    
+    return 1;
 }
 
-PATHLIB_API const char* pathlib_name(const Path* path) {
-    PATHLIB_ASSERT(path);
-
-    if (path->size == 0) {
-        return "";
-    }
+typedef enum Pathlib__Query_Kind {
+    PATHLIB__QUERY_NAME,
+    PATHLIB__QUERY_DEPTH,
+    PATHLIB__QUERY_TYPE,
+    PATHLIB__QUERY_SIZE,
+    PATHLIB__QUERY_MTIME,
+    PATHLIB__QUERY_PERM,
+    PATHLIB__QUERY_OWNER,
+    PATHLIB__QUERY_AND,
+    PATHLIB__QUERY_OR,
+    PATHLIB__QUERY_NOT
+} Pathlib__Query_Kind;
+
+struct Pathlib_Query {
+    Pathlib__Query_Kind kind;
+    int cost; /* 0 for the name and the depth, 1 when readdir may give it, 2 when it needs a stat */
+    char* pattern;
+    pathlib_u64 min;
+    pathlib_u64 max;
+    Pathlib_Query* left;
+    Pathlib_Query* right;
+};
+
+static Pathlib_Query* pathlib__query_new(Pathlib__Query_Kind kind, int cost, pathlib_u64 min, pathlib_u64 max) {
+    Pathlib_Query* query;
+    
+    query = pathlib__malloc(sizeof(*query));
+    query->kind = kind;
+    query->cost = cost;
+    query->pattern = NULL;
+    query->min = min;
+    query->max = max;
+    query->left = NULL;
+    query->right = NULL;
+    
+    return query;
+}
 
-    return path->parts[path->size - 1];
+PATHLIB_API Pathlib_Query* pathlib_query_name(const char* pattern) {
+    Pathlib_Query* query;
+    
+    PATHLIB_ASSERT(pattern);
+    
+    query = pathlib__query_new(PATHLIB__QUERY_NAME, 0, 0, 0);
+    query->pattern = memcpy(pathlib__malloc(strlen(pattern) + 1), pattern, strlen(pattern) + 1);
+    
+    return query;
 }
 
-PATHLIB_API Path pathlib_copy(const Path* path) {
-    Path ret;
+PATHLIB_API Pathlib_Query* pathlib_query_depth(size_t min, size_t max) {
+    return pathlib__query_new(PATHLIB__QUERY_DEPTH, 0, min, max);
+}
 
-    ret.parts = pathlib__malloc(path->capacity * sizeof(*path->parts));
+PATHLIB_API Pathlib_Query* pathlib_query_type(int type) {
+    return pathlib__query_new(PATHLIB__QUERY_TYPE, 1, type, type);
+}
 
-    memcpy(ret.parts, path->parts, path->size * sizeof(*path->parts));
-    ret.size = path->size;
-    ret.capacity = path->capacity;
+PATHLIB_API Pathlib_Query* pathlib_query_size(pathlib_u64 min, pathlib_u64 max) {
+    return pathlib__query_new(PATHLIB__QUERY_SIZE, 2, min, max);
+}
 
-    return ret;
+PATHLIB_API Pathlib_Query* pathlib_query_mtime(pathlib_u64 min, pathlib_u64 max) {
+    return pathlib__query_new(PATHLIB__QUERY_MTIME, 2, min, max);
 }
 
-PATHLIB_API FILE* pathlib_open(const Path* path, const char* mode) {
-    char filename[PATHLIB_MAX_PATH];
+PATHLIB_API Pathlib_Query* pathlib_query_perm(unsigned int mask, unsigned int bits) {
+    return pathlib__query_new(PATHLIB__QUERY_PERM, 2, mask, bits);
+}
 
-    PATHLIB_ASSERT(path);
-    PATHLIB_ASSERT(path);
+PATHLIB_API Pathlib_Query* pathlib_query_owner(unsigned long uid) {
+    return pathlib__query_new(PATHLIB__QUERY_OWNER, 2, uid, uid);
+}
 
-    if (!pathlib_render_str_to_buffer(path, filename, sizeof(filename) / sizeof(*filename))) {
-        return NULL;
-    }
+static Pathlib_Query* pathlib__query_combine(Pathlib__Query_Kind kind, Pathlib_Query* left, Pathlib_Query* right) {
+    Pathlib_Query* query;
+    
+    PATHLIB_ASSERT(left);
+    PATHLIB_ASSERT(right);
+    
+    query = pathlib__query_new(kind, left->cost > right->cost ? left->cost : right->cost, 0, 0);
+    /* the cheaper side is evaluated first so it can skip the stat */
+    query->left = left->cost <= right->cost ? left : right;
+    query->right = left->cost <= right->cost ? right : left;
+    
+    return query;
+}
 
-    if (!pathlib_exists(path)) {
-        if (!pathlib_touch(path)) {
-            return NULL;
-        }
-    }
+PATHLIB_API Pathlib_Query* pathlib_query_and(Pathlib_Query* left, Pathlib_Query* right) {
+    return pathlib__query_combine(PATHLIB__QUERY_AND, left, right);
+}
 
-    return fopen(filename, mode);
+PATHLIB_API Pathlib_Query* pathlib_query_or(Pathlib_Query* left, Pathlib_Query* right) {
+    return pathlib__query_combine(PATHLIB__QUERY_OR, left, right);
 }
 
-PATHLIB_API char* pathlib_read_text(const Path* path) {
-    FILE* f;
-    long int file_size;
-    char* buff;
-    
-    if (!pathlib_exists(path)) {
-        return NULL;
-    }
+PATHLIB_API Pathlib_Query* pathlib_query_not(Pathlib_Query* query) {
+    Pathlib_Query* not_query;
     
-    f = pathlib_open(path, "r");
+    PATHLIB_ASSERT(query);
     
-    if (f == NULL) {
-        return NULL;
-    }
-    if (fseek(f, 0, SEEK_END) < 0) {
-        return NULL;
-    }
-    file_size = ftell(f);
-    if (file_size < 0) {
-        return NULL;
-    }
-    if (fseek(f, 0, SEEK_SET) < 0) {
-        return NULL;
-    }
+    not_query = pathlib__query_new(PATHLIB__QUERY_NOT, query->cost, 0, 0);
+    not_query->left = query;
     
-    buff = pathlib__malloc(file_size + 1);
-    buff[file_size] = 0;
-    fread(buff, file_size, 1, f);
+    return not_query;
+}
 
-    if (ferror(f)) {
-        fclose(f);
-        PATHLIB_FREE(buff);
-        return NULL;
+PATHLIB_API void pathlib_query_free(Pathlib_Query* query) {
+    if (query) {
+        pathlib_query_free(query->left);
+        pathlib_query_free(query->right);
+        PATHLIB_FREE(query->pattern);
+        PATHLIB_FREE(query);
     }
-    fclose(f);
-    
-    return buff;
 }
 
-PATHLIB_API unsigned char* pathlib_read_bytes(const Path* path, size_t* byte_count) {
-    FILE* f;
-    long int file_size;
-    unsigned char* buff;
-    
-    if (!pathlib_exists(path)) {
-        return NULL;
+static int pathlib__query_match(const Pathlib_Query* query, Pathlib__Walk* walk) {
+    switch (query->kind) {
+        case PATHLIB__QUERY_NAME:
+            return pathlib__fnmatch(query->pattern, walk->path + walk->name_offset) == 0;
+        case PATHLIB__QUERY_DEPTH:
+            return walk->depth >= query->min && walk->depth <= query->max;
+        case PATHLIB__QUERY_TYPE:
+            return pathlib__walk_type(walk) == (int)query->min;
+        case PATHLIB__QUERY_SIZE:
+            return pathlib__walk_stat(walk) && walk->st.size >= query->min && walk->st.size <= query->max;
+        case PATHLIB__QUERY_MTIME:
+            return pathlib__walk_stat(walk) && walk->st.mtime_sec >= query->min && walk->st.mtime_sec <= query->max;
+        case PATHLIB__QUERY_PERM:
+            return pathlib__walk_stat(walk) && (walk->st.mode & query->min) == query->max;
+        case PATHLIB__QUERY_OWNER:
+            return pathlib__walk_stat(walk) && walk->st.uid == query->min;
+        case PATHLIB__QUERY_AND:
+            return pathlib__query_match(query->left, walk) && pathlib__query_match(query->right, walk);
+        case PATHLIB__QUERY_OR:
+            return pathlib__query_match(query->left, walk) || pathlib__query_match(query->right, walk);
+        case PATHLIB__QUERY_NOT:
+            return !pathlib__query_match(query->left, walk);
     }
     
-    f = pathlib_open(path, "rb");
+    return 0;
+}
+
+/* the deepest depth that query can match, nothing below it has to be listed */
+static pathlib_u64 pathlib__query_max_depth(const Pathlib_Query* query) {
+    pathlib_u64 left, right;
     
-    if (f == NULL) {
-        return NULL;
-    }
-    if (fseek(f, 0, SEEK_END) < 0) {
-        return NULL;
-    }
-    file_size = ftell(f);
-    if (file_size < 0) {
-        return NULL;
-    }
-    if (fseek(f, 0, SEEK_SET) < 0) {
-        return NULL;
+    switch (query->kind) {
+        case PATHLIB__QUERY_DEPTH:
+            return query->max;
+        case PATHLIB__QUERY_AND:
+            left = pathlib__query_max_depth(query->left);
+            right = pathlib__query_max_depth(query->right);
+            return left < right ? left : right;
+        case PATHLIB__QUERY_OR:
+            left = pathlib__query_max_depth(query->left);
+            right = pathlib__query_max_depth(query->right);
+            return left > right ? left : right;
+        default:
+            return (pathlib_u64)-1;
     }
-    
-    buff = pathlib__malloc(file_size + 1);
-    buff[file_size] = 0;
-    fread(buff, file_size, 1, f);
+}
 
-    if (ferror(f)) {
-        fclose(f);
-        PATHLIB_FREE(buff);
-        return NULL;
+typedef struct Pathlib__Find {
+    const Pathlib_Query* query;
+    pathlib_u64 max_depth;
+    Paths* results;
+} Pathlib__Find;
+
+static int pathlib__find_visit(Pathlib__Walk* walk, void* ctx) {
+    Pathlib__Find* find = ctx;
+    
+    if (pathlib__query_match(find->query, walk)) {
+        pathlib_paths_add(find->results, pathlib_from_str(walk->path));
     }
-    fclose(f);
     
-    *byte_count = file_size;
-    return buff;
+    return walk->depth < find->max_depth;
 }
- 
-PATHLIB_API int pathlib_write_text(const Path* path, const char* text, size_t text_size) {
-    FILE* f;
-    size_t n;
+
+PATHLIB_API Paths pathlib_find(const Path* root, const Pathlib_Query* query) {
+    Pathlib__Walk* walk;
+    Pathlib__Find find;
+    Paths results;
     
-    if (!pathlib_exists(path)) {
-        if (!pathlib_touch(path)) {
-            return 0;
-        }
-    }
+    PATHLIB_ASSERT(root);
+    PATHLIB_ASSERT(query);
     
-    f = pathlib_open(path, "w");
+    pathlib_error = PATHLIB_NONE;
     
-    if (f == NULL) {
-        return 0;
-    }
+    results.paths = NULL;
+    results.size = 0;
+    results.capacity = 0;
     
-    while (text_size > 0) {
-        n = fwrite(text, 1, text_size, f);
-        if (ferror(f)) {
-            fclose(f);
-            return 0;
-        }
-        text_size -= n;
-        text  += n;
-    }
+    find.query = query;
+    find.max_depth = pathlib__query_max_depth(query);
+    find.results = &results;
     
-    fclose(f);
+    walk = pathlib__malloc(sizeof(*walk));
+    if (!pathlib__walk(walk, root, pathlib__find_visit, &find)) {
+        pathlib_error = PATHLIB_NEXISTS;
+    } else if (walk->failed) {
+        pathlib_error = PATHLIB_OSERROR;
+    }
+    PATHLIB_FREE(walk);
     
-    return 1;
+    return results;
 }
 
-PATHLIB_API int pathlib_write_bytes(const Path* path, const unsigned char* buff, size_t buff_size) {
-    FILE* f;
-    size_t n;
+typedef struct Pathlib__Top_Entry {
+    pathlib_u64 key;
+    char* path;
+} Pathlib__Top_Entry;
+
+typedef struct Pathlib__Aggregate {
+    const Pathlib_Query* query;
+    pathlib_u64 max_depth;
+    int flags;
+    Pathlib_Aggregate* result;
+    Pathlib__Top_Entry* heap; /* a min heap so the smallest of the top k is at the root */
+    size_t heap_size;
+    size_t k;
+} Pathlib__Aggregate;
+
+static void pathlib__top_sift_down(Pathlib__Top_Entry* heap, size_t size, size_t i) {
+    Pathlib__Top_Entry temp;
+    size_t smallest, child;
     
-    if (!pathlib_exists(path)) {
-        if (!pathlib_touch(path)) {
-            return 0;
+    for (;;) {
+        smallest = i;
+        child = 2 * i + 1;
+        if (child < size && heap[child].key < heap[smallest].key) {
+            smallest = child;
         }
+        if (child + 1 < size && heap[child + 1].key < heap[smallest].key) {
+            smallest = child + 1;
+        }
+        if (smallest == i) {
+            return;
+        }
+        temp = heap[i];
+        heap[i] = heap[smallest];
+        heap[smallest] = temp;
+        i = smallest;
     }
+}
+
+static void pathlib__top_push(Pathlib__Aggregate* aggregate, pathlib_u64 key, const char* path, size_t path_size) {
+    Pathlib__Top_Entry temp;
+    size_t i;
     
-    f = pathlib_open(path, "wb");
-    
-    if (f == NULL) {
-        return 0;
+    if (aggregate->heap_size < aggregate->k) {
+        i = aggregate->heap_size++;
+        aggregate->heap[i].key = key;
+        aggregate->heap[i].path = memcpy(pathlib__malloc(path_size + 1), path, path_size + 1);
+        /* sift up */
+        while (i > 0 && aggregate->heap[(i - 1) / 2].key > aggregate->heap[i].key) {
+            temp = aggregate->heap[i];
+            aggregate->heap[i] = aggregate->heap[(i - 1) / 2];
+            aggregate->heap[(i - 1) / 2] = temp;
+            i = (i - 1) / 2;
+        }
+    } else if (key > aggregate->heap[0].key) {
+        PATHLIB_FREE(aggregate->heap[0].path);
+        aggregate->heap[0].key = key;
+        aggregate->heap[0].path = memcpy(pathlib__malloc(path_size + 1), path, path_size + 1);
+        pathlib__top_sift_down(aggregate->heap, aggregate->heap_size, 0);
     }
+}
+
+static int pathlib__aggregate_visit(Pathlib__Walk* walk, void* ctx) {
+    Pathlib__Aggregate* aggregate = ctx;
     
-    while (buff_size > 0) {
-        n = fwrite(buff, 1, buff_size, f);
-        if (ferror(f)) {
-            fclose(f);
-            return 0;
+    if (aggregate->query == NULL || pathlib__query_match(aggregate->query, walk)) {
+        aggregate->result->count++;
+        
+        /* only the modes that need the size or the mtime stat the entry */
+        if ((aggregate->flags & (PATHLIB_AGGREGATE_TOTAL_SIZE | PATHLIB_AGGREGATE_TOP_SIZE | PATHLIB_AGGREGATE_TOP_MTIME)) &&
+            pathlib__walk_stat(walk)) {
+            aggregate->result->total_size += walk->st.size;
+            if (aggregate->k > 0 && (aggregate->flags & PATHLIB_AGGREGATE_TOP_SIZE)) {
+                pathlib__top_push(aggregate, walk->st.size, walk->path, walk->path_size);
+            } else if (aggregate->k > 0 && (aggregate->flags & PATHLIB_AGGREGATE_TOP_MTIME)) {
+                pathlib__top_push(aggregate, walk->st.mtime_sec * 1000000000 + walk->st.mtime_nsec, walk->path, walk->path_size);
+            }
         }
-        buff_size -= n;
-        buff  += n;
     }
     
-    fclose(f);
-    
-    return 1;
+    return walk->depth < aggregate->max_depth;
 }
 
-PATHLIB_API int pathlib_unlink(const Path* path) {
-    char filename[PATHLIB_MAX_PATH];
-   
-    PATHLIB_ASSERT(path);
+PATHLIB_API int pathlib_aggregate(const Path* root, PATHLIB_NULLABLE const Pathlib_Query* query, int flags, size_t k, Pathlib_Aggregate* result) {
+    Pathlib__Aggregate aggregate;
+    Pathlib__Walk* walk;
+    Pathlib__Top_Entry temp;
+    size_t i;
+    int ok;
+    
+    PATHLIB_ASSERT(root);
+    PATHLIB_ASSERT(result);
+    PATHLIB_ASSERT((flags & PATHLIB_AGGREGATE_TOP_SIZE) == 0 || (flags & PATHLIB_AGGREGATE_TOP_MTIME) == 0);
     
     pathlib_error = PATHLIB_NONE;
     
-    if (!pathlib_exists(path)) {
+    memset(result, 0, sizeof(*result));
+    
+    aggregate.query = query;
+    aggregate.max_depth = query ? pathlib__query_max_depth(query) : (pathlib_u64)-1;
+    aggregate.flags = flags;
+    aggregate.result = result;
+    aggregate.k = (flags & (PATHLIB_AGGREGATE_TOP_SIZE | PATHLIB_AGGREGATE_TOP_MTIME)) ? k : 0;
+    aggregate.heap = pathlib__malloc(sizeof(*aggregate.heap) * aggregate.k + 1);
+    aggregate.heap_size = 0;
+    
+    walk = pathlib__malloc(sizeof(*walk));
+    ok = pathlib__walk(walk, root, pathlib__aggregate_visit, &aggregate);
+    if (!ok) {
         pathlib_error = PATHLIB_NEXISTS;
-        return 0;
+    } else if (walk->failed) {
+        pathlib_error = PATHLIB_OSERROR;
+    }
+    PATHLIB_FREE(walk);
+    
+    /* popping the min heap gives the top k from the smallest to the largest */
+    result->top_keys = pathlib__malloc(sizeof(*result->top_keys) * aggregate.heap_size + 1);
+    result->top.paths = pathlib__malloc(sizeof(*result->top.paths) * aggregate.heap_size + 1);
+    result->top.size = aggregate.heap_size;
+    result->top.capacity = aggregate.heap_size;
+    for (i = aggregate.heap_size; i > 0; i--) {
+        result->top_keys[i - 1] = aggregate.heap[0].key;
+        result->top.paths[i - 1] = pathlib_from_str(aggregate.heap[0].path);
+        PATHLIB_FREE(aggregate.heap[0].path);
+        temp = aggregate.heap[0];
+        aggregate.heap[0] = aggregate.heap[i - 1];
+        aggregate.heap[i - 1] = temp;
+        pathlib__top_sift_down(aggregate.heap, i - 1, 0);
     }
+    PATHLIB_FREE(aggregate.heap);
+    
+    return ok;
+}
 
-    if (!pathlib_render_str_to_buffer(path, filename, sizeof(filename) / sizeof(*filename))) {
-        /* this part should be unreachable */
-        pathlib_error = PATHLIB_NEXISTS;
-        return 0;
+PATHLIB_API void pathlib_aggregate_free(Pathlib_Aggregate* result) {
+    size_t i;
+    
+    PATHLIB_ASSERT(result);
+    
+    for (i = 0; i < result->top.size; i++) {
+        pathlib_destroy(&result->top.paths[i]);
     }
+    pathlib_paths_free(&result->top);
+    PATHLIB_FREE(result->top_keys);
+    result->top_keys = NULL;
+}
+
+struct Pathlib_Path_Tree {
+    Pathlib_Trie* nodes; /* only the nodes and the edges of the trie are used, not its values */
+    pathlib_u32* entries;
+    size_t size;
+    size_t capacity;
+};
+
+PATHLIB_API Pathlib_Path_Tree* pathlib_path_tree_new(void) {
+    Pathlib_Path_Tree* tree;
     
-    if (remove(filename) != 0) {
-        pathlib_error = PATHLIB_OSERROR;
-        return 0;
+    tree = pathlib__malloc(sizeof(*tree));
+    tree->nodes = pathlib_trie_new();
+    tree->entries = NULL;
+    tree->size = 0;
+    tree->capacity = 0;
+    
+    return tree;
+}
+
+PATHLIB_API void pathlib_path_tree_free(Pathlib_Path_Tree* tree) {
+    if (tree) {
+        pathlib_trie_free(tree->nodes);
+        PATHLIB_FREE(tree->entries);
+        PATHLIB_FREE(tree);
     }
+}
 
-    return 1;
+PATHLIB_API size_t pathlib_path_tree_size(const Pathlib_Path_Tree* tree) {
+    PATHLIB_ASSERT(tree);
+    
+    return tree->size;
 }
 
-#ifdef _WIN32
-int pathlib__remove_directory_contents(const Path* path) {
-    WIN32_FIND_DATA findFileData;
-    HANDLE hFind;
-    char fullPath[MAX_PATH];
-    char searchPath[MAX_PATH+3];
-    size_t searchPathSize;
-    Path subpath;
+PATHLIB_API size_t pathlib_path_tree_node(Pathlib_Path_Tree* tree, size_t parent, const char* name) {
+    Pathlib__Trie_View view;
+    pathlib_u32 child;
+    size_t name_size;
     
-    pathlib_error = PATHLIB_NONE;
+    PATHLIB_ASSERT(tree);
+    PATHLIB_ASSERT(name);
+    PATHLIB_ASSERT(parent < tree->nodes->node_count);
     
-    if (!pathlib_render_str_to_buffer(path, searchPath, sizeof(fullPath) / sizeof(*fullPath))) {
-        return 0;
+    name_size = strlen(name);
+    pathlib__trie_view(tree->nodes, &view);
+    child = pathlib__trie_view_child(&view, (pathlib_u32)parent, name, name_size);
+    if (child == 0) {
+        child = pathlib__trie_add_child(tree->nodes, (pathlib_u32)parent, name, name_size);
     }
-    searchPathSize = strlen(searchPath);
-    searchPath[searchPathSize] = '\\';
-    searchPath[searchPathSize+1] = '*';
-    searchPath[searchPathSize+2] = '\0';
+    
+    return child;
+}
 
-    hFind = FindFirstFile(searchPath, &findFileData);
-    if (hFind == INVALID_HANDLE_VALUE) {
-        pathlib_print_os_error("FindFirstFile", searchPath);
-        pathlib_error = PATHLIB_OSERROR;
-        return 0;
+PATHLIB_API size_t pathlib_path_tree_node_of(Pathlib_Path_Tree* tree, const Path* path) {
+    size_t node, i;
+    
+    PATHLIB_ASSERT(tree);
+    PATHLIB_ASSERT(path);
+    
+    node = PATHLIB_PATH_TREE_ROOT;
+    for (i = 0; i < path->size; i++) {
+        node = pathlib_path_tree_node(tree, node, path->parts[i]);
     }
+    
+    return node;
+}
 
-    do {
-        const char* name = findFileData.cFileName;
-
-        /* Skip "." and ".." entries */
-        if (strcmp(name, ".") == 0 || strcmp(name, "..") == 0) {
-            continue;
-        }
-        
-        subpath = pathlib_copy(path);
-        pathlib_add_part(&subpath, name);
-
-        /* Recursive removal for directories, or delete files */
-        if (findFileData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
-            if (!pathlib_rmdir(&subpath, 1)) {
-                FindClose(hFind);
-                return 0;
-            }
-        } else {
-            if (!pathlib_render_str_to_buffer(&subpath, fullPath, sizeof(fullPath) / sizeof(*fullPath))) {
-                return 0;
-            }
-            if (!DeleteFile(fullPath)) {
-                FindClose(hFind);
-                pathlib_print_os_error("DeleteFile", fullPath);
-                pathlib_error = PATHLIB_OSERROR;
-                return 0;
-            }
+PATHLIB_API size_t pathlib_path_tree_push(Pathlib_Path_Tree* tree, size_t node) {
+    pathlib_u32* temp;
+    
+    PATHLIB_ASSERT(tree);
+    PATHLIB_ASSERT(node < tree->nodes->node_count);
+    
+    if (tree->size >= tree->capacity) {
+        tree->capacity = tree->capacity == 0 ? 64 : tree->capacity * 2;
+        temp = pathlib__malloc(sizeof(*temp) * tree->capacity);
+        if (tree->size > 0) {
+            memcpy(temp, tree->entries, sizeof(*temp) * tree->size);
         }
+        PATHLIB_FREE(tree->entries);
+        tree->entries = temp;
+    }
+    
+    tree->entries[tree->size] = (pathlib_u32)node;
+    return tree->size++;
+}
 
-        pathlib_destroy(&subpath);
+PATHLIB_API size_t pathlib_path_tree_add(Pathlib_Path_Tree* tree, const Path* path) {
+    return pathlib_path_tree_push(tree, pathlib_path_tree_node_of(tree, path));
+}
 
-    } while (FindNextFile(hFind, &findFileData) != 0);
+PATHLIB_API Path pathlib_path_tree_get(const Pathlib_Path_Tree* tree, size_t index) {
+    const Pathlib__Trie_Node* nodes;
+    pathlib_u32 node;
+    size_t depth;
+    Path path;
+    
+    PATHLIB_ASSERT(tree);
+    PATHLIB_ASSERT(index < tree->size);
+    
+    nodes = tree->nodes->nodes;
+    depth = 0;
+    for (node = tree->entries[index]; node != PATHLIB_PATH_TREE_ROOT; node = nodes[node].parent) {
+        depth++;
+    }
+    
+    path.parts = pathlib__malloc(sizeof(*path.parts) * (depth + 1));
+    path.size = (unsigned short)depth;
+    path.capacity = (unsigned short)(depth + 1);
+    /* the parts are filled from the last one since the nodes only know their parent */
+    for (node = tree->entries[index]; node != PATHLIB_PATH_TREE_ROOT; node = nodes[node].parent) {
+        path.parts[--depth] = tree->nodes->strings + nodes[node].name_offset;
+    }
+    
+    return path;
+}
 
-    FindClose(hFind);
-    return 1;
+PATHLIB_API int pathlib_path_tree_render(const Pathlib_Path_Tree* tree, size_t index, char* buffer, size_t buffer_size) {
+    Path path;
+    int ok;
+    
+    PATHLIB_ASSERT(tree);
+    PATHLIB_ASSERT(buffer);
+    
+    path = pathlib_path_tree_get(tree, index);
+    ok = pathlib_render_str_to_buffer(&path, buffer, buffer_size);
+    pathlib_destroy(&path);
+    
+    return ok;
 }
-#else /* _WIN32 */
-int pathlib__remove_directory_contents(const Path* path) {
-    DIR* dir;
-    struct dirent* entry;
-    struct stat pathStat;
-    char fullPath[PATHLIB_MAX_PATH];
-    Path subpath;
+
+typedef struct Pathlib__Glob_Tree {
+    Pathlib_Path_Tree* tree;
+    const char* pattern;
+    size_t* nodes; /* the node of the directory at every depth of the walk */
+    size_t nodes_capacity;
+} Pathlib__Glob_Tree;
+
+static int pathlib__glob_tree_visit(Pathlib__Walk* walk, void* ctx) {
+    Pathlib__Glob_Tree* glob = ctx;
+    size_t node, *temp;
+    int type;
     
-    pathlib_error = PATHLIB_NONE;
+    if (walk->depth == 0) {
+        return 1;
+    }
     
-    if (!pathlib_render_str_to_buffer(path, fullPath, sizeof(fullPath) / sizeof(*fullPath))) {
-        return 0;
+    type = pathlib__walk_type(walk);
+    
+    /* only the directories that are entered and the files that match get a node, the names of everything else are never copied */
+    if (type == PATHLIB_ENTRY_DIR) {
+        node = pathlib_path_tree_node(glob->tree, glob->nodes[walk->depth - 1], walk->path + walk->name_offset);
+        if (walk->depth >= glob->nodes_capacity) {
+            temp = pathlib__malloc(sizeof(*temp) * glob->nodes_capacity * 2);
+            memcpy(temp, glob->nodes, sizeof(*temp) * glob->nodes_capacity);
+            PATHLIB_FREE(glob->nodes);
+            glob->nodes = temp;
+            glob->nodes_capacity *= 2;
+        }
+        glob->nodes[walk->depth] = node;
+        return 1;
+    }
+    
+    /* like pathlib_rglob only the entries that are not directories are matched */
+    if (pathlib__fnmatch(glob->pattern, walk->path + walk->name_offset) == 0) {
+        node = pathlib_path_tree_node(glob->tree, glob->nodes[walk->depth - 1], walk->path + walk->name_offset);
+        pathlib_path_tree_push(glob->tree, node);
     }
+    
+    return 0;
+}
 
-    dir = opendir(fullPath);
-    if (dir == NULL) {
-        pathlib_print_os_error("opendir", fullPath);
+PATHLIB_API Pathlib_Path_Tree* pathlib_rglob_tree(const Path* path, const char* pattern) {
+    Pathlib__Glob_Tree glob;
+    Pathlib__Walk* walk;
+    
+    PATHLIB_ASSERT(path);
+    PATHLIB_ASSERT(pattern);
+    
+    pathlib_error = PATHLIB_NONE;
+    
+    glob.tree = pathlib_path_tree_new();
+    glob.pattern = pattern;
+    glob.nodes_capacity = 64;
+    glob.nodes = pathlib__malloc(sizeof(*glob.nodes) * glob.nodes_capacity);
+    glob.nodes[0] = pathlib_path_tree_node_of(glob.tree, path);
+    
+    walk = pathlib__malloc(sizeof(*walk));
+    if (!pathlib__walk(walk, path, pathlib__glob_tree_visit, &glob)) {
+        pathlib_error = PATHLIB_NEXISTS;
+    } else if (walk->failed) {
         pathlib_error = PATHLIB_OSERROR;
-        return 0;
     }
+    
+    PATHLIB_FREE(walk);
+    PATHLIB_FREE(glob.nodes);
+    
+    return glob.tree;
+}
 
-    while ((entry = readdir(dir)) != NULL) {
-        const char* name = entry->d_name;
-
-        if (strcmp(name, ".") == 0 || strcmp(name, "..") == 0) {
-            continue;
-        }
+typedef struct Pathlib__Intern_Slot {
+    pathlib_u64 hash;
+    const char* str; /* NULL for empty slots */
+    size_t size;
+} Pathlib__Intern_Slot;
 
-        subpath = pathlib_copy(path);
-        pathlib_add_part(&subpath, name);
+struct Pathlib_Intern_Pool {
+    Pathlib__Intern_Slot* slots;
+    size_t size;
+    size_t capacity; /* always a power of two */
+    Pathlib__Arena arena;
+};
 
-        if (!pathlib_render_str_to_buffer(&subpath, fullPath, sizeof(fullPath) / sizeof(*fullPath))) {
-            pathlib_destroy(&subpath);
-            return 0;
-        }
-        
-        if (stat(fullPath, &pathStat) != 0) {
-            pathlib_print_os_error("stat", fullPath);
-            pathlib_error = PATHLIB_OSERROR;
-            closedir(dir);
-            pathlib_destroy(&subpath);
-            return 0;
+static Pathlib__Intern_Slot* pathlib__intern_find(const Pathlib_Intern_Pool* pool, const char* str, size_t size, pathlib_u64 hash) {
+    Pathlib__Intern_Slot* slot;
+    size_t i;
+    
+    for (i = (size_t)hash & (pool->capacity - 1); ; i = (i + 1) & (pool->capacity - 1)) {
+        slot = &pool->slots[i];
+        if (slot->str == NULL || (slot->hash == hash && slot->size == size && memcmp(slot->str, str, size) == 0)) {
+            return slot;
         }
+    }
+}
 
-        if (S_ISDIR(pathStat.st_mode)) {
-            if (!pathlib_rmdir(&subpath, 1)) {
-                closedir(dir);
-                pathlib_destroy(&subpath);
-                return 0;
-            }
-        } else {
-            if (unlink(fullPath) != 0) {
-                closedir(dir);
-                pathlib_destroy(&subpath);
-                return 0;
-            }
+static void pathlib__intern_grow(Pathlib_Intern_Pool* pool) {
+    Pathlib__Intern_Slot* old_slots = pool->slots;
+    size_t old_capacity = pool->capacity, i;
+    
+    pool->capacity *= 2;
+    pool->slots = pathlib__malloc(sizeof(*pool->slots) * pool->capacity);
+    memset(pool->slots, 0, sizeof(*pool->slots) * pool->capacity);
+    
+    for (i = 0; i < old_capacity; i++) {
+        if (old_slots[i].str != NULL) {
+            *pathlib__intern_find(pool, old_slots[i].str, old_slots[i].size, old_slots[i].hash) = old_slots[i];
         }
+    }
+    
+    PATHLIB_FREE(old_slots);
+}
 
-        pathlib_destroy(&subpath);
+/* str doesnt have to end with a 0, the copy inside the pool does */
+static const char* pathlib__intern(Pathlib_Intern_Pool* pool, const char* str, size_t size) {
+    Pathlib__Intern_Slot* slot;
+    pathlib_u64 hash;
+    char* copy;
+    
+    hash = pathlib__hash_bytes(str, size);
+    slot = pathlib__intern_find(pool, str, size, hash);
+    if (slot->str != NULL) {
+        return slot->str;
+    }
+    
+    /* keep the load factor under 0.7 */
+    if ((pool->size + 1) * 10 > pool->capacity * 7) {
+        pathlib__intern_grow(pool);
+        slot = pathlib__intern_find(pool, str, size, hash);
     }
+    
+    copy = pathlib__arena_alloc(&pool->arena, size + 1);
+    memcpy(copy, str, size);
+    copy[size] = 0;
+    slot->hash = hash;
+    slot->str = copy;
+    slot->size = size;
+    pool->size++;
+    
+    return copy;
+}
 
-    closedir(dir);
-    return 1;
+PATHLIB_API Pathlib_Intern_Pool* pathlib_intern_pool_new(void) {
+    Pathlib_Intern_Pool* pool;
+    
+    pool = pathlib__malloc(sizeof(*pool));
+    pool->size = 0;
+    pool->capacity = 256;
+    pool->slots = pathlib__malloc(sizeof(*pool->slots) * pool->capacity);
+    memset(pool->slots, 0, sizeof(*pool->slots) * pool->capacity);
+    memset(&pool->arena, 0, sizeof(pool->arena));
+    
+    return pool;
 }
-#endif /* _WIN32 */
 
-PATHLIB_API int pathlib_rmdir(const Path* path, int remove_contents) {
-    char filename[PATHLIB_MAX_PATH];
+PATHLIB_API void pathlib_intern_pool_free(Pathlib_Intern_Pool* pool) {
+    if (pool) {
+        pathlib__arena_free(&pool->arena);
+        PATHLIB_FREE(pool->slots);
+        PATHLIB_FREE(pool);
+    }
+}
+
+PATHLIB_API size_t pathlib_intern_pool_size(const Pathlib_Intern_Pool* pool) {
+    PATHLIB_ASSERT(pool);
     
-    PATHLIB_ASSERT(path);
+    return pool->size;
+}
+
+PATHLIB_API const char* pathlib_intern(Pathlib_Intern_Pool* pool, const char* part) {
+    PATHLIB_ASSERT(pool);
+    PATHLIB_ASSERT(part);
     
-    pathlib_error = PATHLIB_NONE;
+    return pathlib__intern(pool, part, strlen(part));
+}
+
+PATHLIB_API void pathlib_intern_path(Pathlib_Intern_Pool* pool, Path* path) {
+    size_t i;
     
-    if (!pathlib_exists(path)) {
-        pathlib_error = PATHLIB_NEXISTS;
-        return 0;
-    }
+    PATHLIB_ASSERT(pool);
+    PATHLIB_ASSERT(path);
     
-    if (!pathlib_render_str_to_buffer(path, filename, sizeof(filename) / sizeof(*filename))) {
-        pathlib_error = PATHLIB_NEXISTS;
-        return 0;
+    for (i = 0; i < path->size; i++) {
+        path->parts[i] = pathlib__intern(pool, path->parts[i], strlen(path->parts[i]));
     }
+}
+
+PATHLIB_API Path pathlib_from_str_interned(Pathlib_Intern_Pool* pool, const char* str) {
+    const char* start, *temp;
+    size_t part_count;
+    Path path;
     
+    PATHLIB_ASSERT(pool);
+    PATHLIB_ASSERT(str);
     
-    if (remove_contents) {
-        if (!pathlib__remove_directory_contents(path)) {
-            pathlib_error = PATHLIB_OSERROR;
-            return 0;
+    part_count = 1;
+    for (temp = str; *temp; temp++) {
+        if (*temp == '\\' || *temp == '/') {
+            part_count++;
         }
     }
     
-    #ifdef _WIN32
-        if (!RemoveDirectory(filename)) {
-            pathlib_print_os_error("RemoveDirectory", filename);
-            pathlib_error = PATHLIB_OSERROR;
-            return 0;
-        }
-    #else
-        if (rmdir(filename) != 0) {
-            pathlib_print_os_error("rmdir", filename);
-            pathlib_error = PATHLIB_OSERROR;
-            return 0;
+    path.parts = pathlib__malloc(sizeof(*path.parts) * part_count);
+    path.size = 0;
+    path.capacity = (unsigned short)part_count;
+    
+    /* the parts are interned straight from str so nothing else is allocated */
+    start = str;
+    for (temp = str; ; temp++) {
+        if (*temp == '/' || *temp == '\\' || *temp == '\0') {
+            path.parts[path.size++] = pathlib__intern(pool, start, temp - start);
+            if (*temp == '\0') {
+                break;
+            }
+            start = temp + 1;
         }
-    #endif
+    }
     
-    return 1;
+    return path;
 }
 
-/* Djb2 hash function by Dan Bernstein */
-PATHLIB_API unsigned long pathlib_hashfunc(const Path* path) {
-    unsigned long hash = 5381;
-    const char* str;
-    int c;
+PATHLIB_API int pathlib_interned_equal(const Path* a, const Path* b) {
     size_t i;
     
-    for (i = 0; i < path->size; i++) {
-        str = path->parts[i];
-        while ((c = *str++)) {
-            hash = ((hash << 5) + hash) + c; /* hash * 33 + c */
+    PATHLIB_ASSERT(a);
+    PATHLIB_ASSERT(b);
+    
+    if (a->size != b->size) {
+        return 0;
+    }
+    /* the last parts differ the most often so they are compared first */
+    for (i = a->size; i > 0; i--) {
+        if (a->parts[i - 1] != b->parts[i - 1]) {
+            return 0;
         }
-        hash = ((hash << 5) + hash) + '/';
     }
-
-    return hash;
+    
+    return 1;
 }
 
-PATHLIB_API void pathlib_paths_add(Paths* paths, const Path path) {
-    void* temp;
+/* a path with the interned parts of prefix followed by name */
+static Path pathlib__interned_child(Pathlib_Intern_Pool* pool, const char** prefix, size_t prefix_size, const char* name, size_t name_size) {
+    Path path;
     
-    PATHLIB_ASSERT(paths);
-
-    if (paths->size >= paths->capacity) {
-        paths->capacity = paths->capacity == 0 ? 4 : paths->capacity*2;
-        temp = pathlib__malloc(paths->capacity * sizeof(*paths->paths));
-        if (paths->size > 0) {
-            memcpy(temp, paths->paths, sizeof(*paths->paths)*paths->size);
-        }
-        PATHLIB_FREE(paths->paths);
-        paths->paths = temp;
+    path.parts = pathlib__malloc(sizeof(*path.parts) * (prefix_size + 1));
+    if (prefix_size > 0) {
+        memcpy(path.parts, prefix, sizeof(*path.parts) * prefix_size);
     }
-
-    paths->paths[paths->size++] = path;
+    path.parts[prefix_size] = pathlib__intern(pool, name, name_size);
+    path.size = (unsigned short)(prefix_size + 1);
+    path.capacity = path.size;
+    
+    return path;
 }
 
-PATHLIB_API void pathlib_paths_pop(Paths* paths, size_t i) {
-    PATHLIB_ASSERT(paths->size > i);
+PATHLIB_API Paths pathlib_listdir_interned(Pathlib_Intern_Pool* pool, const Path* path) {
+    char dirname[PATHLIB_MAX_PATH];
+    Pathlib__Names names;
+    Path prefix;
+    Paths paths;
+    size_t i;
     
-    if (paths->size == 0) {
-        return;
+    PATHLIB_ASSERT(pool);
+    PATHLIB_ASSERT(path);
+    
+    pathlib_error = PATHLIB_NONE;
+    memset(&paths, 0, sizeof(paths));
+    
+    if (!pathlib_render_str_to_buffer(path, dirname, PATHLIB_ARRSIZE(dirname)) || !pathlib_is_dir(path)) {
+        pathlib_error = PATHLIB_NEXISTS;
+        return paths;
     }
-    if (paths->size - 1 == i) {
-        paths->size--;
-        return;
+    if (!pathlib__names_read(&names, dirname, 0)) {
+        pathlib_error = PATHLIB_OSERROR;
+        return paths;
     }
-
-    memmove(paths->paths + i, paths->paths + i + 1, sizeof(*paths->paths) * (paths->size - i));
-    paths->size--;
+    
+    prefix = pathlib_copy(path);
+    pathlib_intern_path(pool, &prefix);
+    
+    paths.paths = pathlib__malloc(sizeof(*paths.paths) * (names.count + 1));
+    paths.capacity = names.count + 1;
+    for (i = 0; i < names.count; i++) {
+        paths.paths[paths.size++] = pathlib__interned_child(pool, prefix.parts, prefix.size, names.names[i], strlen(names.names[i]));
+    }
+    
+    pathlib_destroy(&prefix);
+    pathlib__names_free(&names);
+    
+    return paths;
 }
 
-PATHLIB_API void pathlib_paths_free(Paths* paths) {
-    if (paths->paths) {
-        PATHLIB_FREE(paths->paths);
-        paths->capacity = 0;
-        paths->size = 0;
-        paths->paths = NULL;
+typedef struct Pathlib__Glob_Interned {
+    Pathlib_Intern_Pool* pool;
+    const char* pattern;
+    const char** parts; /* the interned parts of the directory that the walk is inside */
+    size_t root_size;
+    size_t parts_capacity;
+    Paths* results;
+} Pathlib__Glob_Interned;
+
+static int pathlib__glob_interned_visit(Pathlib__Walk* walk, void* ctx) {
+    Pathlib__Glob_Interned* glob = ctx;
+    const char* name, **temp;
+    size_t size, name_size;
+    
+    if (walk->depth == 0) {
+        return 1;
+    }
+    
+    size = glob->root_size + walk->depth - 1;
+    name = walk->path + walk->name_offset;
+    name_size = walk->path_size - walk->name_offset;
+    
+    if (pathlib__walk_type(walk) == PATHLIB_ENTRY_DIR) {
+        if (size >= glob->parts_capacity) {
+            temp = pathlib__malloc(sizeof(*temp) * glob->parts_capacity * 2);
+            memcpy(temp, glob->parts, sizeof(*temp) * glob->parts_capacity);
+            PATHLIB_FREE(glob->parts);
+            glob->parts = temp;
+            glob->parts_capacity *= 2;
+        }
+        glob->parts[size] = pathlib__intern(glob->pool, name, name_size);
+        return 1;
+    }
+    
+    /* like pathlib_rglob only the entries that are not directories are matched */
+    if (pathlib__fnmatch(glob->pattern, name) == 0) {
+        pathlib_paths_add(glob->results, pathlib__interned_child(glob->pool, glob->parts, size, name, name_size));
     }
+    
+    return 0;
 }
 
-PATHLIB_API Paths pathlib_listdir(const Path* inpath) {
-    Paths paths;
-    char fullPath[PATHLIB_MAX_PATH];
-    Path path;
-    Path subpath;
-    size_t name_len, count;
-    const char* name;
-    #ifdef _WIN32
-        char searchPath[PATHLIB_MAX_PATH+3];
-        WIN32_FIND_DATA findFileData;
-        HANDLE hFind;
-        size_t searchPathSize;
-    #else /* _WIN32 */
-        DIR* dir;
-        struct dirent* entry;
-    #endif /* _WIN32 */
-        
-    paths.paths = NULL;
-    paths.size = 0;
-    paths.capacity = 0;
-    subpath.parts = NULL;
-    subpath.size = 0;
-    subpath.capacity = 0;
+PATHLIB_API Paths pathlib_rglob_interned(Pathlib_Intern_Pool* pool, const Path* path, const char* pattern) {
+    Pathlib__Glob_Interned glob;
+    Pathlib__Walk* walk;
+    Paths results;
+    size_t i;
+    
+    PATHLIB_ASSERT(pool);
+    PATHLIB_ASSERT(path);
+    PATHLIB_ASSERT(pattern);
     
     pathlib_error = PATHLIB_NONE;
+    memset(&results, 0, sizeof(results));
     
-    if (!pathlib_exists(inpath)) {
-        return paths;
+    if (!pathlib_is_dir(path)) {
+        pathlib_error = PATHLIB_NEXISTS;
+        return results;
     }
     
-    if (!pathlib_render_str_to_buffer(inpath, fullPath, sizeof(fullPath) / sizeof(*fullPath))) {
-        return paths;
+    glob.pool = pool;
+    glob.pattern = pattern;
+    glob.root_size = path->size;
+    glob.parts_capacity = path->size + 64;
+    glob.parts = pathlib__malloc(sizeof(*glob.parts) * glob.parts_capacity);
+    for (i = 0; i < path->size; i++) {
+        glob.parts[i] = pathlib__intern(pool, path->parts[i], strlen(path->parts[i]));
     }
+    glob.results = &results;
     
-    /* doing this because this function appends one extra item to the end of the input path
-    *  and this way it doesnt need to waste memory by doubling the capacity of the path */
-    path.parts = memcpy(pathlib__malloc(sizeof(*path.parts) * (inpath->capacity + 1)), inpath->parts, sizeof(*path.parts) * (inpath->capacity + 1));
-    path.size = inpath->size;
-    path.capacity = inpath->capacity + 1;
+    walk = pathlib__malloc(sizeof(*walk));
+    if (!pathlib__walk(walk, path, pathlib__glob_interned_visit, &glob)) {
+        pathlib_error = PATHLIB_NEXISTS;
+    } else if (walk->failed) {
+        pathlib_error = PATHLIB_OSERROR;
+    }
     
-    /* TODO */
-    #ifdef _WIN32
-        memcpy(searchPath, fullPath, PATHLIB_MAX_PATH);
+    PATHLIB_FREE(walk);
+    PATHLIB_FREE(glob.parts);
+    
+    return results;
+}
 
-        searchPathSize = strlen(searchPath);
-        searchPath[searchPathSize] = '\\';
-        searchPath[searchPathSize+1] = '*';
-        searchPath[searchPathSize+2] = '\0';
+/* the keys of pathlib_paths_sort are the parts with a 0 after each one, rewritten so that comparing their
+*  bytes gives the order. A run of digits becomes a '0', its length without the leading zeros as 2 big endian
+*  bytes and the digits, so longer numbers sort after shorter ones and the run still compares against the
+*  other characters like a digit would */
+#define PATHLIB__SORT_SMALL 32
+#define PATHLIB__SORT_PARALLEL_MIN (64 * 1024)
 
-        count = 0;
-        hFind = FindFirstFile(searchPath, &findFileData);
-        if (hFind == INVALID_HANDLE_VALUE) {
-            pathlib_print_os_error("FindFirstFile", searchPath);
-            pathlib_error = PATHLIB_OSERROR;
-            return paths;
-        }
-        
-        do {
-            name = findFileData.cFileName;
+typedef struct Pathlib__Sort_Item {
+    const unsigned char* key;
+    size_t size;
+    const Path* path;
+    size_t index;
+} Pathlib__Sort_Item;
+
+typedef struct Pathlib__Sort_Range {
+    size_t begin;
+    size_t count;
+    size_t depth; /* every key inside the range has the same first depth bytes */
+} Pathlib__Sort_Range;
+
+typedef struct Pathlib__Sort_Stack {
+    Pathlib__Sort_Range* ranges;
+    size_t size;
+    size_t capacity;
+} Pathlib__Sort_Stack;
+
+typedef struct Pathlib__Sort {
+    Pathlib__Sort_Item* items;
+    Pathlib__Sort_Item* temp;
+    const Pathlib__Sort_Range* ranges; /* the ranges that the workers sort */
+} Pathlib__Sort;
+
+/* writes the key of path and returns its size, key may be NULL to only measure it */
+static size_t pathlib__sort_key(const Path* path, int order, unsigned char* key) {
+    const unsigned char* part;
+    size_t i, size, run, zeros;
+    unsigned char c;
     
-            /* Skip "." and ".." entries */
-            if (strcmp(name, ".") == 0 || strcmp(name, "..") == 0) {
+    size = 0;
+    for (i = 0; i < path->size; i++) {
+        part = (const unsigned char*)path->parts[i];
+        while (*part) {
+            if ((order & PATHLIB_SORT_NATURAL) && *part >= '0' && *part <= '9') {
+                for (run = 0; part[run] >= '0' && part[run] <= '9'; run++);
+                for (zeros = 0; zeros + 1 < run && part[zeros] == '0'; zeros++);
+                part += zeros;
+                run -= zeros;
+                if (key) {
+                    key[size] = '0';
+                    key[size + 1] = (unsigned char)((run > 0xFFFF ? 0xFFFF : run) >> 8);
+                    key[size + 2] = (unsigned char)(run > 0xFFFF ? 0xFF : run);
+                    memcpy(key + size + 3, part, run);
+                }
+                size += 3 + run;
+                part += run;
                 continue;
             }
             
-            count++;
+            c = *part++;
+            if ((order & PATHLIB_SORT_IGNORE_CASE) && c >= 'A' && c <= 'Z') {
+                c += 'a' - 'A';
+            }
+            if (key) {
+                key[size] = c;
+            }
+            size++;
+        }
+        if (key) {
+            key[size] = 0;
+        }
+        size++;
+    }
     
-        } while (FindNextFile(hFind, &findFileData) != 0);
+    return size;
+}
+
+/* compares the bytes of the parts, which is the order of PATHLIB_SORT_BYTES */
+static int pathlib__path_bytes_cmp(const Path* a, const Path* b) {
+    size_t i, size;
+    int cmp;
     
-        FindClose(hFind);
-        
-        paths.paths = pathlib__malloc(sizeof(*paths.paths)*count);
-        paths.capacity = count;
-        
-        hFind = FindFirstFile(searchPath, &findFileData);
-        if (hFind == INVALID_HANDLE_VALUE) {
-            pathlib_print_os_error("FindFirstFile", searchPath);
-            pathlib_error = PATHLIB_OSERROR;
-            return paths;
+    size = a->size < b->size ? a->size : b->size;
+    for (i = 0; i < size; i++) {
+        cmp = strcmp(a->parts[i], b->parts[i]);
+        if (cmp != 0) {
+            return cmp;
         }
+    }
+    if (a->size != b->size) {
+        return a->size < b->size ? -1 : 1;
+    }
     
-        do {
-            name = findFileData.cFileName;
+    return 0;
+}
+
+/* orders the paths whose keys are equal by their bytes and then by their original position */
+static int pathlib__sort_tie_cmp(const Pathlib__Sort_Item* a, const Pathlib__Sort_Item* b) {
+    int cmp = pathlib__path_bytes_cmp(a->path, b->path);
     
-            /* Skip "." and ".." entries */
-            if (strcmp(name, ".") == 0 || strcmp(name, "..") == 0) {
-                continue;
-            }
-            
-            name_len = strlen(name);
-            name = memcpy(pathlib__malloc(name_len + 1), name, name_len);
-            
-            subpath = pathlib_copy(&path);
-            pathlib_add_part(&subpath, name);
-            pathlib_paths_add(&paths, subpath);
+    if (cmp != 0) {
+        return cmp;
+    }
+    return a->index < b->index ? -1 : a->index > b->index;
+}
+
+static int pathlib__sort_tie_qsort_cmp(const void* a, const void* b) {
+    return pathlib__sort_tie_cmp(a, b);
+}
+
+static int pathlib__sort_cmp(const Pathlib__Sort_Item* a, const Pathlib__Sort_Item* b, size_t depth) {
+    size_t size = a->size < b->size ? a->size : b->size;
+    int cmp;
+    
+    cmp = memcmp(a->key + depth, b->key + depth, size - depth);
+    if (cmp != 0) {
+        return cmp;
+    }
+    if (a->size != b->size) {
+        return a->size < b->size ? -1 : 1;
+    }
     
-        } while (FindNextFile(hFind, &findFileData) != 0);
+    return pathlib__sort_tie_cmp(a, b);
+}
+
+/* the bucket of an item at depth, 0 when its key ended before it */
+#define pathlib__sort_bucket(item, depth) ((depth) < (item)->size ? (size_t)(item)->key[depth] + 1 : 0)
+
+static void pathlib__sort_push(Pathlib__Sort_Stack* stack, size_t begin, size_t count, size_t depth) {
+    Pathlib__Sort_Range* temp;
     
-        FindClose(hFind);
-        
-    #else /* _WIN32 */
-        count = 0;
-        dir = opendir(fullPath);
-        if (dir == NULL) {
-            pathlib_print_os_error("opendir", fullPath);
-            pathlib_error = PATHLIB_OSERROR;
-            return paths;
+    if (stack->size >= stack->capacity) {
+        stack->capacity = stack->capacity == 0 ? 64 : stack->capacity * 2;
+        temp = pathlib__malloc(sizeof(*temp) * stack->capacity);
+        if (stack->size > 0) {
+            memcpy(temp, stack->ranges, sizeof(*temp) * stack->size);
         }
+        PATHLIB_FREE(stack->ranges);
+        stack->ranges = temp;
+    }
     
-        while ((entry = readdir(dir)) != NULL) {
-            name = entry->d_name;
+    stack->ranges[stack->size].begin = begin;
+    stack->ranges[stack->size].count = count;
+    stack->ranges[stack->size].depth = depth;
+    stack->size++;
+}
+
+/* sorts the range when it is small, otherwise distributes it by the byte at its depth and pushes the buckets that still need sorting */
+static void pathlib__sort_step(Pathlib__Sort* sort, Pathlib__Sort_Range range, Pathlib__Sort_Stack* stack) {
+    Pathlib__Sort_Item* items = sort->items + range.begin;
+    Pathlib__Sort_Item* temp = sort->temp + range.begin;
+    Pathlib__Sort_Item item;
+    size_t counts[257], offsets[257], i, j, bucket;
     
-            if (strcmp(name, ".") == 0 || strcmp(name, "..") == 0) {
-                continue;
+    if (range.count < PATHLIB__SORT_SMALL) {
+        for (i = 1; i < range.count; i++) {
+            item = items[i];
+            for (j = i; j > 0 && pathlib__sort_cmp(&items[j - 1], &item, range.depth) > 0; j--) {
+                items[j] = items[j - 1];
             }
-            count++;
+            items[j] = item;
         }
+        return;
+    }
     
-        closedir(dir);
-        
-        paths.paths = pathlib__malloc(sizeof(*paths.paths)*count);
-        paths.capacity = count;
-        
-        dir = opendir(fullPath);
-        if (dir == NULL) {
-            pathlib_print_os_error("opendir", fullPath);
-            pathlib_error = PATHLIB_OSERROR;
-            return paths;
+    memset(counts, 0, sizeof(counts));
+    for (i = 0; i < range.count; i++) {
+        counts[pathlib__sort_bucket(&items[i], range.depth)]++;
+    }
+    
+    /* a shared byte doesnt move anything, the keys that ended are only ordered by their ties */
+    bucket = pathlib__sort_bucket(&items[0], range.depth);
+    if (counts[bucket] == range.count) {
+        if (bucket == 0) {
+            qsort(items, range.count, sizeof(*items), pathlib__sort_tie_qsort_cmp);
+        } else {
+            pathlib__sort_push(stack, range.begin, range.count, range.depth + 1);
         }
+        return;
+    }
     
-        while ((entry = readdir(dir)) != NULL) {
-            name = entry->d_name;
+    offsets[0] = 0;
+    for (i = 1; i < 257; i++) {
+        offsets[i] = offsets[i - 1] + counts[i - 1];
+    }
+    for (i = 0; i < range.count; i++) {
+        temp[offsets[pathlib__sort_bucket(&items[i], range.depth)]++] = items[i];
+    }
+    memcpy(items, temp, sizeof(*items) * range.count);
     
-            if (strcmp(name, ".") == 0 || strcmp(name, "..") == 0) {
-                continue;
-            }
-            
-            name_len = strlen(name);
-            name = memcpy(pathlib__malloc(name_len + 1), name, name_len);
-            
-            subpath = pathlib_copy(&path);
-            pathlib_add_part(&subpath, name);
-            pathlib_paths_add(&paths, subpath);
+    for (i = 0; i < 257; i++) {
+        if (counts[i] < 2) {
+            continue;
+        }
+        if (i == 0) {
+            qsort(items, counts[0], sizeof(*items), pathlib__sort_tie_qsort_cmp);
+        } else {
+            pathlib__sort_push(stack, range.begin + offsets[i] - counts[i], counts[i], range.depth + 1);
         }
+    }
+}
+
+static void pathlib__sort_run(Pathlib__Sort* sort, Pathlib__Sort_Range range) {
+    Pathlib__Sort_Stack stack;
     
-        closedir(dir);
-    #endif /* _WIN32 */
+    memset(&stack, 0, sizeof(stack));
+    pathlib__sort_push(&stack, range.begin, range.count, range.depth);
+    while (stack.size > 0) {
+        stack.size--;
+        pathlib__sort_step(sort, stack.ranges[stack.size], &stack);
+    }
     
-    pathlib_destroy(&path);
-        
-    return paths;
+    PATHLIB_FREE(stack.ranges);
 }
 
-/* a slightly stripped down version of fnmatch from musl C stdlib */
-/* BEGIN OF https://github.com/kraj/musl/blob/eb4309b142bb7a8bdc839ef1faf18811b9ff31c8/src/regex/fnmatch.c */
-#define END 0
-#define UNMATCHABLE -2
-#define BRACKET -3
-#define QUESTION -4
-#define STAR -5
-#define	FNM_NOMATCH 1
-#define FNM_NOSYS   (-1)
+/* the ranges dont overlap so every worker uses its own part of items and temp */
+static void pathlib__sort_worker(void* ctx, size_t index, size_t worker) {
+    Pathlib__Sort* sort = ctx;
+    
+    (void) worker;
+    pathlib__sort_run(sort, sort->ranges[index]);
+}
 
-static wctype_t pathlib__wctype(const char *s) {
-   	int i;
-   	const char *p;
-   	/* order must match! */
-   	static const char names[] =
-  		"alnum\0" "alpha\0" "blank\0"
-  		"cntrl\0" "digit\0" "graph\0"
-  		"lower\0" "print\0" "punct\0"
-  		"space\0" "upper\0" "xdigit";
-   	for (i=1, p=names; *p; i++, p+=6)
-  		if (*s == *p && !strcmp(s, p))
- 			return i;
-   	return 0;
+PATHLIB_API void pathlib_paths_sort(Paths* paths, int order) {
+    Pathlib__Sort_Stack stack;
+    Pathlib__Sort_Range range;
+    Pathlib__Sort sort;
+    unsigned char* keys, *key;
+    size_t i, keys_size, head, workers;
+    Path* sorted;
+    
+    PATHLIB_ASSERT(paths);
+    
+    if (paths->size < 2) {
+        return;
+    }
+    
+    keys_size = 0;
+    for (i = 0; i < paths->size; i++) {
+        keys_size += pathlib__sort_key(&paths->paths[i], order, NULL);
+    }
+    keys = pathlib__malloc(keys_size + 1);
+    sort.items = pathlib__malloc(sizeof(*sort.items) * paths->size);
+    sort.temp = pathlib__malloc(sizeof(*sort.temp) * paths->size);
+    
+    key = keys;
+    for (i = 0; i < paths->size; i++) {
+        sort.items[i].key = key;
+        sort.items[i].size = pathlib__sort_key(&paths->paths[i], order, key);
+        sort.items[i].path = &paths->paths[i];
+        sort.items[i].index = i;
+        key += sort.items[i].size;
+    }
+    
+    range.begin = 0;
+    range.count = paths->size;
+    range.depth = 0;
+    workers = (order & PATHLIB_SORT_PARALLEL) && paths->size >= PATHLIB__SORT_PARALLEL_MIN ? pathlib__parallel_workers(paths->size) : 1;
+    if (workers > 1) {
+        /* split the ranges breadth first until there are enough of them to keep every worker busy */
+        memset(&stack, 0, sizeof(stack));
+        pathlib__sort_push(&stack, range.begin, range.count, range.depth);
+        head = 0;
+        while (head < stack.size && stack.size - head < workers * 16) {
+            range = stack.ranges[head++];
+            pathlib__sort_step(&sort, range, &stack);
+        }
+        sort.ranges = stack.ranges + head;
+        pathlib__parallel_for(stack.size - head, workers, pathlib__sort_worker, &sort);
+        PATHLIB_FREE(stack.ranges);
+    } else {
+        pathlib__sort_run(&sort, range);
+    }
+    
+    sorted = pathlib__malloc(sizeof(*sorted) * paths->size);
+    for (i = 0; i < paths->size; i++) {
+        sorted[i] = *sort.items[i].path;
+    }
+    memcpy(paths->paths, sorted, sizeof(*sorted) * paths->size);
+    
+    PATHLIB_FREE(sorted);
+    PATHLIB_FREE(sort.temp);
+    PATHLIB_FREE(sort.items);
+    PATHLIB_FREE(keys);
 }
 
-static int pathlib__str_next(const char *str, size_t n, size_t *step) {
-   	if (!n) {
-  		*step = 0;
-  		return 0;
-   	}
-   	*step = 1;
-   	return str[0];
+#define pathlib__is_digit(c) ((c) >= '0' && (c) <= '9')
+
+/* compares two parts like their pathlib_paths_sort keys compare */
+static int pathlib__sort_part_cmp(const unsigned char* a, const unsigned char* b, int order) {
+    size_t a_run, b_run;
+    unsigned char x, y;
+    int cmp;
+    
+    for (;;) {
+        if ((order & PATHLIB_SORT_NATURAL) && pathlib__is_digit(*a) && pathlib__is_digit(*b)) {
+            while (*a == '0' && pathlib__is_digit(a[1])) {
+                a++;
+            }
+            while (*b == '0' && pathlib__is_digit(b[1])) {
+                b++;
+            }
+            for (a_run = 0; pathlib__is_digit(a[a_run]); a_run++);
+            for (b_run = 0; pathlib__is_digit(b[b_run]); b_run++);
+            if (a_run != b_run) {
+                return a_run < b_run ? -1 : 1;
+            }
+            cmp = memcmp(a, b, a_run);
+            if (cmp != 0) {
+                return cmp;
+            }
+            a += a_run;
+            b += b_run;
+            continue;
+        }
+        
+        /* a run of digits against anything else compares like its first digit */
+        x = *a++;
+        y = *b++;
+        if (order & PATHLIB_SORT_IGNORE_CASE) {
+            x = x >= 'A' && x <= 'Z' ? x + ('a' - 'A') : x;
+            y = y >= 'A' && y <= 'Z' ? y + ('a' - 'A') : y;
+        }
+        if (x != y) {
+            return x < y ? -1 : 1;
+        }
+        if (x == 0) {
+            return 0;
+        }
+    }
 }
 
-static int pathlib__pat_next(const char *pat, size_t m, size_t *step) {
-   	if (!m || !*pat) {
-  		*step = 0;
-  		return END;
-   	}
-   	*step = 1;
-   	if (pat[0]=='\\' && pat[1]) {
-  		*step = 2;
-  		pat++;
-  		goto escaped;
-   	}
-   	if (pat[0]=='[') {
-  		size_t k = 1;
-  		if (k<m) if (pat[k] == '^' || pat[k] == '!') k++;
-  		if (k<m) if (pat[k] == ']') k++;
-  		for (; k<m && pat[k] && pat[k]!=']'; k++) {
- 			if (k+1<m && pat[k+1] && pat[k]=='[' && (pat[k+1]==':' || pat[k+1]=='.' || pat[k+1]=='=')) {
-				int z = pat[k+1];
-				k+=2;
-				if (k<m && pat[k]) k++;
-				while (k<m && pat[k] && (pat[k-1]!=z || pat[k]!=']')) k++;
-				if (k==m || !pat[k]) break;
- 			}
-  		}
-  		if (k==m || !pat[k]) {
- 			*step = 1;
- 			return '[';
-  		}
-  		*step = k+1;
-  		return BRACKET;
-   	}
-   	if (pat[0] == '*')
-  		return STAR;
-   	if (pat[0] == '?')
-  		return QUESTION;
-escaped:
-   	return pat[0];
+/* the order of pathlib_paths_sort without the original positions */
+static int pathlib__sort_path_cmp(const Path* a, const Path* b, int order) {
+    size_t i, size;
+    int cmp;
+    
+    if ((order & (PATHLIB_SORT_IGNORE_CASE | PATHLIB_SORT_NATURAL)) != 0) {
+        size = a->size < b->size ? a->size : b->size;
+        for (i = 0; i < size; i++) {
+            cmp = pathlib__sort_part_cmp((const unsigned char*)a->parts[i], (const unsigned char*)b->parts[i], order);
+            if (cmp != 0) {
+                return cmp;
+            }
+        }
+        if (a->size != b->size) {
+            return a->size < b->size ? -1 : 1;
+        }
+    }
+    
+    return pathlib__path_bytes_cmp(a, b);
 }
 
-static int pathlib__match_bracket(const char *p, int k, int kfold) {
-   	wchar_t wc;
-   	int inv = 0;
-   	p++;
-   	if (*p=='^' || *p=='!') {
-  		inv = 1;
-  		p++;
-   	}
-   	if (*p==']') {
-  		if (k==']') return !inv;
-  		p++;
-   	} else if (*p=='-') {
-  		if (k=='-') return !inv;
-  		p++;
-   	}
-   	wc = p[-1];
-   	for (; *p != ']'; p++) {
-  		if (p[0]=='-' && p[1]!=']') {
- 			wchar_t wc2;
- 			int l = mbtowc(&wc2, p+1, 4);
- 			if (l < 0) return 0;
- 			if (wc <= wc2)
-				if ((unsigned)k-wc <= (unsigned)wc2-wc ||
-				(unsigned)kfold-wc <= (unsigned)wc2-wc)
-   					return !inv;
- 			p += l-1;
- 			continue;
-  		}
-  		if (p[0]=='[' && (p[1]==':' || p[1]=='.' || p[1]=='=')) {
- 			const char *p0 = p+2;
- 			int z = p[1];
- 			p+=3;
- 			while (p[-1]!=z || p[0]!=']') p++;
- 			if (z == ':' && p-1-p0 < 16) {
-				char buf[16];
-				memcpy(buf, p0, p-1-p0);
-				buf[p-1-p0] = 0;
-				if (iswctype(k, pathlib__wctype(buf)) ||
-				    iswctype(kfold, pathlib__wctype(buf)))
-   					return !inv;
- 			}
- 			continue;
-  		}
-  		if ((unsigned char)*p < 128U) {
- 			wc = (unsigned char)*p;
-  		} else {
- 			int l = mbtowc(&wc, p, 4);
- 			if (l < 0) return 0;
- 			p += l-1;
-  		}
-  		if (wc==k || wc==kfold) return !inv;
-   	}
-   	return inv;
+PATHLIB_API Paths pathlib_paths_set_op(const Paths* a, const Paths* b, int op, int order) {
+    const Path* path;
+    Paths result;
+    size_t i, j;
+    int cmp, keep;
+    
+    PATHLIB_ASSERT(a);
+    PATHLIB_ASSERT(b);
+    
+    memset(&result, 0, sizeof(result));
+    
+    i = 0;
+    j = 0;
+    while (i < a->size || j < b->size) {
+        /* nothing that is only inside b can be kept */
+        if (i >= a->size && (op == PATHLIB_SET_INTERSECTION || op == PATHLIB_SET_DIFFERENCE)) {
+            break;
+        }
+        
+        if (i >= a->size) {
+            cmp = 1;
+        } else if (j >= b->size) {
+            cmp = -1;
+        } else {
+            cmp = pathlib__sort_path_cmp(&a->paths[i], &b->paths[j], order);
+        }
+        
+        if (cmp < 0) {
+            path = &a->paths[i];
+            keep = op != PATHLIB_SET_INTERSECTION;
+        } else if (cmp > 0) {
+            path = &b->paths[j];
+            keep = op == PATHLIB_SET_UNION || op == PATHLIB_SET_SYMMETRIC_DIFFERENCE;
+        } else {
+            path = &a->paths[i];
+            keep = op == PATHLIB_SET_UNION || op == PATHLIB_SET_INTERSECTION;
+        }
+        
+        /* equal paths are next to each other so the duplicates are skipped here */
+        while (cmp <= 0 && i < a->size && pathlib__path_bytes_cmp(&a->paths[i], path) == 0) {
+            i++;
+        }
+        while (cmp >= 0 && j < b->size && pathlib__path_bytes_cmp(&b->paths[j], path) == 0) {
+            j++;
+        }
+        
+        if (keep) {
+            pathlib_paths_add(&result, pathlib_copy(path));
+        }
+    }
+    
+    return result;
+}
+
+PATHLIB_API Paths pathlib_paths_set_op_unsorted(const Paths* a, const Paths* b, int op) {
+    Pathlib_Path_Set* in_b, *seen;
+    Paths result;
+    size_t i;
+    int keep;
+    
+    PATHLIB_ASSERT(a);
+    PATHLIB_ASSERT(b);
+    
+    memset(&result, 0, sizeof(result));
+    
+    in_b = pathlib_path_set_from_paths(b);
+    seen = pathlib_path_set_new(a->size + b->size);
+    
+    for (i = 0; i < a->size; i++) {
+        if (!pathlib_path_set_add(seen, &a->paths[i])) {
+            continue;
+        }
+        if (pathlib_path_set_contains(in_b, &a->paths[i])) {
+            keep = op == PATHLIB_SET_UNION || op == PATHLIB_SET_INTERSECTION;
+        } else {
+            keep = op != PATHLIB_SET_INTERSECTION;
+        }
+        if (keep) {
+            pathlib_paths_add(&result, pathlib_copy(&a->paths[i]));
+        }
+    }
+    
+    /* seen holds every path of a so it also skips the paths of b that are inside a */
+    if (op == PATHLIB_SET_UNION || op == PATHLIB_SET_SYMMETRIC_DIFFERENCE) {
+        for (i = 0; i < b->size; i++) {
+            if (pathlib_path_set_add(seen, &b->paths[i])) {
+                pathlib_paths_add(&result, pathlib_copy(&b->paths[i]));
+            }
+        }
+    }
+    
+    pathlib_path_set_free(seen);
+    pathlib_path_set_free(in_b);
+    
+    return result;
 }
 
-static int pathlib__fnmatch_internal(const char *pat, size_t m, const char *str, size_t n) {
-   	const char *p, *ptail, *endpat;
-   	const char *s, *stail, *endstr;
-   	size_t pinc, sinc, tailcnt=0;
-   	int c, k;
-
-   	for (;;) {
-  		switch ((c = pathlib__pat_next(pat, m, &pinc))) {
-  		case UNMATCHABLE:
- 			return FNM_NOMATCH;
-  		case STAR:
- 			pat++;
- 			m--;
- 			break;
-  		default:
- 			k = pathlib__str_next(str, n, &sinc);
- 			if (k <= 0)
-				return (c==END) ? 0 : FNM_NOMATCH;
- 			str += sinc;
- 			n -= sinc;
- 			if (c == BRACKET) {
-				if (!pathlib__match_bracket(pat, k, k))
-   					return FNM_NOMATCH;
- 			} else if (c != QUESTION && k != c && k != c) {
-				return FNM_NOMATCH;
- 			}
- 			pat+=pinc;
- 			m-=pinc;
- 			continue;
-  		}
-  		break;
-   	}
+/* empty parts come from repeated separators and `.` parts point to the same directory */
+#define pathlib__is_redundant_part(part) ((part)[0] == 0 || ((part)[0] == '.' && (part)[1] == 0))
 
-   	/* Compute real pat length if it was initially unknown/-1 */
-   	m = strlen(pat);
-   	endpat = pat + m;
+/* a leading separator leaves an empty first part, drive letters are handled by pathlib_is_absolute */
+static int pathlib__has_root(const Path* path) {
+    return (path->size > 1 && path->parts[0][0] == 0) || pathlib_is_absolute(path);
+}
 
-   	/* Find the last * in pat and count chars needed after it */
-   	for (p=ptail=pat; p<endpat; p+=pinc) {
-  		switch (pathlib__pat_next(p, endpat-p, &pinc)) {
-  		case UNMATCHABLE:
- 			return FNM_NOMATCH;
-  		case STAR:
- 			tailcnt=0;
- 			ptail = p+1;
- 			break;
-  		default:
- 			tailcnt++;
- 			break;
-  		}
-   	}
+/* how many parts a and b share, interned parts are equal without a strcmp */
+static size_t pathlib__common_parts(const Path* a, const Path* b, size_t limit) {
+    size_t i;
+    
+    for (i = 0; i < limit && i < a->size && i < b->size; i++) {
+        if (a->parts[i] != b->parts[i] && strcmp(a->parts[i], b->parts[i]) != 0) {
+            break;
+        }
+    }
+    
+    return i;
+}
 
-   	/* Past this point we need not check for UNMATCHABLE in pat,
-  	 * because all of pat has already been parsed once. */
+PATHLIB_API int pathlib_relative_to(const Path* path, const Path* base, int walk_up, Path* result) {
+    size_t common, i, ups;
+    
+    PATHLIB_ASSERT(path);
+    PATHLIB_ASSERT(base);
+    PATHLIB_ASSERT(result);
+    
+    memset(result, 0, sizeof(*result));
+    
+    if (pathlib__has_root(path) != pathlib__has_root(base)) {
+        return 0;
+    }
+    
+    common = pathlib__common_parts(path, base, (size_t)-1);
+    /* the first part of an absolute path is its root, nothing leads from one root to another */
+    if (common == 0 && pathlib__has_root(path)) {
+        return 0;
+    }
+    
+    ups = 0;
+    for (i = common; i < base->size; i++) {
+        if (pathlib__is_redundant_part(base->parts[i])) {
+            continue;
+        }
+        if (!walk_up || strcmp(base->parts[i], "..") == 0) {
+            return 0;
+        }
+        ups++;
+    }
+    
+    result->capacity = (unsigned short)(ups + path->size - common + 1);
+    result->parts = pathlib__malloc(sizeof(*result->parts) * result->capacity);
+    for (i = 0; i < ups; i++) {
+        result->parts[result->size++] = "..";
+    }
+    for (i = common; i < path->size; i++) {
+        if (!pathlib__is_redundant_part(path->parts[i])) {
+            result->parts[result->size++] = path->parts[i];
+        }
+    }
+    if (result->size == 0) {
+        result->parts[result->size++] = ".";
+    }
+    
+    return 1;
+}
 
-   	/* Compute real str length if it was initially unknown/-1 */
-   	n = strlen(str);
-   	endstr = str + n;
-   	if (n < tailcnt) return FNM_NOMATCH;
+PATHLIB_API Path pathlib_common_path(const Paths* paths) {
+    size_t i, common;
+    Path result;
+    
+    PATHLIB_ASSERT(paths);
+    
+    memset(&result, 0, sizeof(result));
+    if (paths->size == 0) {
+        return result;
+    }
+    
+    common = paths->paths[0].size;
+    for (i = 1; i < paths->size && common > 0; i++) {
+        common = pathlib__common_parts(&paths->paths[0], &paths->paths[i], common);
+    }
+    if (common == 0) {
+        return result;
+    }
+    
+    result.capacity = (unsigned short)(common + 1);
+    result.parts = pathlib__malloc(sizeof(*result.parts) * result.capacity);
+    memcpy(result.parts, paths->paths[0].parts, sizeof(*result.parts) * common);
+    result.size = (unsigned short)common;
+    /* only the empty root part is left, the root on its own is "/" which has a second empty part */
+    if (common == 1 && result.parts[0][0] == 0) {
+        result.parts[result.size++] = "";
+    }
+    
+    return result;
+}
 
-   	/* Find the final tailcnt chars of str, accounting for UTF-8.
-  	 * On illegal sequences we may get it wrong, but in that case
-  	 * we necessarily have a matching failure anyway. */
-   	for (s=endstr; s>str && tailcnt; tailcnt--) {
-  		if ((unsigned char)s[-1] < 128U || MB_CUR_MAX==1) s--;
-  		else while ((unsigned char)*--s-0x80U<0x40 && s>str);
-   	}
-   	if (tailcnt) return FNM_NOMATCH;
-   	stail = s;
+/* how many leading parts are the root, the empty part before a leading separator or a drive letter on windows */
+static size_t pathlib__normalize_root(const char* first_part, size_t size) {
+    if (size > 1 && first_part[0] == 0) {
+        return 1;
+    }
+    #ifdef _WIN32
+        if (size > 0 && ((first_part[0] >= 'a' && first_part[0] <= 'z') || (first_part[0] >= 'A' && first_part[0] <= 'Z')) &&
+            first_part[1] == ':' && first_part[2] == 0) {
+            return 1;
+        }
+    #endif
+    return 0;
+}
 
-   	/* Check that the pat and str tails match */
-   	p = ptail;
-   	for (;;) {
-  		c = pathlib__pat_next(p, endpat-p, &pinc);
-  		p += pinc;
-  		if ((k = pathlib__str_next(s, endstr-s, &sinc)) <= 0) {
- 			if (c != END) return FNM_NOMATCH;
- 			break;
-  		}
-  		s += sinc;
-  		if (c == BRACKET) {
- 			if (!pathlib__match_bracket(p-pinc, k, k))
-				return FNM_NOMATCH;
-  		} else if (c != QUESTION && k != c && k != c) {
- 			return FNM_NOMATCH;
-  		}
-   	}
+/* appends part to the normalized parts[0, size) and returns the new size */
+static size_t pathlib__normalize_push(const char** parts, size_t size, size_t root, const char* part) {
+    if (pathlib__is_redundant_part(part)) {
+        return size;
+    }
+    if (part[0] == '.' && part[1] == '.' && part[2] == 0) {
+        if (size > root && strcmp(parts[size - 1], "..") != 0) {
+            return size - 1;
+        }
+        /* nothing is above the root */
+        if (root > 0) {
+            return size;
+        }
+    }
+    
+    parts[size] = part;
+    return size + 1;
+}
 
-   	/* We're all done with the tails now, so throw them out */
-   	endstr = stail;
-   	endpat = ptail;
+/* the root on its own is "/" or "C:/" which have a second empty part, an empty relative path becomes "." */
+static size_t pathlib__normalize_finish(const char** parts, size_t size, size_t root, size_t capacity) {
+    if (size == root && size < capacity) {
+        parts[size++] = root > 0 ? "" : ".";
+    }
+    return size;
+}
 
-   	/* Match pattern components until there are none left */
-   	while (pat<endpat) {
-  		p = pat;
-  		s = str;
-  		for (;;) {
- 			c = pathlib__pat_next(p, endpat-p, &pinc);
- 			p += pinc;
- 			/* Encountering * completes/commits a component */
- 			if (c == STAR) {
-				pat = p;
-				str = s;
-				break;
- 			}
- 			k = pathlib__str_next(s, endstr-s, &sinc);
- 			if (!k)
-				return FNM_NOMATCH;
- 			if (c == BRACKET) {
-				if (!pathlib__match_bracket(p-pinc, k, k))
-   					break;
- 			} else if (c != QUESTION && k != c && k != c) {
-				break;
- 			}
- 			s += sinc;
-  		}
-  		if (c == STAR) continue;
-  		/* If we failed, advance str, by 1 char if it's a valid
- 		 * char, or past all invalid bytes otherwise. */
-  		k = pathlib__str_next(str, endstr-str, &sinc);
-  		if (k > 0) str += sinc;
-  		else for (str++; pathlib__str_next(str, endstr-str, &sinc)<0; str++);
-   	}
+PATHLIB_API Path pathlib_from_str_normalized(const char* instr) {
+    char* str, *start, *temp;
+    size_t instr_len, part_count, root, size;
+    int last;
+    Path path;
+    
+    PATHLIB_ASSERT(instr);
+    
+    instr_len = strlen(instr);
+    str = memcpy(pathlib__malloc(instr_len + 1), instr, instr_len);
+    str[instr_len] = 0;
+    
+    part_count = 1;
+    for (temp = str; *temp; temp++) {
+        if (*temp == '\\' || *temp == '/') {
+            part_count++;
+        }
+    }
+    
+    path.parts = pathlib__malloc(sizeof(*path.parts) * part_count);
+    path.capacity = (unsigned short)part_count;
+    
+    /* every part is pushed as soon as its separator is found so the string is only walked once */
+    size = 0;
+    root = 0;
+    start = str;
+    for (temp = str; ; temp++) {
+        if (*temp == '/' || *temp == '\\' || *temp == '\0') {
+            last = *temp == '\0';
+            *temp = 0;
+            if (start == str) {
+                root = pathlib__normalize_root(start, part_count);
+            }
+            if (start == str && root > 0) {
+                path.parts[size++] = start;
+            } else {
+                size = pathlib__normalize_push(path.parts, size, root, start);
+            }
+            if (last) {
+                break;
+            }
+            start = temp + 1;
+        }
+    }
+    path.size = (unsigned short)pathlib__normalize_finish(path.parts, size, root, part_count);
+    
+    return path;
+}
 
-   	return 0;
+PATHLIB_API void pathlib_normalize(Path* path) {
+    size_t i, root, size;
+    
+    PATHLIB_ASSERT(path);
+    
+    if (path->size == 0) {
+        return;
+    }
+    
+    /* the normalized parts are never ahead of the parts that are read */
+    root = pathlib__normalize_root(path->parts[0], path->size);
+    size = root;
+    for (i = root; i < path->size; i++) {
+        size = pathlib__normalize_push(path->parts, size, root, path->parts[i]);
+    }
+    path->size = (unsigned short)pathlib__normalize_finish(path->parts, size, root, path->capacity);
 }
 
-int pathlib__fnmatch(const char *pat, const char *str) {
-   	return pathlib__fnmatch_internal(pat, -1, str, -1);
+/* how many symlinks pathlib_resolve follows before it gives up, like the kernel does */
+#define PATHLIB__MAX_SYMLINKS 40
+
+typedef struct Pathlib__Resolve_Entry {
+    pathlib_u64 generation;
+    int is_link;
+    char* target; /* where the symlink points to, it is stored right after the entry */
+} Pathlib__Resolve_Entry;
+
+struct Pathlib_Resolve_Cache {
+    Pathlib__Str_Map entries; /* keyed by the path of the part with its directory already resolved */
+    pathlib_u64 generation;
+};
+
+PATHLIB_API Pathlib_Resolve_Cache* pathlib_resolve_cache_new(void) {
+    Pathlib_Resolve_Cache* cache;
+    
+    cache = pathlib__malloc(sizeof(*cache));
+    memset(&cache->entries, 0, sizeof(cache->entries));
+    cache->generation = 1;
+    
+    return cache;
 }
 
-#undef END
-#undef UNMATCHABLE
-#undef BRACKET
-#undef QUESTION
-#undef STAR
-#undef FNM_NOMATCH
-#undef FNM_NOSYS
+PATHLIB_API void pathlib_resolve_cache_invalidate(Pathlib_Resolve_Cache* cache) {
+    PATHLIB_ASSERT(cache);
+    
+    /* the stale entries are replaced when their path is resolved again */
+    cache->generation++;
+}
 
-/* END OF https://github.com/kraj/musl/blob/eb4309b142bb7a8bdc839ef1faf18811b9ff31c8/src/regex/fnmatch.c */
+PATHLIB_API void pathlib_resolve_cache_free(Pathlib_Resolve_Cache* cache) {
+    if (cache) {
+        pathlib__str_map_free(&cache->entries, 1);
+        PATHLIB_FREE(cache);
+    }
+}
 
-static int pathlib__recursive_glob(char* base_path, const char* pattern, int recursive, Paths* results) {
-    char fullpath[PATHLIB_MAX_PATH];
+#ifndef _WIN32
+static void pathlib__resolve_cache_put(Pathlib_Resolve_Cache* cache, const char* path, size_t path_size, const char* target) {
+    Pathlib__Str_Map_Slot* slot;
+    Pathlib__Resolve_Entry* entry;
+    size_t target_size = target ? strlen(target) : 0;
+    
+    entry = pathlib__malloc(sizeof(*entry) + target_size + 1);
+    entry->generation = cache->generation;
+    entry->is_link = target != NULL;
+    entry->target = (char*)(entry + 1);
+    memcpy(entry->target, target ? target : "", target_size + 1);
+    
+    slot = pathlib__str_map_insert(&cache->entries, path, path_size);
+    PATHLIB_FREE(slot->value);
+    slot->value = entry;
+}
+#endif /* _WIN32 */
 
-    #if defined(_WIN32)
-        WIN32_FIND_DATA find_data;
-        HANDLE hFind;
-        char search_path[PATHLIB_MAX_PATH];
+PATHLIB_API Path pathlib_resolve(const Path* path, PATHLIB_NULLABLE Pathlib_Resolve_Cache* cache) {
+    char resolved[PATHLIB_MAX_PATH];
+    Path result;
+    #ifdef _WIN32
+        char full[PATHLIB_MAX_PATH];
+    #else
+        char rest[PATHLIB_MAX_PATH], next[PATHLIB_MAX_PATH], target[PATHLIB_MAX_PATH];
+        Pathlib__Resolve_Entry* entry;
+        const char* p, *end, *link;
+        size_t resolved_size, name_size, link_size, rest_size, links;
+        int missing, more;
+        struct stat statbuf;
+        long n;
+    #endif
     
-        if (snprintf(search_path, sizeof(search_path), "%s\\*", base_path) < 0) {
-            return 0;
+    PATHLIB_ASSERT(path);
+    
+    pathlib_error = PATHLIB_NONE;
+    memset(&result, 0, sizeof(result));
+    
+    #ifdef _WIN32
+        (void) cache;
+        if (!pathlib_render_str_to_buffer(path, resolved, PATHLIB_ARRSIZE(resolved))) {
+            pathlib_error = PATHLIB_OSERROR;
+            return result;
         }
-    
-        hFind = FindFirstFile(search_path, &find_data);
-        if (hFind == INVALID_HANDLE_VALUE) {
-            pathlib_print_os_error("FindFirstFile", search_path);
+        if (GetFullPathName(resolved, PATHLIB_ARRSIZE(full), full, NULL) == 0) {
+            pathlib_print_os_error("GetFullPathName", resolved);
             pathlib_error = PATHLIB_OSERROR;
-            return 0;
+            return result;
         }
-    
-        do {
-            const char* name = find_data.cFileName;
+        return pathlib_from_str(full);
+    #else
+        if (!pathlib_render_str_to_buffer(path, rest, PATHLIB_ARRSIZE(rest))) {
+            pathlib_error = PATHLIB_OSERROR;
+            return result;
+        }
+        
+        /* resolved never has a trailing separator so the root is the empty string */
+        resolved_size = 0;
+        if (rest[0] != '/') {
+            if (getcwd(resolved, sizeof(resolved)) == NULL) {
+                pathlib_print_func_failed("getcwd");
+                pathlib_error = PATHLIB_OSERROR;
+                return result;
+            }
+            resolved_size = strlen(resolved);
+            if (resolved_size == 1) {
+                resolved_size = 0;
+            }
+        }
+        resolved[resolved_size] = 0;
+        
+        links = 0;
+        missing = 0;
+        p = rest;
+        for (;;) {
+            while (*p == '/') {
+                p++;
+            }
+            if (*p == 0) {
+                break;
+            }
+            for (end = p; *end && *end != '/'; end++);
+            name_size = end - p;
             
-            if (strcmp(name, ".") == 0 || strcmp(name, "..") == 0) {
+            if (name_size == 1 && p[0] == '.') {
+                p = end;
                 continue;
             }
-    
-            if (snprintf(fullpath, sizeof(fullpath), "%s\\%s", base_path, name) < 0) {
+            /* resolved has no symlinks so its parent is lexical */
+            if (name_size == 2 && p[0] == '.' && p[1] == '.') {
+                while (resolved_size > 0 && resolved[--resolved_size] != '/');
+                resolved[resolved_size] = 0;
+                p = end;
                 continue;
             }
-
-            if (find_data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
-                if (recursive) {
-                    if (!pathlib__recursive_glob(fullpath, pattern, recursive, results)) {
-                        FindClose(hFind);
-                        return 0;
+            
+            if (resolved_size + 1 + name_size + 1 > sizeof(resolved)) {
+                pathlib_print_error("path too long while resolving `%s`", rest);
+                pathlib_error = PATHLIB_OSERROR;
+                return result;
+            }
+            resolved[resolved_size] = '/';
+            memcpy(resolved + resolved_size + 1, p, name_size);
+            resolved_size += 1 + name_size;
+            resolved[resolved_size] = 0;
+            p = end;
+            
+            if (missing) {
+                continue;
+            }
+            for (end = p; *end == '/'; end++);
+            more = *end != 0;
+            
+            entry = cache ? pathlib__str_map_get(&cache->entries, resolved, resolved_size) : NULL;
+            if (entry && entry->generation == cache->generation) {
+                if (!entry->is_link) {
+                    continue;
+                }
+                link = entry->target;
+            } else {
+                if (lstat(resolved, &statbuf) != 0) {
+                    if (errno == ENOENT || errno == ENOTDIR) {
+                        missing = 1;
+                        continue;
                     }
+                    pathlib_print_os_error("lstat", resolved);
+                    pathlib_error = PATHLIB_OSERROR;
+                    return result;
                 }
-                continue;
+                if (!S_ISLNK(statbuf.st_mode)) {
+                    /* only the directories are cached, the last part is usually a file that is never seen again */
+                    if (cache && more) {
+                        pathlib__resolve_cache_put(cache, resolved, resolved_size, NULL);
+                    }
+                    continue;
+                }
+                n = (long)readlink(resolved, target, sizeof(target) - 1);
+                if (n < 0) {
+                    pathlib_print_os_error("readlink", resolved);
+                    pathlib_error = PATHLIB_OSERROR;
+                    return result;
+                }
+                target[n] = 0;
+                if (cache && more) {
+                    pathlib__resolve_cache_put(cache, resolved, resolved_size, target);
+                }
+                link = target;
             }
-    
-            if (pathlib__fnmatch(pattern, name) == 0) {
-                pathlib_paths_add(results, pathlib_from_str(fullpath));
+            
+            if (++links > PATHLIB__MAX_SYMLINKS) {
+                pathlib_print_error("too many levels of symbolic links while resolving `%s`", resolved);
+                pathlib_error = PATHLIB_OSERROR;
+                return result;
+            }
+            
+            /* the target replaces the symlink, an absolute one starts over from the root */
+            while (resolved_size > 0 && resolved[--resolved_size] != '/');
+            if (link[0] == '/') {
+                resolved_size = 0;
             }
+            resolved[resolved_size] = 0;
+            
+            link_size = strlen(link);
+            rest_size = strlen(p);
+            if (link_size + 1 + rest_size + 1 > sizeof(next)) {
+                pathlib_print_error("path too long while resolving `%s`", link);
+                pathlib_error = PATHLIB_OSERROR;
+                return result;
+            }
+            memcpy(next, link, link_size);
+            next[link_size] = '/';
+            memcpy(next + link_size + 1, p, rest_size + 1);
+            memcpy(rest, next, link_size + 1 + rest_size + 1);
+            p = rest;
+        }
+        
+        if (resolved_size == 0) {
+            return pathlib_from_str("/");
+        }
+        return pathlib_from_str(resolved);
+    #endif
+}
+
+
+struct Pathlib_Mount_Table {
+    char* data;            /* the contents of mountinfo, the strings of the mounts point inside */
+    Pathlib_Mount* mounts;
+    size_t size;
+    Pathlib_Trie* trie;    /* the mount points, the value is the index of the mount */
+    int fd;                /* mountinfo stays open so poll can report changes */
+};
+
+/* the path without its trailing empty parts, so `/` is a prefix of `/a` inside the trie */
+static Path pathlib__mount_key(const Path* path) {
+    Path key;
     
-        } while (FindNextFile(hFind, &find_data) != 0);
+    key = *path;
+    while (key.size > 1 && key.parts[key.size - 1][0] == '\0') {
+        key.size--;
+    }
     
-        FindClose(hFind);
-    #else /* _WIN32 */
-        DIR* dir;
-        struct dirent* entry;
-        struct stat path_stat;
+    return key;
+}
+
+#ifdef __linux__
+/* cuts the next field out of a mountinfo line and decodes the `\ooo` escapes of the kernel, NULL at the end of the line */
+static char* pathlib__mountinfo_field(char** cursor) {
+    char *start, *read, *write;
     
-        dir = opendir(base_path);
-        if (dir == NULL) {
-            pathlib_print_os_error("opendir", base_path);
-            pathlib_error = PATHLIB_OSERROR;
-            return 0;
+    start = *cursor;
+    if (*start == '\0') {
+        return NULL;
+    }
+    
+    for (read = write = start; *read != '\0' && *read != ' '; read++) {
+        if (read[0] == '\\' && read[1] >= '0' && read[1] <= '3' && read[2] >= '0' && read[2] <= '7' && read[3] >= '0' && read[3] <= '7') {
+            *write++ = (char)(((read[1] - '0') << 6) | ((read[2] - '0') << 3) | (read[3] - '0'));
+            read += 3;
+        } else {
+            *write++ = *read;
         }
+    }
+    *cursor = *read == ' ' ? read + 1 : read;
+    *write = '\0';
     
-        while ((entry = readdir(dir)) != NULL) {
-            if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
-                continue;
-            }
+    return start;
+}
+
+/* parses a line like `36 35 98:0 /mnt1 /mnt/parent rw,noatime master:1 - ext3 /dev/root rw` */
+static int pathlib__mountinfo_parse_line(char* line, Pathlib_Mount* mount) {
+    char *id, *parent_id, *device, *options, *field, *end;
     
-            if (snprintf(fullpath, sizeof(fullpath), "%s/%s", base_path, entry->d_name) < 0) {
-                continue;
-            }
+    id = pathlib__mountinfo_field(&line);
+    parent_id = pathlib__mountinfo_field(&line);
+    device = pathlib__mountinfo_field(&line);
+    mount->root = pathlib__mountinfo_field(&line);
+    mount->mount_point = pathlib__mountinfo_field(&line);
+    options = pathlib__mountinfo_field(&line);
+    if (options == NULL) {
+        return 0;
+    }
     
-            if (stat(fullpath, &path_stat) != 0) {
-                continue;
-            }
+    /* the optional fields end with a single `-` */
+    do {
+        field = pathlib__mountinfo_field(&line);
+    } while (field != NULL && strcmp(field, "-") != 0);
     
-            if (S_ISDIR(path_stat.st_mode)) {
-                if (recursive) {
-                    if (!pathlib__recursive_glob(fullpath, pattern, recursive, results)) {
-                        closedir(dir);
-                        return 0;
-                    }
-                }
+    mount->fs_type = pathlib__mountinfo_field(&line);
+    mount->source = pathlib__mountinfo_field(&line);
+    if (mount->source == NULL) {
+        return 0;
+    }
+    mount->options = options;
+    
+    mount->id = (unsigned int)strtoul(id, NULL, 10);
+    mount->parent_id = (unsigned int)strtoul(parent_id, NULL, 10);
+    mount->major = (unsigned int)strtoul(device, &end, 10);
+    mount->minor = *end == ':' ? (unsigned int)strtoul(end + 1, NULL, 10) : 0;
+    
+    return 1;
+}
+
+/* reads mountinfo from the start and replaces the contents of the table */
+static int pathlib__mount_table_load(Pathlib_Mount_Table* table) {
+    char *data, *old_data, *line, *next;
+    size_t used, capacity, lines;
+    Pathlib_Mount* mounts;
+    Pathlib_Trie* trie;
+    Path path, key;
+    size_t size;
+    ssize_t got;
+    
+    if (lseek(table->fd, 0, SEEK_SET) < 0) {
+        pathlib_print_os_error("lseek", "/proc/self/mountinfo");
+        pathlib_error = PATHLIB_OSERROR;
+        return 0;
+    }
+    
+    /* the size of a proc file is not known before it is read */
+    capacity = 16 * 1024;
+    used = 0;
+    data = pathlib__malloc(capacity);
+    for (;;) {
+        if (used + 1 == capacity) {
+            old_data = data;
+            capacity *= 2;
+            data = pathlib__malloc(capacity);
+            memcpy(data, old_data, used);
+            PATHLIB_FREE(old_data);
+        }
+        got = read(table->fd, data + used, capacity - used - 1);
+        if (got < 0) {
+            if (errno == EINTR) {
                 continue;
             }
+            pathlib_print_os_error("read", "/proc/self/mountinfo");
+            pathlib_error = PATHLIB_OSERROR;
+            PATHLIB_FREE(data);
+            return 0;
+        }
+        if (got == 0) {
+            break;
+        }
+        used += (size_t)got;
+    }
+    data[used] = '\0';
     
-            if (pathlib__fnmatch(pattern, entry->d_name) == 0) {
-                pathlib_paths_add(results, pathlib_from_str(fullpath));
-            }
+    lines = 1;
+    for (line = data; *line != '\0'; line++) {
+        lines += *line == '\n';
+    }
+    
+    mounts = pathlib__malloc(sizeof(*mounts) * lines);
+    trie = pathlib_trie_new();
+    size = 0;
+    for (line = data; *line != '\0'; line = next) {
+        next = strchr(line, '\n');
+        if (next != NULL) {
+            *next++ = '\0';
+        } else {
+            next = line + strlen(line);
+        }
+        if (!pathlib__mountinfo_parse_line(line, &mounts[size])) {
+            continue;
         }
+        /* later lines are mounted over the earlier ones at the same point */
+        path = pathlib_from_str(mounts[size].mount_point);
+        key = pathlib__mount_key(&path);
+        pathlib_trie_insert(trie, &key, size);
+        PATHLIB_FREE((void*)path.parts[0]);
+        pathlib_destroy(&path);
+        size++;
+    }
+    
+    PATHLIB_FREE(table->data);
+    PATHLIB_FREE(table->mounts);
+    pathlib_trie_free(table->trie);
+    table->data = data;
+    table->mounts = mounts;
+    table->size = size;
+    table->trie = trie;
     
-        closedir(dir);
-    #endif /*_WIN32 */
-
     return 1;
 }
+#endif /* __linux__ */
 
-PATHLIB_API Paths pathlib_glob(const Path* path, const char* pattern) {
-    char fullpath[PATHLIB_MAX_PATH];
-    Paths results;
-    results.paths = NULL;
-    results.size = 0;
-    results.capacity = 0;
+PATHLIB_API Pathlib_Mount_Table* pathlib_mount_table_new(void) {
+    Pathlib_Mount_Table* table;
     
-    PATHLIB_ASSERT(path);
-    PATHLIB_ASSERT(pattern);
+    pathlib_error = PATHLIB_NONE;
+    
+    #ifdef __linux__
+        table = pathlib__malloc(sizeof(*table));
+        table->data = NULL;
+        table->mounts = NULL;
+        table->size = 0;
+        table->trie = NULL;
+        table->fd = open("/proc/self/mountinfo", O_RDONLY | O_CLOEXEC);
+        if (table->fd < 0) {
+            pathlib_print_os_error("open", "/proc/self/mountinfo");
+            pathlib_error = PATHLIB_OSERROR;
+            PATHLIB_FREE(table);
+            return NULL;
+        }
+        
+        if (!pathlib__mount_table_load(table)) {
+            pathlib_mount_table_free(table);
+            return NULL;
+        }
+        
+        return table;
+    #else
+        (void)table;
+        pathlib_print_error("the mount table is only available on linux");
+        pathlib_error = PATHLIB_OSERROR;
+        return NULL;
+    #endif
+}
+
+PATHLIB_API int pathlib_mount_table_refresh(Pathlib_Mount_Table* table) {
+    #ifdef __linux__
+        struct pollfd pfd;
+    #endif
+    
+    PATHLIB_ASSERT(table);
     
     pathlib_error = PATHLIB_NONE;
     
-    if (!pathlib_is_dir(path)) {
-        pathlib_error = PATHLIB_NEXISTS;
-        return results;
+    #ifdef __linux__
+        /* a change of the mount namespace wakes up pollers of mountinfo with POLLERR | POLLPRI, the poll itself consumes the event */
+        pfd.fd = table->fd;
+        pfd.events = POLLPRI;
+        pfd.revents = 0;
+        if (poll(&pfd, 1, 0) < 0) {
+            pathlib_print_func_failed("poll");
+            pathlib_error = PATHLIB_OSERROR;
+            return 0;
+        }
+        if (!(pfd.revents & (POLLERR | POLLPRI))) {
+            return 0;
+        }
+        
+        return pathlib__mount_table_load(table);
+    #else
+        return 0;
+    #endif
+}
+
+PATHLIB_API void pathlib_mount_table_free(Pathlib_Mount_Table* table) {
+    if (table == NULL) {
+        return;
     }
     
-    if (!pathlib_render_str_to_buffer(path, fullpath, PATHLIB_ARRSIZE(fullpath))) {
-        pathlib_error = PATHLIB_NEXISTS;
-        return results;
-    }
+    #ifdef __linux__
+        close(table->fd);
+    #endif
+    PATHLIB_FREE(table->data);
+    PATHLIB_FREE(table->mounts);
+    pathlib_trie_free(table->trie);
+    PATHLIB_FREE(table);
+}
+
+PATHLIB_API const Pathlib_Mount* pathlib_mount_table_mounts(const Pathlib_Mount_Table* table, size_t* size) {
+    PATHLIB_ASSERT(table);
+    PATHLIB_ASSERT(size);
     
-    if (!pathlib__recursive_glob(fullpath, pattern, 0, &results)) {
-        pathlib_paths_free(&results);
+    *size = table->size;
+    return table->mounts;
+}
+
+PATHLIB_API const Pathlib_Mount* pathlib_mount_of(const Pathlib_Mount_Table* table, const Path* path) {
+    pathlib_u64 index;
+    Path key;
+    
+    PATHLIB_ASSERT(table);
+    PATHLIB_ASSERT(path);
+    
+    key = pathlib__mount_key(path);
+    if (!pathlib_trie_longest_prefix(table->trie, &key, &index, NULL)) {
+        return NULL;
     }
+    
+    return &table->mounts[index];
+}
 
-    return results;
+PATHLIB_API int pathlib_mount_table_is_mount(const Pathlib_Mount_Table* table, const Path* path) {
+    Path key;
+    
+    PATHLIB_ASSERT(table);
+    PATHLIB_ASSERT(path);
+    
+    key = pathlib__mount_key(path);
+    return pathlib_trie_get(table->trie, &key, NULL);
 }
 
-PATHLIB_API Paths pathlib_rglob(const Path* path, const char* pattern) {
-    char fullpath[PATHLIB_MAX_PATH];
-    Paths results;
-    results.paths = NULL;
-    results.size = 0;
-    results.capacity = 0;
+PATHLIB_API const char* pathlib_fs_type(const Pathlib_Mount_Table* table, const Path* path) {
+    const Pathlib_Mount* mount;
     
+    PATHLIB_ASSERT(table);
     PATHLIB_ASSERT(path);
-    PATHLIB_ASSERT(pattern);
     
-    pathlib_error = PATHLIB_NONE;
+    mount = pathlib_mount_of(table, path);
+    return mount != NULL ? mount->fs_type : NULL;
+}
+
+
+#if !defined(_WIN32)
+/* translates the ST_* flags of statvfs, which linux also uses for the f_flags of statfs */
+static int pathlib__fs_flags(unsigned long flags) {
+    int result = 0;
     
-    if (!pathlib_is_dir(path)) {
-        pathlib_error = PATHLIB_NEXISTS;
-        return results;
+    if (flags & ST_RDONLY) {
+        result |= PATHLIB_FS_READ_ONLY;
+    }
+    if (flags & ST_NOSUID) {
+        result |= PATHLIB_FS_NOSUID;
     }
+    #ifdef ST_NOATIME
+        if (flags & ST_NOATIME) {
+            result |= PATHLIB_FS_NOATIME;
+        }
+    #endif
+    #ifdef ST_RELATIME
+        if (flags & ST_RELATIME) {
+            result |= PATHLIB_FS_RELATIME;
+        }
+    #endif
+    #ifdef ST_NOEXEC
+        if (flags & ST_NOEXEC) {
+            result |= PATHLIB_FS_NOEXEC;
+        }
+    #endif
+    #ifdef ST_SYNCHRONOUS
+        if (flags & ST_SYNCHRONOUS) {
+            result |= PATHLIB_FS_SYNCHRONOUS;
+        }
+    #endif
     
-    if (!pathlib_render_str_to_buffer(path, fullpath, PATHLIB_ARRSIZE(fullpath))) {
+    return result;
+}
+#endif /* _WIN32 */
+
+PATHLIB_API int pathlib_fs_info(const Path* path, Pathlib_Fs_Info* info) {
+    char filename[PATHLIB_MAX_PATH];
+    #if defined(_WIN32)
+        char volume[PATHLIB_MAX_PATH];
+        ULARGE_INTEGER available, total, total_free;
+        DWORD sectors_per_cluster, bytes_per_sector, free_clusters, total_clusters, max_name_size, flags;
+    #elif defined(__linux__)
+        struct statfs st;
+        pathlib_u64 unit;
+    #else
+        struct statvfs st;
+        pathlib_u64 unit;
+    #endif
+    
+    PATHLIB_ASSERT(path);
+    PATHLIB_ASSERT(info);
+    
+    pathlib_error = PATHLIB_NONE;
+    
+    memset(info, 0, sizeof(*info));
+    
+    if (!pathlib_render_str_to_buffer(path, filename, PATHLIB_ARRSIZE(filename))) {
         pathlib_error = PATHLIB_NEXISTS;
-        return results;
+        return 0;
     }
     
-    if (!pathlib__recursive_glob(fullpath, pattern, 1, &results)) {
-        pathlib_paths_free(&results);
-    }
-
-    return results;
+    #if defined(_WIN32)
+        if (!GetDiskFreeSpaceEx(filename, &available, &total, &total_free)) {
+            pathlib_print_os_error("GetDiskFreeSpaceEx", filename);
+            pathlib_error = GetLastError() == ERROR_FILE_NOT_FOUND || GetLastError() == ERROR_PATH_NOT_FOUND ? PATHLIB_NEXISTS : PATHLIB_OSERROR;
+            return 0;
+        }
+        info->total_bytes = total.QuadPart;
+        info->free_bytes = total_free.QuadPart;
+        info->available_bytes = available.QuadPart;
+        
+        /* the cluster size and the flags are only known for the root of the volume */
+        if (!GetVolumePathName(filename, volume, PATHLIB_ARRSIZE(volume))) {
+            pathlib_print_os_error("GetVolumePathName", filename);
+            pathlib_error = PATHLIB_OSERROR;
+            return 0;
+        }
+        if (GetDiskFreeSpace(volume, &sectors_per_cluster, &bytes_per_sector, &free_clusters, &total_clusters)) {
+            info->block_size = (pathlib_u64)sectors_per_cluster * bytes_per_sector;
+            info->fragment_size = info->block_size;
+        }
+        if (GetVolumeInformation(volume, NULL, 0, NULL, &max_name_size, &flags, NULL, 0)) {
+            info->max_name_size = max_name_size;
+            info->flags = flags & FILE_READ_ONLY_VOLUME ? PATHLIB_FS_READ_ONLY : 0;
+        }
+    #else
+        #ifdef __linux__
+            if (statfs(filename, &st) != 0) {
+                pathlib_print_os_error("statfs", filename);
+                pathlib_error = errno == ENOENT || errno == ENOTDIR ? PATHLIB_NEXISTS : PATHLIB_OSERROR;
+                return 0;
+            }
+        #else
+            if (statvfs(filename, &st) != 0) {
+                pathlib_print_os_error("statvfs", filename);
+                pathlib_error = errno == ENOENT || errno == ENOTDIR ? PATHLIB_NEXISTS : PATHLIB_OSERROR;
+                return 0;
+            }
+        #endif
+        
+        /* the block counts are in fragments, old kernels leave the fragment size at 0 */
+        unit = st.f_frsize != 0 ? (pathlib_u64)st.f_frsize : (pathlib_u64)st.f_bsize;
+        info->total_bytes = (pathlib_u64)st.f_blocks * unit;
+        info->free_bytes = (pathlib_u64)st.f_bfree * unit;
+        info->available_bytes = (pathlib_u64)st.f_bavail * unit;
+        info->total_inodes = (pathlib_u64)st.f_files;
+        info->free_inodes = (pathlib_u64)st.f_ffree;
+        info->block_size = (pathlib_u64)st.f_bsize;
+        info->fragment_size = unit;
+        #ifdef __linux__
+            /* statfs has no separate count for unprivileged users, glibc's statvfs reports the free inodes too */
+            info->available_inodes = (pathlib_u64)st.f_ffree;
+            info->magic = (pathlib_u64)(unsigned long)st.f_type;
+            info->max_name_size = (pathlib_u64)st.f_namelen;
+            info->flags = pathlib__fs_flags((unsigned long)st.f_flags);
+        #else
+            info->available_inodes = (pathlib_u64)st.f_favail;
+            info->max_name_size = (pathlib_u64)st.f_namemax;
+            info->flags = pathlib__fs_flags((unsigned long)st.f_flag);
+        #endif
+    #endif
+    
+    return 1;
 }
 
 #endif /* PATHLIB_IMPLEMENTATION */